@@ -0,0 +1,86 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_CORE_ARENA_HPP_
+#define MCF_CORE_ARENA_HPP_
+
+#include <MCFCRT/env/arena.h>
+#include <new>
+#include <cstddef>
+
+namespace MCF {
+
+class Arena {
+public:
+	enum : std::size_t { kSuggestedChunkSize = _MCFCRT_ARENA_SUGGESTED_CHUNK_SIZE };
+
+	using Mark = ::_MCFCRT_ArenaMark;
+
+private:
+	::_MCFCRT_Arena x_vArena;
+
+public:
+	explicit Arena(std::size_t uChunkSize = kSuggestedChunkSize) noexcept {
+		::_MCFCRT_InitializeArena(&x_vArena, nullptr, 0, uChunkSize);
+	}
+	Arena(void *pBuffer, std::size_t uBufferSize, std::size_t uChunkSize = kSuggestedChunkSize) noexcept {
+		::_MCFCRT_InitializeArena(&x_vArena, pBuffer, uBufferSize, uChunkSize);
+	}
+	~Arena(){
+		::_MCFCRT_ReleaseArena(&x_vArena);
+	}
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+public:
+	__attribute__((__malloc__))
+	void *Allocate(std::size_t uSize, std::size_t uAlignment = alignof(std::max_align_t)){
+		const auto pBlock = ::_MCFCRT_AllocateFromArena(&x_vArena, uSize, uAlignment);
+		if(!pBlock){
+			throw std::bad_alloc();
+		}
+		return pBlock;
+	}
+	__attribute__((__malloc__))
+	void *Allocate(const std::nothrow_t &, std::size_t uSize, std::size_t uAlignment = alignof(std::max_align_t)) noexcept {
+		return ::_MCFCRT_AllocateFromArena(&x_vArena, uSize, uAlignment);
+	}
+
+	Mark GetMark() const noexcept {
+		return ::_MCFCRT_GetArenaMark(&x_vArena);
+	}
+	void Rewind(const Mark &vMark) noexcept {
+		::_MCFCRT_RewindArena(&x_vArena, vMark);
+	}
+	void Release() noexcept {
+		::_MCFCRT_ReleaseArena(&x_vArena);
+	}
+};
+
+// 用法：
+//   struct RequestArena {
+//     Arena &operator()() const noexcept { return g_vRequestArena; }
+//   };
+//   Vector<int, ArenaAllocator<RequestArena>> vecScratch;
+// 释放操作什么都不做，内存在内存池回滚或释放时统一回收。容器重新分配时旧的存储不会被回收。
+
+template<class ArenaProviderT>
+struct ArenaAllocator {
+	__attribute__((__malloc__))
+	void *operator()(std::size_t uSize){
+		return ArenaProviderT()().Allocate(uSize);
+	}
+	__attribute__((__malloc__))
+	void *operator()(const std::nothrow_t &, std::size_t uSize) noexcept {
+		return ArenaProviderT()().Allocate(std::nothrow, uSize);
+	}
+	void operator()(void *pBlock) noexcept {
+		(void)pBlock;
+	}
+};
+
+}
+
+#endif
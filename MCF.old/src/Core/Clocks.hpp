@@ -38,6 +38,21 @@ inline double GetHiResMonoClock() noexcept {
 	return ::_MCFCRT_GetHiResMonoClock();
 }
 
+// 周期时钟的单位不确定，应该只在相减之后再转换成纳秒。
+inline std::uint64_t GetMonoCycleClock() noexcept {
+	return ::_MCFCRT_GetMonoCycleClock();
+}
+inline std::uint64_t GetMonoCycleClockFrequency() noexcept {
+	return ::_MCFCRT_GetMonoCycleClockFrequency();
+}
+inline std::uint64_t ConvertMonoCyclesToNanoseconds(std::uint64_t u64Cycles) noexcept {
+	return ::_MCFCRT_ConvertMonoCyclesToNanoseconds(u64Cycles);
+}
+// 以纳秒为单位。
+inline std::uint64_t GetPreciseMonoClock() noexcept {
+	return ::_MCFCRT_GetPreciseMonoClock();
+}
+
 }
 
 #endif
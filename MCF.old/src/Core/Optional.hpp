@@ -128,7 +128,7 @@ public:
 		if(ppException){
 			std::rethrow_exception(*ppException);
 		}
-		return *x_vData.template Get<0>();
+		return **x_vData.template Get<0>();
 	}
 	ElementT &Require() const {
 		return Get();
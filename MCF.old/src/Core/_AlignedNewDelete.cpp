@@ -0,0 +1,79 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include <MCFCRT/env/heap.h>
+#include <new>
+#include <cstddef>
+
+// libstdc++ 在 Windows 上使用 msvcrt 的 `_aligned_malloc()` 实现这些函数，因此这里将其替换为 MCFCRT 的堆。
+// 带大小的释放函数会交给调试堆检查大小是否匹配。不带对齐的版本仍然由 libstdc++ 提供，以免与用户替换的 `operator delete(void *)` 不一致。
+
+namespace {
+
+__attribute__((__always_inline__)) inline void *AllocateAligned(std::size_t uSize, std::align_val_t eAlignment, const void *pRetAddr){
+	for(;;){
+		const auto pBlock = ::__MCFCRT_HeapAllocAligned(uSize, static_cast<std::size_t>(eAlignment), false, pRetAddr);
+		if(pBlock){
+			return pBlock;
+		}
+		const auto pfnHandler = std::get_new_handler();
+		if(!pfnHandler){
+			throw std::bad_alloc();
+		}
+		(*pfnHandler)();
+	}
+}
+__attribute__((__always_inline__)) inline void *AllocateAlignedNoThrow(std::size_t uSize, std::align_val_t eAlignment, const void *pRetAddr) noexcept {
+	try {
+		return AllocateAligned(uSize, eAlignment, pRetAddr);
+	} catch(std::bad_alloc &){
+		return nullptr;
+	}
+}
+__attribute__((__always_inline__)) inline void DeallocateAligned(void *pBlock, const void *pRetAddr) noexcept {
+	if(!pBlock){
+		return;
+	}
+	::__MCFCRT_HeapFree(pBlock, pRetAddr);
+}
+__attribute__((__always_inline__)) inline void DeallocateAlignedSized(void *pBlock, std::size_t uSize, const void *pRetAddr) noexcept {
+	if(!pBlock){
+		return;
+	}
+	::__MCFCRT_HeapFreeSized(pBlock, uSize, pRetAddr);
+}
+
+}
+
+void *operator new(std::size_t uSize, std::align_val_t eAlignment){
+	return AllocateAligned(uSize, eAlignment, __builtin_return_address(0));
+}
+void *operator new(std::size_t uSize, std::align_val_t eAlignment, const std::nothrow_t &) noexcept {
+	return AllocateAlignedNoThrow(uSize, eAlignment, __builtin_return_address(0));
+}
+void *operator new[](std::size_t uSize, std::align_val_t eAlignment){
+	return AllocateAligned(uSize, eAlignment, __builtin_return_address(0));
+}
+void *operator new[](std::size_t uSize, std::align_val_t eAlignment, const std::nothrow_t &) noexcept {
+	return AllocateAlignedNoThrow(uSize, eAlignment, __builtin_return_address(0));
+}
+
+void operator delete(void *pBlock, std::align_val_t) noexcept {
+	DeallocateAligned(pBlock, __builtin_return_address(0));
+}
+void operator delete(void *pBlock, std::align_val_t, const std::nothrow_t &) noexcept {
+	DeallocateAligned(pBlock, __builtin_return_address(0));
+}
+void operator delete(void *pBlock, std::size_t uSize, std::align_val_t) noexcept {
+	DeallocateAlignedSized(pBlock, uSize, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, std::align_val_t) noexcept {
+	DeallocateAligned(pBlock, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, std::align_val_t, const std::nothrow_t &) noexcept {
+	DeallocateAligned(pBlock, __builtin_return_address(0));
+}
+void operator delete[](void *pBlock, std::size_t uSize, std::align_val_t) noexcept {
+	DeallocateAlignedSized(pBlock, uSize, __builtin_return_address(0));
+}
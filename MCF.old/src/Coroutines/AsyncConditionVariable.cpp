@@ -0,0 +1,63 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "AsyncConditionVariable.hpp"
+#include "_CoroutineWarnings.hpp"
+#include <cstdint>
+
+namespace MCF {
+
+void AsyncConditionVariable::X_WaitAwaiter::await_suspend(std::coroutine_handle<> hCoroutine) noexcept {
+	x_vWaiter.hCoroutine = hCoroutine;
+	x_vWaiter.pLoop = RunLoop::GetCurrent();
+	// 协程在加入等待队列之后随时可能被其他线程恢复，此后不能再访问这个对象。
+	const auto pMutex = x_pMutex;
+	{
+		const auto vLock = x_pCond->x_mtxState.GetLock();
+		x_pCond->x_queWaiters.Push(&x_vWaiter);
+	}
+	pMutex->Unlock();
+}
+
+AsyncConditionVariable::~AsyncConditionVariable(){
+	MCF_ASSERT_MSG(x_queWaiters.IsEmpty(), L"AsyncConditionVariable 被析构时仍有协程在等待。");
+}
+
+MCF_BEGIN_COROUTINE_DEFINITIONS
+Task<void> AsyncConditionVariable::Wait(AsyncMutex &vMutex){
+	MCF_ASSERT_MSG(vMutex.IsLocked(), L"互斥体没有被锁定。");
+
+	co_await X_WaitAwaiter(this, &vMutex);
+	co_await vMutex.Lock();
+}
+MCF_END_COROUTINE_DEFINITIONS
+
+std::size_t AsyncConditionVariable::Signal(std::size_t uMaxCountToWakeUp) noexcept {
+	Impl_RunLoop::WaiterQueue queWoken;
+	std::size_t uCount = 0;
+	{
+		const auto vLock = x_mtxState.GetLock();
+		while(uCount < uMaxCountToWakeUp){
+			const auto pWaiter = x_queWaiters.Pop();
+			if(!pWaiter){
+				break;
+			}
+			queWoken.Push(pWaiter);
+			++uCount;
+		}
+	}
+	for(;;){
+		const auto pWaiter = queWoken.Pop();
+		if(!pWaiter){
+			break;
+		}
+		Impl_RunLoop::Wake(pWaiter);
+	}
+	return uCount;
+}
+std::size_t AsyncConditionVariable::Broadcast() noexcept {
+	return Signal(SIZE_MAX);
+}
+
+}
@@ -0,0 +1,60 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_COROUTINES_ASYNC_CONDITION_VARIABLE_HPP_
+#define MCF_COROUTINES_ASYNC_CONDITION_VARIABLE_HPP_
+
+#include "Task.hpp"
+#include "RunLoop.hpp"
+#include "AsyncMutex.hpp"
+#include "../Thread/Mutex.hpp"
+#include <coroutine>
+#include <cstddef>
+
+namespace MCF {
+
+class AsyncConditionVariable {
+private:
+	class X_WaitAwaiter {
+	private:
+		AsyncConditionVariable *x_pCond;
+		AsyncMutex *x_pMutex;
+		Impl_RunLoop::Waiter x_vWaiter;
+
+	public:
+		X_WaitAwaiter(AsyncConditionVariable *pCond, AsyncMutex *pMutex) noexcept
+			: x_pCond(pCond), x_pMutex(pMutex)
+		{ }
+
+	public:
+		bool await_ready() const noexcept {
+			return false;
+		}
+		void await_suspend(std::coroutine_handle<> hCoroutine) noexcept;
+		void await_resume() const noexcept {
+		}
+	};
+
+private:
+	mutable Mutex x_mtxState;
+	Impl_RunLoop::WaiterQueue x_queWaiters;
+
+public:
+	constexpr AsyncConditionVariable() noexcept = default;
+	~AsyncConditionVariable();
+
+	AsyncConditionVariable(const AsyncConditionVariable &) = delete;
+	AsyncConditionVariable &operator=(const AsyncConditionVariable &) = delete;
+
+public:
+	// 调用者必须已经锁定 vMutex。协程挂起后 vMutex 被解锁，被唤醒后重新锁定 vMutex。
+	Task<void> Wait(AsyncMutex &vMutex);
+	// 返回被唤醒的协程数量。
+	std::size_t Signal(std::size_t uMaxCountToWakeUp = 1) noexcept;
+	std::size_t Broadcast() noexcept;
+};
+
+}
+
+#endif
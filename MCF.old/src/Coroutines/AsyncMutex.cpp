@@ -0,0 +1,50 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "AsyncMutex.hpp"
+
+namespace MCF {
+
+AsyncMutex::~AsyncMutex(){
+	MCF_ASSERT_MSG(x_queWaiters.IsEmpty(), L"AsyncMutex 被析构时仍有协程在等待。");
+}
+
+bool AsyncMutex::X_LockOrEnqueue(Impl_RunLoop::Waiter *pWaiter) noexcept {
+	const auto vLock = x_mtxState.GetLock();
+	if(!x_bLocked){
+		x_bLocked = true;
+		return false;
+	}
+	x_queWaiters.Push(pWaiter);
+	return true;
+}
+
+bool AsyncMutex::IsLocked() const noexcept {
+	const auto vLock = x_mtxState.GetLock();
+	return x_bLocked;
+}
+bool AsyncMutex::TryLock() noexcept {
+	const auto vLock = x_mtxState.GetLock();
+	if(x_bLocked){
+		return false;
+	}
+	x_bLocked = true;
+	return true;
+}
+void AsyncMutex::Unlock() noexcept {
+	Impl_RunLoop::Waiter *pWaiter;
+	{
+		const auto vLock = x_mtxState.GetLock();
+		MCF_ASSERT_MSG(x_bLocked, L"互斥体没有被锁定。");
+		pWaiter = x_queWaiters.Pop();
+		if(!pWaiter){
+			x_bLocked = false;
+			return;
+		}
+	}
+	// 所有权被直接转交给等待者，x_bLocked 保持为 true。
+	Impl_RunLoop::Wake(pWaiter);
+}
+
+}
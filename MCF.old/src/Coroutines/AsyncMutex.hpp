@@ -0,0 +1,71 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_COROUTINES_ASYNC_MUTEX_HPP_
+#define MCF_COROUTINES_ASYNC_MUTEX_HPP_
+
+#include "RunLoop.hpp"
+#include "../Thread/Mutex.hpp"
+#include <coroutine>
+
+namespace MCF {
+
+// 等待 AsyncMutex 的协程被挂起，而不会阻塞所在的线程。Unlock() 把互斥体的所有权直接交给等待时间最长的协程。
+// AsyncMutex 不是递归的，也不要求由加锁的协程解锁。
+
+class AsyncMutex {
+private:
+	class X_LockAwaiter {
+	private:
+		AsyncMutex *x_pMutex;
+		Impl_RunLoop::Waiter x_vWaiter;
+
+	public:
+		explicit X_LockAwaiter(AsyncMutex *pMutex) noexcept
+			: x_pMutex(pMutex)
+		{ }
+
+	public:
+		bool await_ready() const noexcept {
+			return x_pMutex->TryLock();
+		}
+		bool await_suspend(std::coroutine_handle<> hCoroutine) noexcept {
+			x_vWaiter.hCoroutine = hCoroutine;
+			x_vWaiter.pLoop = RunLoop::GetCurrent();
+			return x_pMutex->X_LockOrEnqueue(&x_vWaiter);
+		}
+		void await_resume() const noexcept {
+		}
+	};
+
+private:
+	mutable Mutex x_mtxState;
+	bool x_bLocked;
+	Impl_RunLoop::WaiterQueue x_queWaiters;
+
+public:
+	AsyncMutex() noexcept
+		: x_bLocked(false)
+	{ }
+	~AsyncMutex();
+
+	AsyncMutex(const AsyncMutex &) = delete;
+	AsyncMutex &operator=(const AsyncMutex &) = delete;
+
+private:
+	// 如果互斥体已被锁定，把 pWaiter 加入等待队列并返回 true；否则锁定互斥体并返回 false。
+	bool X_LockOrEnqueue(Impl_RunLoop::Waiter *pWaiter) noexcept;
+
+public:
+	bool IsLocked() const noexcept;
+	bool TryLock() noexcept;
+	X_LockAwaiter Lock() noexcept {
+		return X_LockAwaiter(this);
+	}
+	void Unlock() noexcept;
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "AsyncSemaphore.hpp"
+
+namespace MCF {
+
+AsyncSemaphore::~AsyncSemaphore(){
+	MCF_ASSERT_MSG(x_queWaiters.IsEmpty(), L"AsyncSemaphore 被析构时仍有协程在等待。");
+}
+
+bool AsyncSemaphore::X_WaitOrEnqueue(Impl_RunLoop::Waiter *pWaiter) noexcept {
+	const auto vLock = x_mtxState.GetLock();
+	if(x_uCount != 0){
+		--x_uCount;
+		return false;
+	}
+	x_queWaiters.Push(pWaiter);
+	return true;
+}
+
+std::size_t AsyncSemaphore::GetCount() const noexcept {
+	const auto vLock = x_mtxState.GetLock();
+	return x_uCount;
+}
+bool AsyncSemaphore::TryWait() noexcept {
+	const auto vLock = x_mtxState.GetLock();
+	if(x_uCount == 0){
+		return false;
+	}
+	--x_uCount;
+	return true;
+}
+std::size_t AsyncSemaphore::Post(std::size_t uPostCount) noexcept {
+	Impl_RunLoop::WaiterQueue queWoken;
+	std::size_t uOldCount;
+	{
+		const auto vLock = x_mtxState.GetLock();
+		uOldCount = x_uCount;
+		// 计数直接交给等待者，不经过 x_uCount。
+		while(uPostCount != 0){
+			const auto pWaiter = x_queWaiters.Pop();
+			if(!pWaiter){
+				break;
+			}
+			queWoken.Push(pWaiter);
+			--uPostCount;
+		}
+		x_uCount += uPostCount;
+	}
+	for(;;){
+		const auto pWaiter = queWoken.Pop();
+		if(!pWaiter){
+			break;
+		}
+		Impl_RunLoop::Wake(pWaiter);
+	}
+	return uOldCount;
+}
+
+}
@@ -0,0 +1,72 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_COROUTINES_ASYNC_SEMAPHORE_HPP_
+#define MCF_COROUTINES_ASYNC_SEMAPHORE_HPP_
+
+#include "RunLoop.hpp"
+#include "../Thread/Mutex.hpp"
+#include <coroutine>
+#include <cstddef>
+
+namespace MCF {
+
+// 等待者按先进先出的顺序获得计数。
+
+class AsyncSemaphore {
+private:
+	class X_WaitAwaiter {
+	private:
+		AsyncSemaphore *x_pSemaphore;
+		Impl_RunLoop::Waiter x_vWaiter;
+
+	public:
+		explicit X_WaitAwaiter(AsyncSemaphore *pSemaphore) noexcept
+			: x_pSemaphore(pSemaphore)
+		{ }
+
+	public:
+		bool await_ready() const noexcept {
+			return x_pSemaphore->TryWait();
+		}
+		bool await_suspend(std::coroutine_handle<> hCoroutine) noexcept {
+			x_vWaiter.hCoroutine = hCoroutine;
+			x_vWaiter.pLoop = RunLoop::GetCurrent();
+			return x_pSemaphore->X_WaitOrEnqueue(&x_vWaiter);
+		}
+		void await_resume() const noexcept {
+		}
+	};
+
+private:
+	mutable Mutex x_mtxState;
+	std::size_t x_uCount;
+	Impl_RunLoop::WaiterQueue x_queWaiters;
+
+public:
+	explicit AsyncSemaphore(std::size_t uInitCount) noexcept
+		: x_uCount(uInitCount)
+	{ }
+	~AsyncSemaphore();
+
+	AsyncSemaphore(const AsyncSemaphore &) = delete;
+	AsyncSemaphore &operator=(const AsyncSemaphore &) = delete;
+
+private:
+	// 如果计数为零，把 pWaiter 加入等待队列并返回 true；否则减少计数并返回 false。
+	bool X_WaitOrEnqueue(Impl_RunLoop::Waiter *pWaiter) noexcept;
+
+public:
+	std::size_t GetCount() const noexcept;
+	bool TryWait() noexcept;
+	X_WaitAwaiter Wait() noexcept {
+		return X_WaitAwaiter(this);
+	}
+	// 返回原来的计数。
+	std::size_t Post(std::size_t uPostCount = 1) noexcept;
+};
+
+}
+
+#endif
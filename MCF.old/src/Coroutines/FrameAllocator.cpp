@@ -0,0 +1,101 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "FrameAllocator.hpp"
+#include "../Core/Atomic.hpp"
+#include <new>
+
+namespace MCF {
+
+CoroutineFrameAllocator::~CoroutineFrameAllocator(){ }
+
+PooledCoroutineFrameAllocator::~PooledCoroutineFrameAllocator(){
+	Trim();
+}
+
+void *PooledCoroutineFrameAllocator::Allocate(std::size_t uSize){
+	if(uSize > kMaxPooledSize){
+		return ::operator new(uSize);
+	}
+	const auto uClass = (uSize - 1) / kGranularity;
+	{
+		const auto vLock = x_mtxPool.GetLock();
+		const auto pBlock = x_apFreeLists[uClass];
+		if(pBlock){
+			x_apFreeLists[uClass] = pBlock->pNext;
+			return pBlock;
+		}
+	}
+	return ::operator new((uClass + 1) * kGranularity);
+}
+void PooledCoroutineFrameAllocator::Deallocate(void *pBlock, std::size_t uSize) noexcept {
+	if(uSize > kMaxPooledSize){
+		::operator delete(pBlock);
+		return;
+	}
+	const auto uClass = (uSize - 1) / kGranularity;
+	const auto pFreeBlock = static_cast<X_FreeBlock *>(pBlock);
+	const auto vLock = x_mtxPool.GetLock();
+	pFreeBlock->pNext = x_apFreeLists[uClass];
+	x_apFreeLists[uClass] = pFreeBlock;
+}
+
+void PooledCoroutineFrameAllocator::Trim() noexcept {
+	X_FreeBlock *apFreeLists[kClassCount];
+	{
+		const auto vLock = x_mtxPool.GetLock();
+		for(std::size_t uClass = 0; uClass < kClassCount; ++uClass){
+			apFreeLists[uClass] = x_apFreeLists[uClass];
+			x_apFreeLists[uClass] = nullptr;
+		}
+	}
+	for(std::size_t uClass = 0; uClass < kClassCount; ++uClass){
+		auto pBlock = apFreeLists[uClass];
+		while(pBlock){
+			const auto pNext = pBlock->pNext;
+			::operator delete(pBlock);
+			pBlock = pNext;
+		}
+	}
+}
+
+namespace {
+	Atomic<CoroutineFrameAllocator *> g_pAllocator(nullptr);
+
+	// 每个帧之前存放分配它的分配器。这个头部的大小保证帧的对齐不变。
+	constexpr std::size_t kHeaderSize = alignof(std::max_align_t);
+	static_assert(kHeaderSize >= sizeof(CoroutineFrameAllocator *), "The frame header is too small.");
+}
+
+CoroutineFrameAllocator *GetCoroutineFrameAllocator() noexcept {
+	return g_pAllocator.Load(kAtomicConsume);
+}
+CoroutineFrameAllocator *SetCoroutineFrameAllocator(CoroutineFrameAllocator *pAllocator) noexcept {
+	return g_pAllocator.Exchange(pAllocator, kAtomicAcqRel);
+}
+
+namespace Impl_CoroutineFrameAllocator {
+	void *AllocateFrame(std::size_t uSize){
+		const auto pAllocator = GetCoroutineFrameAllocator();
+		void *pBlock;
+		if(pAllocator){
+			pBlock = pAllocator->Allocate(uSize + kHeaderSize);
+		} else {
+			pBlock = ::operator new(uSize + kHeaderSize);
+		}
+		*static_cast<CoroutineFrameAllocator **>(pBlock) = pAllocator;
+		return static_cast<unsigned char *>(pBlock) + kHeaderSize;
+	}
+	void DeallocateFrame(void *pFrame, std::size_t uSize) noexcept {
+		const auto pBlock = static_cast<unsigned char *>(pFrame) - kHeaderSize;
+		const auto pAllocator = *reinterpret_cast<CoroutineFrameAllocator **>(pBlock);
+		if(pAllocator){
+			pAllocator->Deallocate(pBlock, uSize + kHeaderSize);
+		} else {
+			::operator delete(pBlock);
+		}
+	}
+}
+
+}
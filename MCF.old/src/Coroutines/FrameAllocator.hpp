@@ -0,0 +1,79 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_COROUTINES_FRAME_ALLOCATOR_HPP_
+#define MCF_COROUTINES_FRAME_ALLOCATOR_HPP_
+
+#include "../Thread/Mutex.hpp"
+#include <cstddef>
+
+namespace MCF {
+
+// 所有 MCF 协程的帧都通过当前的帧分配器分配。每个帧记录了分配它的分配器，因此更换分配器不影响已经分配的帧。
+// 分配器必须比由它分配的所有帧存活得更久。
+class CoroutineFrameAllocator {
+public:
+	virtual ~CoroutineFrameAllocator();
+
+public:
+	virtual void *Allocate(std::size_t uSize) = 0;
+	virtual void Deallocate(void *pBlock, std::size_t uSize) noexcept = 0;
+};
+
+// 按大小分级缓存被释放的帧，以便频繁创建的协程复用它们。超过 kMaxPooledSize 的帧不被缓存。
+class PooledCoroutineFrameAllocator final : public CoroutineFrameAllocator {
+public:
+	enum : std::size_t {
+		kGranularity    = 64,
+		kClassCount     = 32,
+		kMaxPooledSize  = kGranularity * kClassCount,
+	};
+
+private:
+	struct X_FreeBlock {
+		X_FreeBlock *pNext;
+	};
+
+private:
+	Mutex x_mtxPool;
+	X_FreeBlock *x_apFreeLists[kClassCount] = { };
+
+public:
+	constexpr PooledCoroutineFrameAllocator() noexcept = default;
+	~PooledCoroutineFrameAllocator() override;
+
+	PooledCoroutineFrameAllocator(const PooledCoroutineFrameAllocator &) = delete;
+	PooledCoroutineFrameAllocator &operator=(const PooledCoroutineFrameAllocator &) = delete;
+
+public:
+	void *Allocate(std::size_t uSize) override;
+	void Deallocate(void *pBlock, std::size_t uSize) noexcept override;
+
+	// 释放所有缓存的帧。
+	void Trim() noexcept;
+};
+
+// 如果分配器为空指针，帧通过 ::operator new() 分配。
+extern CoroutineFrameAllocator *GetCoroutineFrameAllocator() noexcept;
+// 返回原来的分配器。
+extern CoroutineFrameAllocator *SetCoroutineFrameAllocator(CoroutineFrameAllocator *pAllocator) noexcept;
+
+namespace Impl_CoroutineFrameAllocator {
+	extern void *AllocateFrame(std::size_t uSize);
+	extern void DeallocateFrame(void *pFrame, std::size_t uSize) noexcept;
+
+	// 协程的承诺类型从这个类派生，以便通过当前的帧分配器分配帧。
+	struct FrameAllocationBase {
+		static void *operator new(std::size_t uSize){
+			return AllocateFrame(uSize);
+		}
+		static void operator delete(void *pFrame, std::size_t uSize) noexcept {
+			DeallocateFrame(pFrame, uSize);
+		}
+	};
+}
+
+}
+
+#endif
@@ -0,0 +1,176 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "RunLoop.hpp"
+#include "_CoroutineWarnings.hpp"
+#include "../Thread/ThreadLocal.hpp"
+#include "../Core/Defer.hpp"
+#include <algorithm>
+
+namespace MCF {
+
+namespace Impl_RunLoop {
+	namespace {
+		ThreadLocal<RunLoop *> &GetCurrentLoopStorage(){
+			static ThreadLocal<RunLoop *> s_tlsCurrentLoop;
+			return s_tlsCurrentLoop;
+		}
+
+		struct TimerComparator {
+			template<typename TimerT>
+			bool operator()(const TimerT &vLeft, const TimerT &vRight) const noexcept {
+				// 最小堆。
+				return vLeft.u64DueTime > vRight.u64DueTime;
+			}
+		};
+	}
+
+	void Wake(Waiter *pWaiter) noexcept {
+		if(pWaiter->pLoop){
+			pWaiter->pLoop->X_Post(pWaiter);
+		} else {
+			pWaiter->hCoroutine.resume();
+		}
+	}
+}
+
+RunLoop *RunLoop::GetCurrent() noexcept {
+	const auto ppLoop = Impl_RunLoop::GetCurrentLoopStorage().Get();
+	if(!ppLoop){
+		return nullptr;
+	}
+	return *ppLoop;
+}
+
+RunLoop::RunLoop() noexcept
+	: x_uDetachedCount(0), x_bStopping(false)
+{ }
+RunLoop::~RunLoop(){
+	MCF_ASSERT_MSG(x_queReady.IsEmpty() && x_vecTimers.IsEmpty() && (x_uDetachedCount == 0), L"RunLoop 被析构时仍有协程在其中挂起。");
+}
+
+MCF_BEGIN_COROUTINE_DEFINITIONS
+RunLoop::X_DetachedCoroutine RunLoop::X_Detach(RunLoop *pLoop, Task<void> vTask){
+	co_await pLoop->Reschedule();
+	co_await std::move(vTask);
+	pLoop->X_OnDetachedCoroutineExit();
+}
+MCF_END_COROUTINE_DEFINITIONS
+
+void RunLoop::X_Post(Impl_RunLoop::Waiter *pWaiter) noexcept {
+	const auto vLock = x_mtxQueue.GetLock();
+	const bool bWasEmpty = x_queReady.IsEmpty();
+	x_queReady.Push(pWaiter);
+	if(bWasEmpty){
+		x_cvQueue.Signal();
+	}
+}
+void RunLoop::X_AddTimer(std::uint64_t u64DueTime, Impl_RunLoop::Waiter *pWaiter){
+	const auto vLock = x_mtxQueue.GetLock();
+	x_vecTimers.Push(X_Timer{ u64DueTime, pWaiter });
+	std::push_heap(x_vecTimers.GetBegin(), x_vecTimers.GetEnd(), Impl_RunLoop::TimerComparator());
+	// 如果新的定时器最早到期，正在等待的线程需要重新计算等待时间。
+	if(x_vecTimers.GetBegin()->pWaiter == pWaiter){
+		x_cvQueue.Signal();
+	}
+}
+void RunLoop::X_OnDetachedCoroutineExit() noexcept {
+	const auto vLock = x_mtxQueue.GetLock();
+	--x_uDetachedCount;
+	if(x_uDetachedCount == 0){
+		x_cvQueue.Signal();
+	}
+}
+void RunLoop::X_OnDriverExit(bool &bDone) noexcept {
+	const auto vLock = x_mtxQueue.GetLock();
+	bDone = true;
+	x_cvQueue.Signal();
+}
+void RunLoop::X_Pump(const bool *pbDone){
+	const auto pOldLoop = GetCurrent();
+	*(Impl_RunLoop::GetCurrentLoopStorage().Require()) = this;
+	const auto vRestore = Defer([&]{ *(Impl_RunLoop::GetCurrentLoopStorage().Require()) = pOldLoop; });
+
+	Impl_RunLoop::WaiterQueue queBatch;
+	for(;;){
+		{
+			auto vLock = x_mtxQueue.GetLock();
+			for(;;){
+				if(pbDone){
+					if(*pbDone){
+						return;
+					}
+				} else if(x_bStopping){
+					x_bStopping = false;
+					return;
+				}
+				const auto u64Now = GetFastMonoClock();
+				while(!x_vecTimers.IsEmpty() && (x_vecTimers.GetBegin()->u64DueTime <= u64Now)){
+					std::pop_heap(x_vecTimers.GetBegin(), x_vecTimers.GetEnd(), Impl_RunLoop::TimerComparator());
+					x_queReady.Push(x_vecTimers.GetEnd()[-1].pWaiter);
+					x_vecTimers.Pop();
+				}
+				if(!x_queReady.IsEmpty()){
+					break;
+				}
+				if(!pbDone && (x_uDetachedCount == 0) && x_vecTimers.IsEmpty()){
+					return;
+				}
+				if(x_vecTimers.IsEmpty()){
+					x_cvQueue.Wait(vLock);
+				} else {
+					x_cvQueue.Wait(vLock, x_vecTimers.GetBegin()->u64DueTime);
+				}
+			}
+			queBatch.Swap(x_queReady);
+		}
+		// 协程可能在被恢复后立即把自己投递回来，它们会进入下一批。
+		for(;;){
+			const auto pWaiter = queBatch.Pop();
+			if(!pWaiter){
+				break;
+			}
+			pWaiter->hCoroutine.resume();
+		}
+	}
+}
+void RunLoop::X_Start(Task<void> &vDriver, const bool &bDone){
+	const auto pOldLoop = GetCurrent();
+	*(Impl_RunLoop::GetCurrentLoopStorage().Require()) = this;
+	{
+		const auto vRestore = Defer([&]{ *(Impl_RunLoop::GetCurrentLoopStorage().Require()) = pOldLoop; });
+		vDriver.GetHandle().resume();
+	}
+	X_Pump(&bDone);
+}
+
+void RunLoop::Spawn(Task<void> vTask){
+	MCF_ASSERT(vTask.IsValid());
+
+	{
+		const auto vLock = x_mtxQueue.GetLock();
+		++x_uDetachedCount;
+	}
+	try {
+		X_Detach(this, std::move(vTask));
+	} catch(...){
+		X_OnDetachedCoroutineExit();
+		throw;
+	}
+}
+void RunLoop::Run(){
+	{
+		// 忽略在没有运行 Run() 时调用的 Stop()，否则下一次 Run() 会立即返回。
+		const auto vLock = x_mtxQueue.GetLock();
+		x_bStopping = false;
+	}
+	X_Pump(nullptr);
+}
+void RunLoop::Stop() noexcept {
+	const auto vLock = x_mtxQueue.GetLock();
+	x_bStopping = true;
+	x_cvQueue.Signal();
+}
+
+}
@@ -0,0 +1,217 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_COROUTINES_RUN_LOOP_HPP_
+#define MCF_COROUTINES_RUN_LOOP_HPP_
+
+#include "Task.hpp"
+#include "_CoroutineWarnings.hpp"
+#include "../Containers/Vector.hpp"
+#include "../Thread/Mutex.hpp"
+#include "../Thread/ConditionVariable.hpp"
+#include "../Core/Clocks.hpp"
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+namespace MCF {
+
+class RunLoop;
+
+namespace Impl_RunLoop {
+	// 每个挂起的协程在它的帧中保存一个这样的节点，因此唤醒协程不需要分配内存。
+	struct Waiter {
+		Waiter *pNext;
+		std::coroutine_handle<> hCoroutine;
+		RunLoop *pLoop;
+	};
+
+	class WaiterQueue {
+	private:
+		Waiter *x_pFirst = nullptr;
+		Waiter *x_pLast = nullptr;
+
+	public:
+		bool IsEmpty() const noexcept {
+			return !x_pFirst;
+		}
+		void Push(Waiter *pWaiter) noexcept {
+			pWaiter->pNext = nullptr;
+			if(x_pLast){
+				x_pLast->pNext = pWaiter;
+			} else {
+				x_pFirst = pWaiter;
+			}
+			x_pLast = pWaiter;
+		}
+		Waiter *Pop() noexcept {
+			const auto pWaiter = x_pFirst;
+			if(pWaiter){
+				x_pFirst = pWaiter->pNext;
+				if(!x_pFirst){
+					x_pLast = nullptr;
+				}
+			}
+			return pWaiter;
+		}
+		void Swap(WaiterQueue &vOther) noexcept {
+			using std::swap;
+			swap(x_pFirst, vOther.x_pFirst);
+			swap(x_pLast, vOther.x_pLast);
+		}
+	};
+
+	// 如果协程挂起时在某个 RunLoop 中运行，把它交给那个 RunLoop 恢复；否则在当前线程中直接恢复它。
+	extern void Wake(Waiter *pWaiter) noexcept;
+}
+
+// RunLoop 在调用 Run() 或 RunUntilComplete() 的线程中恢复协程。同一时刻只能有一个线程在运行同一个 RunLoop，
+// 但是其他线程可以向它投递协程。就绪的协程被成批取出，每一批按投递的顺序恢复。
+// RunLoop 必须比所有在其中挂起的协程存活得更久。
+
+class RunLoop {
+private:
+	struct X_Timer {
+		std::uint64_t u64DueTime;
+		Impl_RunLoop::Waiter *pWaiter;
+	};
+
+	struct X_DetachedCoroutine {
+		struct promise_type : Impl_CoroutineFrameAllocator::FrameAllocationBase {
+			X_DetachedCoroutine get_return_object() const noexcept {
+				return { };
+			}
+			std::suspend_never initial_suspend() const noexcept {
+				return { };
+			}
+			std::suspend_never final_suspend() const noexcept {
+				return { };
+			}
+			void return_void() const noexcept {
+			}
+			[[noreturn]] void unhandled_exception() const noexcept {
+				std::terminate();
+			}
+		};
+	};
+
+	class X_RescheduleAwaiter {
+	private:
+		RunLoop *x_pLoop;
+		Impl_RunLoop::Waiter x_vWaiter;
+
+	public:
+		explicit X_RescheduleAwaiter(RunLoop *pLoop) noexcept
+			: x_pLoop(pLoop)
+		{ }
+
+	public:
+		bool await_ready() const noexcept {
+			return false;
+		}
+		void await_suspend(std::coroutine_handle<> hCoroutine) noexcept {
+			x_vWaiter.hCoroutine = hCoroutine;
+			x_vWaiter.pLoop = x_pLoop;
+			x_pLoop->X_Post(&x_vWaiter);
+		}
+		void await_resume() const noexcept {
+		}
+	};
+
+	class X_SleepAwaiter {
+	private:
+		RunLoop *x_pLoop;
+		std::uint64_t x_u64DueTime;
+		Impl_RunLoop::Waiter x_vWaiter;
+
+	public:
+		X_SleepAwaiter(RunLoop *pLoop, std::uint64_t u64DueTime) noexcept
+			: x_pLoop(pLoop), x_u64DueTime(u64DueTime)
+		{ }
+
+	public:
+		bool await_ready() const noexcept {
+			return GetFastMonoClock() >= x_u64DueTime;
+		}
+		void await_suspend(std::coroutine_handle<> hCoroutine){
+			x_vWaiter.hCoroutine = hCoroutine;
+			x_vWaiter.pLoop = x_pLoop;
+			x_pLoop->X_AddTimer(x_u64DueTime, &x_vWaiter);
+		}
+		void await_resume() const noexcept {
+		}
+	};
+
+public:
+	// 如果当前线程没有在运行 RunLoop，返回空指针。
+	static RunLoop *GetCurrent() noexcept;
+
+private:
+	mutable Mutex x_mtxQueue;
+	ConditionVariable x_cvQueue;
+	Impl_RunLoop::WaiterQueue x_queReady;
+	Vector<X_Timer> x_vecTimers;
+	std::size_t x_uDetachedCount;
+	bool x_bStopping;
+
+public:
+	RunLoop() noexcept;
+	~RunLoop();
+
+	RunLoop(const RunLoop &) = delete;
+	RunLoop &operator=(const RunLoop &) = delete;
+
+private:
+	static X_DetachedCoroutine X_Detach(RunLoop *pLoop, Task<void> vTask);
+	MCF_BEGIN_COROUTINE_DEFINITIONS
+	template<typename ElementT>
+	static Task<void> X_Drive(RunLoop *pLoop, Task<ElementT> &vTask, bool &bDone){
+		co_await vTask.WhenReady();
+		// vTask 可能在其他线程中结束。回到这个 RunLoop 中再设置 bDone，否则 X_Pump() 返回之后这个协程帧可能仍在被使用。
+		co_await pLoop->Reschedule();
+		pLoop->X_OnDriverExit(bDone);
+	}
+	MCF_END_COROUTINE_DEFINITIONS
+
+	void X_Post(Impl_RunLoop::Waiter *pWaiter) noexcept;
+	void X_AddTimer(std::uint64_t u64DueTime, Impl_RunLoop::Waiter *pWaiter);
+	void X_OnDetachedCoroutineExit() noexcept;
+	void X_OnDriverExit(bool &bDone) noexcept;
+	// 如果 pbDone 为空指针，一直运行到 Stop() 被调用，或者没有分离的协程和定时器为止。
+	void X_Pump(const bool *pbDone);
+	void X_Start(Task<void> &vDriver, const bool &bDone);
+
+	friend void Impl_RunLoop::Wake(Impl_RunLoop::Waiter *pWaiter) noexcept;
+
+public:
+	// 分离的协程不能抛出异常，否则程序被终止。
+	void Spawn(Task<void> vTask);
+	// 在当前线程中运行 RunLoop，直到 vTask 结束，然后返回它的结果。
+	template<typename ElementT>
+	ElementT RunUntilComplete(Task<ElementT> vTask){
+		bool bDone = false;
+		auto vDriver = X_Drive(this, vTask, bDone);
+		X_Start(vDriver, bDone);
+		return static_cast<ElementT>(std::move(vTask).GetResult());
+	}
+	void Run();
+	// 使正在运行的 Run() 在恢复完当前一批协程之后返回。在 Run() 开始之前调用没有效果。
+	void Stop() noexcept;
+
+	// 把当前协程放到这个 RunLoop 的就绪队列末尾。这也可以用来把协程转移到另一个 RunLoop 中运行。
+	X_RescheduleAwaiter Reschedule() noexcept {
+		return X_RescheduleAwaiter(this);
+	}
+	// 挂起当前协程直到指定的时刻（由 GetFastMonoClock() 给出）。协程在挂起期间不能被销毁。
+	X_SleepAwaiter SleepUntil(std::uint64_t u64UntilFastMonoClock) noexcept {
+		return X_SleepAwaiter(this, u64UntilFastMonoClock);
+	}
+	X_SleepAwaiter SleepFor(std::uint64_t u64Milliseconds) noexcept {
+		return X_SleepAwaiter(this, GetFastMonoClock() + u64Milliseconds);
+	}
+};
+
+}
+
+#endif
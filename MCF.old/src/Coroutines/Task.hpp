@@ -0,0 +1,265 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_COROUTINES_TASK_HPP_
+#define MCF_COROUTINES_TASK_HPP_
+
+#ifndef __cpp_impl_coroutine
+#  error MCF coroutines require compiler support for C++ coroutines. Compile with GCC 10 or later and -fcoroutines.
+#endif
+
+#include "FrameAllocator.hpp"
+#include "../Core/Assert.hpp"
+#include "../Core/Optional.hpp"
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace MCF {
+
+template<typename ElementT>
+class Task;
+
+namespace Impl_Task {
+	class PromiseBase : public Impl_CoroutineFrameAllocator::FrameAllocationBase {
+	private:
+		struct X_FinalAwaiter {
+			bool await_ready() const noexcept {
+				return false;
+			}
+			template<typename PromiseT>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseT> hCoroutine) noexcept {
+				// 对称转移：直接恢复等待者，而不是在这里嵌套调用 resume()。
+				// GCC 12 只在启用 -foptimize-sibling-calls（-O2 及以上）时把它编译为尾调用，否则每一层等待仍然占用几十字节的栈。
+				const auto hContinuation = hCoroutine.promise().x_hContinuation;
+				if(!hContinuation){
+					return std::noop_coroutine();
+				}
+				return hContinuation;
+			}
+			void await_resume() const noexcept {
+			}
+		};
+
+	private:
+		std::coroutine_handle<> x_hContinuation;
+
+	public:
+		std::suspend_always initial_suspend() const noexcept {
+			return { };
+		}
+		X_FinalAwaiter final_suspend() const noexcept {
+			return { };
+		}
+
+		void SetContinuation(std::coroutine_handle<> hContinuation) noexcept {
+			x_hContinuation = hContinuation;
+		}
+	};
+
+	template<typename ElementT>
+	class Promise : public PromiseBase {
+	private:
+		Optional<ElementT> x_vResult;
+
+	public:
+		Task<ElementT> get_return_object() noexcept;
+
+		template<typename ParamT>
+		void return_value(ParamT &&vParam){
+			x_vResult.Reset(std::forward<ParamT>(vParam));
+		}
+		void unhandled_exception() noexcept {
+			x_vResult.Reset(std::current_exception());
+		}
+
+		ElementT &GetResult(){
+			const auto pElement = x_vResult.Get();
+			MCF_ASSERT_MSG(pElement, L"协程尚未返回。");
+			return *pElement;
+		}
+		ElementT &&MoveResult(){
+			return std::move(GetResult());
+		}
+	};
+
+	template<typename ElementT>
+	class Promise<ElementT &> : public PromiseBase {
+	private:
+		Optional<ElementT &> x_vResult;
+
+	public:
+		Task<ElementT &> get_return_object() noexcept;
+
+		void return_value(ElementT &vElement) noexcept {
+			x_vResult.Reset(vElement);
+		}
+		void unhandled_exception() noexcept {
+			x_vResult.Reset(std::current_exception());
+		}
+
+		ElementT &GetResult(){
+			MCF_ASSERT_MSG(x_vResult.IsSet(), L"协程尚未返回。");
+			return x_vResult.Get();
+		}
+		ElementT &MoveResult(){
+			return GetResult();
+		}
+	};
+
+	template<>
+	class Promise<void> : public PromiseBase {
+	private:
+		std::exception_ptr x_pException;
+
+	public:
+		Task<void> get_return_object() noexcept;
+
+		void return_void() noexcept {
+		}
+		void unhandled_exception() noexcept {
+			x_pException = std::current_exception();
+		}
+
+		void GetResult(){
+			if(x_pException){
+				std::rethrow_exception(x_pException);
+			}
+		}
+		void MoveResult(){
+			GetResult();
+		}
+	};
+
+	template<typename PromiseT>
+	struct AwaiterBase {
+		std::coroutine_handle<PromiseT> hCoroutine;
+
+		bool await_ready() const noexcept {
+			return hCoroutine.done();
+		}
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> hAwaiting) noexcept {
+			hCoroutine.promise().SetContinuation(hAwaiting);
+			return hCoroutine;
+		}
+	};
+}
+
+// Task 是惰性启动的：协程在第一次被 co_await 时才开始执行，并在结束时直接把执行权转移给等待者。
+// 一个 Task 只能被等待一次。Task 对象析构时销毁协程帧，因此不能在协程被挂起时析构正在被等待的 Task。
+
+template<typename ElementT>
+class Task {
+public:
+	using promise_type = Impl_Task::Promise<ElementT>;
+	using Handle = std::coroutine_handle<promise_type>;
+
+private:
+	Handle x_hCoroutine;
+
+public:
+	constexpr Task() noexcept
+		: x_hCoroutine()
+	{ }
+	explicit Task(Handle hCoroutine) noexcept
+		: x_hCoroutine(hCoroutine)
+	{ }
+	Task(Task &&vOther) noexcept
+		: x_hCoroutine(std::exchange(vOther.x_hCoroutine, nullptr))
+	{ }
+	Task &operator=(Task &&vOther) noexcept {
+		Task(std::move(vOther)).Swap(*this);
+		return *this;
+	}
+	~Task(){
+		if(x_hCoroutine){
+			x_hCoroutine.destroy();
+		}
+	}
+
+public:
+	bool IsValid() const noexcept {
+		return !!x_hCoroutine;
+	}
+	bool IsDone() const noexcept {
+		MCF_ASSERT(x_hCoroutine);
+		return x_hCoroutine.done();
+	}
+	Handle GetHandle() const noexcept {
+		return x_hCoroutine;
+	}
+	Handle Release() noexcept {
+		return std::exchange(x_hCoroutine, nullptr);
+	}
+
+	// 协程必须已经结束。如果协程抛出了异常，重新抛出该异常。
+	decltype(auto) GetResult() & {
+		MCF_ASSERT_MSG(IsDone(), L"协程尚未结束。");
+		return x_hCoroutine.promise().GetResult();
+	}
+	decltype(auto) GetResult() && {
+		MCF_ASSERT_MSG(IsDone(), L"协程尚未结束。");
+		return x_hCoroutine.promise().MoveResult();
+	}
+
+	// 等待协程结束，但不获取结果，也不重新抛出异常。
+	auto WhenReady() const noexcept {
+		MCF_ASSERT(x_hCoroutine);
+
+		struct Awaiter : Impl_Task::AwaiterBase<promise_type> {
+			void await_resume() const noexcept {
+			}
+		};
+		return Awaiter{ { x_hCoroutine } };
+	}
+
+	void Swap(Task &vOther) noexcept {
+		using std::swap;
+		swap(x_hCoroutine, vOther.x_hCoroutine);
+	}
+
+public:
+	auto operator co_await() & noexcept {
+		MCF_ASSERT(x_hCoroutine);
+
+		struct Awaiter : Impl_Task::AwaiterBase<promise_type> {
+			decltype(auto) await_resume() const {
+				return this->hCoroutine.promise().GetResult();
+			}
+		};
+		return Awaiter{ { x_hCoroutine } };
+	}
+	auto operator co_await() && noexcept {
+		MCF_ASSERT(x_hCoroutine);
+
+		struct Awaiter : Impl_Task::AwaiterBase<promise_type> {
+			decltype(auto) await_resume() const {
+				return this->hCoroutine.promise().MoveResult();
+			}
+		};
+		return Awaiter{ { x_hCoroutine } };
+	}
+
+	friend void swap(Task &vSelf, Task &vOther) noexcept {
+		vSelf.Swap(vOther);
+	}
+};
+
+namespace Impl_Task {
+	template<typename ElementT>
+	Task<ElementT> Promise<ElementT>::get_return_object() noexcept {
+		return Task<ElementT>(Task<ElementT>::Handle::from_promise(*this));
+	}
+	template<typename ElementT>
+	Task<ElementT &> Promise<ElementT &>::get_return_object() noexcept {
+		return Task<ElementT &>(Task<ElementT &>::Handle::from_promise(*this));
+	}
+	inline Task<void> Promise<void>::get_return_object() noexcept {
+		return Task<void>(Task<void>::Handle::from_promise(*this));
+	}
+}
+
+}
+
+#endif
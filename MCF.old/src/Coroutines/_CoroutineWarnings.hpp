@@ -0,0 +1,16 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_COROUTINES_COROUTINE_WARNINGS_HPP_
+#define MCF_COROUTINES_COROUTINE_WARNINGS_HPP_
+
+// GCC 12 在展开协程时会生成字面量 0 作为空指针，在每个协程的末尾触发 -Wzero-as-null-pointer-constant。
+// 这无法通过修改代码来避免，因此协程的定义要放在这两个宏之间。
+#define MCF_BEGIN_COROUTINE_DEFINITIONS	\
+	_Pragma("GCC diagnostic push")	\
+	_Pragma("GCC diagnostic ignored \"-Wzero-as-null-pointer-constant\"")
+#define MCF_END_COROUTINE_DEFINITIONS	\
+	_Pragma("GCC diagnostic pop")
+
+#endif
@@ -76,7 +76,7 @@ namespace Impl_IntrusivePtr {
 		bool DropRef() const volatile noexcept {
 			MCF_DEBUG_CHECK(static_cast<std::ptrdiff_t>(x_uRef.Load(kAtomicRelaxed)) > 0);
 
-			return x_uRef.Decrement(kAtomicRelaxed) == 0;
+			return x_uRef.Decrement(kAtomicAcqRel) == 0;
 		}
 	};
 
@@ -0,0 +1,56 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_BARRIER_HPP_
+#define MCF_THREAD_BARRIER_HPP_
+
+#include "../Core/Atomic.hpp"
+#include <MCFCRT/env/barrier.h>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+namespace MCF {
+
+// 可重复使用的屏障。每一轮中所有线程都到达之后才进入下一轮。
+
+class Barrier {
+public:
+	enum : std::size_t { kSuggestedSpinCount = _MCFCRT_BARRIER_SUGGESTED_SPIN_COUNT };
+
+private:
+	::_MCFCRT_Barrier x_vBarrier;
+	Atomic<std::size_t> x_uSpinCount;
+
+public:
+	explicit constexpr Barrier(std::uint32_t u32Threshold, std::size_t uSpinCount = kSuggestedSpinCount) noexcept
+		: x_vBarrier{ 0, 0, u32Threshold }, x_uSpinCount(uSpinCount)
+	{ }
+
+	Barrier(const Barrier &) = delete;
+	Barrier &operator=(const Barrier &) = delete;
+
+public:
+	std::size_t GetSpinCount() const noexcept {
+		return x_uSpinCount.Load(kAtomicRelaxed);
+	}
+	void SetSpinCount(std::size_t uSpinCount) noexcept {
+		x_uSpinCount.Store(uSpinCount, kAtomicRelaxed);
+	}
+
+	std::uint32_t GetThreshold() const noexcept {
+		return x_vBarrier.__u32Threshold;
+	}
+
+	// 每一轮中最后到达的线程获得 true，其余线程获得 false。
+	bool ArriveAndWait() noexcept {
+		return ::_MCFCRT_ArriveAtBarrierAndWait(&x_vBarrier, GetSpinCount());
+	}
+};
+
+static_assert(std::is_trivially_destructible<Barrier>::value, "Hey!");
+
+}
+
+#endif
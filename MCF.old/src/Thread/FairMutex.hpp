@@ -0,0 +1,66 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_FAIR_MUTEX_HPP_
+#define MCF_THREAD_FAIR_MUTEX_HPP_
+
+#include "../Core/Atomic.hpp"
+#include "UniqueLock.hpp"
+#include <MCFCRT/env/fair_mutex.h>
+#include <type_traits>
+#include <cstddef>
+
+namespace MCF {
+
+// 等待的线程按先进先出的顺序获得锁，适用于竞争激烈、需要限制等待时间的场合。竞争不激烈时 Mutex 更快。
+// 带超时的 Try() 不参与排队，而是在超时之前反复尝试。
+// 由一个线程锁定的互斥锁可以由另一个线程解锁。
+
+class FairMutex {
+public:
+	enum : std::size_t { kSuggestedSpinCount = _MCFCRT_FAIR_MUTEX_SUGGESTED_SPIN_COUNT };
+
+private:
+	::_MCFCRT_FairMutex x_vMutex;
+	Atomic<std::size_t> x_uSpinCount;
+
+public:
+	explicit constexpr FairMutex(std::size_t uSpinCount = kSuggestedSpinCount) noexcept
+		: x_vMutex{ nullptr, nullptr }, x_uSpinCount(uSpinCount)
+	{ }
+
+	FairMutex(const FairMutex &) = delete;
+	FairMutex &operator=(const FairMutex &) = delete;
+
+public:
+	std::size_t GetSpinCount() const noexcept {
+		return x_uSpinCount.Load(kAtomicRelaxed);
+	}
+	void SetSpinCount(std::size_t uSpinCount) noexcept {
+		x_uSpinCount.Store(uSpinCount, kAtomicRelaxed);
+	}
+
+	bool Try(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
+		return ::_MCFCRT_WaitForFairMutex(&x_vMutex, u64UntilFastMonoClock);
+	}
+	void Lock() noexcept {
+		::_MCFCRT_WaitForFairMutexForever(&x_vMutex, GetSpinCount());
+	}
+	void Unlock() noexcept {
+		::_MCFCRT_SignalFairMutex(&x_vMutex);
+	}
+
+	UniqueLock<FairMutex> TryGetLock(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
+		return UniqueLock<FairMutex>(*this, u64UntilFastMonoClock);
+	}
+	UniqueLock<FairMutex> GetLock() noexcept {
+		return UniqueLock<FairMutex>(*this);
+	}
+};
+
+static_assert(std::is_trivially_destructible<FairMutex>::value, "Hey!");
+
+}
+
+#endif
@@ -0,0 +1,255 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "FiberScheduler.hpp"
+#include "OnceFlag.hpp"
+#include "../Core/Exception.hpp"
+#include <MCFCRT/env/last_error.h>
+#include <MCFCRT/env/cpu.h>
+
+namespace MCF {
+
+namespace Impl_FiberScheduler {
+	namespace {
+		OnceFlag g_vLocalSlotOnce;
+		// 每个纤程的这个纤程局部存储槽中保存了指向对应的 SchedulerFiber 的指针。
+		Atomic<std::size_t> g_uLocalSlot(SIZE_MAX);
+
+		void RequireLocalSlot(){
+			g_vLocalSlotOnce.CallOnce([]{
+				std::size_t uSlot;
+				if(!::_MCFCRT_AllocFiberLocalSlot(&uSlot)){
+					MCF_THROW(Exception, ERROR_NOT_ENOUGH_MEMORY, Rcntws::View(L"FiberScheduler: _MCFCRT_AllocFiberLocalSlot() 失败。"));
+				}
+				g_uLocalSlot.Store(uSlot, kAtomicRelease);
+			});
+		}
+	}
+}
+
+SchedulerFiber::~SchedulerFiber(){ }
+
+template class IntrusivePtr<SchedulerFiber>;
+
+void SchedulerFiber::X_Run() noexcept {
+	try {
+		X_FiberProc();
+	} catch(...){
+		x_pException = std::current_exception();
+	}
+}
+
+bool SchedulerFiber::X_AddWaiter(SchedulerFiber *pWaiter) const noexcept {
+	pWaiter->x_bWaitWoken.Store(false, kAtomicRelaxed);
+	auto pFirst = x_pWaiterFirst.Load(kAtomicRelaxed);
+	do {
+		if(pFirst == this){
+			// 纤程已经结束。
+			return false;
+		}
+		pWaiter->x_pNextWaiter = pFirst;
+	} while(!x_pWaiterFirst.CompareExchange(pFirst, pWaiter, kAtomicRelease, kAtomicRelaxed));
+	// 现在链表持有这个引用。
+	pWaiter->Share().Release();
+	return true;
+}
+void SchedulerFiber::X_WakeWaiters() noexcept {
+	auto pWaiter = x_pWaiterFirst.Exchange(this, kAtomicAcqRel);
+	while(pWaiter){
+		// 接管链表持有的引用。等待者被唤醒之后可能会进入其他链表，因此要先读取下一个等待者。
+		const IntrusivePtr<SchedulerFiber> pHolder(pWaiter);
+		pWaiter = pHolder->x_pNextWaiter;
+		pHolder->x_bWaitWoken.Store(true, kAtomicRelease);
+		pHolder->Unpark();
+	}
+}
+
+void SchedulerFiber::Wait() const {
+	MCF_ASSERT_MSG(x_pScheduler, L"该纤程尚未被创建。");
+	const auto pWaiter = FiberScheduler::GetCurrentFiber();
+	if(pWaiter){
+		MCF_ASSERT_MSG(pWaiter != this, L"纤程不能等待自己。");
+		if(X_AddWaiter(pWaiter)){
+			// 其他线程或纤程也可能调用 Unpark()，因此要一直挂起，直到被目标纤程唤醒。
+			do {
+				FiberScheduler::ParkFiber();
+			} while(!pWaiter->x_bWaitWoken.Load(kAtomicAcquire));
+		}
+	} else {
+		x_vDone.Wait();
+	}
+	if(x_pException){
+		std::rethrow_exception(x_pException);
+	}
+}
+
+void SchedulerFiber::Unpark() noexcept {
+	MCF_ASSERT_MSG(x_pScheduler, L"该纤程尚未被创建。");
+	if(x_bPermit.Exchange(true, kAtomicSeqCst)){
+		return;
+	}
+	// 这个操作和 FiberScheduler::X_ThreadProc() 中挂起纤程的操作配对。两者中至少有一个能看到对方。
+	auto uState = static_cast<unsigned>(kStateParked);
+	if(!x_uState.CompareExchange(uState, kStateQueued, kAtomicSeqCst)){
+		return;
+	}
+	// 接管挂起的纤程持有的引用。
+	x_pScheduler->X_Enqueue(this);
+}
+
+FiberScheduler::FiberScheduler(std::size_t uThreadCount, std::size_t uStackSize)
+	: x_uStackSize(uStackSize ? uStackSize : _MCFCRT_FIBER_DEFAULT_STACK_SIZE)
+	, x_pQueueFirst(nullptr), x_pQueueLast(nullptr), x_uLiveCount(0), x_bStopping(false)
+{
+	Impl_FiberScheduler::RequireLocalSlot();
+
+	if(uThreadCount == 0){
+		uThreadCount = ::_MCFCRT_CpuGetLogicalProcessorCount();
+	}
+	try {
+		x_vecThreads.Reserve(uThreadCount);
+		for(std::size_t uIndex = 0; uIndex < uThreadCount; ++uIndex){
+			x_vecThreads.Push(MakeThread([this]{ X_ThreadProc(); }));
+		}
+	} catch(...){
+		X_Stop();
+		throw;
+	}
+}
+FiberScheduler::~FiberScheduler(){
+	X_Stop();
+}
+
+void FiberScheduler::X_NativeFiberProc(std::intptr_t nParam) noexcept {
+	const auto pFiber = reinterpret_cast<SchedulerFiber *>(nParam);
+	pFiber->X_Run();
+}
+
+void FiberScheduler::X_Enqueue(SchedulerFiber *pFiber) noexcept {
+	const auto vLock = x_mtxQueue.GetLock();
+	pFiber->x_pNextQueued = nullptr;
+	if(x_pQueueLast){
+		x_pQueueLast->x_pNextQueued = pFiber;
+	} else {
+		x_pQueueFirst = pFiber;
+	}
+	x_pQueueLast = pFiber;
+	x_cvQueue.Signal();
+}
+void FiberScheduler::X_ThreadProc() noexcept {
+	for(;;){
+		SchedulerFiber *pFiber;
+		{
+			auto vLock = x_mtxQueue.GetLock();
+			for(;;){
+				pFiber = x_pQueueFirst;
+				if(pFiber){
+					break;
+				}
+				if(x_bStopping && (x_uLiveCount == 0)){
+					return;
+				}
+				x_cvQueue.Wait(vLock);
+			}
+			x_pQueueFirst = pFiber->x_pNextQueued;
+			if(!x_pQueueFirst){
+				x_pQueueLast = nullptr;
+			}
+		}
+		// 接管队列持有的引用。
+		IntrusivePtr<SchedulerFiber> pHolder(pFiber);
+
+		pFiber->x_uState.Store(SchedulerFiber::kStateRunning, kAtomicRelaxed);
+		pFiber->x_eAction = SchedulerFiber::kActionNone;
+		if(::_MCFCRT_ResumeFiber(pFiber->x_hFiber.Get())){
+			pFiber->x_hFiber.Reset();
+			pFiber->x_vDone.CountDown();
+			pFiber->X_WakeWaiters();
+
+			const auto vLock = x_mtxQueue.GetLock();
+			--x_uLiveCount;
+			if(x_bStopping && (x_uLiveCount == 0)){
+				x_cvQueue.Broadcast();
+			}
+			continue;
+		}
+		switch(pFiber->x_eAction){
+		case SchedulerFiber::kActionYield:
+			pFiber->x_uState.Store(SchedulerFiber::kStateQueued, kAtomicRelaxed);
+			X_Enqueue(pHolder.Release());
+			break;
+		case SchedulerFiber::kActionPark:
+			// 挂起的纤程持有一个引用，它在纤程被 Unpark() 时被转交给队列。
+			pHolder.Release();
+			// 纤程已经切换回来，从现在起它可以被其他线程恢复。
+			pFiber->x_uState.Store(SchedulerFiber::kStateParked, kAtomicSeqCst);
+			if(pFiber->x_bPermit.Load(kAtomicSeqCst)){
+				auto uState = static_cast<unsigned>(SchedulerFiber::kStateParked);
+				if(pFiber->x_uState.CompareExchange(uState, SchedulerFiber::kStateQueued, kAtomicSeqCst)){
+					X_Enqueue(pFiber);
+				}
+			}
+			break;
+		default:
+			MCF_ASSERT_MSG(false, L"纤程在调度器之外让出了执行权。");
+		}
+	}
+}
+void FiberScheduler::X_Stop() noexcept {
+	{
+		const auto vLock = x_mtxQueue.GetLock();
+		x_bStopping = true;
+		x_cvQueue.Broadcast();
+	}
+	for(std::size_t uIndex = 0; uIndex < x_vecThreads.GetSize(); ++uIndex){
+		x_vecThreads[uIndex]->Wait();
+	}
+}
+
+void FiberScheduler::Spawn(IntrusivePtr<SchedulerFiber> pFiber){
+	MCF_ASSERT(pFiber);
+	MCF_ASSERT_MSG(!pFiber->x_pScheduler, L"该纤程已被创建过。");
+
+	if(!pFiber->x_hFiber.Reset(::_MCFCRT_CreateFiber(&X_NativeFiberProc, reinterpret_cast<std::intptr_t>(pFiber.Get()), x_uStackSize))){
+		MCF_THROW(Exception, ::_MCFCRT_GetLastError(), Rcntws::View(L"FiberScheduler: _MCFCRT_CreateFiber() 失败。"));
+	}
+	::_MCFCRT_SetFiberLocal(pFiber->x_hFiber.Get(), Impl_FiberScheduler::g_uLocalSlot.Load(kAtomicAcquire), reinterpret_cast<std::intptr_t>(pFiber.Get()));
+	pFiber->x_pScheduler = this;
+	{
+		const auto vLock = x_mtxQueue.GetLock();
+		++x_uLiveCount;
+	}
+	X_Enqueue(pFiber.Release());
+}
+
+SchedulerFiber *FiberScheduler::GetCurrentFiber() noexcept {
+	const auto uSlot = Impl_FiberScheduler::g_uLocalSlot.Load(kAtomicAcquire);
+	if(uSlot == SIZE_MAX){
+		return nullptr;
+	}
+	const auto hFiber = ::_MCFCRT_GetCurrentFiber();
+	if(!hFiber){
+		return nullptr;
+	}
+	return reinterpret_cast<SchedulerFiber *>(::_MCFCRT_GetFiberLocal(hFiber, uSlot));
+}
+void FiberScheduler::YieldFiber() noexcept {
+	const auto pFiber = GetCurrentFiber();
+	if(!pFiber){
+		YieldThread();
+		return;
+	}
+	pFiber->x_eAction = SchedulerFiber::kActionYield;
+	::_MCFCRT_YieldFiber();
+}
+void FiberScheduler::ParkFiber() noexcept {
+	const auto pFiber = GetCurrentFiber();
+	MCF_ASSERT_MSG(pFiber, L"当前线程没有在运行由调度器创建的纤程。");
+	while(!pFiber->x_bPermit.Exchange(false, kAtomicAcquire)){
+		pFiber->x_eAction = SchedulerFiber::kActionPark;
+		::_MCFCRT_YieldFiber();
+	}
+}
+
+}
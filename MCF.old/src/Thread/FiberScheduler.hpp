@@ -0,0 +1,186 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_FIBER_SCHEDULER_HPP_
+#define MCF_THREAD_FIBER_SCHEDULER_HPP_
+
+#include "../SmartPointers/IntrusivePtr.hpp"
+#include "../Core/UniqueHandle.hpp"
+#include "../Core/Atomic.hpp"
+#include "../Containers/Vector.hpp"
+#include "Thread.hpp"
+#include "Latch.hpp"
+#include "Mutex.hpp"
+#include "ConditionVariable.hpp"
+#include <MCFCRT/env/fiber.h>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace MCF {
+
+class FiberScheduler;
+
+namespace Impl_FiberScheduler {
+	using Handle = ::_MCFCRT_FiberHandle;
+
+	struct FiberCloser {
+		constexpr Handle operator()() const noexcept {
+			return nullptr;
+		}
+		void operator()(Handle hFiber) const noexcept {
+			::_MCFCRT_DestroyFiber(hFiber);
+		}
+	};
+}
+
+class SchedulerFiber : public IntrusiveBase<SchedulerFiber> {
+	friend FiberScheduler;
+
+private:
+	enum State : unsigned {
+		kStateRunning  = 0,
+		kStateParked   = 1,
+		kStateQueued   = 2,
+	};
+	enum Action : unsigned {
+		kActionNone    = 0,
+		kActionYield   = 1,
+		kActionPark    = 2,
+	};
+
+private:
+	FiberScheduler *x_pScheduler = nullptr;
+	SchedulerFiber *x_pNextQueued = nullptr;
+	UniqueHandle<Impl_FiberScheduler::FiberCloser> x_hFiber;
+	Atomic<unsigned> x_uState;
+	Atomic<bool> x_bPermit;
+	// 这个值由纤程在切换回调度器之前设置，由调度器在切换回来之后读取。
+	Action x_eAction = kActionNone;
+	mutable Latch x_vDone;
+	std::exception_ptr x_pException;
+
+	// 在这个纤程上等待的纤程组成一个单向链表，链表持有每个等待者的一个引用。
+	// 纤程结束时，链表头被置为指向纤程自己，此后的等待者不再进入链表。
+	mutable Atomic<SchedulerFiber *> x_pWaiterFirst;
+	// 以下两个值属于等待者。
+	SchedulerFiber *x_pNextWaiter = nullptr;
+	Atomic<bool> x_bWaitWoken;
+
+protected:
+	SchedulerFiber() noexcept
+		: x_uState(kStateQueued), x_bPermit(false), x_vDone(1), x_pWaiterFirst(nullptr), x_bWaitWoken(false)
+	{ }
+
+public:
+	virtual ~SchedulerFiber();
+
+protected:
+	virtual void X_FiberProc() = 0;
+
+private:
+	void X_Run() noexcept;
+	bool X_AddWaiter(SchedulerFiber *pWaiter) const noexcept;
+	void X_WakeWaiters() noexcept;
+
+public:
+	bool IsDone() const noexcept {
+		return x_vDone.IsReady();
+	}
+	// 如果在纤程中调用，当前纤程被挂起直到目标纤程结束，而不会阻塞所在的线程。
+	// 如果纤程抛出了异常，在纤程结束后重新抛出该异常。
+	void Wait() const;
+
+	// 如果纤程被挂起，使它重新被调度；否则使它下一次调用 FiberScheduler::ParkFiber() 时立即返回。
+	void Unpark() noexcept;
+};
+
+extern template class IntrusivePtr<SchedulerFiber>;
+
+namespace Impl_FiberScheduler {
+	template<typename FunctionT>
+	class ConcreteFiber final : public SchedulerFiber {
+	private:
+		std::decay_t<FunctionT> x_vFunction;
+
+	public:
+		explicit ConcreteFiber(FunctionT &vFunction)
+			: x_vFunction(std::forward<FunctionT>(vFunction))
+		{ }
+		~ConcreteFiber() override;
+
+	protected:
+		void X_FiberProc() override {
+			std::forward<FunctionT>(x_vFunction)();
+		}
+	};
+
+	template<typename FunctionT>
+	ConcreteFiber<FunctionT>::~ConcreteFiber(){ }
+}
+
+// 调度器把纤程分配到固定数量的线程上执行。就绪的纤程被放在一个公共队列中，空闲的线程从中取出纤程并恢复它们的执行。
+// 纤程是协作式调度的：纤程只在调用 YieldFiber() 或 ParkFiber() 时，或者纤程函数返回时，才会让出所在的线程。
+// 纤程每次可能在不同的线程上恢复执行，因此不能在纤程中使用线程局部存储，也不能在 catch 块中让出执行权。
+
+class FiberScheduler {
+	friend SchedulerFiber;
+
+private:
+	std::size_t x_uStackSize;
+	Vector<IntrusivePtr<Thread>> x_vecThreads;
+
+	mutable Mutex x_mtxQueue;
+	ConditionVariable x_cvQueue;
+	SchedulerFiber *x_pQueueFirst;
+	SchedulerFiber *x_pQueueLast;
+	std::size_t x_uLiveCount;
+	bool x_bStopping;
+
+public:
+	// 如果 uThreadCount 为零，创建与逻辑处理器数量相同的线程。如果 uStackSize 为零，使用 _MCFCRT_FIBER_DEFAULT_STACK_SIZE。
+	explicit FiberScheduler(std::size_t uThreadCount = 0, std::size_t uStackSize = 0);
+	// 析构函数等待所有纤程结束。
+	~FiberScheduler();
+
+	FiberScheduler(const FiberScheduler &) = delete;
+	FiberScheduler &operator=(const FiberScheduler &) = delete;
+
+private:
+	static void X_NativeFiberProc(std::intptr_t nParam) noexcept;
+
+	void X_Enqueue(SchedulerFiber *pFiber) noexcept;
+	void X_ThreadProc() noexcept;
+	void X_Stop() noexcept;
+
+public:
+	std::size_t GetThreadCount() const noexcept {
+		return x_vecThreads.GetSize();
+	}
+	std::size_t GetStackSize() const noexcept {
+		return x_uStackSize;
+	}
+
+	// 同一个纤程只能被创建一次。
+	void Spawn(IntrusivePtr<SchedulerFiber> pFiber);
+	template<typename FunctionT>
+	IntrusivePtr<SchedulerFiber> Spawn(FunctionT &&vFunction){
+		IntrusivePtr<SchedulerFiber> pFiber = MakeIntrusive<Impl_FiberScheduler::ConcreteFiber<FunctionT>>(vFunction);
+		Spawn(pFiber);
+		return pFiber;
+	}
+
+	// 如果当前线程不在运行由调度器创建的纤程，返回空指针。
+	static SchedulerFiber *GetCurrentFiber() noexcept;
+	// 把当前纤程放到就绪队列的末尾。如果当前线程不在运行由调度器创建的纤程，让出当前线程。
+	static void YieldFiber() noexcept;
+	// 挂起当前纤程，直到另一个线程或纤程调用它的 Unpark()。如果它已经被 Unpark() 过，这个函数立即返回。
+	static void ParkFiber() noexcept;
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_LATCH_HPP_
+#define MCF_THREAD_LATCH_HPP_
+
+#include <MCFCRT/env/latch.h>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+namespace MCF {
+
+// 一次性的倒数计数器。计数减到零时唤醒所有等待的线程，之后不能重置。
+
+class Latch {
+private:
+	::_MCFCRT_Latch x_vLatch;
+
+public:
+	explicit constexpr Latch(std::size_t uInitCount) noexcept
+		: x_vLatch{ uInitCount }
+	{ }
+
+	Latch(const Latch &) = delete;
+	Latch &operator=(const Latch &) = delete;
+
+public:
+	bool IsReady() const noexcept {
+		return ::_MCFCRT_IsLatchReady(&x_vLatch);
+	}
+	bool Wait(std::uint64_t u64UntilFastMonoClock) noexcept {
+		return ::_MCFCRT_WaitForLatch(&x_vLatch, u64UntilFastMonoClock);
+	}
+	void Wait() noexcept {
+		::_MCFCRT_WaitForLatchForever(&x_vLatch);
+	}
+	// 如果计数被本次调用减到零，返回 true。
+	bool CountDown(std::size_t uCount = 1) noexcept {
+		return ::_MCFCRT_CountDownLatch(&x_vLatch, uCount);
+	}
+	void CountDownAndWait(std::size_t uCount = 1) noexcept {
+		if(CountDown(uCount)){
+			return;
+		}
+		Wait();
+	}
+};
+
+static_assert(std::is_trivially_destructible<Latch>::value, "Hey!");
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "ParallelAlgorithms.hpp"
+#include "OnceFlag.hpp"
+#include <MCFCRT/env/cpu.h>
+
+namespace MCF {
+
+namespace Impl_ParallelAlgorithms {
+	namespace {
+		OnceFlag g_vPoolOnce;
+		ThreadPool *g_pPool;
+	}
+
+	ThreadPool &GetThreadPool(){
+		g_vPoolOnce.CallOnce([]{
+			// 线程池从不被销毁，否则进程退出时会等待仍在执行的任务。
+			g_pPool = new ThreadPool;
+		});
+		return *g_pPool;
+	}
+
+	std::size_t GetChunkSize(std::size_t uElementSize, std::size_t uCount){
+		std::size_t uCacheSize = 0x40000;
+		::_MCFCRT_CpuCacheInfo vCacheInfo;
+		if(::_MCFCRT_CpuGetCacheInfo(&vCacheInfo, ::_MCFCRT_kCpuCacheLevel2)){
+			// 超线程共享二级缓存，每个线程只能用到其中的一部分。
+			uCacheSize = vCacheInfo.__uSize / vCacheInfo.__uSharingCount;
+		}
+		// 每一块只占用二级缓存的一半，给函数对象自己的数据留出空间。
+		const auto uMaxByCache = uCacheSize / 2 / std::max<std::size_t>(uElementSize, 1);
+		// 块的数量至少是工作线程数量的四倍，以便空闲的工作线程可以窃取。
+		const auto uMaxByBalance = uCount / (GetThreadPool().GetWorkerCount() * 4);
+		return std::max<std::size_t>(std::min(uMaxByCache, uMaxByBalance), 1);
+	}
+}
+
+}
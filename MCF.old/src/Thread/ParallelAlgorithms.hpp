@@ -0,0 +1,227 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_PARALLEL_ALGORITHMS_HPP_
+#define MCF_THREAD_PARALLEL_ALGORITHMS_HPP_
+
+#include "ThreadPool.hpp"
+#include "../Core/ArrayView.hpp"
+#include "../Containers/Vector.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+namespace MCF {
+
+// 这些算法共享一个进程内的线程池，其工作线程数量与逻辑处理器数量相同。
+// 区间被递归地二分，直到每一块的大小不超过二级缓存的一半，并且每个工作线程至少能分到四块。
+// 如果多个块抛出了异常，只有其中一个会被重新抛出。
+
+namespace Impl_ParallelAlgorithms {
+	extern ThreadPool &GetThreadPool();
+	extern std::size_t GetChunkSize(std::size_t uElementSize, std::size_t uCount);
+
+	template<typename IteratorT>
+	IteratorT Advance(IteratorT itBase, std::size_t uOffset){
+		return itBase + static_cast<typename std::iterator_traits<IteratorT>::difference_type>(uOffset);
+	}
+
+	// 左侧被提交到线程池，右侧在当前线程中执行。
+	template<typename LeftT, typename RightT>
+	void ForkJoin(LeftT &&vLeft, RightT &&vRight){
+		const auto pTask = GetThreadPool().Submit([&]{ std::forward<LeftT>(vLeft)(); });
+		try {
+			std::forward<RightT>(vRight)();
+		} catch(...){
+			try {
+				pTask->Wait();
+			} catch(...){
+				// 丢弃左侧的异常。
+			}
+			throw;
+		}
+		pTask->Wait();
+	}
+
+	template<typename ChunkFunctionT>
+	void ForEachChunk(std::size_t uBegin, std::size_t uEnd, std::size_t uChunkSize, const ChunkFunctionT &vChunkFunction){
+		if(uEnd - uBegin <= uChunkSize){
+			vChunkFunction(uBegin, uEnd);
+			return;
+		}
+		const auto uMiddle = uBegin + (uEnd - uBegin) / 2;
+		ForkJoin([&]{ ForEachChunk(uBegin, uMiddle, uChunkSize, vChunkFunction); },
+		         [&]{ ForEachChunk(uMiddle, uEnd, uChunkSize, vChunkFunction); });
+	}
+
+	template<typename ValueT, typename ChunkFunctionT, typename CombineFunctionT>
+	ValueT ReduceChunks(std::size_t uBegin, std::size_t uEnd, std::size_t uChunkSize, const ValueT &vIdentity, const ChunkFunctionT &vChunkFunction, const CombineFunctionT &vCombineFunction){
+		if(uEnd - uBegin <= uChunkSize){
+			return vChunkFunction(uBegin, uEnd);
+		}
+		const auto uMiddle = uBegin + (uEnd - uBegin) / 2;
+		ValueT vLeft(vIdentity), vRight(vIdentity);
+		ForkJoin([&]{ vLeft = ReduceChunks(uBegin, uMiddle, uChunkSize, vIdentity, vChunkFunction, vCombineFunction); },
+		         [&]{ vRight = ReduceChunks(uMiddle, uEnd, uChunkSize, vIdentity, vChunkFunction, vCombineFunction); });
+		return vCombineFunction(std::move(vLeft), std::move(vRight));
+	}
+
+	// 把 [itFirst, itFirst + uFirstCount) 和 [itSecond, itSecond + uSecondCount) 两个有序区间合并到 itOutput 开始的区间中。
+	// 元素被移动而非复制。较长的区间在中点处被拆分，另一个区间在对应的位置被拆分，两部分被并行地合并。
+	template<typename InputIteratorT, typename OutputIteratorT, typename ComparatorT>
+	void Merge(InputIteratorT itFirst, std::size_t uFirstCount, InputIteratorT itSecond, std::size_t uSecondCount, OutputIteratorT itOutput, std::size_t uChunkSize, const ComparatorT &vComparator){
+		if(uFirstCount + uSecondCount <= uChunkSize){
+			std::merge(std::make_move_iterator(itFirst), std::make_move_iterator(Advance(itFirst, uFirstCount)),
+				std::make_move_iterator(itSecond), std::make_move_iterator(Advance(itSecond, uSecondCount)), itOutput, vComparator);
+			return;
+		}
+		if(uFirstCount < uSecondCount){
+			using std::swap;
+			swap(itFirst, itSecond);
+			swap(uFirstCount, uSecondCount);
+		}
+		const auto uFirstSplit = uFirstCount / 2;
+		const auto uSecondSplit = static_cast<std::size_t>(std::lower_bound(itSecond, Advance(itSecond, uSecondCount), *Advance(itFirst, uFirstSplit), vComparator) - itSecond);
+		ForkJoin([&]{ Merge(itFirst, uFirstSplit, itSecond, uSecondSplit, itOutput, uChunkSize, vComparator); },
+		         [&]{ Merge(Advance(itFirst, uFirstSplit), uFirstCount - uFirstSplit, Advance(itSecond, uSecondSplit), uSecondCount - uSecondSplit,
+		                    Advance(itOutput, uFirstSplit + uSecondSplit), uChunkSize, vComparator); });
+	}
+
+	// 待排序的元素总是位于 itData 开始的区间中，itScratch 开始的区间用于暂存。
+	// 如果 bResultInData 为 true，排序的结果被存放在 itData 开始的区间中，否则被存放在 itScratch 开始的区间中。
+	template<typename DataIteratorT, typename ScratchIteratorT, typename ComparatorT>
+	void Sort(DataIteratorT itData, ScratchIteratorT itScratch, std::size_t uCount, bool bResultInData, std::size_t uChunkSize, const ComparatorT &vComparator){
+		if(uCount <= uChunkSize){
+			std::sort(itData, Advance(itData, uCount), vComparator);
+			if(!bResultInData){
+				std::move(itData, Advance(itData, uCount), itScratch);
+			}
+			return;
+		}
+		const auto uHalf = uCount / 2;
+		ForkJoin([&]{ Sort(itData, itScratch, uHalf, !bResultInData, uChunkSize, vComparator); },
+		         [&]{ Sort(Advance(itData, uHalf), Advance(itScratch, uHalf), uCount - uHalf, !bResultInData, uChunkSize, vComparator); });
+		if(bResultInData){
+			Merge(itScratch, uHalf, Advance(itScratch, uHalf), uCount - uHalf, itData, uChunkSize, vComparator);
+		} else {
+			Merge(itData, uHalf, Advance(itData, uHalf), uCount - uHalf, itScratch, uChunkSize, vComparator);
+		}
+	}
+}
+
+// 对 [uBegin, uEnd) 中的每个下标调用 vFunction(uIndex)。
+// 下标本身不占用缓存，uBytesPerIndex 是每次调用访问的数据的大小，用于确定块的大小。默认每次调用访问一个缓存行。
+template<typename IndexT, typename FunctionT,
+	std::enable_if_t<
+		std::is_integral<IndexT>::value,
+		int> = 0>
+void ParallelFor(IndexT tBegin, IndexT tEnd, FunctionT &&vFunction, std::size_t uBytesPerIndex = _MCFCRT_CACHE_LINE_SIZE){
+	if(tEnd <= tBegin){
+		return;
+	}
+	const auto uCount = static_cast<std::size_t>(tEnd - tBegin);
+	const auto uChunkSize = Impl_ParallelAlgorithms::GetChunkSize(uBytesPerIndex, uCount);
+	Impl_ParallelAlgorithms::ForEachChunk(0, uCount, uChunkSize,
+		[&](std::size_t uChunkBegin, std::size_t uChunkEnd){
+			for(auto uIndex = uChunkBegin; uIndex < uChunkEnd; ++uIndex){
+				vFunction(static_cast<IndexT>(tBegin + static_cast<IndexT>(uIndex)));
+			}
+		});
+}
+// 对 [itBegin, itEnd) 中的每个元素调用 vFunction(vElement)。迭代器必须是随机访问的。
+template<typename IteratorT, typename FunctionT,
+	std::enable_if_t<
+		!std::is_integral<IteratorT>::value,
+		int> = 0>
+void ParallelFor(IteratorT itBegin, IteratorT itEnd, FunctionT &&vFunction){
+	if(!(itBegin < itEnd)){
+		return;
+	}
+	const auto uCount = static_cast<std::size_t>(itEnd - itBegin);
+	const auto uChunkSize = Impl_ParallelAlgorithms::GetChunkSize(sizeof(*itBegin), uCount);
+	Impl_ParallelAlgorithms::ForEachChunk(0, uCount, uChunkSize,
+		[&](std::size_t uChunkBegin, std::size_t uChunkEnd){
+			const auto itChunkEnd = Impl_ParallelAlgorithms::Advance(itBegin, uChunkEnd);
+			for(auto it = Impl_ParallelAlgorithms::Advance(itBegin, uChunkBegin); it != itChunkEnd; ++it){
+				vFunction(*it);
+			}
+		});
+}
+template<typename ElementT, typename FunctionT>
+void ParallelFor(const ArrayView<ElementT> &avRange, FunctionT &&vFunction){
+	ParallelFor(avRange.GetBegin(), avRange.GetEnd(), std::forward<FunctionT>(vFunction));
+}
+template<typename ElementT, class AllocatorT, typename FunctionT>
+void ParallelFor(Vector<ElementT, AllocatorT> &vecRange, FunctionT &&vFunction){
+	ParallelFor(vecRange.GetData(), vecRange.GetData() + vecRange.GetSize(), std::forward<FunctionT>(vFunction));
+}
+template<typename ElementT, class AllocatorT, typename FunctionT>
+void ParallelFor(const Vector<ElementT, AllocatorT> &vecRange, FunctionT &&vFunction){
+	ParallelFor(vecRange.GetData(), vecRange.GetData() + vecRange.GetSize(), std::forward<FunctionT>(vFunction));
+}
+
+// 每一块的结果以 vIdentity 为初值，通过 vAccumulate(std::move(vResult), vElement) 累加得到，各块的结果通过 vCombine(std::move(vLeft), std::move(vRight)) 合并。
+// 合并的顺序与元素的顺序一致，因此 vCombine 只需满足结合律，但 vIdentity 必须是它的单位元。
+template<typename IteratorT, typename ValueT, typename AccumulateFunctionT, typename CombineFunctionT>
+ValueT ParallelReduce(IteratorT itBegin, IteratorT itEnd, ValueT vIdentity, AccumulateFunctionT &&vAccumulate, CombineFunctionT &&vCombine){
+	if(!(itBegin < itEnd)){
+		return vIdentity;
+	}
+	const auto uCount = static_cast<std::size_t>(itEnd - itBegin);
+	const auto uChunkSize = Impl_ParallelAlgorithms::GetChunkSize(sizeof(*itBegin), uCount);
+	return Impl_ParallelAlgorithms::ReduceChunks(0, uCount, uChunkSize, vIdentity,
+		[&](std::size_t uChunkBegin, std::size_t uChunkEnd){
+			ValueT vResult(vIdentity);
+			const auto itChunkEnd = Impl_ParallelAlgorithms::Advance(itBegin, uChunkEnd);
+			for(auto it = Impl_ParallelAlgorithms::Advance(itBegin, uChunkBegin); it != itChunkEnd; ++it){
+				vResult = vAccumulate(std::move(vResult), *it);
+			}
+			return vResult;
+		},
+		vCombine);
+}
+template<typename IteratorT, typename ValueT, typename FunctionT>
+ValueT ParallelReduce(IteratorT itBegin, IteratorT itEnd, ValueT vIdentity, FunctionT &&vFunction){
+	return ParallelReduce(itBegin, itEnd, std::move(vIdentity), vFunction, vFunction);
+}
+template<typename ElementT, typename ValueT, typename ...FunctionsT>
+ValueT ParallelReduce(const ArrayView<ElementT> &avRange, ValueT vIdentity, FunctionsT &&...vFunctions){
+	return ParallelReduce(avRange.GetBegin(), avRange.GetEnd(), std::move(vIdentity), std::forward<FunctionsT>(vFunctions)...);
+}
+template<typename ElementT, class AllocatorT, typename ValueT, typename ...FunctionsT>
+ValueT ParallelReduce(const Vector<ElementT, AllocatorT> &vecRange, ValueT vIdentity, FunctionsT &&...vFunctions){
+	return ParallelReduce(vecRange.GetData(), vecRange.GetData() + vecRange.GetSize(), std::move(vIdentity), std::forward<FunctionsT>(vFunctions)...);
+}
+
+// 并行归并排序。排序是不稳定的。需要一个与区间等长的临时缓冲区，元素只被移动，不被复制。
+template<typename IteratorT, typename ComparatorT = std::less<>>
+void ParallelSort(IteratorT itBegin, IteratorT itEnd, ComparatorT &&vComparator = ComparatorT()){
+	if(!(itBegin < itEnd)){
+		return;
+	}
+	const auto uCount = static_cast<std::size_t>(itEnd - itBegin);
+	const auto uChunkSize = Impl_ParallelAlgorithms::GetChunkSize(sizeof(*itBegin), uCount);
+	if(uCount <= uChunkSize){
+		std::sort(itBegin, itEnd, vComparator);
+		return;
+	}
+	// 元素被移入缓冲区并在那里排序，合并的结果最终被移回原来的区间。
+	Vector<typename std::iterator_traits<IteratorT>::value_type> vecScratch(std::make_move_iterator(itBegin), std::make_move_iterator(itEnd));
+	Impl_ParallelAlgorithms::Sort(vecScratch.GetData(), itBegin, uCount, false, std::max<std::size_t>(uChunkSize, 2), vComparator);
+}
+template<typename ElementT, typename ...ComparatorT>
+void ParallelSort(const ArrayView<ElementT> &avRange, ComparatorT &&...vComparator){
+	ParallelSort(avRange.GetBegin(), avRange.GetEnd(), std::forward<ComparatorT>(vComparator)...);
+}
+template<typename ElementT, class AllocatorT, typename ...ComparatorT>
+void ParallelSort(Vector<ElementT, AllocatorT> &vecRange, ComparatorT &&...vComparator){
+	ParallelSort(vecRange.GetData(), vecRange.GetData() + vecRange.GetSize(), std::forward<ComparatorT>(vComparator)...);
+}
+
+}
+
+#endif
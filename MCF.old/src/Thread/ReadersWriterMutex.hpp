@@ -5,14 +5,20 @@
 #ifndef MCF_THREAD_READER_WRITER_MUTEX_HPP_
 #define MCF_THREAD_READER_WRITER_MUTEX_HPP_
 
-#include "Mutex.hpp"
 #include "../Core/Atomic.hpp"
+#include "UniqueLock.hpp"
+#include <MCFCRT/env/rwlock.h>
+#include <type_traits>
+#include <cstddef>
 
 namespace MCF {
 
+// 写者优先：一旦有写者在等待，新的读者就会被阻塞。不可递归锁定。
+// UpgradeToWriter() 在有其他线程正在升级时返回 false，此时调用者仍然持有读锁。
+
 class ReadersWriterMutex {
 public:
-	enum : std::size_t { kSuggestedSpinCount = Mutex::kSuggestedSpinCount };
+	enum : std::size_t { kSuggestedSpinCount = _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT };
 
 	struct MutexTraitsAsReader {
 		static bool Try(ReadersWriterMutex *pMutex, std::uint64_t u64UntilFastMonoClock){
@@ -38,13 +44,12 @@ public:
 	};
 
 private:
-	Mutex x_mtxReaderGuard;
-	Mutex x_mtxExclusive;
-	Atomic<std::size_t> x_uReaderCount;
+	::_MCFCRT_RwLock x_vLock;
+	Atomic<std::size_t> x_uSpinCount;
 
 public:
 	explicit constexpr ReadersWriterMutex(std::size_t uSpinCount = kSuggestedSpinCount) noexcept
-		: x_mtxReaderGuard(kSuggestedSpinCount), x_mtxExclusive(uSpinCount), x_uReaderCount(0)
+		: x_vLock{ 0 }, x_uSpinCount(uSpinCount)
 	{ }
 
 	ReadersWriterMutex(const ReadersWriterMutex &) = delete;
@@ -52,15 +57,21 @@ public:
 
 public:
 	std::size_t GetSpinCount() const noexcept {
-		return x_mtxExclusive.GetSpinCount();
+		return x_uSpinCount.Load(kAtomicRelaxed);
 	}
 	void SetSpinCount(std::size_t uSpinCount) noexcept {
-		x_mtxExclusive.SetSpinCount(uSpinCount);
+		x_uSpinCount.Store(uSpinCount, kAtomicRelaxed);
 	}
 
-	bool TryAsReader(std::uint64_t u64UntilFastMonoClock = 0) noexcept;
-	void LockAsReader() noexcept;
-	void UnlockAsReader() noexcept;
+	bool TryAsReader(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
+		return ::_MCFCRT_WaitForRwLockShared(&x_vLock, GetSpinCount(), u64UntilFastMonoClock);
+	}
+	void LockAsReader() noexcept {
+		::_MCFCRT_WaitForRwLockSharedForever(&x_vLock, GetSpinCount());
+	}
+	void UnlockAsReader() noexcept {
+		::_MCFCRT_SignalRwLockShared(&x_vLock);
+	}
 
 	UniqueLock<ReadersWriterMutex, MutexTraitsAsReader> TryGetLockAsReader(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
 		return UniqueLock<ReadersWriterMutex, MutexTraitsAsReader>(*this, u64UntilFastMonoClock);
@@ -69,9 +80,15 @@ public:
 		return UniqueLock<ReadersWriterMutex, MutexTraitsAsReader>(*this);
 	}
 
-	bool TryAsWriter(std::uint64_t u64UntilFastMonoClock = 0) noexcept;
-	void LockAsWriter() noexcept;
-	void UnlockAsWriter() noexcept;
+	bool TryAsWriter(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
+		return ::_MCFCRT_WaitForRwLockExclusive(&x_vLock, GetSpinCount(), u64UntilFastMonoClock);
+	}
+	void LockAsWriter() noexcept {
+		::_MCFCRT_WaitForRwLockExclusiveForever(&x_vLock, GetSpinCount());
+	}
+	void UnlockAsWriter() noexcept {
+		::_MCFCRT_SignalRwLockExclusive(&x_vLock);
+	}
 
 	UniqueLock<ReadersWriterMutex, MutexTraitsAsWriter> TryGetLockAsWriter(std::uint64_t u64UntilFastMonoClock = 0) noexcept {
 		return UniqueLock<ReadersWriterMutex, MutexTraitsAsWriter>(*this, u64UntilFastMonoClock);
@@ -79,6 +96,13 @@ public:
 	UniqueLock<ReadersWriterMutex, MutexTraitsAsWriter> GetLockAsWriter() noexcept {
 		return UniqueLock<ReadersWriterMutex, MutexTraitsAsWriter>(*this);
 	}
+
+	bool UpgradeToWriter() noexcept {
+		return ::_MCFCRT_UpgradeRwLock(&x_vLock, GetSpinCount());
+	}
+	void DowngradeToReader() noexcept {
+		::_MCFCRT_DowngradeRwLock(&x_vLock);
+	}
 };
 
 static_assert(std::is_trivially_destructible<ReadersWriterMutex>::value, "Hey!");
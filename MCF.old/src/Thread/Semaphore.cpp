@@ -1,36 +0,0 @@
-// 这个文件是 MCF 的一部分。
-// 有关具体授权说明，请参阅 MCFLicense.txt。
-// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
-
-#include "Semaphore.hpp"
-
-namespace MCF {
-
-bool Semaphore::Wait(std::uint64_t u64UntilFastMonoClock) noexcept {
-	auto vLock = x_mtxGuard.GetLock();
-	while(x_uCount == 0){
-		if(!x_cvWaiter.WaitOrAbandon(vLock, u64UntilFastMonoClock)){
-			return false;
-		}
-	}
-	--x_uCount;
-	return true;
-}
-void Semaphore::Wait() noexcept {
-	auto vLock = x_mtxGuard.GetLock();
-	while(x_uCount == 0){
-		x_cvWaiter.Wait(vLock);
-	}
-	--x_uCount;
-}
-std::size_t Semaphore::Post(std::size_t uPostCount) noexcept {
-	auto vLock = x_mtxGuard.GetLock();
-	const auto uOldCount = x_uCount;
-	const auto uNewCount = uOldCount + uPostCount;
-	MCF_DEBUG_CHECK_MSG(uNewCount >= uOldCount, L"算术运算结果超出可表示范围。");
-	x_uCount = uNewCount;
-	x_cvWaiter.Signal(uPostCount);
-	return uOldCount;
-}
-
-}
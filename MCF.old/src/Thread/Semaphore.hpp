@@ -5,32 +5,55 @@
 #ifndef MCF_THREAD_SEMAPHORE_HPP_
 #define MCF_THREAD_SEMAPHORE_HPP_
 
-#include "Mutex.hpp"
-#include "ConditionVariable.hpp"
+#include "../Core/Atomic.hpp"
+#include "../Core/Assert.hpp"
+#include <MCFCRT/env/semaphore.h>
 #include <type_traits>
 #include <cstddef>
 #include <cstdint>
 
 namespace MCF {
 
+// 在没有线程需要睡眠时，Wait() 和 Post() 都不加锁。
+
 class Semaphore {
+public:
+	enum : std::size_t { kSuggestedSpinCount = _MCFCRT_SEMAPHORE_SUGGESTED_SPIN_COUNT };
+
 private:
-	mutable Mutex x_mtxGuard;
-	mutable ConditionVariable x_cvWaiter;
-	std::size_t x_uCount;
+	::_MCFCRT_Semaphore x_vSemaphore;
+	Atomic<std::size_t> x_uSpinCount;
 
 public:
-	explicit constexpr Semaphore(std::size_t uInitCount) noexcept
-		: x_mtxGuard(), x_cvWaiter(), x_uCount(uInitCount)
+	explicit constexpr Semaphore(std::size_t uInitCount, std::size_t uSpinCount = kSuggestedSpinCount) noexcept
+		: x_vSemaphore{ uInitCount, 0 }, x_uSpinCount(uSpinCount)
 	{ }
 
 	Semaphore(const Semaphore &) = delete;
 	Semaphore &operator=(const Semaphore &) = delete;
 
 public:
-	bool Wait(std::uint64_t u64UntilFastMonoClock) noexcept;
-	void Wait() noexcept;
-	std::size_t Post(std::size_t uPostCount = 1) noexcept;
+	std::size_t GetSpinCount() const noexcept {
+		return x_uSpinCount.Load(kAtomicRelaxed);
+	}
+	void SetSpinCount(std::size_t uSpinCount) noexcept {
+		x_uSpinCount.Store(uSpinCount, kAtomicRelaxed);
+	}
+
+	bool Wait(std::uint64_t u64UntilFastMonoClock) noexcept {
+		return ::_MCFCRT_WaitForSemaphore(&x_vSemaphore, GetSpinCount(), u64UntilFastMonoClock);
+	}
+	void Wait() noexcept {
+		::_MCFCRT_WaitForSemaphoreForever(&x_vSemaphore, GetSpinCount());
+	}
+	std::size_t Post(std::size_t uPostCount = 1) noexcept {
+		// 计数溢出时不修改信号量，以免其他线程看到回绕之后的计数。
+		std::size_t uOldCount;
+		const bool bPosted = ::_MCFCRT_TryPostSemaphore(&x_vSemaphore, &uOldCount, uPostCount);
+		MCF_DEBUG_CHECK_MSG(bPosted, L"算术运算结果超出可表示范围。");
+		static_cast<void>(bPosted);
+		return uOldCount;
+	}
 };
 
 static_assert(std::is_trivially_destructible<Semaphore>::value, "Hey!");
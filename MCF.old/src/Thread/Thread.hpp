@@ -92,7 +92,7 @@ namespace Impl_Thread {
 	template<typename FunctionT>
 	class ConcreteThread final : public Thread {
 	private:
-		std::decay_t<FunctionT> x_vFunction;
+		mutable std::decay_t<FunctionT> x_vFunction;
 
 	public:
 		ConcreteThread(FunctionT &vFunction, bool bSuspended)
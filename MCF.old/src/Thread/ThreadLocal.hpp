@@ -12,6 +12,7 @@
 #include "../Core/ConstructDestruct.hpp"
 #include "../Core/ReconstructOrAssign.hpp"
 #include <MCFCRT/pre/tls.h>
+#include <MCFCRT/env/heap.h>
 #include <MCFCRT/env/last_error.h>
 #include <type_traits>
 #include <cstddef>
@@ -21,7 +22,7 @@ namespace MCF {
 
 template<typename ElementT>
 class ThreadLocal {
-	static_assert(alignof(ElementT) <= alignof(std::max_align_t), "ElementT is over-aligned.");
+	static_assert(alignof(ElementT) <= _MCFCRT_HEAP_MAX_ALIGNMENT, "ElementT is over-aligned.");
 
 private:
 	struct X_TlsKeyDeleter {
@@ -58,9 +59,9 @@ private:
 
 public:
 	explicit ThreadLocal(){
-		const auto hTemp = ::_MCFCRT_TlsAllocKey(sizeof(X_TlsContainer), nullptr, &X_ContainerDestructor, 0);
+		const auto hTemp = ::_MCFCRT_TlsAllocKeyAligned(sizeof(X_TlsContainer), alignof(X_TlsContainer), nullptr, &X_ContainerDestructor, 0);
 		if(!hTemp){
-			MCF_THROW(Exception, ::_MCFCRT_GetLastWin32Error(), Rcntws::View(L"ThreadLocal: _MCFCRT_TlsAllocKey() 失败。"));
+			MCF_THROW(Exception, ::_MCFCRT_GetLastError(), Rcntws::View(L"ThreadLocal: _MCFCRT_TlsAllocKeyAligned() 失败。"));
 		}
 		x_hTlsKey.Reset(hTemp);
 	}
@@ -87,7 +88,7 @@ public:
 		void *pContainerRaw;
 		const bool bResult = ::_MCFCRT_TlsRequire(x_hTlsKey.Get(), &pContainerRaw);
 		if(!bResult){
-			MCF_THROW(Exception, ::_MCFCRT_GetLastWin32Error(), Rcntws::View(L"ThreadLocal: _MCFCRT_TlsRequire() 失败。"));
+			MCF_THROW(Exception, ::_MCFCRT_GetLastError(), Rcntws::View(L"ThreadLocal: _MCFCRT_TlsRequire() 失败。"));
 		}
 		const auto pContainer = static_cast<X_TlsContainer *>(pContainerRaw);
 		MCF_ASSERT(pContainer);
@@ -0,0 +1,363 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "ThreadPool.hpp"
+#include "Thread.hpp"
+#include "../Core/Clocks.hpp"
+#include <MCFCRT/env/wait_on_address.h>
+#include <MCFCRT/env/cpu.h>
+
+namespace MCF {
+
+namespace {
+	// 等待任务的工作线程在自旋之后每次睡眠这么长时间，然后重新查找其他任务。
+	constexpr std::uint64_t kHelpSleepMilliseconds = 1;
+}
+
+namespace Impl_ThreadPool {
+	// 参考文献：
+	//   David Chase, Yossi Lev. Dynamic Circular Work-Stealing Deque. SPAA 2005.
+	//   Nhat Minh Lê, Antoniu Pop, Albert Cohen, Francesco Zappa Nardelli. Correct and Efficient Work-Stealing for Weak Memory Models. PPoPP 2013.
+	// 只有所有者可以在尾部压入和弹出元素，其他线程只能从头部窃取元素。
+	class WorkStealingDeque {
+	private:
+		struct X_Buffer {
+			std::size_t uMask;
+			UniquePtr<Atomic<ThreadPoolTask *> [], DefaultDeleter<Atomic<ThreadPoolTask *> []>> pSlots;
+			// 窃取者可能仍在读取被替换的缓冲区，因此它们在队列析构之前不会被释放。
+			X_Buffer *pRetired;
+		};
+
+		enum : std::size_t { kInitCapacity = 256 };
+
+	private:
+		alignas(64) Atomic<std::ptrdiff_t> x_nTop;
+		alignas(64) Atomic<std::ptrdiff_t> x_nBottom;
+		Atomic<X_Buffer *> x_pBuffer;
+
+	public:
+		WorkStealingDeque()
+			: x_nTop(0), x_nBottom(0)
+		{
+			auto pBuffer = MakeUnique<X_Buffer>();
+			pBuffer->uMask = kInitCapacity - 1;
+			pBuffer->pSlots.Reset(new Atomic<ThreadPoolTask *>[kInitCapacity]);
+			pBuffer->pRetired = nullptr;
+			x_pBuffer.Store(pBuffer.Release(), kAtomicRelaxed);
+		}
+		~WorkStealingDeque(){
+			MCF_ASSERT(IsEmpty());
+
+			auto pBuffer = x_pBuffer.Load(kAtomicRelaxed);
+			while(pBuffer){
+				const auto pRetired = pBuffer->pRetired;
+				delete pBuffer;
+				pBuffer = pRetired;
+			}
+		}
+
+	private:
+		X_Buffer *X_Grow(X_Buffer *pOldBuffer, std::ptrdiff_t nTop, std::ptrdiff_t nBottom){
+			const auto uNewCapacity = (pOldBuffer->uMask + 1) * 2;
+			auto pBuffer = MakeUnique<X_Buffer>();
+			pBuffer->uMask = uNewCapacity - 1;
+			pBuffer->pSlots.Reset(new Atomic<ThreadPoolTask *>[uNewCapacity]);
+			for(auto nIndex = nTop; nIndex < nBottom; ++nIndex){
+				const auto pTask = pOldBuffer->pSlots[static_cast<std::size_t>(nIndex) & pOldBuffer->uMask].Load(kAtomicRelaxed);
+				pBuffer->pSlots[static_cast<std::size_t>(nIndex) & pBuffer->uMask].Store(pTask, kAtomicRelaxed);
+			}
+			pBuffer->pRetired = pOldBuffer;
+			x_pBuffer.Store(pBuffer.Get(), kAtomicRelease);
+			return pBuffer.Release();
+		}
+
+	public:
+		bool IsEmpty() const noexcept {
+			return x_nBottom.Load(kAtomicRelaxed) <= x_nTop.Load(kAtomicRelaxed);
+		}
+
+		// 以下两个函数只能由所有者调用。
+		void Push(ThreadPoolTask *pTask){
+			const auto nBottom = x_nBottom.Load(kAtomicRelaxed);
+			const auto nTop = x_nTop.Load(kAtomicAcquire);
+			auto pBuffer = x_pBuffer.Load(kAtomicRelaxed);
+			if(static_cast<std::size_t>(nBottom - nTop) > pBuffer->uMask){
+				pBuffer = X_Grow(pBuffer, nTop, nBottom);
+			}
+			pBuffer->pSlots[static_cast<std::size_t>(nBottom) & pBuffer->uMask].Store(pTask, kAtomicRelaxed);
+			x_nBottom.Store(nBottom + 1, kAtomicRelease);
+		}
+		ThreadPoolTask *Pop() noexcept {
+			const auto nBottom = x_nBottom.Load(kAtomicRelaxed) - 1;
+			const auto pBuffer = x_pBuffer.Load(kAtomicRelaxed);
+			x_nBottom.Store(nBottom, kAtomicRelaxed);
+			AtomicFence(kAtomicSeqCst);
+			auto nTop = x_nTop.Load(kAtomicRelaxed);
+			if(nTop > nBottom){
+				// 队列为空。
+				x_nBottom.Store(nBottom + 1, kAtomicRelaxed);
+				return nullptr;
+			}
+			auto pTask = pBuffer->pSlots[static_cast<std::size_t>(nBottom) & pBuffer->uMask].Load(kAtomicRelaxed);
+			if(nTop == nBottom){
+				// 这是最后一个元素，可能有窃取者在和我们竞争。
+				if(!x_nTop.CompareExchange(nTop, nTop + 1, kAtomicSeqCst, kAtomicRelaxed)){
+					pTask = nullptr;
+				}
+				x_nBottom.Store(nBottom + 1, kAtomicRelaxed);
+			}
+			return pTask;
+		}
+
+		// 这个函数可以由任何线程调用。如果因为和其他线程竞争而失败，bContended 被置为 true。
+		ThreadPoolTask *Steal(bool &bContended) noexcept {
+			auto nTop = x_nTop.Load(kAtomicAcquire);
+			AtomicFence(kAtomicSeqCst);
+			const auto nBottom = x_nBottom.Load(kAtomicAcquire);
+			if(nTop >= nBottom){
+				return nullptr;
+			}
+			const auto pBuffer = x_pBuffer.Load(kAtomicConsume);
+			const auto pTask = pBuffer->pSlots[static_cast<std::size_t>(nTop) & pBuffer->uMask].Load(kAtomicRelaxed);
+			if(!x_nTop.CompareExchange(nTop, nTop + 1, kAtomicSeqCst, kAtomicRelaxed)){
+				bContended = true;
+				return nullptr;
+			}
+			return pTask;
+		}
+	};
+
+	struct alignas(64) Worker {
+		WorkStealingDeque vDeque;
+		std::uint32_t u32Seed;
+		IntrusivePtr<Thread> pThread;
+	};
+
+	void WorkerArrayDeleter::operator()(Worker *pWorkers) const noexcept {
+		delete[] pWorkers;
+	}
+}
+
+ThreadPoolTask::~ThreadPoolTask(){ }
+
+template class IntrusivePtr<ThreadPoolTask>;
+
+void ThreadPoolTask::X_Execute() noexcept {
+	try {
+		X_Run();
+	} catch(...){
+		x_pException = std::current_exception();
+	}
+	x_vDone.CountDown();
+}
+
+bool ThreadPoolTask::Wait(std::uint64_t u64UntilFastMonoClock) const {
+	MCF_ASSERT_MSG(x_pPool, L"该任务尚未被提交。");
+	if(!x_pPool->X_HelpUntilDone(this, true, u64UntilFastMonoClock)){
+		if(!x_vDone.Wait(u64UntilFastMonoClock)){
+			return false;
+		}
+	}
+	if(x_pException){
+		std::rethrow_exception(x_pException);
+	}
+	return true;
+}
+void ThreadPoolTask::Wait() const {
+	MCF_ASSERT_MSG(x_pPool, L"该任务尚未被提交。");
+	if(!x_pPool->X_HelpUntilDone(this, false, UINT64_MAX)){
+		x_vDone.Wait();
+	}
+	if(x_pException){
+		std::rethrow_exception(x_pException);
+	}
+}
+
+ThreadPool::ThreadPool(std::size_t uWorkerCount, std::size_t uSpinCount)
+	: x_uWorkerCount(uWorkerCount ? uWorkerCount : ::_MCFCRT_CpuGetLogicalProcessorCount())
+	, x_pWorkers(new Impl_ThreadPool::Worker[x_uWorkerCount]), x_uSpinCount(uSpinCount)
+	, x_pInjectedFirst(nullptr), x_pInjectedLast(nullptr), x_uInjectedCount(0), x_u32WakeEpoch(0), x_uSleepingCount(0), x_bStopping(false)
+{
+	try {
+		for(std::size_t uIndex = 0; uIndex < x_uWorkerCount; ++uIndex){
+			const auto pWorker = &(x_pWorkers[uIndex]);
+			pWorker->u32Seed = static_cast<std::uint32_t>(uIndex + 1) * 0x9E3779B9u;
+			pWorker->pThread = MakeThread([this, pWorker]{ X_WorkerProc(pWorker); });
+		}
+	} catch(...){
+		X_Stop();
+		throw;
+	}
+}
+ThreadPool::~ThreadPool(){
+	// 工作线程在所有队列都为空之后才会退出。
+	X_Stop();
+}
+
+Impl_ThreadPool::Worker *ThreadPool::X_GetCurrentWorker() const noexcept {
+	const auto ppWorker = x_tlsCurrentWorker.Get();
+	if(!ppWorker){
+		return nullptr;
+	}
+	return *ppWorker;
+}
+ThreadPoolTask *ThreadPool::X_ShiftInjectedTask() noexcept {
+	const auto vLock = x_mtxInjected.GetLock();
+	const auto pTask = x_pInjectedFirst;
+	if(pTask){
+		x_pInjectedFirst = pTask->x_pNextInjected;
+		if(!x_pInjectedFirst){
+			x_pInjectedLast = nullptr;
+		}
+		x_uInjectedCount.Decrement(kAtomicRelaxed);
+	}
+	return pTask;
+}
+ThreadPoolTask *ThreadPool::X_FindTask(Impl_ThreadPool::Worker *pWorker) noexcept {
+	ThreadPoolTask *pTask;
+	if(pWorker){
+		pTask = pWorker->vDeque.Pop();
+		if(pTask){
+			return pTask;
+		}
+	}
+	if(x_uInjectedCount.Load(kAtomicRelaxed) != 0){
+		pTask = X_ShiftInjectedTask();
+		if(pTask){
+			return pTask;
+		}
+	}
+	// 从一个随机的工作线程开始，依次尝试窃取。如果所有的失败都是由于竞争，则重试。
+	std::size_t uStart = 0;
+	if(pWorker){
+		pWorker->u32Seed = pWorker->u32Seed * 1664525u + 1013904223u;
+		uStart = pWorker->u32Seed >> 8;
+	}
+	bool bContended;
+	do {
+		bContended = false;
+		for(std::size_t uOffset = 0; uOffset < x_uWorkerCount; ++uOffset){
+			const auto pVictim = &(x_pWorkers[(uStart + uOffset) % x_uWorkerCount]);
+			if(pVictim == pWorker){
+				continue;
+			}
+			pTask = pVictim->vDeque.Steal(bContended);
+			if(pTask){
+				return pTask;
+			}
+		}
+	} while(bContended);
+	return nullptr;
+}
+void ThreadPool::X_RunTask(ThreadPoolTask *pTask) noexcept {
+	// 接管队列持有的引用。
+	const IntrusivePtr<ThreadPoolTask> pHolder(pTask);
+	pTask->X_Execute();
+}
+void ThreadPool::X_WakeOneWorker() noexcept {
+	// 这个屏障和 X_WorkerProc() 中递增 x_uSleepingCount 之后的屏障配对。两者中至少有一个能看到对方。
+	AtomicFence(kAtomicSeqCst);
+	if(x_uSleepingCount.Load(kAtomicRelaxed) == 0){
+		return;
+	}
+	__atomic_add_fetch(&x_u32WakeEpoch, 1, __ATOMIC_SEQ_CST);
+	::_MCFCRT_WakeOneByAddress(&x_u32WakeEpoch);
+}
+void ThreadPool::X_WorkerProc(Impl_ThreadPool::Worker *pWorker) noexcept {
+	*(x_tlsCurrentWorker.Require()) = pWorker;
+
+	for(;;){
+		auto pTask = X_FindTask(pWorker);
+		for(std::size_t uSpinIndex = GetSpinCount(); !pTask && (uSpinIndex != 0); --uSpinIndex){
+			AtomicPause();
+			pTask = X_FindTask(pWorker);
+		}
+		if(!pTask){
+			const auto u32Epoch = __atomic_load_n(&x_u32WakeEpoch, __ATOMIC_ACQUIRE);
+			x_uSleepingCount.Increment(kAtomicRelaxed);
+			AtomicFence(kAtomicSeqCst);
+			pTask = X_FindTask(pWorker);
+			if(!pTask){
+				if(x_bStopping.Load(kAtomicAcquire)){
+					x_uSleepingCount.Decrement(kAtomicRelaxed);
+					break;
+				}
+				// 如果在此期间有工作线程被唤醒，这个函数立即返回。
+				::_MCFCRT_WaitOnAddressForever(&x_u32WakeEpoch, &u32Epoch, sizeof(u32Epoch));
+			}
+			x_uSleepingCount.Decrement(kAtomicRelaxed);
+			if(!pTask){
+				continue;
+			}
+		}
+		X_RunTask(pTask);
+	}
+}
+bool ThreadPool::X_HelpUntilDone(const ThreadPoolTask *pTask, bool bMayTimeOut, std::uint64_t u64UntilFastMonoClock) noexcept {
+	const auto pWorker = X_GetCurrentWorker();
+	if(!pWorker){
+		return false;
+	}
+	std::size_t uSpinIndex = 0;
+	while(!pTask->IsDone()){
+		if(bMayTimeOut && (GetFastMonoClock() >= u64UntilFastMonoClock)){
+			return false;
+		}
+		const auto pOtherTask = X_FindTask(pWorker);
+		if(pOtherTask){
+			X_RunTask(pOtherTask);
+			uSpinIndex = 0;
+			continue;
+		}
+		if(uSpinIndex < GetSpinCount()){
+			AtomicPause();
+			++uSpinIndex;
+			continue;
+		}
+		// 自旋之后仍然没有其他任务可执行，在任务完成之前睡眠。
+		// 睡眠的时间很短，因为此时提交的任务不会唤醒这个线程，醒来之后要重新查找任务。
+		auto u64WakeTime = GetFastMonoClock() + kHelpSleepMilliseconds;
+		if(bMayTimeOut && (u64WakeTime > u64UntilFastMonoClock)){
+			u64WakeTime = u64UntilFastMonoClock;
+		}
+		pTask->x_vDone.Wait(u64WakeTime);
+	}
+	return true;
+}
+void ThreadPool::X_Stop() noexcept {
+	x_bStopping.Store(true, kAtomicRelease);
+	__atomic_add_fetch(&x_u32WakeEpoch, 1, __ATOMIC_SEQ_CST);
+	::_MCFCRT_WakeAllByAddress(&x_u32WakeEpoch);
+	for(std::size_t uIndex = 0; uIndex < x_uWorkerCount; ++uIndex){
+		const auto &pThread = x_pWorkers[uIndex].pThread;
+		if(pThread){
+			pThread->Wait();
+		}
+	}
+}
+
+void ThreadPool::Submit(IntrusivePtr<ThreadPoolTask> pTask){
+	MCF_ASSERT(pTask);
+	MCF_ASSERT_MSG(!pTask->x_pPool, L"该任务已被提交过。");
+	pTask->x_pPool = this;
+
+	const auto pWorker = X_GetCurrentWorker();
+	if(pWorker){
+		pWorker->vDeque.Push(pTask.Get());
+	} else {
+		const auto vLock = x_mtxInjected.GetLock();
+		if(x_pInjectedLast){
+			x_pInjectedLast->x_pNextInjected = pTask.Get();
+		} else {
+			x_pInjectedFirst = pTask.Get();
+		}
+		x_pInjectedLast = pTask.Get();
+		x_uInjectedCount.Increment(kAtomicRelaxed);
+	}
+	// 现在队列持有这个引用。
+	pTask.Release();
+	X_WakeOneWorker();
+}
+
+}
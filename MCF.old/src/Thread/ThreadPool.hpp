@@ -0,0 +1,161 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_THREAD_POOL_HPP_
+#define MCF_THREAD_THREAD_POOL_HPP_
+
+#include "../SmartPointers/IntrusivePtr.hpp"
+#include "../SmartPointers/UniquePtr.hpp"
+#include "../Core/Atomic.hpp"
+#include "Latch.hpp"
+#include "Mutex.hpp"
+#include "ThreadLocal.hpp"
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace MCF {
+
+class ThreadPool;
+
+namespace Impl_ThreadPool {
+	struct Worker;
+
+	struct WorkerArrayDeleter {
+		constexpr Worker *operator()() const noexcept {
+			return nullptr;
+		}
+		void operator()(Worker *pWorkers) const noexcept;
+	};
+}
+
+class ThreadPoolTask : public IntrusiveBase<ThreadPoolTask> {
+	friend ThreadPool;
+
+private:
+	ThreadPool *x_pPool = nullptr;
+	ThreadPoolTask *x_pNextInjected = nullptr;
+	mutable Latch x_vDone;
+	std::exception_ptr x_pException;
+
+protected:
+	ThreadPoolTask() noexcept
+		: x_vDone(1)
+	{ }
+
+public:
+	virtual ~ThreadPoolTask();
+
+protected:
+	virtual void X_Run() = 0;
+
+private:
+	void X_Execute() noexcept;
+
+public:
+	bool IsDone() const noexcept {
+		return x_vDone.IsReady();
+	}
+	// 如果当前线程是同一个线程池的工作线程，它在等待期间会执行其他任务，因此任务可以等待它创建的子任务。没有其他任务可执行时，它在自旋之后睡眠。
+	// 如果任务抛出了异常，在任务完成后重新抛出该异常。
+	bool Wait(std::uint64_t u64UntilFastMonoClock) const;
+	void Wait() const;
+};
+
+extern template class IntrusivePtr<ThreadPoolTask>;
+
+namespace Impl_ThreadPool {
+	template<typename FunctionT>
+	class ConcreteTask final : public ThreadPoolTask {
+	private:
+		std::decay_t<FunctionT> x_vFunction;
+
+	public:
+		explicit ConcreteTask(FunctionT &vFunction)
+			: x_vFunction(std::forward<FunctionT>(vFunction))
+		{ }
+		~ConcreteTask() override;
+
+	protected:
+		void X_Run() override {
+			std::forward<FunctionT>(x_vFunction)();
+		}
+	};
+
+	template<typename FunctionT>
+	ConcreteTask<FunctionT>::~ConcreteTask(){ }
+}
+
+// 每个工作线程拥有一个 Chase-Lev 双端队列。工作线程创建的任务被压入它自己的队列，其他线程创建的任务被放入一个公共队列。
+// 工作线程从自己的队列尾部取任务执行；自己的队列为空时，先检查公共队列，再随机选择其他工作线程，从其队列头部窃取任务。
+// 找不到任务的工作线程先自旋一段时间，然后睡眠，直到有新的任务被提交。
+
+class ThreadPool {
+	friend ThreadPoolTask;
+
+public:
+	enum : std::size_t { kSuggestedSpinCount = 1000 };
+
+private:
+	std::size_t x_uWorkerCount;
+	UniquePtr<Impl_ThreadPool::Worker [], Impl_ThreadPool::WorkerArrayDeleter> x_pWorkers;
+	ThreadLocal<Impl_ThreadPool::Worker *> x_tlsCurrentWorker;
+	Atomic<std::size_t> x_uSpinCount;
+
+	// 其他线程提交的任务被放入这个单向链表。
+	Mutex x_mtxInjected;
+	ThreadPoolTask *x_pInjectedFirst;
+	ThreadPoolTask *x_pInjectedLast;
+	Atomic<std::size_t> x_uInjectedCount;
+
+	// 这个值在每次唤醒睡眠的工作线程时被递增。睡眠的工作线程等待它发生变化。
+	std::uint32_t x_u32WakeEpoch;
+	Atomic<std::size_t> x_uSleepingCount;
+	Atomic<bool> x_bStopping;
+
+public:
+	// 如果 uWorkerCount 为零，创建与逻辑处理器数量相同的工作线程。
+	explicit ThreadPool(std::size_t uWorkerCount = 0, std::size_t uSpinCount = kSuggestedSpinCount);
+	// 析构函数等待所有已提交的任务完成。
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+private:
+	Impl_ThreadPool::Worker *X_GetCurrentWorker() const noexcept;
+	ThreadPoolTask *X_ShiftInjectedTask() noexcept;
+	ThreadPoolTask *X_FindTask(Impl_ThreadPool::Worker *pWorker) noexcept;
+	void X_RunTask(ThreadPoolTask *pTask) noexcept;
+	void X_WakeOneWorker() noexcept;
+	void X_WorkerProc(Impl_ThreadPool::Worker *pWorker) noexcept;
+	bool X_HelpUntilDone(const ThreadPoolTask *pTask, bool bMayTimeOut, std::uint64_t u64UntilFastMonoClock) noexcept;
+	void X_Stop() noexcept;
+
+public:
+	std::size_t GetWorkerCount() const noexcept {
+		return x_uWorkerCount;
+	}
+	std::size_t GetSpinCount() const noexcept {
+		return x_uSpinCount.Load(kAtomicRelaxed);
+	}
+	void SetSpinCount(std::size_t uSpinCount) noexcept {
+		x_uSpinCount.Store(uSpinCount, kAtomicRelaxed);
+	}
+
+	// 同一个任务只能被提交一次。
+	void Submit(IntrusivePtr<ThreadPoolTask> pTask);
+	template<typename FunctionT>
+	IntrusivePtr<ThreadPoolTask> Submit(FunctionT &&vFunction){
+		IntrusivePtr<ThreadPoolTask> pTask = MakeIntrusive<Impl_ThreadPool::ConcreteTask<FunctionT>>(vFunction);
+		Submit(pTask);
+		return pTask;
+	}
+};
+
+}
+
+#endif
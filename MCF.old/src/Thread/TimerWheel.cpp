@@ -0,0 +1,379 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "TimerWheel.hpp"
+#include <exception>
+
+namespace MCF {
+
+WheelTimer::~WheelTimer(){ }
+
+template class IntrusivePtr<WheelTimer>;
+
+bool WheelTimer::IsPending() const noexcept {
+	const auto pWheel = GetWheel();
+	if(!pWheel){
+		return false;
+	}
+	const auto vLock = pWheel->x_mtxWheel.GetLock();
+	return !!x_ppPrevNext;
+}
+std::uint64_t WheelTimer::GetDueTime() const noexcept {
+	const auto pWheel = GetWheel();
+	if(!pWheel){
+		return 0;
+	}
+	const auto vLock = pWheel->x_mtxWheel.GetLock();
+	return x_u64DueTime;
+}
+
+bool WheelTimer::Cancel() noexcept {
+	const auto pWheel = GetWheel();
+	if(!pWheel){
+		return false;
+	}
+	return pWheel->Cancel(this);
+}
+
+namespace {
+	constexpr std::uint64_t kSlotMask = TimerWheel::kSlotCount - 1;
+
+	constexpr std::uint64_t GetLevelMask(unsigned uLevel) noexcept {
+		return (std::uint64_t(1) << (TimerWheel::kLevelBits * uLevel)) - 1;
+	}
+}
+
+TimerWheel::TimerWheel(std::uint64_t u64TickInterval, bool bUseServiceThread)
+	: x_u64TickInterval(u64TickInterval)
+	, x_u64NextTick(0), x_auLevelCounts(), x_aapSlots(), x_pExpired(nullptr), x_uPendingCount(0)
+	, x_u64ServiceWakeTime(0), x_bStopping(false)
+{
+	MCF_ASSERT_MSG(u64TickInterval != 0, L"滴答长度不能为零。");
+
+	x_u64NextTick = GetFastMonoClock() / x_u64TickInterval + 1;
+	if(bUseServiceThread){
+		x_pServiceThread = MakeThread([this]{ X_ServiceProc(); });
+	}
+}
+TimerWheel::~TimerWheel(){
+	X_Stop();
+
+	WheelTimer *pBatch = nullptr;
+	{
+		const auto vLock = x_mtxWheel.GetLock();
+		const auto fnDetachAll = [&](WheelTimer **ppHead){
+			for(;;){
+				const auto pTimer = *ppHead;
+				if(!pTimer){
+					break;
+				}
+				X_Unlink(pTimer);
+				pTimer->x_pWheel.Store(nullptr, kAtomicRelease);
+				pTimer->x_pNextFiring = pBatch;
+				pBatch = pTimer;
+			}
+		};
+		for(unsigned uLevel = 0; uLevel < kLevelCount; ++uLevel){
+			for(std::size_t uSlot = 0; uSlot < kSlotCount; ++uSlot){
+				fnDetachAll(&(x_aapSlots[uLevel][uSlot]));
+			}
+		}
+		fnDetachAll(&x_pExpired);
+		x_uPendingCount = 0;
+	}
+	// 在不持有锁的情况下释放时间轮持有的引用。
+	while(pBatch){
+		const IntrusivePtr<WheelTimer> pTimer(pBatch);
+		pBatch = pTimer->x_pNextFiring;
+	}
+}
+
+void TimerWheel::X_Link(WheelTimer **ppHead, unsigned uLevel, WheelTimer *pTimer) noexcept {
+	const auto pNext = *ppHead;
+	pTimer->x_pNext = pNext;
+	if(pNext){
+		pNext->x_ppPrevNext = &(pTimer->x_pNext);
+	}
+	pTimer->x_ppPrevNext = ppHead;
+	*ppHead = pTimer;
+	pTimer->x_uLevel = uLevel;
+	if(uLevel < kLevelCount){
+		++x_auLevelCounts[uLevel];
+	}
+}
+void TimerWheel::X_Unlink(WheelTimer *pTimer) noexcept {
+	const auto pNext = pTimer->x_pNext;
+	*(pTimer->x_ppPrevNext) = pNext;
+	if(pNext){
+		pNext->x_ppPrevNext = pTimer->x_ppPrevNext;
+	}
+	pTimer->x_pNext = nullptr;
+	pTimer->x_ppPrevNext = nullptr;
+	if(pTimer->x_uLevel < kLevelCount){
+		--x_auLevelCounts[pTimer->x_uLevel];
+	}
+}
+void TimerWheel::X_Place(WheelTimer *pTimer) noexcept {
+	const auto u64DueTick = pTimer->x_u64DueTick;
+	if(u64DueTick < x_u64NextTick){
+		X_Link(&x_pExpired, kLevelCount, pTimer);
+		return;
+	}
+	auto u64Delta = u64DueTick - x_u64NextTick;
+	auto u64Index = u64DueTick;
+	if(u64Delta > GetLevelMask(kLevelCount)){
+		// 超出了时间轮的范围。把计时器放在最高层的最后一个槽中，它在那个槽被展开时会被重新放置。
+		u64Delta = GetLevelMask(kLevelCount);
+		u64Index = x_u64NextTick + u64Delta;
+	}
+	unsigned uLevel = 0;
+	while((uLevel + 1 < kLevelCount) && (u64Delta > GetLevelMask(uLevel + 1))){
+		++uLevel;
+	}
+	const auto uSlot = static_cast<std::size_t>((u64Index >> (kLevelBits * uLevel)) & kSlotMask);
+	X_Link(&(x_aapSlots[uLevel][uSlot]), uLevel, pTimer);
+}
+void TimerWheel::X_Cascade(unsigned uLevel, std::size_t uSlot) noexcept {
+	const auto ppHead = &(x_aapSlots[uLevel][uSlot]);
+	for(;;){
+		const auto pTimer = *ppHead;
+		if(!pTimer){
+			break;
+		}
+		X_Unlink(pTimer);
+		X_Place(pTimer);
+	}
+}
+void TimerWheel::X_AdvanceTo(std::uint64_t u64Tick) noexcept {
+	while(x_u64NextTick <= u64Tick){
+		// 如果低层都是空的，直接跳到下一次需要展开高层的槽的滴答。
+		unsigned uLevel = 0;
+		while((uLevel < kLevelCount) && (x_auLevelCounts[uLevel] == 0)){
+			++uLevel;
+		}
+		if(uLevel == kLevelCount){
+			x_u64NextTick = u64Tick + 1;
+			break;
+		}
+		if(uLevel != 0){
+			const auto u64Mask = GetLevelMask(uLevel);
+			if((x_u64NextTick & u64Mask) != 0){
+				const auto u64Boundary = (x_u64NextTick | u64Mask) + 1;
+				if(u64Boundary > u64Tick){
+					x_u64NextTick = u64Tick + 1;
+					break;
+				}
+				x_u64NextTick = u64Boundary;
+			}
+		}
+
+		const auto uSlot = static_cast<std::size_t>(x_u64NextTick & kSlotMask);
+		if(uSlot == 0){
+			for(unsigned uUpper = 1; uUpper < kLevelCount; ++uUpper){
+				const auto uUpperSlot = static_cast<std::size_t>((x_u64NextTick >> (kLevelBits * uUpper)) & kSlotMask);
+				X_Cascade(uUpper, uUpperSlot);
+				if(uUpperSlot != 0){
+					break;
+				}
+			}
+		}
+		const auto ppHead = &(x_aapSlots[0][uSlot]);
+		for(;;){
+			const auto pTimer = *ppHead;
+			if(!pTimer){
+				break;
+			}
+			X_Unlink(pTimer);
+			X_Link(&x_pExpired, kLevelCount, pTimer);
+		}
+		++x_u64NextTick;
+	}
+}
+WheelTimer *TimerWheel::X_TakeExpired() noexcept {
+	WheelTimer *pBatch = nullptr;
+	for(;;){
+		const auto pTimer = x_pExpired;
+		if(!pTimer){
+			break;
+		}
+		X_Unlink(pTimer);
+		--x_uPendingCount;
+		// 时间轮持有的引用被转交给这一批。
+		pTimer->x_u64FiringSerial = pTimer->x_u64Serial;
+		pTimer->x_pNextFiring = pBatch;
+		pBatch = pTimer;
+	}
+	return pBatch;
+}
+std::uint64_t TimerWheel::X_GetNextWakeTime() const noexcept {
+	if(x_pExpired){
+		return 0;
+	}
+	if(x_uPendingCount == 0){
+		return UINT64_MAX;
+	}
+	unsigned uLevel = 0;
+	while((uLevel < kLevelCount) && (x_auLevelCounts[uLevel] == 0)){
+		++uLevel;
+	}
+	std::uint64_t u64Tick;
+	if(uLevel == 0){
+		// 在第一层中找到第一个非空的槽，但是不能越过下一次展开高层的槽的滴答。
+		const bool bUpperEmpty = x_uPendingCount == x_auLevelCounts[0];
+		u64Tick = x_u64NextTick;
+		while(!x_aapSlots[0][u64Tick & kSlotMask] && (bUpperEmpty || ((u64Tick & kSlotMask) != 0))){
+			++u64Tick;
+		}
+	} else {
+		const auto u64Mask = GetLevelMask(uLevel);
+		u64Tick = ((x_u64NextTick - 1) | u64Mask) + 1;
+	}
+	if(u64Tick > UINT64_MAX / x_u64TickInterval){
+		return UINT64_MAX;
+	}
+	return u64Tick * x_u64TickInterval;
+}
+std::size_t TimerWheel::X_Dispatch(WheelTimer *pBatch){
+	std::size_t uCount = 0;
+	std::exception_ptr pException;
+	while(pBatch){
+		// 接管这一批持有的引用。
+		const IntrusivePtr<WheelTimer> pTimer(pBatch);
+		pBatch = pTimer->x_pNextFiring;
+
+		{
+			const auto vLock = x_mtxWheel.GetLock();
+			if(pTimer->x_u64Serial != pTimer->x_u64FiringSerial){
+				// 计时器在被取出之后被取消或者重新调度了。
+				continue;
+			}
+			++(pTimer->x_u64Serial);
+			// 回调可以把计时器重新调度到这个时间轮中。
+			pTimer->x_pWheel.Store(nullptr, kAtomicRelease);
+		}
+		++uCount;
+		try {
+			pTimer->X_OnTimer();
+		} catch(...){
+			if(!pException){
+				pException = std::current_exception();
+			}
+		}
+	}
+	if(pException){
+		std::rethrow_exception(pException);
+	}
+	return uCount;
+}
+void TimerWheel::X_ServiceProc() noexcept {
+	for(;;){
+		WheelTimer *pBatch;
+		{
+			auto vLock = x_mtxWheel.GetLock();
+			for(;;){
+				if(x_bStopping){
+					return;
+				}
+				X_AdvanceTo(GetFastMonoClock() / x_u64TickInterval);
+				if(x_pExpired){
+					break;
+				}
+				const auto u64WakeTime = X_GetNextWakeTime();
+				x_u64ServiceWakeTime = u64WakeTime;
+				if(u64WakeTime == UINT64_MAX){
+					x_cvWheel.Wait(vLock);
+				} else {
+					x_cvWheel.Wait(vLock, u64WakeTime);
+				}
+				x_u64ServiceWakeTime = 0;
+			}
+			pBatch = X_TakeExpired();
+		}
+		// 服务线程中的回调不能抛出异常。
+		X_Dispatch(pBatch);
+	}
+}
+void TimerWheel::X_Stop() noexcept {
+	if(!x_pServiceThread){
+		return;
+	}
+	{
+		const auto vLock = x_mtxWheel.GetLock();
+		x_bStopping = true;
+		x_cvWheel.Signal();
+	}
+	x_pServiceThread->Wait();
+	x_pServiceThread.Reset();
+}
+
+std::size_t TimerWheel::GetPendingCount() const noexcept {
+	const auto vLock = x_mtxWheel.GetLock();
+	return x_uPendingCount;
+}
+
+void TimerWheel::Schedule(IntrusivePtr<WheelTimer> pTimer, std::uint64_t u64DueTime){
+	MCF_ASSERT(pTimer);
+
+	const auto u64DueTick = u64DueTime / x_u64TickInterval + (u64DueTime % x_u64TickInterval != 0);
+
+	const auto vLock = x_mtxWheel.GetLock();
+	const auto pRaw = pTimer.Get();
+	const auto pOldWheel = pRaw->x_pWheel.Load(kAtomicRelaxed);
+	MCF_ASSERT_MSG(!pOldWheel || (pOldWheel == this), L"该计时器已被调度到其他时间轮。");
+	pRaw->x_pWheel.Store(this, kAtomicRelease);
+	// 使已经被取出但尚未分发的这个计时器失效。
+	++(pRaw->x_u64Serial);
+	if(pRaw->x_ppPrevNext){
+		X_Unlink(pRaw);
+	} else {
+		// 等待中的计时器由时间轮持有一个引用。
+		pTimer.Release();
+		++x_uPendingCount;
+	}
+	pRaw->x_u64DueTime = u64DueTime;
+	pRaw->x_u64DueTick = u64DueTick;
+	X_Place(pRaw);
+	if((x_u64ServiceWakeTime != 0) && (u64DueTime < x_u64ServiceWakeTime)){
+		x_cvWheel.Signal();
+	}
+}
+bool TimerWheel::Cancel(WheelTimer *pTimer) noexcept {
+	MCF_ASSERT(pTimer);
+
+	// 在不持有锁的情况下释放时间轮持有的引用。
+	IntrusivePtr<WheelTimer> pDropped;
+	const auto vLock = x_mtxWheel.GetLock();
+	const auto pOldWheel = pTimer->x_pWheel.Load(kAtomicRelaxed);
+	MCF_ASSERT_MSG(!pOldWheel || (pOldWheel == this), L"该计时器已被调度到其他时间轮。");
+	if(!pOldWheel){
+		return false;
+	}
+	pTimer->x_pWheel.Store(nullptr, kAtomicRelease);
+	// 使已经被取出但尚未分发的这个计时器失效。
+	++(pTimer->x_u64Serial);
+	if(pTimer->x_ppPrevNext){
+		X_Unlink(pTimer);
+		--x_uPendingCount;
+		pDropped.Reset(pTimer);
+	}
+	return true;
+}
+
+std::size_t TimerWheel::Advance(std::uint64_t u64Now){
+	MCF_ASSERT_MSG(!x_pServiceThread, L"这个时间轮由服务线程驱动。");
+
+	WheelTimer *pBatch;
+	{
+		const auto vLock = x_mtxWheel.GetLock();
+		X_AdvanceTo(u64Now / x_u64TickInterval);
+		pBatch = X_TakeExpired();
+	}
+	return X_Dispatch(pBatch);
+}
+std::uint64_t TimerWheel::GetNextWakeTime() const noexcept {
+	const auto vLock = x_mtxWheel.GetLock();
+	return X_GetNextWakeTime();
+}
+
+}
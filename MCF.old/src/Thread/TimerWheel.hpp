@@ -0,0 +1,178 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef MCF_THREAD_TIMER_WHEEL_HPP_
+#define MCF_THREAD_TIMER_WHEEL_HPP_
+
+#include "../SmartPointers/IntrusivePtr.hpp"
+#include "../Core/Atomic.hpp"
+#include "../Core/Clocks.hpp"
+#include "Thread.hpp"
+#include "Mutex.hpp"
+#include "ConditionVariable.hpp"
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace MCF {
+
+class TimerWheel;
+
+class WheelTimer : public IntrusiveBase<WheelTimer> {
+	friend TimerWheel;
+
+private:
+	// 计时器在等待中或者已被取出但尚未分发时指向所属时间轮，否则为空指针。只在持有时间轮的互斥体时修改。
+	Atomic<TimerWheel *> x_pWheel;
+	// 以下成员受所属时间轮的互斥体保护。
+	WheelTimer *x_pNext = nullptr;
+	WheelTimer **x_ppPrevNext = nullptr;
+	unsigned x_uLevel = 0;
+	std::uint64_t x_u64DueTime = 0;
+	std::uint64_t x_u64DueTick = 0;
+	// 这个链表只在分发期间使用，因此分发一批计时器的同时可以重新调度其中的计时器。
+	WheelTimer *x_pNextFiring = nullptr;
+	// 每次调度、取消或触发计时器时递增。分发计时器之前它应当仍然等于 x_u64FiringSerial，否则说明计时器在此期间被取消或重新调度了。
+	std::uint64_t x_u64Serial = 0;
+	std::uint64_t x_u64FiringSerial = UINT64_MAX;
+
+protected:
+	WheelTimer() noexcept
+		: x_pWheel(nullptr)
+	{ }
+
+public:
+	virtual ~WheelTimer();
+
+protected:
+	virtual void X_OnTimer() = 0;
+
+public:
+	// 计时器被触发或取消之后返回空指针，因此计时器可以比时间轮存活得更久，只要不与时间轮的析构函数同时调用这些函数。
+	TimerWheel *GetWheel() const noexcept {
+		return x_pWheel.Load(kAtomicAcquire);
+	}
+	bool IsPending() const noexcept;
+	std::uint64_t GetDueTime() const noexcept;
+
+	// 等同于 GetWheel()->Cancel(this)。如果计时器不属于任何时间轮，返回 false。
+	bool Cancel() noexcept;
+};
+
+extern template class IntrusivePtr<WheelTimer>;
+
+namespace Impl_TimerWheel {
+	template<typename FunctionT>
+	class ConcreteTimer final : public WheelTimer {
+	private:
+		std::decay_t<FunctionT> x_vFunction;
+
+	public:
+		explicit ConcreteTimer(FunctionT &vFunction)
+			: x_vFunction(std::forward<FunctionT>(vFunction))
+		{ }
+		~ConcreteTimer() override;
+
+	protected:
+		void X_OnTimer() override {
+			x_vFunction();
+		}
+	};
+
+	template<typename FunctionT>
+	ConcreteTimer<FunctionT>::~ConcreteTimer(){ }
+}
+
+// 分层时间轮：四层，每层 256 个槽。第一层的每个槽对应一个滴答，上一层的每个槽对应下一层转一圈的时间。
+// 调度和取消计时器都是 O(1) 的，计时器在到期之前只会在层与层之间移动至多三次。到期的计时器被成批取出，在不持有锁的情况下依次分发。
+// 时间轮可以由自己的服务线程驱动，也可以由调用者在自己的循环中调用 Advance() 驱动，此时 GetNextWakeTime() 给出下一次需要调用 Advance() 的时刻。
+// 计时器不会早于它的到期时刻被触发，但是可能晚至多一个滴答。
+
+class TimerWheel {
+	friend WheelTimer;
+
+public:
+	enum : unsigned {
+		kLevelBits   = 8,
+		kLevelCount  = 4,
+	};
+	enum : std::size_t {
+		kSlotCount   = 1u << kLevelBits,
+	};
+
+private:
+	std::uint64_t x_u64TickInterval;
+
+	mutable Mutex x_mtxWheel;
+	ConditionVariable x_cvWheel;
+	// 下一个要处理的滴答。
+	std::uint64_t x_u64NextTick;
+	std::size_t x_auLevelCounts[kLevelCount];
+	WheelTimer *x_aapSlots[kLevelCount][kSlotCount];
+	// 已到期但尚未被取出的计时器。
+	WheelTimer *x_pExpired;
+	std::size_t x_uPendingCount;
+
+	IntrusivePtr<Thread> x_pServiceThread;
+	// 如果服务线程正在睡眠，这是它被唤醒的时刻；否则为零。
+	std::uint64_t x_u64ServiceWakeTime;
+	bool x_bStopping;
+
+public:
+	// u64TickInterval 是以毫秒为单位的滴答长度，不能为零。如果 bUseServiceThread 为 true，创建一个线程驱动这个时间轮。
+	explicit TimerWheel(std::uint64_t u64TickInterval = 1, bool bUseServiceThread = false);
+	// 析构函数停止服务线程，并取消所有等待中的计时器。
+	~TimerWheel();
+
+	TimerWheel(const TimerWheel &) = delete;
+	TimerWheel &operator=(const TimerWheel &) = delete;
+
+private:
+	void X_Link(WheelTimer **ppHead, unsigned uLevel, WheelTimer *pTimer) noexcept;
+	void X_Unlink(WheelTimer *pTimer) noexcept;
+	void X_Place(WheelTimer *pTimer) noexcept;
+	void X_Cascade(unsigned uLevel, std::size_t uSlot) noexcept;
+	void X_AdvanceTo(std::uint64_t u64Tick) noexcept;
+	WheelTimer *X_TakeExpired() noexcept;
+	std::uint64_t X_GetNextWakeTime() const noexcept;
+	std::size_t X_Dispatch(WheelTimer *pBatch);
+	void X_ServiceProc() noexcept;
+	void X_Stop() noexcept;
+
+public:
+	std::uint64_t GetTickInterval() const noexcept {
+		return x_u64TickInterval;
+	}
+	bool HasServiceThread() const noexcept {
+		return !!x_pServiceThread;
+	}
+	std::size_t GetPendingCount() const noexcept;
+
+	// u64DueTime 由 GetFastMonoClock() 给出。如果计时器已经在等待，它被重新调度到新的时刻。
+	// 一个计时器只能被调度到同一个时间轮。在分发之前被取消或重新调度的计时器不会被触发，但是已经开始执行的回调不会被中断。
+	void Schedule(IntrusivePtr<WheelTimer> pTimer, std::uint64_t u64DueTime);
+	template<typename FunctionT>
+	IntrusivePtr<WheelTimer> Schedule(std::uint64_t u64DueTime, FunctionT &&vFunction){
+		IntrusivePtr<WheelTimer> pTimer = MakeIntrusive<Impl_TimerWheel::ConcreteTimer<FunctionT>>(vFunction);
+		Schedule(pTimer, u64DueTime);
+		return pTimer;
+	}
+	// 如果这次调用阻止了计时器被触发，返回 true。
+	bool Cancel(WheelTimer *pTimer) noexcept;
+
+	// 以下两个函数供没有服务线程的时间轮使用。
+	// 触发所有在 u64Now 之前到期的计时器，返回被触发的计时器数量。
+	// 如果有回调抛出异常，这一批中其余的计时器仍会被触发，然后重新抛出第一个异常。
+	std::size_t Advance(std::uint64_t u64Now);
+	std::size_t Advance(){
+		return Advance(GetFastMonoClock());
+	}
+	// 返回下一次需要调用 Advance() 的时刻。这个值可能早于实际最早到期的计时器。如果没有等待中的计时器，返回 UINT64_MAX。
+	std::uint64_t GetNextWakeTime() const noexcept;
+};
+
+}
+
+#endif
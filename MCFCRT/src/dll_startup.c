@@ -5,6 +5,7 @@
 #include "mcfcrt.h"
 #include "env/cpu.h"
 #include "env/thread.h"
+#include "env/_heap_engine.h"
 #include "env/mcfwin.h"
 
 __attribute__((__stdcall__)) extern BOOL __MCFCRT_DllStartup(HINSTANCE hInstance, DWORD dwReason, LPVOID pReserved)
@@ -34,6 +35,7 @@ static unsigned long WrappedDllStartup(void *pOpaque){
 		return true;
 
 	case DLL_THREAD_DETACH:
+		__MCFCRT_HeapEngineThreadCleanup();
 		return true;
 
 	default:
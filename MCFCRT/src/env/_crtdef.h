@@ -13,6 +13,11 @@
 #  error SSSE3 (triple S) is required to use MCFCRT. Check your `-march=` command line option.
 #endif
 
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+// The POSIX platform layer needs `syscall()`, `clock_gettime()` and `tm_gmtoff`, which `-std=c11` hides.
+#  define _GNU_SOURCE                  1
+#endif
+
 #ifdef __STDC_VERSION__
 #  if __STDC_VERSION__ >= 199409l
 #    define _MCFCRT_C95                1
@@ -0,0 +1,838 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_heap_engine.h"
+#include "mcfwin.h"
+#include "mutex.h"
+#include "inline_mem.h"
+#include "xassert.h"
+#include "expect.h"
+
+#define CHUNK_ALIGNMENT         ((size_t)0x10000)
+#define CHUNK_HEADER_SIZE       ((size_t)_MCFCRT_CACHE_LINE_SIZE)
+#define PAGE_SIZE               ((size_t)_MCFCRT_PAGE_SIZE_MINIMUM)
+
+#define CLASS_COUNT             ((size_t)32)
+#define CLASS_LARGE             ((size_t)-1)
+
+#define MAX_SMALL_SIZE          ((size_t)8192)
+#define BATCH_SIZE_IN_BYTES     ((size_t)8192)
+#define MIN_BATCH_SIZE          ((size_t)4)
+#define MAX_BATCH_SIZE          ((size_t)64)
+
+#define BYTES_PENDING_THRESHOLD ((intptr_t)0x10000)
+
+// Large blocks reserve this many times the address space that they need, so they can be resized in place by committing or decommitting pages.
+#ifdef _WIN64
+#  define RESERVATION_FACTOR    ((size_t)8)
+#else
+#  define RESERVATION_FACTOR    ((size_t)2)
+#endif
+
+// Freed large blocks up to this size (including their headers) are kept for reuse, so medium-sized blocks do not cost a system call each.
+// Blocks of each rounded size are cached separately, up to this many blocks, so no size can take up the space of the others. There are 19 such
+// sizes from 12KiB to 320KiB, one block of each of which adds up to about 1.9MiB, so full caches keep at most about 15MiB committed on x64 and
+// 7.5MiB on x86.
+#define MAX_CACHED_LARGE_SIZE   ((size_t)0x50000)
+#ifdef _WIN64
+#  define LARGE_CACHE_DEPTH     ((size_t)8)
+#else
+#  define LARGE_CACHE_DEPTH     ((size_t)4)
+#endif
+
+// Size classes are 16 bytes apart up to 128 bytes, then there are four classes between each two adjacent powers of two.
+static const size_t kBlockSizeTable[CLASS_COUNT] = {
+	  16,   32,   48,   64,   80,   96,  112,  128,
+	 160,  192,  224,  256,  320,  384,  448,  512,
+	 640,  768,  896, 1024, 1280, 1536, 1792, 2048,
+	2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192,
+};
+
+static_assert(MAX_SMALL_SIZE == 8192, "Please update `kBlockSizeTable`.");
+
+static inline size_t GetClassIndex(size_t uSize){
+	_MCFCRT_ASSERT(uSize <= MAX_SMALL_SIZE);
+	if(uSize <= 128){
+		return (uSize - (uSize != 0)) / 16;
+	}
+	const size_t uLast = uSize - 1;
+	const unsigned uLog2 = 63 - (unsigned)__builtin_clzll(uLast);
+	return 8 + (uLog2 - 7) * 4 + ((uLast >> (uLog2 - 2)) & 3);
+}
+static inline size_t GetBatchSize(size_t uClass){
+	const size_t uBatchSize = BATCH_SIZE_IN_BYTES / kBlockSizeTable[uClass];
+	if(uBatchSize < MIN_BATCH_SIZE){
+		return MIN_BATCH_SIZE;
+	}
+	if(uBatchSize > MAX_BATCH_SIZE){
+		return MAX_BATCH_SIZE;
+	}
+	return uBatchSize;
+}
+
+typedef struct tagFreeBlock {
+	struct tagFreeBlock *pNext;
+} FreeBlock;
+
+// Every chunk begins at an address that is a multiple of `CHUNK_ALIGNMENT`, where this header resides.
+// A slab is a chunk of `CHUNK_ALIGNMENT` bytes that is divided into blocks of the same size class.
+// A large block is a chunk that holds exactly one block following its header. Every block must start within `CHUNK_ALIGNMENT` bytes from its chunk.
+typedef struct tagChunk {
+	size_t uClass;
+	union {
+		struct {
+			struct tagChunk *pPrev; // Slabs with free blocks of the same size class
+			struct tagChunk *pNext; // Slabs with free blocks of the same size class
+			FreeBlock *pFreeHead;
+			unsigned char *pbyUntouched; // Blocks from here on have never been handed out.
+			size_t uBlockCount;
+			size_t uBlocksInUse; // This includes blocks cached by threads.
+		};
+		struct {
+			size_t uBlockOffset; // This is `CHUNK_HEADER_SIZE` unless the block is over-aligned.
+			size_t uUsableSize; // All pages up to the end of the block have been committed.
+			size_t uReservedSize; // This includes the header.
+			struct tagChunk *pNextCached; // Cached large blocks of the same size
+		};
+	};
+} Chunk;
+
+static_assert(sizeof(Chunk) <= CHUNK_HEADER_SIZE, "Chunk is too large.");
+static_assert(_MCFCRT_HEAP_MAX_ALIGNMENT < CHUNK_ALIGNMENT, "Over-aligned blocks would not start within their chunks.");
+static_assert(CHUNK_HEADER_SIZE % alignof(max_align_t) == 0, "??");
+
+static inline Chunk *GetChunk(const void *pStorage){
+	return (Chunk *)((uintptr_t)pStorage & ~(uintptr_t)(CHUNK_ALIGNMENT - 1));
+}
+static inline size_t GetUsableSize(const Chunk *pChunk){
+	if(pChunk->uClass == CLASS_LARGE){
+		return pChunk->uUsableSize;
+	}
+	return kBlockSizeTable[pChunk->uClass];
+}
+
+typedef struct tagSizeClass {
+	alignas(_MCFCRT_CACHE_LINE_SIZE) _MCFCRT_Mutex mtxGuard;
+	Chunk *pFirst; // Slabs with free blocks
+} SizeClass;
+
+static SizeClass g_aSizeClasses[CLASS_COUNT];
+
+static Chunk *CreateSlabUnlocked(size_t uClass){
+	Chunk *const pChunk = VirtualAlloc(_MCFCRT_NULLPTR, CHUNK_ALIGNMENT, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if(!pChunk){
+		return _MCFCRT_NULLPTR;
+	}
+	_MCFCRT_ASSERT(((uintptr_t)pChunk & (CHUNK_ALIGNMENT - 1)) == 0);
+	pChunk->uClass       = uClass;
+	pChunk->pPrev        = _MCFCRT_NULLPTR;
+	pChunk->pNext        = _MCFCRT_NULLPTR;
+	pChunk->pFreeHead    = _MCFCRT_NULLPTR;
+	pChunk->pbyUntouched = (unsigned char *)pChunk + CHUNK_HEADER_SIZE;
+	pChunk->uBlockCount  = (CHUNK_ALIGNMENT - CHUNK_HEADER_SIZE) / kBlockSizeTable[uClass];
+	pChunk->uBlocksInUse = 0;
+	return pChunk;
+}
+static void LinkSlabUnlocked(SizeClass *pSizeClass, Chunk *pChunk){
+	Chunk *const pNext = pSizeClass->pFirst;
+	if(pNext){
+		pNext->pPrev = pChunk;
+	}
+	pChunk->pPrev = _MCFCRT_NULLPTR;
+	pChunk->pNext = pNext;
+	pSizeClass->pFirst = pChunk;
+}
+static void UnlinkSlabUnlocked(SizeClass *pSizeClass, Chunk *pChunk){
+	Chunk *const pPrev = pChunk->pPrev;
+	Chunk *const pNext = pChunk->pNext;
+	if(pPrev){
+		pPrev->pNext = pNext;
+	} else {
+		pSizeClass->pFirst = pNext;
+	}
+	if(pNext){
+		pNext->pPrev = pPrev;
+	}
+	pChunk->pPrev = _MCFCRT_NULLPTR;
+	pChunk->pNext = _MCFCRT_NULLPTR;
+}
+
+// A slab is in the list of its size class if and only if it has free blocks.
+static size_t FetchBlocksFromSlabs(FreeBlock **restrict ppHead, size_t uClass, size_t uCountWanted){
+	SizeClass *const pSizeClass = g_aSizeClasses + uClass;
+	const size_t uBlockSize = kBlockSizeTable[uClass];
+
+	FreeBlock *pHead = _MCFCRT_NULLPTR;
+	size_t uCount = 0;
+	_MCFCRT_WaitForMutexForever(&(pSizeClass->mtxGuard), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	while(uCount < uCountWanted){
+		Chunk *pChunk = pSizeClass->pFirst;
+		if(!pChunk){
+			pChunk = CreateSlabUnlocked(uClass);
+			if(!pChunk){
+				break;
+			}
+			LinkSlabUnlocked(pSizeClass, pChunk);
+		}
+		do {
+			FreeBlock *pBlock = pChunk->pFreeHead;
+			if(pBlock){
+				pChunk->pFreeHead = pBlock->pNext;
+			} else {
+				pBlock = (void *)(pChunk->pbyUntouched);
+				pChunk->pbyUntouched += uBlockSize;
+			}
+			pBlock->pNext = pHead;
+			pHead = pBlock;
+			++uCount;
+			++(pChunk->uBlocksInUse);
+		} while((uCount < uCountWanted) && (pChunk->uBlocksInUse < pChunk->uBlockCount));
+		if(pChunk->uBlocksInUse == pChunk->uBlockCount){
+			UnlinkSlabUnlocked(pSizeClass, pChunk);
+		}
+	}
+	_MCFCRT_SignalMutex(&(pSizeClass->mtxGuard));
+
+	*ppHead = pHead;
+	return uCount;
+}
+static void ReturnBlocksToSlabs(size_t uClass, FreeBlock *pHead){
+	SizeClass *const pSizeClass = g_aSizeClasses + uClass;
+
+	Chunk *pChunksToRelease = _MCFCRT_NULLPTR;
+	_MCFCRT_WaitForMutexForever(&(pSizeClass->mtxGuard), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	while(pHead){
+		FreeBlock *const pBlock = pHead;
+		pHead = pBlock->pNext;
+
+		Chunk *const pChunk = GetChunk(pBlock);
+		_MCFCRT_ASSERT(pChunk->uClass == uClass);
+		_MCFCRT_ASSERT(pChunk->uBlocksInUse != 0);
+		if(pChunk->uBlocksInUse == pChunk->uBlockCount){
+			LinkSlabUnlocked(pSizeClass, pChunk);
+		}
+		pBlock->pNext = pChunk->pFreeHead;
+		pChunk->pFreeHead = pBlock;
+		if(--(pChunk->uBlocksInUse) == 0){
+			// Keep the last slab of this size class to avoid thrashing.
+			if((pSizeClass->pFirst != pChunk) || pChunk->pNext){
+				UnlinkSlabUnlocked(pSizeClass, pChunk);
+				pChunk->pNext = pChunksToRelease;
+				pChunksToRelease = pChunk;
+			}
+		}
+	}
+	_MCFCRT_SignalMutex(&(pSizeClass->mtxGuard));
+
+	while(pChunksToRelease){
+		Chunk *const pChunk = pChunksToRelease;
+		pChunksToRelease = pChunk->pNext;
+
+		const bool bSucceeded = VirtualFree(pChunk, 0, MEM_RELEASE);
+		_MCFCRT_ASSERT_MSG(bSucceeded, L"VirtualFree() 失败。");
+	}
+}
+
+typedef struct tagCacheBin {
+	FreeBlock *pHead;
+	size_t uCount;
+} CacheBin;
+
+// Counters of a thread are written by that thread only, so there is no need for atomic read-modify-write operations.
+typedef struct tagCounters {
+	volatile uint64_t u64BytesAllocated;
+	volatile uint64_t u64BytesFreed;
+	volatile uint64_t u64AllocationCount;
+	volatile uint64_t u64FreeCount;
+	volatile uint64_t u64ReallocInPlaceCount;
+	volatile uint64_t u64ReallocCopyCount;
+	volatile uint64_t au64AllocationCountBySize[_MCFCRT_HEAP_STATISTICS_BUCKET_COUNT];
+} Counters;
+
+typedef struct tagThreadCache {
+	CacheBin aBins[CLASS_COUNT];
+	struct tagThreadCache *pPrev; // Live thread caches
+	struct tagThreadCache *pNext; // Live thread caches
+	uintptr_t uThreadId;
+	intptr_t nBytesPending; // Bytes allocated but not yet added to `g_nBytesInUse`
+	Counters vCounters;
+} ThreadCache;
+
+static_assert(sizeof(ThreadCache) <= MAX_SMALL_SIZE, "ThreadCache is too large.");
+
+// This is stored into the TLS slot of a thread once its cache has been flushed. Allocations made by that thread afterwards, for example in TLS
+// destructors or at-exit callbacks, are served from slabs directly. Otherwise a new cache would be created, which nothing would ever release.
+#define DETACHED_THREAD_CACHE   ((ThreadCache *)(uintptr_t)1)
+
+static volatile DWORD g_dwTlsIndex = TLS_OUT_OF_INDEXES;
+
+static _MCFCRT_Mutex g_mtxThreadCacheList = { 0 };
+static ThreadCache *g_pFirstThreadCache = _MCFCRT_NULLPTR;
+
+// These are updated with atomic operations. They hold counters of threads that have exited, as well as those of operations on threads without caches.
+static Counters g_vSharedCounters;
+// The peak is checked whenever a thread adds its pending bytes to `g_nBytesInUse`, which happens every `BYTES_PENDING_THRESHOLD` bytes.
+static volatile intptr_t g_nBytesInUse = 0;
+static volatile size_t g_uPeakBytesInUse = 0;
+
+static inline void IncreaseCounter(volatile uint64_t *pu64Counter, ThreadCache *pCache, uint64_t u64Delta){
+	if(_MCFCRT_EXPECT_NOT(!pCache)){
+		__atomic_add_fetch(pu64Counter, u64Delta, __ATOMIC_RELAXED);
+		return;
+	}
+	__atomic_store_n(pu64Counter, __atomic_load_n(pu64Counter, __ATOMIC_RELAXED) + u64Delta, __ATOMIC_RELAXED);
+}
+static inline Counters *GetCounters(ThreadCache *pCache){
+	if(_MCFCRT_EXPECT_NOT(!pCache)){
+		return &g_vSharedCounters;
+	}
+	return &(pCache->vCounters);
+}
+static inline size_t GetStatisticsBucketIndex(size_t uSize){
+	if(uSize <= 16){
+		return 0;
+	}
+	const size_t uIndex = (size_t)(64 - __builtin_clzll(uSize - 1)) - 4;
+	if(uIndex >= _MCFCRT_HEAP_STATISTICS_BUCKET_COUNT){
+		return _MCFCRT_HEAP_STATISTICS_BUCKET_COUNT - 1;
+	}
+	return uIndex;
+}
+
+static size_t UpdatePeakBytesInUse(size_t uBytesInUse){
+	size_t uPeak = __atomic_load_n(&g_uPeakBytesInUse, __ATOMIC_RELAXED);
+	while(uPeak < uBytesInUse){
+		if(__atomic_compare_exchange_n(&g_uPeakBytesInUse, &uPeak, uBytesInUse, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+			return uBytesInUse;
+		}
+	}
+	return uPeak;
+}
+static void AddBytesInUse(intptr_t nDelta){
+	const intptr_t nBytesInUse = __atomic_add_fetch(&g_nBytesInUse, nDelta, __ATOMIC_RELAXED);
+	if(nBytesInUse <= 0){
+		return;
+	}
+	UpdatePeakBytesInUse((size_t)nBytesInUse);
+}
+static inline void AccountForBytes(ThreadCache *pCache, size_t uBytesAllocated, size_t uBytesFreed){
+	Counters *const pCounters = GetCounters(pCache);
+	if(uBytesAllocated != 0){
+		IncreaseCounter(&(pCounters->u64BytesAllocated), pCache, uBytesAllocated);
+	}
+	if(uBytesFreed != 0){
+		IncreaseCounter(&(pCounters->u64BytesFreed), pCache, uBytesFreed);
+	}
+	const intptr_t nDelta = (intptr_t)(uBytesAllocated - uBytesFreed);
+	if(_MCFCRT_EXPECT_NOT(!pCache)){
+		AddBytesInUse(nDelta);
+		return;
+	}
+	const intptr_t nBytesPending = pCache->nBytesPending + nDelta;
+	if(_MCFCRT_EXPECT_NOT((nBytesPending >= BYTES_PENDING_THRESHOLD) || (nBytesPending <= -BYTES_PENDING_THRESHOLD))){
+		AddBytesInUse(nBytesPending);
+		pCache->nBytesPending = 0;
+		return;
+	}
+	pCache->nBytesPending = nBytesPending;
+}
+
+// `TlsGetValue()` and `TlsSetValue()` overwrite the per-thread error code even if they succeed.
+static ThreadCache *GetThreadCache(DWORD dwTlsIndex){
+	const DWORD dwLastError = GetLastError();
+	ThreadCache *const pCache = TlsGetValue(dwTlsIndex);
+	SetLastError(dwLastError);
+	return pCache;
+}
+static bool SetThreadCache(DWORD dwTlsIndex, ThreadCache *pCache){
+	const DWORD dwLastError = GetLastError();
+	const bool bSucceeded = TlsSetValue(dwTlsIndex, pCache);
+	SetLastError(dwLastError);
+	return bSucceeded;
+}
+
+static ThreadCache *RequireThreadCache(void){
+	const DWORD dwTlsIndex = __atomic_load_n(&g_dwTlsIndex, __ATOMIC_RELAXED);
+	if(_MCFCRT_EXPECT_NOT(dwTlsIndex == TLS_OUT_OF_INDEXES)){
+		return _MCFCRT_NULLPTR;
+	}
+	ThreadCache *pCache = GetThreadCache(dwTlsIndex);
+	if(_MCFCRT_EXPECT_NOT(pCache == DETACHED_THREAD_CACHE)){
+		return _MCFCRT_NULLPTR;
+	}
+	if(_MCFCRT_EXPECT_NOT(!pCache)){
+		FreeBlock *pBlock;
+		if(FetchBlocksFromSlabs(&pBlock, GetClassIndex(sizeof(ThreadCache)), 1) == 0){
+			return _MCFCRT_NULLPTR;
+		}
+		pCache = (void *)pBlock;
+		_MCFCRT_inline_mempset_fwd(pCache, 0, sizeof(ThreadCache));
+		if(!SetThreadCache(dwTlsIndex, pCache)){
+			pBlock->pNext = _MCFCRT_NULLPTR;
+			ReturnBlocksToSlabs(GetClassIndex(sizeof(ThreadCache)), pBlock);
+			return _MCFCRT_NULLPTR;
+		}
+		pCache->uThreadId = GetCurrentThreadId();
+
+		_MCFCRT_WaitForMutexForever(&g_mtxThreadCacheList, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		ThreadCache *const pNext = g_pFirstThreadCache;
+		if(pNext){
+			pNext->pPrev = pCache;
+		}
+		pCache->pNext = pNext;
+		g_pFirstThreadCache = pCache;
+		_MCFCRT_SignalMutex(&g_mtxThreadCacheList);
+	}
+	return pCache;
+}
+// This function does not create a cache, so blocks freed after the thread cache is destroyed go back to slabs directly.
+static ThreadCache *PeekThreadCache(void){
+	const DWORD dwTlsIndex = __atomic_load_n(&g_dwTlsIndex, __ATOMIC_RELAXED);
+	if(_MCFCRT_EXPECT_NOT(dwTlsIndex == TLS_OUT_OF_INDEXES)){
+		return _MCFCRT_NULLPTR;
+	}
+	ThreadCache *const pCache = GetThreadCache(dwTlsIndex);
+	if(_MCFCRT_EXPECT_NOT(pCache == DETACHED_THREAD_CACHE)){
+		return _MCFCRT_NULLPTR;
+	}
+	return pCache;
+}
+static void FlushThreadCache(ThreadCache *pCache){
+	// Unlink the cache, then merge its counters into shared ones, so they are counted exactly once by `__MCFCRT_HeapEngineGetStatistics()`.
+	_MCFCRT_WaitForMutexForever(&g_mtxThreadCacheList, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	ThreadCache *const pPrev = pCache->pPrev;
+	ThreadCache *const pNext = pCache->pNext;
+	if(pPrev){
+		pPrev->pNext = pNext;
+	} else {
+		g_pFirstThreadCache = pNext;
+	}
+	if(pNext){
+		pNext->pPrev = pPrev;
+	}
+	const Counters *const pCounters = &(pCache->vCounters);
+	__atomic_add_fetch(&(g_vSharedCounters.u64BytesAllocated), pCounters->u64BytesAllocated, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(g_vSharedCounters.u64BytesFreed), pCounters->u64BytesFreed, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(g_vSharedCounters.u64AllocationCount), pCounters->u64AllocationCount, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(g_vSharedCounters.u64FreeCount), pCounters->u64FreeCount, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(g_vSharedCounters.u64ReallocInPlaceCount), pCounters->u64ReallocInPlaceCount, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(g_vSharedCounters.u64ReallocCopyCount), pCounters->u64ReallocCopyCount, __ATOMIC_RELAXED);
+	for(size_t uIndex = 0; uIndex < _MCFCRT_HEAP_STATISTICS_BUCKET_COUNT; ++uIndex){
+		__atomic_add_fetch(g_vSharedCounters.au64AllocationCountBySize + uIndex, pCounters->au64AllocationCountBySize[uIndex], __ATOMIC_RELAXED);
+	}
+	AddBytesInUse(pCache->nBytesPending);
+	_MCFCRT_SignalMutex(&g_mtxThreadCacheList);
+
+	for(size_t uClass = 0; uClass < CLASS_COUNT; ++uClass){
+		CacheBin *const pBin = pCache->aBins + uClass;
+		if(pBin->pHead){
+			ReturnBlocksToSlabs(uClass, pBin->pHead);
+			pBin->pHead = _MCFCRT_NULLPTR;
+			pBin->uCount = 0;
+		}
+	}
+	FreeBlock *const pBlock = (void *)pCache;
+	pBlock->pNext = _MCFCRT_NULLPTR;
+	ReturnBlocksToSlabs(GetClassIndex(sizeof(ThreadCache)), pBlock);
+}
+
+static void *AllocSmall(ThreadCache *pCache, size_t uClass){
+	FreeBlock *pBlock;
+	if(_MCFCRT_EXPECT_NOT(!pCache)){
+		if(FetchBlocksFromSlabs(&pBlock, uClass, 1) == 0){
+			return _MCFCRT_NULLPTR;
+		}
+		return pBlock;
+	}
+	CacheBin *const pBin = pCache->aBins + uClass;
+	pBlock = pBin->pHead;
+	if(_MCFCRT_EXPECT_NOT(!pBlock)){
+		const size_t uCount = FetchBlocksFromSlabs(&pBlock, uClass, GetBatchSize(uClass));
+		if(uCount == 0){
+			return _MCFCRT_NULLPTR;
+		}
+		pBin->uCount = uCount;
+	}
+	pBin->pHead = pBlock->pNext;
+	--(pBin->uCount);
+	return pBlock;
+}
+static void FreeSmall(ThreadCache *pCache, size_t uClass, void *pStorage){
+	FreeBlock *const pBlock = pStorage;
+	if(_MCFCRT_EXPECT_NOT(!pCache)){
+		pBlock->pNext = _MCFCRT_NULLPTR;
+		ReturnBlocksToSlabs(uClass, pBlock);
+		return;
+	}
+	CacheBin *const pBin = pCache->aBins + uClass;
+	pBlock->pNext = pBin->pHead;
+	pBin->pHead = pBlock;
+	++(pBin->uCount);
+	const size_t uBatchSize = GetBatchSize(uClass);
+	if(_MCFCRT_EXPECT_NOT(pBin->uCount > uBatchSize * 2)){
+		// Give a batch back from the head of the list, which saves a walk to its tail.
+		FreeBlock *const pHead = pBin->pHead;
+		FreeBlock *pLast = pHead;
+		for(size_t uIndex = 1; uIndex < uBatchSize; ++uIndex){
+			pLast = pLast->pNext;
+		}
+		pBin->pHead = pLast->pNext;
+		pBin->uCount -= uBatchSize;
+		pLast->pNext = _MCFCRT_NULLPTR;
+		ReturnBlocksToSlabs(uClass, pHead);
+	}
+}
+
+static inline bool CalculateSizeToMap(size_t *restrict puSizeToMap, size_t uSize, size_t uBlockOffset){
+	size_t uSizeToMap;
+	if(__builtin_add_overflow(uSize, uBlockOffset + PAGE_SIZE - 1, &uSizeToMap)){
+		return false;
+	}
+	*puSizeToMap = uSizeToMap & ~(PAGE_SIZE - 1);
+	return true;
+}
+
+// Large blocks that are small enough to be cached are rounded up like size classes, four sizes between each two adjacent powers of two, so a
+// freed block can be reused for any request that rounds up to the same size.
+static inline size_t RoundUpCachedLargeSize(size_t uSizeToMap){
+	_MCFCRT_ASSERT((uSizeToMap != 0) && (uSizeToMap <= MAX_CACHED_LARGE_SIZE));
+	const unsigned uLog2 = 63 - (unsigned)__builtin_clzll(uSizeToMap - 1);
+	size_t uStep = (size_t)1 << (uLog2 - 2);
+	if(uStep < PAGE_SIZE){
+		uStep = PAGE_SIZE;
+	}
+	return (uSizeToMap + uStep - 1) & ~(uStep - 1);
+}
+
+typedef struct tagLargeCacheBin {
+	Chunk *pFirst;
+	size_t uCount;
+} LargeCacheBin;
+
+// Bins are indexed by the number of pages, most of which are never used. The table is small enough anyway.
+static _MCFCRT_Mutex g_mtxLargeCache = { 0 };
+static LargeCacheBin g_aLargeCacheBins[MAX_CACHED_LARGE_SIZE / PAGE_SIZE + 1];
+
+static Chunk *TakeCachedLarge(size_t uSizeMapped){
+	LargeCacheBin *const pBin = g_aLargeCacheBins + uSizeMapped / PAGE_SIZE;
+	if(!__atomic_load_n(&(pBin->pFirst), __ATOMIC_RELAXED)){
+		return _MCFCRT_NULLPTR;
+	}
+	_MCFCRT_WaitForMutexForever(&g_mtxLargeCache, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	Chunk *const pChunk = pBin->pFirst;
+	if(pChunk){
+		__atomic_store_n(&(pBin->pFirst), pChunk->pNextCached, __ATOMIC_RELAXED);
+		--(pBin->uCount);
+	}
+	_MCFCRT_SignalMutex(&g_mtxLargeCache);
+	return pChunk;
+}
+static bool CacheLarge(Chunk *pChunk){
+	const size_t uSizeMapped = pChunk->uBlockOffset + pChunk->uUsableSize;
+	// Blocks that have been resized in place may have any number of pages. Only those that will be asked for again are kept.
+	if((uSizeMapped > MAX_CACHED_LARGE_SIZE) || (RoundUpCachedLargeSize(uSizeMapped) != uSizeMapped)){
+		return false;
+	}
+	LargeCacheBin *const pBin = g_aLargeCacheBins + uSizeMapped / PAGE_SIZE;
+	bool bCached = false;
+	_MCFCRT_WaitForMutexForever(&g_mtxLargeCache, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	if(pBin->uCount < LARGE_CACHE_DEPTH){
+		pChunk->pNextCached = pBin->pFirst;
+		__atomic_store_n(&(pBin->pFirst), pChunk, __ATOMIC_RELAXED);
+		++(pBin->uCount);
+		bCached = true;
+	}
+	_MCFCRT_SignalMutex(&g_mtxLargeCache);
+	return bCached;
+}
+static void ReleaseCachedLarge(void){
+	for(size_t uIndex = 0; uIndex < sizeof(g_aLargeCacheBins) / sizeof(g_aLargeCacheBins[0]); ++uIndex){
+		LargeCacheBin *const pBin = g_aLargeCacheBins + uIndex;
+		Chunk *pChunk = pBin->pFirst;
+		pBin->pFirst = _MCFCRT_NULLPTR;
+		pBin->uCount = 0;
+		while(pChunk){
+			Chunk *const pNext = pChunk->pNextCached;
+			const bool bSucceeded = VirtualFree(pChunk, 0, MEM_RELEASE);
+			_MCFCRT_ASSERT_MSG(bSucceeded, L"VirtualFree() 失败。");
+			pChunk = pNext;
+		}
+	}
+}
+
+static void *AllocLarge(size_t uSize, size_t uBlockOffset, bool bFillsWithZero){
+	size_t uSizeToMap;
+	if(!CalculateSizeToMap(&uSizeToMap, uSize, uBlockOffset)){
+		return _MCFCRT_NULLPTR;
+	}
+	Chunk *pChunk;
+	if(uSizeToMap <= MAX_CACHED_LARGE_SIZE){
+		uSizeToMap = RoundUpCachedLargeSize(uSizeToMap);
+		// A cached block has exactly `uSizeToMap` bytes committed, but they are not zeroed.
+		pChunk = TakeCachedLarge(uSizeToMap);
+		if(pChunk){
+			pChunk->uBlockOffset = uBlockOffset;
+			pChunk->uUsableSize  = uSizeToMap - uBlockOffset;
+			unsigned char *const pbyStorage = (unsigned char *)pChunk + uBlockOffset;
+			if(bFillsWithZero){
+				_MCFCRT_inline_mempset_fwd(pbyStorage, 0, pChunk->uUsableSize);
+			}
+			return pbyStorage;
+		}
+	}
+	pChunk = _MCFCRT_NULLPTR;
+	size_t uSizeToReserve;
+	if(!__builtin_mul_overflow(uSizeToMap, RESERVATION_FACTOR, &uSizeToReserve) && (uSizeToReserve <= SIZE_MAX - (CHUNK_ALIGNMENT - 1))){
+		uSizeToReserve = (uSizeToReserve + CHUNK_ALIGNMENT - 1) & ~(CHUNK_ALIGNMENT - 1);
+		pChunk = VirtualAlloc(_MCFCRT_NULLPTR, uSizeToReserve, MEM_RESERVE, PAGE_NOACCESS);
+	}
+	if(!pChunk){
+		// Address space may be scarce. Reserve only what is needed.
+		uSizeToReserve = uSizeToMap;
+		pChunk = VirtualAlloc(_MCFCRT_NULLPTR, uSizeToReserve, MEM_RESERVE, PAGE_NOACCESS);
+		if(!pChunk){
+			return _MCFCRT_NULLPTR;
+		}
+	}
+	_MCFCRT_ASSERT(((uintptr_t)pChunk & (CHUNK_ALIGNMENT - 1)) == 0);
+	// Pages committed by `VirtualAlloc()` are zeroed by the system.
+	if(!VirtualAlloc(pChunk, uSizeToMap, MEM_COMMIT, PAGE_READWRITE)){
+		const bool bSucceeded = VirtualFree(pChunk, 0, MEM_RELEASE);
+		_MCFCRT_ASSERT_MSG(bSucceeded, L"VirtualFree() 失败。");
+		return _MCFCRT_NULLPTR;
+	}
+	pChunk->uClass        = CLASS_LARGE;
+	pChunk->uBlockOffset  = uBlockOffset;
+	pChunk->uUsableSize   = uSizeToMap - uBlockOffset;
+	pChunk->uReservedSize = uSizeToReserve;
+	return (unsigned char *)pChunk + uBlockOffset;
+}
+static bool ResizeLargeInPlace(Chunk *pChunk, size_t uSize){
+	size_t uSizeToMap;
+	if(!CalculateSizeToMap(&uSizeToMap, uSize, pChunk->uBlockOffset)){
+		return false;
+	}
+	if(uSizeToMap > pChunk->uReservedSize){
+		return false;
+	}
+	const size_t uSizeMapped = pChunk->uBlockOffset + pChunk->uUsableSize;
+	if(uSizeToMap > uSizeMapped){
+		// Pages that are committed again are zeroed by the system, too.
+		if(!VirtualAlloc((unsigned char *)pChunk + uSizeMapped, uSizeToMap - uSizeMapped, MEM_COMMIT, PAGE_READWRITE)){
+			return false;
+		}
+	} else if(uSizeToMap < uSizeMapped){
+		const bool bSucceeded = VirtualFree((unsigned char *)pChunk + uSizeToMap, uSizeMapped - uSizeToMap, MEM_DECOMMIT);
+		_MCFCRT_ASSERT_MSG(bSucceeded, L"VirtualFree() 失败。");
+	}
+	pChunk->uUsableSize = uSizeToMap - pChunk->uBlockOffset;
+	return true;
+}
+static void FreeLarge(Chunk *pChunk){
+	if(CacheLarge(pChunk)){
+		return;
+	}
+	const bool bSucceeded = VirtualFree(pChunk, 0, MEM_RELEASE);
+	_MCFCRT_ASSERT_MSG(bSucceeded, L"VirtualFree() 失败。");
+}
+
+bool __MCFCRT_HeapEngineInit(void){
+	const DWORD dwTlsIndex = TlsAlloc();
+	if(dwTlsIndex == TLS_OUT_OF_INDEXES){
+		return false;
+	}
+	__atomic_store_n(&g_dwTlsIndex, dwTlsIndex, __ATOMIC_RELAXED);
+	return true;
+}
+void __MCFCRT_HeapEngineUninit(void){
+	__MCFCRT_HeapEngineThreadCleanup();
+	ReleaseCachedLarge();
+
+	const DWORD dwTlsIndex = __atomic_exchange_n(&g_dwTlsIndex, TLS_OUT_OF_INDEXES, __ATOMIC_RELAXED);
+	if(dwTlsIndex == TLS_OUT_OF_INDEXES){
+		return;
+	}
+	const bool bSucceeded = TlsFree(dwTlsIndex);
+	_MCFCRT_ASSERT(bSucceeded);
+}
+
+void __MCFCRT_HeapEngineThreadCleanup(void){
+	const DWORD dwTlsIndex = __atomic_load_n(&g_dwTlsIndex, __ATOMIC_RELAXED);
+	if(dwTlsIndex == TLS_OUT_OF_INDEXES){
+		return;
+	}
+	ThreadCache *const pCache = GetThreadCache(dwTlsIndex);
+	if(pCache == DETACHED_THREAD_CACHE){
+		return;
+	}
+	SetThreadCache(dwTlsIndex, DETACHED_THREAD_CACHE);
+	if(!pCache){
+		return;
+	}
+	FlushThreadCache(pCache);
+}
+
+static void *AllocSmallStorage(ThreadCache *pCache, size_t uClass, bool bFillsWithZero){
+	void *const pStorage = AllocSmall(pCache, uClass);
+	if(!pStorage){
+		return _MCFCRT_NULLPTR;
+	}
+	if(bFillsWithZero){
+		_MCFCRT_inline_mempset_fwd(pStorage, 0, kBlockSizeTable[uClass]);
+	}
+	return pStorage;
+}
+static void *AllocStorage(ThreadCache *pCache, size_t uSize, bool bFillsWithZero){
+	if(_MCFCRT_EXPECT_NOT(uSize > MAX_SMALL_SIZE)){
+		return AllocLarge(uSize, CHUNK_HEADER_SIZE, bFillsWithZero);
+	}
+	return AllocSmallStorage(pCache, GetClassIndex(uSize), bFillsWithZero);
+}
+// Blocks in a slab are laid out contiguously after the header of the slab, so they are aligned if both `CHUNK_HEADER_SIZE` and their size are
+// multiples of the alignment. If no size class is suitable, a large block is allocated with its offset in the chunk raised to the alignment.
+static void *AllocAlignedStorage(ThreadCache *pCache, size_t uSize, size_t uAlignment, bool bFillsWithZero){
+	if(uAlignment <= alignof(max_align_t)){
+		return AllocStorage(pCache, uSize, bFillsWithZero);
+	}
+	if((uAlignment <= CHUNK_HEADER_SIZE) && (uSize <= MAX_SMALL_SIZE)){
+		size_t uClass = GetClassIndex(uSize);
+		while(kBlockSizeTable[uClass] % uAlignment != 0){
+			++uClass;
+		}
+		return AllocSmallStorage(pCache, uClass, bFillsWithZero);
+	}
+	return AllocLarge(uSize, (uAlignment > CHUNK_HEADER_SIZE) ? uAlignment : CHUNK_HEADER_SIZE, bFillsWithZero);
+}
+static void FreeStorage(ThreadCache *pCache, void *pStorage){
+	Chunk *const pChunk = GetChunk(pStorage);
+	if(_MCFCRT_EXPECT_NOT(pChunk->uClass == CLASS_LARGE)){
+		FreeLarge(pChunk);
+		return;
+	}
+	FreeSmall(pCache, pChunk->uClass, pStorage);
+}
+
+static void AccountForAllocation(ThreadCache *pCache, size_t uSize, void *pStorage){
+	Counters *const pCounters = GetCounters(pCache);
+	IncreaseCounter(&(pCounters->u64AllocationCount), pCache, 1);
+	IncreaseCounter(pCounters->au64AllocationCountBySize + GetStatisticsBucketIndex(uSize), pCache, 1);
+	AccountForBytes(pCache, GetUsableSize(GetChunk(pStorage)), 0);
+}
+
+void *__MCFCRT_HeapEngineAlloc(size_t uSize, bool bFillsWithZero){
+	ThreadCache *const pCache = RequireThreadCache();
+	void *const pStorage = AllocStorage(pCache, uSize, bFillsWithZero);
+	if(!pStorage){
+		return _MCFCRT_NULLPTR;
+	}
+	AccountForAllocation(pCache, uSize, pStorage);
+	return pStorage;
+}
+void *__MCFCRT_HeapEngineAllocAligned(size_t uSize, size_t uAlignment, bool bFillsWithZero){
+	_MCFCRT_ASSERT((uAlignment != 0) && ((uAlignment & (uAlignment - 1)) == 0) && (uAlignment <= _MCFCRT_HEAP_MAX_ALIGNMENT));
+
+	ThreadCache *const pCache = RequireThreadCache();
+	void *const pStorage = AllocAlignedStorage(pCache, uSize, uAlignment, bFillsWithZero);
+	if(!pStorage){
+		return _MCFCRT_NULLPTR;
+	}
+	AccountForAllocation(pCache, uSize, pStorage);
+	return pStorage;
+}
+void *__MCFCRT_HeapEngineRealloc(void *pStorageOld, size_t uSize, bool bFillsWithZero){
+	ThreadCache *const pCache = RequireThreadCache();
+	Chunk *const pChunkOld = GetChunk(pStorageOld);
+	const size_t uUsableSizeOld = GetUsableSize(pChunkOld);
+	if((pChunkOld->uClass == CLASS_LARGE) && (uSize > MAX_SMALL_SIZE)){
+		// Grow or shrink a large block in place if it does not outgrow its reserved address space.
+		if(ResizeLargeInPlace(pChunkOld, uSize)){
+			const size_t uUsableSizeNew = pChunkOld->uUsableSize;
+			IncreaseCounter(&(GetCounters(pCache)->u64ReallocInPlaceCount), pCache, 1);
+			if(uUsableSizeNew >= uUsableSizeOld){
+				AccountForBytes(pCache, uUsableSizeNew - uUsableSizeOld, 0);
+			} else {
+				AccountForBytes(pCache, 0, uUsableSizeOld - uUsableSizeNew);
+			}
+			return pStorageOld;
+		}
+	} else if((uSize <= uUsableSizeOld) && (uSize >= uUsableSizeOld / 2)){
+		// Reuse the old block if it is large enough and not too large.
+		IncreaseCounter(&(GetCounters(pCache)->u64ReallocInPlaceCount), pCache, 1);
+		return pStorageOld;
+	}
+	void *const pStorageNew = AllocStorage(pCache, uSize, false);
+	if(!pStorageNew){
+		return _MCFCRT_NULLPTR;
+	}
+	const size_t uUsableSizeNew = GetUsableSize(GetChunk(pStorageNew));
+	if(uUsableSizeNew <= uUsableSizeOld){
+		_MCFCRT_inline_mempcpy_fwd(pStorageNew, pStorageOld, uUsableSizeNew);
+	} else {
+		unsigned char *const pbyWrite = _MCFCRT_inline_mempcpy_fwd(pStorageNew, pStorageOld, uUsableSizeOld);
+		if(bFillsWithZero){
+			_MCFCRT_inline_mempset_fwd(pbyWrite, 0, uUsableSizeNew - uUsableSizeOld);
+		}
+	}
+	FreeStorage(pCache, pStorageOld);
+	IncreaseCounter(&(GetCounters(pCache)->u64ReallocCopyCount), pCache, 1);
+	AccountForBytes(pCache, uUsableSizeNew, uUsableSizeOld);
+	return pStorageNew;
+}
+void __MCFCRT_HeapEngineFree(void *pStorageOld){
+	ThreadCache *const pCache = PeekThreadCache();
+	const size_t uUsableSizeOld = GetUsableSize(GetChunk(pStorageOld));
+	FreeStorage(pCache, pStorageOld);
+	IncreaseCounter(&(GetCounters(pCache)->u64FreeCount), pCache, 1);
+	AccountForBytes(pCache, 0, uUsableSizeOld);
+}
+
+size_t __MCFCRT_HeapEngineGetUsableSize(const void *pStorage){
+	return GetUsableSize(GetChunk(pStorage));
+}
+
+static void AddCounters(_MCFCRT_HeapStatistics *restrict pStatistics, const Counters *pCounters){
+	pStatistics->__u64BytesAllocated      += __atomic_load_n(&(pCounters->u64BytesAllocated), __ATOMIC_RELAXED);
+	pStatistics->__u64BytesFreed          += __atomic_load_n(&(pCounters->u64BytesFreed), __ATOMIC_RELAXED);
+	pStatistics->__u64AllocationCount     += __atomic_load_n(&(pCounters->u64AllocationCount), __ATOMIC_RELAXED);
+	pStatistics->__u64FreeCount           += __atomic_load_n(&(pCounters->u64FreeCount), __ATOMIC_RELAXED);
+	pStatistics->__u64ReallocInPlaceCount += __atomic_load_n(&(pCounters->u64ReallocInPlaceCount), __ATOMIC_RELAXED);
+	pStatistics->__u64ReallocCopyCount    += __atomic_load_n(&(pCounters->u64ReallocCopyCount), __ATOMIC_RELAXED);
+	for(size_t uIndex = 0; uIndex < _MCFCRT_HEAP_STATISTICS_BUCKET_COUNT; ++uIndex){
+		pStatistics->__au64AllocationCountBySize[uIndex] += __atomic_load_n(pCounters->au64AllocationCountBySize + uIndex, __ATOMIC_RELAXED);
+	}
+}
+
+void __MCFCRT_HeapEngineGetStatistics(_MCFCRT_HeapStatistics *pStatistics){
+	_MCFCRT_inline_mempset_fwd(pStatistics, 0, sizeof(*pStatistics));
+
+	_MCFCRT_WaitForMutexForever(&g_mtxThreadCacheList, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	AddCounters(pStatistics, &g_vSharedCounters);
+	for(const ThreadCache *pCache = g_pFirstThreadCache; pCache; pCache = pCache->pNext){
+		AddCounters(pStatistics, &(pCache->vCounters));
+		++(pStatistics->__uThreadCount);
+	}
+	_MCFCRT_SignalMutex(&g_mtxThreadCacheList);
+
+	const size_t uBytesInUse = (size_t)(pStatistics->__u64BytesAllocated - pStatistics->__u64BytesFreed);
+	pStatistics->__uBytesInUse = uBytesInUse;
+	pStatistics->__uPeakBytesInUse = UpdatePeakBytesInUse(uBytesInUse);
+}
+size_t __MCFCRT_HeapEngineGetThreadStatistics(_MCFCRT_HeapThreadStatistics *restrict pThreads, size_t uMaxCount){
+	size_t uCount = 0;
+	_MCFCRT_WaitForMutexForever(&g_mtxThreadCacheList, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	for(const ThreadCache *pCache = g_pFirstThreadCache; pCache; pCache = pCache->pNext){
+		if(uCount < uMaxCount){
+			_MCFCRT_HeapThreadStatistics *const pThread = pThreads + uCount;
+			const Counters *const pCounters = &(pCache->vCounters);
+			pThread->__uThreadId          = pCache->uThreadId;
+			pThread->__u64BytesAllocated  = __atomic_load_n(&(pCounters->u64BytesAllocated), __ATOMIC_RELAXED);
+			pThread->__u64BytesFreed      = __atomic_load_n(&(pCounters->u64BytesFreed), __ATOMIC_RELAXED);
+			pThread->__u64AllocationCount = __atomic_load_n(&(pCounters->u64AllocationCount), __ATOMIC_RELAXED);
+			pThread->__u64FreeCount       = __atomic_load_n(&(pCounters->u64FreeCount), __ATOMIC_RELAXED);
+		}
+		++uCount;
+	}
+	_MCFCRT_SignalMutex(&g_mtxThreadCacheList);
+	return uCount;
+}
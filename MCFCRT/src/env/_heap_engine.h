@@ -0,0 +1,47 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_HEAP_ENGINE_H_
+#define __MCFCRT_ENV_HEAP_ENGINE_H_
+
+#include "_crtdef.h"
+#include "heap.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// The heap engine is what `__MCFCRT_HeapAlloc()` and its friends are built on.
+// Small blocks are carved out of 64KiB slabs that are divided into size classes. Each thread caches a few free blocks for each size class, which it
+// fetches from and returns to the global slab lists in batches. Blocks freed by other threads go into the cache of the freeing thread and migrate back
+// in batches, too. Large blocks are mapped directly, with extra address space reserved after them, so they can be reallocated in place without copying
+// in most cases. Freed large blocks of up to 320KiB are kept in a bounded global cache and reused for requests of the same rounded size.
+// Pages are obtained from the system via `VirtualAlloc()` and the system heap is not used at all.
+
+extern bool __MCFCRT_HeapEngineInit(void) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_HeapEngineUninit(void) _MCFCRT_NOEXCEPT;
+
+// This function returns all blocks cached by the calling thread to the global lists. It is called when a thread exits and may be called more than once.
+// The calling thread will not cache blocks any more. Blocks that it allocates or frees afterwards go to the global lists directly.
+extern void __MCFCRT_HeapEngineThreadCleanup(void) _MCFCRT_NOEXCEPT;
+
+// These functions do not touch the per-thread error code.
+// If `__bFillsWithZero` is `true`, the entire usable size of a newly allocated block is zeroed. When a block is reallocated with `__bFillsWithZero`
+// set to `true`, bytes beyond its old usable size are zeroed.
+// `__MCFCRT_HeapEngineRealloc()` returns a null pointer and leaves the old block intact in case of failure.
+__attribute__((__malloc__)) extern void * __MCFCRT_HeapEngineAlloc(_MCFCRT_STD size_t __uSize, bool __bFillsWithZero) _MCFCRT_NOEXCEPT;
+// `__uAlignment` shall be a power of two that is no greater than `_MCFCRT_HEAP_MAX_ALIGNMENT`. Over-aligned blocks can be reallocated and freed as
+// usual. Reallocation preserves the alignment if the block is not moved.
+__attribute__((__malloc__)) extern void * __MCFCRT_HeapEngineAllocAligned(_MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment, bool __bFillsWithZero) _MCFCRT_NOEXCEPT;
+__attribute__((__nonnull__(1))) extern void * __MCFCRT_HeapEngineRealloc(void *__pStorageOld, _MCFCRT_STD size_t __uSize, bool __bFillsWithZero) _MCFCRT_NOEXCEPT;
+__attribute__((__nonnull__(1))) extern void __MCFCRT_HeapEngineFree(void *__pStorageOld) _MCFCRT_NOEXCEPT;
+
+// This function returns the number of bytes that can be used in a block, which is never less than the size that was requested.
+__attribute__((__nonnull__(1))) extern _MCFCRT_STD size_t __MCFCRT_HeapEngineGetUsableSize(const void *__pStorage) _MCFCRT_NOEXCEPT;
+
+// Counters are kept per thread and are merged into shared ones when a thread exits. These functions implement the public ones in `heap.h`.
+extern void __MCFCRT_HeapEngineGetStatistics(_MCFCRT_HeapStatistics *__pStatistics) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t __MCFCRT_HeapEngineGetThreadStatistics(_MCFCRT_HeapThreadStatistics *_MCFCRT_RESTRICT __pThreads, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
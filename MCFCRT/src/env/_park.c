@@ -0,0 +1,205 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_park.h"
+#include "clocks.h"
+#include "xassert.h"
+
+#ifdef _WIN32
+
+#include "_nt_timeout.h"
+#include "mcfwin.h"
+#include <ntdef.h>
+
+__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtWaitForKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
+__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtReleaseKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
+
+__attribute__((__dllimport__, __stdcall__, __const__)) extern BOOLEAN RtlDllShutdownInProgress(void);
+
+bool __MCFCRT_ParkThread(void *pKey, uint64_t u64UntilFastMonoClock){
+	LARGE_INTEGER liTimeout;
+	__MCFCRT_InitializeNtTimeout(&liTimeout, u64UntilFastMonoClock);
+	const NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, pKey, false, &liTimeout);
+	_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+	return lStatus != STATUS_TIMEOUT;
+}
+void __MCFCRT_ParkThreadForever(void *pKey){
+	const NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, pKey, false, _MCFCRT_NULLPTR);
+	_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+	_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+}
+void __MCFCRT_UnparkThread(void *pKey){
+	const NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, pKey, false, _MCFCRT_NULLPTR);
+	_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
+	_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+}
+
+bool __MCFCRT_IsShutdownInProgress(void){
+	return RtlDllShutdownInProgress();
+}
+
+#else
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Keyed events are emulated with a table of wait queues, which is indexed by keys. Parked threads and blocked unparkers are both queued,
+// and each of them is matched with the first one of the other kind having the same key. Every node sleeps on its own futex.
+
+#define BUCKET_COUNT_LOG2       8u
+#define BUCKET_COUNT            ((size_t)1 << BUCKET_COUNT_LOG2)
+
+typedef struct tagParkNode {
+	struct tagParkNode *pPrev;
+	struct tagParkNode *pNext;
+	void *pKey;
+	bool bUnparker;
+	uint32_t u32Matched;
+} ParkNode;
+
+typedef struct __attribute__((__aligned__(64))) tagParkBucket {
+	// 0 = unlocked, 1 = locked, 2 = locked and contended.
+	uint32_t u32Lock;
+	ParkNode *pFirst;
+	ParkNode *pLast;
+} ParkBucket;
+
+static ParkBucket g_aBuckets[BUCKET_COUNT];
+
+static inline long Futex(uint32_t *pu32Word, int nOperation, uint32_t u32Value, const struct timespec *pTimeout){
+	return syscall(SYS_futex, pu32Word, nOperation, u32Value, pTimeout, _MCFCRT_NULLPTR, 0);
+}
+
+// Buckets cannot be protected by `_MCFCRT_Mutex`, which is built on top of this file.
+static void LockBucket(ParkBucket *pBucket){
+	uint32_t u32Old = 0;
+	if(__atomic_compare_exchange_n(&(pBucket->u32Lock), &u32Old, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+		return;
+	}
+	if(u32Old != 2){
+		u32Old = __atomic_exchange_n(&(pBucket->u32Lock), 2, __ATOMIC_ACQUIRE);
+	}
+	while(u32Old != 0){
+		Futex(&(pBucket->u32Lock), FUTEX_WAIT_PRIVATE, 2, _MCFCRT_NULLPTR);
+		u32Old = __atomic_exchange_n(&(pBucket->u32Lock), 2, __ATOMIC_ACQUIRE);
+	}
+}
+static void UnlockBucket(ParkBucket *pBucket){
+	if(__atomic_exchange_n(&(pBucket->u32Lock), 0, __ATOMIC_RELEASE) == 2){
+		Futex(&(pBucket->u32Lock), FUTEX_WAKE_PRIVATE, 1, _MCFCRT_NULLPTR);
+	}
+}
+
+static inline ParkBucket *GetBucket(void *pKey){
+	const uintptr_t uHash = ((uintptr_t)pKey >> 2) * (uintptr_t)0x9E3779B97F4A7C15u;
+	return g_aBuckets + (uHash >> (sizeof(uintptr_t) * CHAR_BIT - BUCKET_COUNT_LOG2));
+}
+
+static void Append(ParkBucket *pBucket, ParkNode *pNode){
+	pNode->pPrev = pBucket->pLast;
+	pNode->pNext = _MCFCRT_NULLPTR;
+	if(pBucket->pLast){
+		pBucket->pLast->pNext = pNode;
+	} else {
+		pBucket->pFirst = pNode;
+	}
+	pBucket->pLast = pNode;
+}
+static void Unlink(ParkBucket *pBucket, ParkNode *pNode){
+	if(pNode->pPrev){
+		pNode->pPrev->pNext = pNode->pNext;
+	} else {
+		pBucket->pFirst = pNode->pNext;
+	}
+	if(pNode->pNext){
+		pNode->pNext->pPrev = pNode->pPrev;
+	} else {
+		pBucket->pLast = pNode->pPrev;
+	}
+}
+// The bucket mutex must be held by the caller.
+static bool MatchCounterpart(ParkBucket *pBucket, void *pKey, bool bUnparker){
+	for(ParkNode *pNode = pBucket->pFirst; pNode; pNode = pNode->pNext){
+		if((pNode->pKey == pKey) && (pNode->bUnparker != bUnparker)){
+			Unlink(pBucket, pNode);
+			// The owner of `pNode` locks the bucket before returning, so `pNode` remains valid until we unlock it.
+			__atomic_store_n(&(pNode->u32Matched), 1, __ATOMIC_RELEASE);
+			Futex(&(pNode->u32Matched), FUTEX_WAKE_PRIVATE, 1, _MCFCRT_NULLPTR);
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool ReallyPark(void *pKey, bool bUnparker, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	ParkBucket *const pBucket = GetBucket(pKey);
+	ParkNode vNode;
+	LockBucket(pBucket);
+	if(MatchCounterpart(pBucket, pKey, bUnparker)){
+		UnlockBucket(pBucket);
+		return true;
+	}
+	if(bMayTimeOut && (_MCFCRT_GetFastMonoClock() >= u64UntilFastMonoClock)){
+		UnlockBucket(pBucket);
+		return false;
+	}
+	vNode.pKey = pKey;
+	vNode.bUnparker = bUnparker;
+	vNode.u32Matched = 0;
+	Append(pBucket, &vNode);
+	UnlockBucket(pBucket);
+
+	for(;;){
+		if(__atomic_load_n(&(vNode.u32Matched), __ATOMIC_ACQUIRE) != 0){
+			break;
+		}
+		struct timespec vTimeout, *pTimeout = _MCFCRT_NULLPTR;
+		if(bMayTimeOut){
+			const uint64_t u64Now = _MCFCRT_GetFastMonoClock();
+			if(u64Now >= u64UntilFastMonoClock){
+				bool bMatched;
+				LockBucket(pBucket);
+				{
+					bMatched = __atomic_load_n(&(vNode.u32Matched), __ATOMIC_ACQUIRE) != 0;
+					if(!bMatched){
+						Unlink(pBucket, &vNode);
+					}
+				}
+				UnlockBucket(pBucket);
+				return bMatched;
+			}
+			const uint64_t u64DeltaMs = u64UntilFastMonoClock - u64Now;
+			vTimeout.tv_sec = (time_t)(u64DeltaMs / 1000);
+			vTimeout.tv_nsec = (long)(u64DeltaMs % 1000) * 1000000;
+			pTimeout = &vTimeout;
+		}
+		// This returns immediately if we have been matched in the meantime.
+		Futex(&(vNode.u32Matched), FUTEX_WAIT_PRIVATE, 0, pTimeout);
+	}
+	// Wait for `MatchCounterpart()` to finish with our node.
+	LockBucket(pBucket);
+	UnlockBucket(pBucket);
+	return true;
+}
+
+bool __MCFCRT_ParkThread(void *pKey, uint64_t u64UntilFastMonoClock){
+	return ReallyPark(pKey, false, true, u64UntilFastMonoClock);
+}
+void __MCFCRT_ParkThreadForever(void *pKey){
+	const bool bUnparked = ReallyPark(pKey, false, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bUnparked);
+}
+void __MCFCRT_UnparkThread(void *pKey){
+	const bool bMatched = ReallyPark(pKey, true, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bMatched);
+}
+
+bool __MCFCRT_IsShutdownInProgress(void){
+	// Threads are not terminated forcibly here.
+	return false;
+}
+
+#endif
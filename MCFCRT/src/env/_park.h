@@ -0,0 +1,30 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_PARK_H_
+#define __MCFCRT_ENV_PARK_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// This is the platform layer on which all synchronization primitives park and unpark threads. It has the semantics of NT keyed events:
+// Each call to `__MCFCRT_UnparkThread()` wakes up exactly one thread parked with the same key. If no such thread is parked, it blocks until one is.
+// Keys are addresses and need not be registered or initialized. They are usually the addresses of control words, so no kernel object is required.
+// On Windows these functions forward to `NtWaitForKeyedEvent()` and `NtReleaseKeyedEvent()`. Elsewhere they are implemented on top of futexes,
+// so the exact same lock algorithms can be built, benchmarked and checked with thread sanitizers on Linux.
+
+// `false` is returned if the time point has been reached before another thread unparks this one.
+// When that happens, the caller must make sure that no one is going to unpark it, or park once more to consume the pending unpark operation.
+extern bool __MCFCRT_ParkThread(void *__pKey, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ParkThreadForever(void *__pKey) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_UnparkThread(void *__pKey) _MCFCRT_NOEXCEPT;
+
+// If this function returns `true`, all other threads will have been terminated.
+// Unparking a thread in this case results in deadlocks, as no thread will ever consume it. Don't do that.
+__attribute__((__const__)) extern bool __MCFCRT_IsShutdownInProgress(void) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
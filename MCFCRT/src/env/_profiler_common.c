@@ -0,0 +1,144 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "_profiler_common.h"
+#include "mcfwin.h"
+#include "standard_streams.h"
+#include "inline_mem.h"
+#include "../ext/wcpcpy.h"
+#include "../ext/itow.h"
+#include "../ext/utf.h"
+
+static inline const void *volatile *GetSiteKey(void *pSites, size_t uSiteSize, size_t uIndex){
+	return (const void *volatile *)((char *)pSites + uSiteSize * uIndex);
+}
+
+size_t __MCFCRT_ProfilerRequireSite(void *pSites, size_t uSiteSize, const void *pKey){
+	if(!pKey){
+		return __MCFCRT_PROFILER_SITE_COUNT;
+	}
+	const size_t uHash = __MCFCRT_ProfilerHashPointer(pKey);
+	for(size_t uProbe = 0; uProbe < __MCFCRT_PROFILER_SITE_MAX_PROBE_COUNT; ++uProbe){
+		const size_t uIndex = (uHash + uProbe) % __MCFCRT_PROFILER_SITE_COUNT;
+		const void *volatile *const ppKey = GetSiteKey(pSites, uSiteSize, uIndex);
+		const void *pCurrent = __atomic_load_n(ppKey, __ATOMIC_RELAXED);
+		if(pCurrent == pKey){
+			return uIndex;
+		}
+		if(pCurrent){
+			continue;
+		}
+		if(__atomic_compare_exchange_n(ppKey, &pCurrent, pKey, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+			return uIndex;
+		}
+		if(pCurrent == pKey){
+			return uIndex;
+		}
+	}
+	return __MCFCRT_PROFILER_SITE_COUNT;
+}
+
+static void SortSites(const __MCFCRT_ProfilerReport *pReport, char *pbySites, size_t uCount, void *pTemp){
+	const size_t uSiteSize = pReport->__uSiteSize;
+	// This is a Shell sort using Ciura's gap sequence.
+	static const size_t kGaps[] = { 701, 301, 132, 57, 23, 10, 4, 1 };
+	for(size_t uGapIndex = 0; uGapIndex < sizeof(kGaps) / sizeof(kGaps[0]); ++uGapIndex){
+		const size_t uGap = kGaps[uGapIndex];
+		for(size_t uIndex = uGap; uIndex < uCount; ++uIndex){
+			_MCFCRT_inline_mempcpy_fwd(pTemp, pbySites + uSiteSize * uIndex, uSiteSize);
+			size_t uInsert = uIndex;
+			while((uInsert >= uGap) && (*(pReport->__pfnSiteComesBefore))(pTemp, pbySites + uSiteSize * (uInsert - uGap))){
+				_MCFCRT_inline_mempcpy_fwd(pbySites + uSiteSize * uInsert, pbySites + uSiteSize * (uInsert - uGap), uSiteSize);
+				uInsert -= uGap;
+			}
+			_MCFCRT_inline_mempcpy_fwd(pbySites + uSiteSize * uInsert, pTemp, uSiteSize);
+		}
+	}
+}
+
+wchar_t *__MCFCRT_ProfilerPrintUint64(wchar_t *pwcWrite, uint64_t u64Value){
+	if(u64Value <= UINTPTR_MAX){
+		return _MCFCRT_itow_u(pwcWrite, (uintptr_t)u64Value);
+	}
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, u64Value / 1000000000);
+	return _MCFCRT_itow0u(pwcWrite, (uintptr_t)(u64Value % 1000000000), 9);
+}
+
+typedef bool (*LineWriter)(void *pContext, const wchar_t *pwcLine, size_t uLength);
+
+static bool WriteReport(const __MCFCRT_ProfilerReport *pReport, LineWriter pfnWriter, void *pContext){
+	const size_t uSiteSize = pReport->__uSiteSize;
+	// Do not allocate memory from the heap, which might be being profiled. The extra site is used as temporary storage when sorting.
+	const size_t uBufferSize = uSiteSize * (__MCFCRT_PROFILER_SITE_COUNT + 2);
+	char *const pbySites = VirtualAlloc(_MCFCRT_NULLPTR, uBufferSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if(!pbySites){
+		return false;
+	}
+	const size_t uCount = (*(pReport->__pfnGetSnapshot))(pbySites, __MCFCRT_PROFILER_SITE_COUNT + 1);
+	SortSites(pReport, pbySites, uCount, pbySites + uSiteSize * (__MCFCRT_PROFILER_SITE_COUNT + 1));
+
+	bool bSucceeded;
+	wchar_t awcLine[__MCFCRT_PROFILER_MAX_LINE_LENGTH];
+	wchar_t *pwcWrite = awcLine;
+	pwcWrite = (*(pReport->__pfnPrintHeader))(pwcWrite, uCount);
+	bSucceeded = (*pfnWriter)(pContext, awcLine, (size_t)(pwcWrite - awcLine));
+	for(size_t uIndex = 0; bSucceeded && (uIndex < uCount); ++uIndex){
+		const void *const pSite = pbySites + uSiteSize * uIndex;
+		const void *const pKey = *(const void *const *)pSite;
+		pwcWrite = awcLine;
+		if(pKey){
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"  0x");
+			pwcWrite = _MCFCRT_itow0X(pwcWrite, (uintptr_t)pKey, sizeof(void *) * 2);
+		} else {
+			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"  (other)");
+		}
+		pwcWrite = (*(pReport->__pfnPrintSite))(pwcWrite, pSite);
+		bSucceeded = (*pfnWriter)(pContext, awcLine, (size_t)(pwcWrite - awcLine));
+	}
+
+	const DWORD dwErrorCode = GetLastError();
+	VirtualFree(pbySites, 0, MEM_RELEASE);
+	SetLastError(dwErrorCode);
+	return bSucceeded;
+}
+
+static bool StandardErrorLineWriter(void *pContext, const wchar_t *pwcLine, size_t uLength){
+	(void)pContext;
+
+	return _MCFCRT_WriteStandardErrorText(pwcLine, uLength, true);
+}
+static bool FileLineWriter(void *pContext, const wchar_t *pwcLine, size_t uLength){
+	const HANDLE hFile = pContext;
+
+	// Each UTF-16 code unit is converted to at most three UTF-8 code units.
+	char achLine[__MCFCRT_PROFILER_MAX_LINE_LENGTH * 3 + 1];
+	const wchar_t *pwcRead = pwcLine;
+	const wchar_t *const pwcReadEnd = pwcLine + uLength;
+	char *pchWrite = achLine;
+	for(;;){
+		const char32_t c32CodePoint = _MCFCRT_DecodeUtf16(&pwcRead, pwcReadEnd, true);
+		if(!_MCFCRT_UTF_SUCCESS(c32CodePoint)){
+			break;
+		}
+		_MCFCRT_UncheckedEncodeUtf8(&pchWrite, c32CodePoint, true);
+	}
+	*(pchWrite++) = '\n';
+	DWORD dwBytesWritten;
+	return WriteFile(hFile, achLine, (DWORD)(pchWrite - achLine), &dwBytesWritten, _MCFCRT_NULLPTR);
+}
+
+bool __MCFCRT_ProfilerDumpToStandardError(const __MCFCRT_ProfilerReport *pReport){
+	return WriteReport(pReport, &StandardErrorLineWriter, _MCFCRT_NULLPTR);
+}
+bool __MCFCRT_ProfilerDumpToFile(const __MCFCRT_ProfilerReport *pReport, const wchar_t *pwszPath){
+	const HANDLE hFile = CreateFileW(pwszPath, GENERIC_WRITE, FILE_SHARE_READ, _MCFCRT_NULLPTR, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, _MCFCRT_NULLPTR);
+	if(hFile == INVALID_HANDLE_VALUE){
+		return false;
+	}
+	const bool bSucceeded = WriteReport(pReport, &FileLineWriter, hFile);
+	const DWORD dwErrorCode = GetLastError();
+	CloseHandle(hFile);
+	SetLastError(dwErrorCode);
+	return bSucceeded;
+}
@@ -0,0 +1,50 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_PROFILER_COMMON_H_
+#define __MCFCRT_ENV_PROFILER_COMMON_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// This is what the heap profiler and the mutex profiler have in common: a lock-free table of sites keyed by addresses, and the report writer.
+// A site table consists of `__MCFCRT_PROFILER_SITE_COUNT + 1` elements of the same size, each of which begins with a `const void *volatile` key.
+// The last element collects everything that does not fit in the table, and its key is always null.
+
+#define __MCFCRT_PROFILER_SITE_COUNT          ((_MCFCRT_STD size_t)4096)
+#define __MCFCRT_PROFILER_SITE_MAX_PROBE_COUNT  ((_MCFCRT_STD size_t)32)
+
+static inline _MCFCRT_STD size_t __MCFCRT_ProfilerHashPointer(const void *__pAddress) _MCFCRT_NOEXCEPT {
+	return (_MCFCRT_STD size_t)(((_MCFCRT_STD uint64_t)(_MCFCRT_STD uintptr_t)__pAddress * 0x9E3779B97F4A7C15u) >> 32);
+}
+
+// This function returns the index of the site whose key is `__pKey`, claiming an empty one if there isn't one. It never fails.
+// `__MCFCRT_PROFILER_SITE_COUNT` is returned if `__pKey` is null or the table is too crowded.
+extern _MCFCRT_STD size_t __MCFCRT_ProfilerRequireSite(void *__pSites, _MCFCRT_STD size_t __uSiteSize, const void *__pKey) _MCFCRT_NOEXCEPT;
+
+// A report is generated from snapshots of sites in the public format, each of which begins with a `const void *` key, too.
+typedef struct __MCFCRT_tagProfilerReport {
+	_MCFCRT_STD size_t __uSiteSize;
+	// This has the semantics of `_MCFCRT_GetHeapProfilerSnapshot()`.
+	_MCFCRT_STD size_t (*__pfnGetSnapshot)(void *__pSites, _MCFCRT_STD size_t __uMaxCount);
+	// Sites are sorted in such a way that a site comes before another one if this function returns `true`.
+	bool (*__pfnSiteComesBefore)(const void *__pSite, const void *__pOther);
+	// These functions write the first line and the remaining part of each line after the key, respectively, and return the end of the text.
+	// Each line must not exceed `__MCFCRT_PROFILER_MAX_LINE_LENGTH` characters in total.
+	wchar_t *(*__pfnPrintHeader)(wchar_t *__pwcWrite, _MCFCRT_STD size_t __uCount);
+	wchar_t *(*__pfnPrintSite)(wchar_t *__pwcWrite, const void *__pSite);
+} __MCFCRT_ProfilerReport;
+
+#define __MCFCRT_PROFILER_MAX_LINE_LENGTH       ((_MCFCRT_STD size_t)256)
+
+extern wchar_t *__MCFCRT_ProfilerPrintUint64(wchar_t *__pwcWrite, _MCFCRT_STD uint64_t __u64Value) _MCFCRT_NOEXCEPT;
+
+// Memory for the report is not allocated from the heap, which might be being profiled.
+extern bool __MCFCRT_ProfilerDumpToStandardError(const __MCFCRT_ProfilerReport *__pReport) _MCFCRT_NOEXCEPT;
+extern bool __MCFCRT_ProfilerDumpToFile(const __MCFCRT_ProfilerReport *__pReport, const wchar_t *__pwszPath) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
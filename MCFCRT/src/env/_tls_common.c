@@ -4,30 +4,88 @@
 
 #include "_tls_common.h"
 #include "mutex.h"
-#include "avl_tree.h"
 #include "heap.h"
 #include "inline_mem.h"
 #include "expect.h"
 #include <winerror.h>
 
+// Every key occupies a slot, which is an index into the slot array of every thread map. Slots of freed keys are recycled.
+// Every key also has a counter that is unique in the process. A thread map entry belongs to a key only if their counters match,
+// so entries left behind by a freed key are never mistaken for entries of another key that reuses its slot.
 typedef struct tagTlsKey {
 	uintptr_t uCounter;
+	size_t uSlot;
 
 	size_t uSize;
+	size_t uAlignment;
 	_MCFCRT_TlsConstructor pfnConstructor;
 	_MCFCRT_TlsDestructor pfnDestructor;
 	intptr_t nContext;
 } TlsKey;
 
+static _MCFCRT_Mutex g_mtxSlots          = { 0 };
+static size_t        g_uSlotCount        = 0;
+static size_t *      g_puFreeSlots       = _MCFCRT_NULLPTR;
+static size_t        g_uFreeSlotCount    = 0;
+static size_t        g_uFreeSlotCapacity = 0;
+
+static bool AllocateSlot(size_t *puSlot){
+	bool bSucceeded = true;
+	_MCFCRT_WaitForMutexForever(&g_mtxSlots, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		if(g_uFreeSlotCount != 0){
+			*puSlot = g_puFreeSlots[--g_uFreeSlotCount];
+		} else if(g_uSlotCount < SIZE_MAX / sizeof(void *)){
+			*puSlot = g_uSlotCount++;
+		} else {
+			bSucceeded = false;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxSlots);
+	return bSucceeded;
+}
+static void DeallocateSlot(size_t uSlot){
+	_MCFCRT_WaitForMutexForever(&g_mtxSlots, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		if(g_uFreeSlotCount >= g_uFreeSlotCapacity){
+			const size_t uNewCapacity = (g_uFreeSlotCapacity + 8) * 2;
+			size_t *const puNewFreeSlots = _MCFCRT_realloc(g_puFreeSlots, uNewCapacity * sizeof(size_t));
+			if(puNewFreeSlots){
+				g_puFreeSlots = puNewFreeSlots;
+				g_uFreeSlotCapacity = uNewCapacity;
+			}
+		}
+		// If the free list could not grow, the slot is leaked. This is harmless.
+		if(g_uFreeSlotCount < g_uFreeSlotCapacity){
+			g_puFreeSlots[g_uFreeSlotCount++] = uSlot;
+		}
+	}
+	_MCFCRT_SignalMutex(&g_mtxSlots);
+}
+
 _MCFCRT_TlsKeyHandle _MCFCRT_TlsAllocKey(size_t uSize, _MCFCRT_TlsConstructor pfnConstructor, _MCFCRT_TlsDestructor pfnDestructor, intptr_t nContext){
+	return _MCFCRT_TlsAllocKeyAligned(uSize, alignof(max_align_t), pfnConstructor, pfnDestructor, nContext);
+}
+_MCFCRT_TlsKeyHandle _MCFCRT_TlsAllocKeyAligned(size_t uSize, size_t uAlignment, _MCFCRT_TlsConstructor pfnConstructor, _MCFCRT_TlsDestructor pfnDestructor, intptr_t nContext){
 	static volatile size_t s_uKeyCounter;
 
+	_MCFCRT_ASSERT_MSG((uAlignment != 0) && ((uAlignment & (uAlignment - 1)) == 0) && (uAlignment <= _MCFCRT_HEAP_MAX_ALIGNMENT), L"对齐值无效。");
+	if(uAlignment < alignof(max_align_t)){
+		uAlignment = alignof(max_align_t);
+	}
+
 	TlsKey *const pKey = _MCFCRT_malloc(sizeof(TlsKey));
 	if(!pKey){
 		return _MCFCRT_NULLPTR;
 	}
+	if(!AllocateSlot(&(pKey->uSlot))){
+		_MCFCRT_free(pKey);
+		return _MCFCRT_NULLPTR;
+	}
+	// Counters start from one. Zero denotes an empty thread map entry.
 	pKey->uCounter       = __atomic_add_fetch(&s_uKeyCounter, 1, __ATOMIC_RELAXED);
 	pKey->uSize          = uSize;
+	pKey->uAlignment     = uAlignment;
 	pKey->pfnConstructor = pfnConstructor;
 	pKey->pfnDestructor  = pfnDestructor;
 	pKey->nContext       = nContext;
@@ -40,6 +98,7 @@ void _MCFCRT_TlsFreeKey(_MCFCRT_TlsKeyHandle hTlsKey){
 		return;
 	}
 
+	DeallocateSlot(pKey->uSlot);
 	_MCFCRT_free(pKey);
 }
 
@@ -47,6 +106,10 @@ size_t _MCFCRT_TlsGetSize(_MCFCRT_TlsKeyHandle hTlsKey){
 	TlsKey *const pKey = (TlsKey *)hTlsKey;
 	return pKey->uSize;
 }
+size_t _MCFCRT_TlsGetAlignment(_MCFCRT_TlsKeyHandle hTlsKey){
+	TlsKey *const pKey = (TlsKey *)hTlsKey;
+	return pKey->uAlignment;
+}
 _MCFCRT_TlsConstructor _MCFCRT_TlsGetConstructor(_MCFCRT_TlsKeyHandle hTlsKey){
 	TlsKey *const pKey = (TlsKey *)hTlsKey;
 	return pKey->pfnConstructor;
@@ -60,54 +123,176 @@ intptr_t _MCFCRT_TlsGetContext(_MCFCRT_TlsKeyHandle hTlsKey){
 	return pKey->nContext;
 }
 
-typedef struct tagTlsObjectKey {
-	struct tagTlsKey *pKey;
-	uintptr_t uCounter;
-} TlsObjectKey;
-
+// Objects are never shared with other threads, so they are packed together without padding.
 typedef struct tagTlsObject {
-	_MCFCRT_AvlNodeHeader avlhNodeByKey;
-
 	_MCFCRT_TlsDestructor pfnDestructor;
 	intptr_t nContext;
+	unsigned char *pbyStorage;
 
 	struct tagTlsObject *pPrev; // By thread
 	struct tagTlsObject *pNext; // By thread
-	struct tagTlsObjectKey vObjectKey;
-
-	unsigned char abyPaddingToAvoidFalseSharing[_MCFCRT_CACHE_LINE_SIZE - alignof(max_align_t)]; // This member is never written into.
-	alignas(max_align_t) unsigned char abyStorage[];
 } TlsObject;
 
-static inline int TlsObjectComparatorNodeKey(const _MCFCRT_AvlNodeHeader *pObjSelf, intptr_t nKeyOther){
-	const TlsObjectKey *const pIndexSelf = &(((const TlsObject *)pObjSelf)->vObjectKey);
-	const TlsObjectKey *const pIndexOther = (const TlsObjectKey *)nKeyOther;
-	if(pIndexSelf->pKey != pIndexOther->pKey){
-		return (pIndexSelf->pKey < pIndexOther->pKey) ? -1 : 1;
-	}
-	if(pIndexSelf->uCounter != pIndexOther->uCounter){
-		return (pIndexSelf->uCounter < pIndexOther->uCounter) ? -1 : 1;
-	}
-	return 0;
-}
-static inline int TlsObjectComparatorNodes(const _MCFCRT_AvlNodeHeader *pObjSelf, const _MCFCRT_AvlNodeHeader *pObjOther){
-	return TlsObjectComparatorNodeKey(pObjSelf, (intptr_t)&((const TlsObject *)pObjOther)->vObjectKey);
+// Storage is placed at the first aligned offset after the header, and the object is allocated with the same alignment.
+static inline size_t CalculateStorageOffset(size_t uAlignment){
+	return (sizeof(TlsObject) + (uAlignment - 1)) & ~(uAlignment - 1);
 }
 
+// Objects of a thread are carved out of slabs owned by that thread. They are never freed individually; all slabs are freed when the thread exits.
+// The only exception is the block of an object whose constructor fails.
+// Slabs are aligned to cache lines and their sizes are multiples of the cache line size, so they do not share cache lines with other threads.
+typedef struct tagTlsSlab {
+	struct tagTlsSlab *pPrev;
+	size_t uCapacity;
+	size_t uUsed;
+	size_t uBlockCount; // Blocks that have not been given back
+	alignas(_MCFCRT_CACHE_LINE_SIZE) unsigned char abyData[];
+} TlsSlab;
+
+#define SLAB_SIZE                 4096u
+#define MAX_SIZE_IN_SHARED_SLAB   (SLAB_SIZE / 2)
+
+typedef struct tagTlsSlot {
+	uintptr_t uCounter;
+	unsigned char *pbyStorage;
+} TlsSlot;
+
+#define MIN_SLOT_CAPACITY   16u
+
 typedef struct tagTlsThreadMap {
-	_MCFCRT_AvlRoot avlObjects;
+	// This array is indexed by key slots and grows on demand.
+	struct tagTlsSlot *pSlots;
+	size_t uSlotCapacity;
+
 	struct tagTlsObject *pLast; // By thread
 	struct tagTlsObject *pFirst; // By thread
+
+	// New objects are allocated from the first slab. Dedicated slabs for large objects are linked after it.
+	struct tagTlsSlab *pSlab;
 } TlsThreadMap;
 
+static TlsSlab *CreateSlab(size_t uMinCapacity){
+	const size_t uCapacity = (uMinCapacity + _MCFCRT_CACHE_LINE_SIZE - 1) & ~(size_t)(_MCFCRT_CACHE_LINE_SIZE - 1);
+	if(uCapacity < uMinCapacity){
+		return _MCFCRT_NULLPTR;
+	}
+	const size_t uSizeToAlloc = sizeof(TlsSlab) + uCapacity;
+	if(uSizeToAlloc < uCapacity){
+		return _MCFCRT_NULLPTR;
+	}
+	TlsSlab *const pSlab = _MCFCRT_aligned_alloc(_MCFCRT_CACHE_LINE_SIZE, uSizeToAlloc);
+	if(!pSlab){
+		return _MCFCRT_NULLPTR;
+	}
+	pSlab->pPrev       = _MCFCRT_NULLPTR;
+	pSlab->uCapacity   = uCapacity;
+	pSlab->uUsed       = 0;
+	pSlab->uBlockCount = 0;
+	return pSlab;
+}
+static void *AllocateFromSlab(TlsSlab *pSlab, size_t uSize, size_t uAlignment){
+	const uintptr_t uBegin = (uintptr_t)(pSlab->abyData + pSlab->uUsed);
+	const size_t uPadding = (size_t)(-uBegin & (uAlignment - 1));
+	if((pSlab->uCapacity - pSlab->uUsed < uPadding) || (pSlab->uCapacity - pSlab->uUsed - uPadding < uSize)){
+		return _MCFCRT_NULLPTR;
+	}
+	void *const pBlock = pSlab->abyData + pSlab->uUsed + uPadding;
+	pSlab->uUsed += uPadding + uSize;
+	++(pSlab->uBlockCount);
+	return pBlock;
+}
+static void *AllocateObjectBlock(TlsThreadMap *pThreadMap, size_t uSize, size_t uAlignment){
+	void *pBlock;
+	TlsSlab *pSlab = pThreadMap->pSlab;
+	if(pSlab){
+		pBlock = AllocateFromSlab(pSlab, uSize, uAlignment);
+		if(pBlock){
+			return pBlock;
+		}
+	}
+	if((uSize > MAX_SIZE_IN_SHARED_SLAB) || (uAlignment > _MCFCRT_CACHE_LINE_SIZE)){
+		// This object gets a slab of its own, which is linked after the first slab so the remaining space of the latter can still be used.
+		const size_t uCapacity = uSize + uAlignment;
+		if(uCapacity < uSize){
+			return _MCFCRT_NULLPTR;
+		}
+		TlsSlab *const pDedicated = CreateSlab(uCapacity);
+		if(!pDedicated){
+			return _MCFCRT_NULLPTR;
+		}
+		pBlock = AllocateFromSlab(pDedicated, uSize, uAlignment);
+		_MCFCRT_ASSERT(pBlock);
+		if(pSlab){
+			pDedicated->pPrev = pSlab->pPrev;
+			pSlab->pPrev = pDedicated;
+		} else {
+			pThreadMap->pSlab = pDedicated;
+		}
+		return pBlock;
+	}
+	pSlab = CreateSlab(SLAB_SIZE - sizeof(TlsSlab));
+	if(!pSlab){
+		return _MCFCRT_NULLPTR;
+	}
+	pBlock = AllocateFromSlab(pSlab, uSize, uAlignment);
+	_MCFCRT_ASSERT(pBlock);
+	pSlab->pPrev = pThreadMap->pSlab;
+	pThreadMap->pSlab = pSlab;
+	return pBlock;
+}
+static void DeallocateObjectBlock(TlsThreadMap *pThreadMap, void *pBlock, size_t uSize){
+	// This is only called when a constructor fails, so all slabs are searched. The block may be in a dedicated slab behind the first one,
+	// and the constructor may have required other keys in the meantime. Space can only be given back if the block is the most recent allocation
+	// in its slab; otherwise it is wasted until the thread exits. A slab that no longer holds any blocks, such as a dedicated one, is freed.
+	TlsSlab **ppLink = &(pThreadMap->pSlab);
+	for(;;){
+		TlsSlab *const pSlab = *ppLink;
+		if(!pSlab){
+			break;
+		}
+		if(((uintptr_t)pBlock >= (uintptr_t)pSlab->abyData) && ((uintptr_t)pBlock < (uintptr_t)(pSlab->abyData + pSlab->uUsed))){
+			if((unsigned char *)pBlock + uSize == pSlab->abyData + pSlab->uUsed){
+				pSlab->uUsed = (size_t)((unsigned char *)pBlock - pSlab->abyData);
+			}
+			if(--(pSlab->uBlockCount) == 0){
+				*ppLink = pSlab->pPrev;
+				_MCFCRT_free(pSlab);
+			}
+			break;
+		}
+		ppLink = &(pSlab->pPrev);
+	}
+}
+
+static bool ReserveSlots(TlsThreadMap *pThreadMap, size_t uSlot){
+	const size_t uOldCapacity = pThreadMap->uSlotCapacity;
+	if(uSlot < uOldCapacity){
+		return true;
+	}
+	size_t uNewCapacity = (uOldCapacity != 0) ? uOldCapacity : MIN_SLOT_CAPACITY;
+	while(uNewCapacity <= uSlot){
+		uNewCapacity *= 2;
+	}
+	TlsSlot *const pNewSlots = _MCFCRT_realloc(pThreadMap->pSlots, uNewCapacity * sizeof(TlsSlot));
+	if(!pNewSlots){
+		return false;
+	}
+	_MCFCRT_inline_mempset_fwd(pNewSlots + uOldCapacity, 0, (uNewCapacity - uOldCapacity) * sizeof(TlsSlot));
+	pThreadMap->pSlots        = pNewSlots;
+	pThreadMap->uSlotCapacity = uNewCapacity;
+	return true;
+}
+
 __MCFCRT_TlsThreadMapHandle __MCFCRT_InternalTlsCreateThreadMap(void){
 	TlsThreadMap *const pThreadMap = _MCFCRT_malloc(sizeof(TlsThreadMap));
 	if(!pThreadMap){
 		return _MCFCRT_NULLPTR;
 	}
-	pThreadMap->avlObjects = _MCFCRT_NULLPTR;
-	pThreadMap->pLast      = _MCFCRT_NULLPTR;
-	pThreadMap->pFirst     = _MCFCRT_NULLPTR;
+	pThreadMap->pSlots        = _MCFCRT_NULLPTR;
+	pThreadMap->uSlotCapacity = 0;
+	pThreadMap->pLast         = _MCFCRT_NULLPTR;
+	pThreadMap->pFirst        = _MCFCRT_NULLPTR;
+	pThreadMap->pSlab         = _MCFCRT_NULLPTR;
 
 	return (__MCFCRT_TlsThreadMapHandle)pThreadMap;
 }
@@ -117,6 +302,7 @@ void __MCFCRT_InternalTlsDestroyThreadMap(__MCFCRT_TlsThreadMapHandle hThreadMap
 		return;
 	}
 
+	// Destructors may access other thread-local objects, so the slot array is kept until all objects have been destroyed.
 	for(;;){
 		TlsObject *const pObject = pThreadMap->pLast;
 		if(!pObject){
@@ -139,11 +325,19 @@ void __MCFCRT_InternalTlsDestroyThreadMap(__MCFCRT_TlsThreadMapHandle hThreadMap
 
 		const _MCFCRT_TlsDestructor pfnDestructor = pObject->pfnDestructor;
 		if(pfnDestructor){
-			(*pfnDestructor)(pObject->nContext, pObject->abyStorage);
+			(*pfnDestructor)(pObject->nContext, pObject->pbyStorage);
 		}
-		_MCFCRT_free(pObject);
 	}
 
+	for(;;){
+		TlsSlab *const pSlab = pThreadMap->pSlab;
+		if(!pSlab){
+			break;
+		}
+		pThreadMap->pSlab = pSlab->pPrev;
+		_MCFCRT_free(pSlab);
+	}
+	_MCFCRT_free(pThreadMap->pSlots);
 	_MCFCRT_free(pThreadMap);
 }
 
@@ -153,12 +347,15 @@ unsigned long __MCFCRT_InternalTlsGet(__MCFCRT_TlsThreadMapHandle hThreadMap, _M
 	TlsKey *const pKey = (TlsKey *)hTlsKey;
 	_MCFCRT_ASSERT(pKey);
 
-	const TlsObjectKey vObjectKey = { pKey, pKey->uCounter };
-	TlsObject *pObject = (TlsObject *)_MCFCRT_AvlFind(&(pThreadMap->avlObjects), (intptr_t)&vObjectKey, &TlsObjectComparatorNodeKey);
-	if(_MCFCRT_EXPECT_NOT(!pObject)){
+	const size_t uSlot = pKey->uSlot;
+	if(_MCFCRT_EXPECT_NOT(uSlot >= pThreadMap->uSlotCapacity)){
+		return ERROR_NOT_FOUND;
+	}
+	const TlsSlot *const pSlot = pThreadMap->pSlots + uSlot;
+	if(_MCFCRT_EXPECT_NOT(pSlot->uCounter != pKey->uCounter)){
 		return ERROR_NOT_FOUND;
 	}
-	*ppStorage = pObject->abyStorage;
+	*ppStorage = pSlot->pbyStorage;
 	return 0;
 }
 unsigned long __MCFCRT_InternalTlsRequire(__MCFCRT_TlsThreadMapHandle hThreadMap, _MCFCRT_TlsKeyHandle hTlsKey, void **restrict ppStorage){
@@ -171,50 +368,61 @@ unsigned long __MCFCRT_InternalTlsRequire(__MCFCRT_TlsThreadMapHandle hThreadMap
 	*ppStorage = (void *)0xDEADBEEF;
 #endif
 
-	const TlsObjectKey vObjectKey = { pKey, pKey->uCounter };
-	TlsObject *pObject = (TlsObject *)_MCFCRT_AvlFind(&(pThreadMap->avlObjects), (intptr_t)&vObjectKey, &TlsObjectComparatorNodeKey);
-	if(_MCFCRT_EXPECT_NOT(!pObject)){
-		const size_t uSizeToAlloc = sizeof(TlsObject) + pKey->uSize;
-		if(uSizeToAlloc < sizeof(TlsObject)){
-			return ERROR_NOT_ENOUGH_MEMORY;
-		}
-		pObject = _MCFCRT_malloc(uSizeToAlloc);
-		if(!pObject){
-			return ERROR_NOT_ENOUGH_MEMORY;
-		}
+	const size_t uSlot = pKey->uSlot;
+	if(_MCFCRT_EXPECT((uSlot < pThreadMap->uSlotCapacity) && (pThreadMap->pSlots[uSlot].uCounter == pKey->uCounter))){
+		*ppStorage = pThreadMap->pSlots[uSlot].pbyStorage;
+		return 0;
+	}
+
+	if(!ReserveSlots(pThreadMap, uSlot)){
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+	const size_t uStorageOffset = CalculateStorageOffset(pKey->uAlignment);
+	const size_t uSizeToAlloc = uStorageOffset + pKey->uSize;
+	if(uSizeToAlloc < uStorageOffset){
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+	TlsObject *const pObject = AllocateObjectBlock(pThreadMap, uSizeToAlloc, pKey->uAlignment);
+	if(!pObject){
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
 #ifndef NDEBUG
-		_MCFCRT_inline_mempset_fwd(pObject, 0xAA, sizeof(TlsObject));
+	_MCFCRT_inline_mempset_fwd(pObject, 0xAA, sizeof(TlsObject));
 #endif
-		_MCFCRT_inline_mempset_fwd(pObject->abyStorage, 0, pKey->uSize);
-		if(pKey->pfnConstructor){
-			const unsigned long ulErrorCode = (*(pKey->pfnConstructor))(pKey->nContext, pObject->abyStorage);
-			if(ulErrorCode != 0){
-				_MCFCRT_free(pObject);
-				return ulErrorCode;
-			}
+	pObject->pbyStorage = (unsigned char *)pObject + uStorageOffset;
+	_MCFCRT_inline_mempset_fwd(pObject->pbyStorage, 0, pKey->uSize);
+	if(pKey->pfnConstructor){
+		const unsigned long ulErrorCode = (*(pKey->pfnConstructor))(pKey->nContext, pObject->pbyStorage);
+		if(ulErrorCode != 0){
+			DeallocateObjectBlock(pThreadMap, pObject, uSizeToAlloc);
+			return ulErrorCode;
 		}
-		pObject->pfnDestructor = pKey->pfnDestructor;
-		pObject->nContext      = pKey->nContext;
+	}
+	pObject->pfnDestructor = pKey->pfnDestructor;
+	pObject->nContext      = pKey->nContext;
+
+	TlsObject *const pPrev = pThreadMap->pLast;
+	TlsObject *const pNext = _MCFCRT_NULLPTR;
+	if(pPrev){
+		pPrev->pNext = pObject;
+	} else {
+		pThreadMap->pFirst = pObject;
+	}
+	if(pNext){
+		pNext->pPrev = pObject;
+	} else {
+		pThreadMap->pLast = pObject;
+	}
+	pObject->pPrev = pPrev;
+	pObject->pNext = pNext;
 
-		TlsObject *const pPrev = pThreadMap->pLast;
-		TlsObject *const pNext = _MCFCRT_NULLPTR;
-		if(pPrev){
-			pPrev->pNext = pObject;
-		} else {
-			pThreadMap->pFirst = pObject;
-		}
-		if(pNext){
-			pNext->pPrev = pObject;
-		} else {
-			pThreadMap->pLast = pObject;
-		}
-		pObject->pPrev = pPrev;
-		pObject->pNext = pNext;
+	// If the slot holds an object of a freed key, that object is destroyed when the thread exits, as before.
+	// The constructor may have required other keys, which may have reallocated the slot array, so it is indexed again here.
+	TlsSlot *const pSlot = pThreadMap->pSlots + uSlot;
+	pSlot->uCounter   = pKey->uCounter;
+	pSlot->pbyStorage = pObject->pbyStorage;
 
-		pObject->vObjectKey = vObjectKey;
-		_MCFCRT_AvlAttach(&(pThreadMap->avlObjects), (_MCFCRT_AvlNodeHeader *)pObject, &TlsObjectComparatorNodes);
-	}
-	*ppStorage = pObject->abyStorage;
+	*ppStorage = pObject->pbyStorage;
 	return 0;
 }
 
@@ -246,17 +454,19 @@ unsigned long __MCFCRT_InternalAtThreadExit(__MCFCRT_TlsThreadMapHandle hThreadM
 	AtExitBlock *pBlock = _MCFCRT_NULLPTR;
 	TlsObject *pObject = pThreadMap->pLast;
 	if(pObject && (pObject->pfnDestructor == &CrtAtThreadExitDestructor)){
-		pBlock = (void *)pObject->abyStorage;
+		pBlock = (void *)pObject->pbyStorage;
 	}
 	if(!pBlock || (pBlock->uSize >= CALLBACKS_PER_BLOCK)){
-		pObject = _MCFCRT_malloc(sizeof(TlsObject) + sizeof(AtExitBlock));
+		const size_t uStorageOffset = CalculateStorageOffset(alignof(max_align_t));
+		pObject = AllocateObjectBlock(pThreadMap, uStorageOffset + sizeof(AtExitBlock), alignof(max_align_t));
 		if(!pObject){
 			return ERROR_NOT_ENOUGH_MEMORY;
 		}
 #ifndef NDEBUG
 		_MCFCRT_inline_mempset_fwd(pObject, 0xAA, sizeof(TlsObject));
 #endif
-		pBlock = (void *)pObject->abyStorage;
+		pObject->pbyStorage = (unsigned char *)pObject + uStorageOffset;
+		pBlock = (void *)pObject->pbyStorage;
 		pBlock->uSize = 0;
 		pObject->pfnDestructor = &CrtAtThreadExitDestructor;
 		pObject->nContext      = 1;
@@ -0,0 +1,105 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_ARENA_INLINE_OR_EXTERN     extern inline
+#include "arena.h"
+#include "heap.h"
+#include "xassert.h"
+#include "expect.h"
+
+// Chunks are chained from the newest to the oldest. The usable memory of a chunk begins right after its header.
+typedef struct __MCFCRT_tagArenaChunk {
+	struct __MCFCRT_tagArenaChunk *pPrev;
+	unsigned char *pbyEnd;
+} ArenaChunk;
+
+static inline unsigned char *GetChunkBegin(ArenaChunk *pChunk){
+	return (unsigned char *)(pChunk + 1);
+}
+static inline size_t GetChunkCapacity(ArenaChunk *pChunk){
+	return (size_t)(pChunk->pbyEnd - GetChunkBegin(pChunk));
+}
+
+static void RetireChunk(_MCFCRT_Arena *pArena, ArenaChunk *pChunk, const void *pRetAddr){
+	ArenaChunk *pChunkToFree = pChunk;
+	// Keep the larger one of the new chunk and the spare one.
+	ArenaChunk *const pSpareChunk = pArena->__pSpareChunk;
+	if(!pSpareChunk || (GetChunkCapacity(pSpareChunk) < GetChunkCapacity(pChunk))){
+		pArena->__pSpareChunk = pChunk;
+		pChunkToFree = pSpareChunk;
+	}
+	if(pChunkToFree){
+		__MCFCRT_HeapFree(pChunkToFree, pRetAddr);
+	}
+}
+
+void * __MCFCRT_ReallyAllocateFromArena(_MCFCRT_Arena *pArena, size_t uSize, size_t uAlignment){
+	_MCFCRT_ASSERT_MSG((uAlignment != 0) && ((uAlignment & (uAlignment - 1)) == 0), L"对齐值必须是 2 的幂。");
+
+	size_t uCapacity, uSizeToAlloc;
+	ArenaChunk *pChunk;
+	uintptr_t uBegin;
+
+	if(pArena->__uChunkSize == 0){
+		return _MCFCRT_NULLPTR;
+	}
+	// Reserve enough space for the worst case of alignment.
+	if(_MCFCRT_EXPECT_NOT(__builtin_add_overflow(uSize, uAlignment - 1, &uCapacity))){
+		return _MCFCRT_NULLPTR;
+	}
+	if(uCapacity < pArena->__uChunkSize){
+		uCapacity = pArena->__uChunkSize;
+	}
+	if(_MCFCRT_EXPECT_NOT(__builtin_add_overflow(uCapacity, sizeof(ArenaChunk), &uSizeToAlloc))){
+		return _MCFCRT_NULLPTR;
+	}
+	// Reuse the spare chunk if it is large enough.
+	pChunk = pArena->__pSpareChunk;
+	if(pChunk && (GetChunkCapacity(pChunk) >= uCapacity)){
+		pArena->__pSpareChunk = _MCFCRT_NULLPTR;
+	} else {
+		pChunk = __MCFCRT_HeapAlloc(uSizeToAlloc, false, __builtin_return_address(0));
+		if(!pChunk){
+			return _MCFCRT_NULLPTR;
+		}
+		pChunk->pbyEnd = (unsigned char *)pChunk + uSizeToAlloc;
+	}
+	pChunk->pPrev = pArena->__pLastChunk;
+	pArena->__pLastChunk = pChunk;
+
+	uBegin = ((uintptr_t)GetChunkBegin(pChunk) + (uAlignment - 1)) & -uAlignment;
+	pArena->__pbyNext = (unsigned char *)(uBegin + uSize);
+	pArena->__pbyEnd  = pChunk->pbyEnd;
+	return (void *)uBegin;
+}
+
+void _MCFCRT_RewindArena(_MCFCRT_Arena *pArena, _MCFCRT_ArenaMark vMark){
+	ArenaChunk *pChunk = pArena->__pLastChunk;
+	while(pChunk != vMark.__pChunk){
+		_MCFCRT_ASSERT_MSG(pChunk, L"该标记不属于此内存池，或者已经失效。");
+
+		ArenaChunk *const pPrev = pChunk->pPrev;
+		RetireChunk(pArena, pChunk, __builtin_return_address(0));
+		pChunk = pPrev;
+	}
+	pArena->__pLastChunk = pChunk;
+	pArena->__pbyNext = vMark.__pbyNext;
+	pArena->__pbyEnd  = pChunk ? pChunk->pbyEnd : pArena->__pbyBufferEnd;
+}
+void _MCFCRT_ReleaseArena(_MCFCRT_Arena *pArena){
+	ArenaChunk *pChunk = pArena->__pLastChunk;
+	while(pChunk){
+		ArenaChunk *const pPrev = pChunk->pPrev;
+		__MCFCRT_HeapFree(pChunk, __builtin_return_address(0));
+		pChunk = pPrev;
+	}
+	pChunk = pArena->__pSpareChunk;
+	if(pChunk){
+		__MCFCRT_HeapFree(pChunk, __builtin_return_address(0));
+	}
+	pArena->__pbyNext     = pArena->__pbyBufferBegin;
+	pArena->__pbyEnd      = pArena->__pbyBufferEnd;
+	pArena->__pLastChunk  = _MCFCRT_NULLPTR;
+	pArena->__pSpareChunk = _MCFCRT_NULLPTR;
+}
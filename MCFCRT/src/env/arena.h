@@ -0,0 +1,82 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_ARENA_H_
+#define __MCFCRT_ENV_ARENA_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_ARENA_INLINE_OR_EXTERN
+#  define __MCFCRT_ARENA_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// An arena hands out memory by bumping a pointer. Blocks are never freed individually; instead, the arena can be rewound to a mark, which
+// discards all blocks that have been allocated since the mark was taken, or released as a whole. Arenas are not thread-safe.
+// Memory is taken from the initial buffer first. When it runs out, chunks of at least `__uChunkSize` bytes are allocated from the heap and chained.
+// If `__uChunkSize` is zero, no chunks will be allocated and allocation fails once the initial buffer is exhausted.
+// One chunk is cached after a rewind to prevent repeated allocation and deallocation. `_MCFCRT_ReleaseArena()` frees it as well.
+
+#define _MCFCRT_ARENA_SUGGESTED_CHUNK_SIZE   0x10000u
+
+struct __MCFCRT_tagArenaChunk;
+
+// In the case of static initialization, please initialize it with { 0 }. Such an arena has neither an initial buffer nor the ability to allocate chunks.
+typedef struct __MCFCRT_tagArena {
+	unsigned char *__pbyNext;
+	unsigned char *__pbyEnd;
+	struct __MCFCRT_tagArenaChunk *__pLastChunk;
+	struct __MCFCRT_tagArenaChunk *__pSpareChunk;
+	unsigned char *__pbyBufferBegin;
+	unsigned char *__pbyBufferEnd;
+	_MCFCRT_STD size_t __uChunkSize;
+} _MCFCRT_Arena;
+
+typedef struct __MCFCRT_tagArenaMark {
+	struct __MCFCRT_tagArenaChunk *__pChunk;
+	unsigned char *__pbyNext;
+} _MCFCRT_ArenaMark;
+
+__MCFCRT_ARENA_INLINE_OR_EXTERN void _MCFCRT_InitializeArena(_MCFCRT_Arena *__pArena, void *__pBuffer, _MCFCRT_STD size_t __uBufferSize, _MCFCRT_STD size_t __uChunkSize) _MCFCRT_NOEXCEPT {
+	__pArena->__pbyNext        = (unsigned char *)__pBuffer;
+	__pArena->__pbyEnd         = (unsigned char *)__pBuffer + __uBufferSize;
+	__pArena->__pLastChunk     = _MCFCRT_NULLPTR;
+	__pArena->__pSpareChunk    = _MCFCRT_NULLPTR;
+	__pArena->__pbyBufferBegin = (unsigned char *)__pBuffer;
+	__pArena->__pbyBufferEnd   = (unsigned char *)__pBuffer + __uBufferSize;
+	__pArena->__uChunkSize     = __uChunkSize;
+}
+
+extern void * __MCFCRT_ReallyAllocateFromArena(_MCFCRT_Arena *__pArena, _MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment) _MCFCRT_NOEXCEPT;
+
+// `__uAlignment` shall be a power of two. Blocks of zero bytes are not guaranteed to have distinct addresses.
+// This function returns a null pointer if the request cannot be satisfied. It does not set the per-thread error code.
+__attribute__((__malloc__))
+__MCFCRT_ARENA_INLINE_OR_EXTERN void * _MCFCRT_AllocateFromArena(_MCFCRT_Arena *__pArena, _MCFCRT_STD size_t __uSize, _MCFCRT_STD size_t __uAlignment) _MCFCRT_NOEXCEPT {
+	const _MCFCRT_STD uintptr_t __uBegin = ((_MCFCRT_STD uintptr_t)__pArena->__pbyNext + (__uAlignment - 1)) & -__uAlignment;
+	const _MCFCRT_STD uintptr_t __uEnd = (_MCFCRT_STD uintptr_t)__pArena->__pbyEnd;
+	// The first comparison fails if `__uBegin` is zero, which is the case when there is no memory at all, or if alignment has pushed it past the end.
+	if(__builtin_expect((__uBegin - 1 < __uEnd) && (__uEnd - __uBegin >= __uSize), true)){
+		__pArena->__pbyNext = (unsigned char *)(__uBegin + __uSize);
+		return (void *)__uBegin;
+	}
+	return __MCFCRT_ReallyAllocateFromArena(__pArena, __uSize, __uAlignment);
+}
+
+__MCFCRT_ARENA_INLINE_OR_EXTERN _MCFCRT_ArenaMark _MCFCRT_GetArenaMark(const _MCFCRT_Arena *__pArena) _MCFCRT_NOEXCEPT {
+	_MCFCRT_ArenaMark __vMark;
+	__vMark.__pChunk  = __pArena->__pLastChunk;
+	__vMark.__pbyNext = __pArena->__pbyNext;
+	return __vMark;
+}
+
+// Marks that have been taken after `__vMark` are invalidated by this function. So are all marks that have been taken before `_MCFCRT_ReleaseArena()`.
+extern void _MCFCRT_RewindArena(_MCFCRT_Arena *__pArena, _MCFCRT_ArenaMark __vMark) _MCFCRT_NOEXCEPT;
+// This function frees all chunks and makes the arena allocate from the beginning of its initial buffer again.
+extern void _MCFCRT_ReleaseArena(_MCFCRT_Arena *__pArena) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -3,9 +3,12 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "bail.h"
-#include "mcfwin.h"
 #include "../ext/wcpcpy.h"
 #include "../ext/wcppcpy.h"
+
+#ifdef _WIN32
+
+#include "mcfwin.h"
 #include "standard_streams.h"
 #include <ntdef.h>
 
@@ -104,3 +107,51 @@ _Noreturn void _MCFCRT_Bail(const wchar_t *pwszDescription){
 	TerminateProcess(GetCurrentProcess(), 3);
 	__builtin_unreachable();
 }
+
+#else
+
+#include "../ext/utf.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+_Noreturn void _MCFCRT_Bail(const wchar_t *pwszDescription){
+	static volatile bool s_bBailing = false;
+	const bool bBailing = __atomic_exchange_n(&s_bBailing, true, __ATOMIC_RELAXED);
+	if(bBailing){
+		// The first thread that bails out will terminate the process.
+		for(;;){
+			pause();
+		}
+	}
+
+	wchar_t awcBuffer[1024 + 128];
+	wchar_t *pwcWrite = _MCFCRT_wcpcpy(awcBuffer, L"应用程序异常终止，请联系作者寻求协助。");
+	if(pwszDescription){
+		pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"\n\n错误描述：\n");
+		pwcWrite = _MCFCRT_wcppcpy(pwcWrite, awcBuffer + 1024, pwszDescription); // 后面还有一些内容，保留一些字符。
+	}
+
+	// 每个 UTF-16 代码单元至多被转换为三个 UTF-8 代码单元。
+	char achBuffer[(1024 + 128) * 3 + 1];
+	const wchar_t *pwcRead = awcBuffer;
+	char *pchWrite = achBuffer;
+	for(;;){
+		const char32_t c32CodePoint = _MCFCRT_DecodeUtf16(&pwcRead, pwcWrite, true);
+		if(!_MCFCRT_UTF_SUCCESS(c32CodePoint)){
+			break;
+		}
+		_MCFCRT_UncheckedEncodeUtf8(&pchWrite, c32CodePoint, true);
+	}
+	*(pchWrite++) = '\n';
+	const char *pchRead = achBuffer;
+	while(pchRead != pchWrite){
+		const ssize_t nWritten = write(STDERR_FILENO, pchRead, (size_t)(pchWrite - pchRead));
+		if(nWritten <= 0){
+			break;
+		}
+		pchRead += nWritten;
+	}
+	abort();
+}
+
+#endif
@@ -0,0 +1,35 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_BARRIER_INLINE_OR_EXTERN     extern inline
+#include "barrier.h"
+#include "wait_on_address.h"
+#include "xassert.h"
+#include "expect.h"
+
+bool _MCFCRT_ArriveAtBarrierAndWait(_MCFCRT_Barrier *pBarrier, size_t uMaxSpinCount){
+	// The phase must be loaded before we arrive, otherwise it might have been incremented by the last thread of our phase.
+	const uint32_t u32Phase = __atomic_load_n(&(pBarrier->__u32Phase), __ATOMIC_ACQUIRE);
+	const uint32_t u32Threshold = __atomic_load_n(&(pBarrier->__u32Threshold), __ATOMIC_RELAXED);
+	const uint32_t u32Arrived = __atomic_add_fetch(&(pBarrier->__u32Arrived), 1, __ATOMIC_ACQ_REL);
+	_MCFCRT_ASSERT_MSG(u32Arrived <= u32Threshold, L"到达屏障的线程数超过了阈值。");
+	if(u32Arrived == u32Threshold){
+		// No other thread can arrive before the phase is incremented, since all threads of this phase are blocked.
+		__atomic_store_n(&(pBarrier->__u32Arrived), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pBarrier->__u32Phase), u32Phase + 1, __ATOMIC_RELEASE);
+		_MCFCRT_WakeAllByAddress(&(pBarrier->__u32Phase));
+		return true;
+	}
+	// Phases in fork/join workloads tend to be short, so spin for a while before going to sleep.
+	for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+		__builtin_ia32_pause();
+		if(_MCFCRT_EXPECT_NOT(__atomic_load_n(&(pBarrier->__u32Phase), __ATOMIC_ACQUIRE) != u32Phase)){
+			return false;
+		}
+	}
+	while(__atomic_load_n(&(pBarrier->__u32Phase), __ATOMIC_ACQUIRE) == u32Phase){
+		_MCFCRT_WaitOnAddressForever(&(pBarrier->__u32Phase), &u32Phase, sizeof(u32Phase));
+	}
+	return false;
+}
@@ -0,0 +1,37 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_BARRIER_H_
+#define __MCFCRT_ENV_BARRIER_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_BARRIER_INLINE_OR_EXTERN
+#  define __MCFCRT_BARRIER_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// A barrier blocks a fixed number of threads until all of them have arrived, then starts the next phase. It can be reused indefinitely.
+
+typedef struct __MCFCRT_tagBarrier {
+	_MCFCRT_STD uint32_t __u32Phase;
+	_MCFCRT_STD uint32_t __u32Arrived;
+	_MCFCRT_STD uint32_t __u32Threshold;
+} _MCFCRT_Barrier;
+
+#define _MCFCRT_BARRIER_SUGGESTED_SPIN_COUNT   1000u
+
+__MCFCRT_BARRIER_INLINE_OR_EXTERN void _MCFCRT_InitializeBarrier(_MCFCRT_Barrier *__pBarrier, _MCFCRT_STD uint32_t __u32Threshold) _MCFCRT_NOEXCEPT {
+	__atomic_store_n(&(__pBarrier->__u32Threshold), __u32Threshold, __ATOMIC_RELAXED);
+	__atomic_store_n(&(__pBarrier->__u32Arrived), 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&(__pBarrier->__u32Phase), 0, __ATOMIC_RELEASE);
+}
+
+// Exactly one of the threads in each phase, which is the last one to arrive, gets `true`. The others get `false`.
+extern bool _MCFCRT_ArriveAtBarrierAndWait(_MCFCRT_Barrier *__pBarrier, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
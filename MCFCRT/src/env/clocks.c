@@ -4,14 +4,22 @@
 
 #define __MCFCRT_CLOCKS_INLINE_OR_EXTERN     extern inline
 #include "clocks.h"
-#include "mcfwin.h"
 #include "bail.h"
 #include "once_flag.h"
 #include "xassert.h"
+#include "cpu.h"
+
+#ifdef _WIN32
+#  include "mcfwin.h"
+#else
+#  include <time.h>
+#endif
 
 static _MCFCRT_OnceFlag g_once;
 static uint64_t g_tz_bias;
+#ifdef _WIN32
 static double g_pc_freq_recip;
+#endif
 
 static void FetchParametersOnce(void){
 	const _MCFCRT_OnceResult result = _MCFCRT_WaitForOnceFlagForever(&g_once);
@@ -20,6 +28,7 @@ static void FetchParametersOnce(void){
 	}
 	_MCFCRT_ASSERT(result == _MCFCRT_kOnceResultInitial);
 
+#ifdef _WIN32
 	TIME_ZONE_INFORMATION tz_info;
 	if(GetTimeZoneInformation(&tz_info) == TIME_ZONE_ID_INVALID){
 		_MCFCRT_Bail(L"GetTimeZoneInformation() 失败。");
@@ -31,17 +40,32 @@ static void FetchParametersOnce(void){
 		_MCFCRT_Bail(L"QueryPerformanceFrequency() 失败。");
 	}
 	g_pc_freq_recip = 1000 / (double)pc_freq.QuadPart;
+#else
+	const time_t now = time(_MCFCRT_NULLPTR);
+	struct tm tm_local;
+	if(!localtime_r(&now, &tm_local)){
+		_MCFCRT_Bail(L"localtime_r() 失败。");
+	}
+	// `tm_gmtoff` is positive east of UTC, while `Bias` on Windows is positive west of UTC.
+	g_tz_bias = (uint64_t)-(int64_t)tm_local.tm_gmtoff * 1000;
+#endif
 
 	_MCFCRT_SignalOnceFlagAsFinished(&g_once);
 }
 
 uint64_t _MCFCRT_GetUtcClock(void){
+#ifdef _WIN32
 	FILETIME ft;
 	GetSystemTimeAsFileTime(&ft);
 	LARGE_INTEGER li;
 	__builtin_memcpy(&li, &ft, sizeof(li));
 	// 0x019DB1DED53E8000 = duration since 1601-01-01 until 1970-01-01 in nanoseconds.
 	return (uint64_t)(int64_t)((double)(li.QuadPart - 0x019DB1DED53E8000) / 10000);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#endif
 }
 uint64_t _MCFCRT_GetLocalClock(void){
 	const uint64_t utc = _MCFCRT_GetUtcClock();
@@ -64,13 +88,177 @@ uint64_t _MCFCRT_GetLocalClockFromUtc(uint64_t utc){
 #endif
 
 uint64_t _MCFCRT_GetFastMonoClock(void){
+#ifdef _WIN32
 	return GetTickCount64() + MONO_CLOCK_OFFSET * 3;
+#else
+	// This has the same resolution as `GetTickCount64()`, which is a few milliseconds.
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000 + MONO_CLOCK_OFFSET * 3;
+#endif
 }
-double _MCFCRT_GetHiResMonoClock(void){
+
+static _MCFCRT_OnceFlag g_cycle_once;
+static bool g_cycle_uses_tsc;
+// This is a copy of `g_cycle_uses_tsc` that is only set after calibration has finished, so it can be read without the once flag.
+static bool g_cycle_tsc_ready;
+static uint64_t g_cycle_freq;
+// Nanoseconds per cycle, as a fixed-point number with 32 fractional bits.
+static uint64_t g_cycle_scale;
+// A reading of the TSC, and a reading of the reference counter that was taken no earlier than it, in the unit of `_MCFCRT_GetHiResMonoClock()`.
+static uint64_t g_cycle_anchor_tsc;
+static double g_cycle_anchor_ms;
+
+// The reference counter is what the mono cycle clock falls back to.
+static uint64_t ReadReferenceCounter(void){
+#ifdef _WIN32
 	LARGE_INTEGER pc_cntr;
 	if(!QueryPerformanceCounter(&pc_cntr)){
 		_MCFCRT_Bail(L"QueryPerformanceCounter() 失败。");
 	}
+	return (uint64_t)pc_cntr.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+static uint64_t GetReferenceFrequency(void){
+#ifdef _WIN32
+	LARGE_INTEGER pc_freq;
+	if(!QueryPerformanceFrequency(&pc_freq)){
+		_MCFCRT_Bail(L"QueryPerformanceFrequency() 失败。");
+	}
+	return (uint64_t)pc_freq.QuadPart;
+#else
+	return 1000000000;
+#endif
+}
+
+static double ConvertReferenceCounterToMilliseconds(uint64_t ref){
+#ifdef _WIN32
 	FetchParametersOnce();
-	return ((double)pc_cntr.QuadPart + MONO_CLOCK_OFFSET * 5) * g_pc_freq_recip;
+	return ((double)ref + MONO_CLOCK_OFFSET * 5) * g_pc_freq_recip;
+#else
+	return (double)ref / 1000000 + MONO_CLOCK_OFFSET * 5;
+#endif
+}
+
+static void SampleTscAndReferenceCounter(uint64_t *restrict tsc_before_ret, uint64_t *restrict tsc_width_ret, uint64_t *restrict ref_ret){
+	// Bracket each read of the reference counter with two reads of the TSC, and keep the narrowest bracket,
+	// which is the one least likely to have been interrupted.
+	uint64_t best_tsc_before = 0, best_width = UINT64_MAX, best_ref = 0;
+	for(unsigned i = 0; i < 16; ++i){
+		const uint64_t tsc_before = __builtin_ia32_rdtsc();
+		const uint64_t ref = ReadReferenceCounter();
+		const uint64_t tsc_after = __builtin_ia32_rdtsc();
+		const uint64_t width = tsc_after - tsc_before;
+		if(width < best_width){
+			best_tsc_before = tsc_before;
+			best_width = width;
+			best_ref = ref;
+		}
+	}
+	*tsc_before_ret = best_tsc_before;
+	*tsc_width_ret = best_width;
+	*ref_ret = best_ref;
+}
+static uint64_t CalculateScale(uint64_t freq){
+	// scale = (1000000000 << 32) / freq, which does not fit in 64 bits before the division.
+	// Calculate the integral part first, then the fractional part bit by bit.
+	uint64_t scale = 1000000000 / freq;
+	uint64_t rem = 1000000000 % freq;
+	for(unsigned i = 0; i < 32; ++i){
+		rem <<= 1;
+		scale <<= 1;
+		if(rem >= freq){
+			rem -= freq;
+			scale |= 1;
+		}
+	}
+	return scale;
+}
+static inline uint64_t MultiplyByScale(uint64_t cycles, uint64_t scale){
+#ifdef __SIZEOF_INT128__
+	__extension__ typedef unsigned __int128 uint128_t;
+	return (uint64_t)(((uint128_t)cycles * scale) >> 32);
+#else
+	// Only the bits [32,96) of the 128-bit product are needed. The sum wraps modulo 2^64 exactly as the product would.
+	const uint64_t cycles_lo = (uint32_t)cycles, cycles_hi = cycles >> 32;
+	const uint64_t scale_lo = (uint32_t)scale, scale_hi = scale >> 32;
+	return ((cycles_hi * scale_hi) << 32) + cycles_hi * scale_lo + cycles_lo * scale_hi + ((cycles_lo * scale_lo) >> 32);
+#endif
+}
+
+static void FetchCycleParametersOnce(void){
+	const _MCFCRT_OnceResult result = _MCFCRT_WaitForOnceFlagForever(&g_cycle_once);
+	if(result == _MCFCRT_kOnceResultFinished){
+		return;
+	}
+	_MCFCRT_ASSERT(result == _MCFCRT_kOnceResultInitial);
+
+	const uint64_t ref_freq = GetReferenceFrequency();
+	_MCFCRT_ASSERT(ref_freq != 0);
+	uint64_t freq = ref_freq;
+	bool uses_tsc = false;
+	if(_MCFCRT_CpuHasFeature(_MCFCRT_kCpuFeatureInvariantTsc)){
+		// Measure the TSC against the reference counter for 20 milliseconds. This happens only once per process.
+		uint64_t tsc_begin, width_begin, ref_begin, tsc_end, width_end, ref_end;
+		SampleTscAndReferenceCounter(&tsc_begin, &width_begin, &ref_begin);
+		do {
+			SampleTscAndReferenceCounter(&tsc_end, &width_end, &ref_end);
+		} while(ref_end - ref_begin < ref_freq / 50);
+		// The reference counter was read in the middle of each bracket, on average.
+		const uint64_t tsc_delta = (tsc_end + width_end / 2) - (tsc_begin + width_begin / 2);
+		const uint64_t tsc_freq = (uint64_t)((double)tsc_delta * (double)ref_freq / (double)(ref_end - ref_begin) + 0.5);
+		// Do not trust a TSC that does not tick at a plausible rate, which may happen in some virtual machines.
+		if((tsc_freq >= 100000000) && (tsc_end > tsc_begin)){
+			freq = tsc_freq;
+			uses_tsc = true;
+			g_cycle_anchor_tsc = tsc_end;
+			g_cycle_anchor_ms = ConvertReferenceCounterToMilliseconds(ref_end);
+		}
+	}
+	g_cycle_uses_tsc = uses_tsc;
+	g_cycle_freq = freq;
+	g_cycle_scale = CalculateScale(freq);
+	__atomic_store_n(&g_cycle_tsc_ready, uses_tsc, __ATOMIC_RELEASE);
+
+	_MCFCRT_SignalOnceFlagAsFinished(&g_cycle_once);
+}
+
+uint64_t _MCFCRT_GetMonoCycleClock(void){
+	// A relaxed load suffices because nothing else is read on this path.
+	if(_MCFCRT_EXPECT(__atomic_load_n(&g_cycle_tsc_ready, __ATOMIC_RELAXED))){
+		return __builtin_ia32_rdtsc();
+	}
+	FetchCycleParametersOnce();
+	if(g_cycle_uses_tsc){
+		return __builtin_ia32_rdtsc();
+	}
+	return ReadReferenceCounter();
+}
+
+uint64_t _MCFCRT_GetMonoCycleClockFrequency(void){
+	FetchCycleParametersOnce();
+	return g_cycle_freq;
+}
+uint64_t _MCFCRT_ConvertMonoCyclesToNanoseconds(uint64_t cycles){
+	FetchCycleParametersOnce();
+	return MultiplyByScale(cycles, g_cycle_scale);
+}
+uint64_t _MCFCRT_GetPreciseMonoClock(void){
+	const uint64_t cycles = _MCFCRT_GetMonoCycleClock();
+	return _MCFCRT_ConvertMonoCyclesToNanoseconds(cycles);
+}
+
+double _MCFCRT_GetHiResMonoClock(void){
+	// Do not calibrate the mono cycle clock here, which would take 20 milliseconds. Read the reference counter until
+	// somebody else has done that. Afterwards, measure the time elapsed since the anchor with the TSC instead.
+	// The anchor was read no later than the reference counter, so the result never goes backwards when switching.
+	if(_MCFCRT_EXPECT(__atomic_load_n(&g_cycle_tsc_ready, __ATOMIC_ACQUIRE))){
+		const uint64_t ns = MultiplyByScale(__builtin_ia32_rdtsc() - g_cycle_anchor_tsc, g_cycle_scale);
+		return g_cycle_anchor_ms + (double)ns / 1000000;
+	}
+	return ConvertReferenceCounterToMilliseconds(ReadReferenceCounter());
 }
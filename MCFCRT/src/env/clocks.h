@@ -6,6 +6,7 @@
 #define __MCFCRT_ENV_CLOCKS_H_
 
 #include "_crtdef.h"
+#include "expect.h"
 
 #ifndef __MCFCRT_CLOCKS_INLINE_OR_EXTERN
 #  define __MCFCRT_CLOCKS_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
@@ -29,6 +30,17 @@ extern _MCFCRT_STD uint64_t _MCFCRT_GetLocalClockFromUtc(_MCFCRT_STD uint64_t __
 extern _MCFCRT_STD uint64_t _MCFCRT_GetFastMonoClock(void) _MCFCRT_NOEXCEPT;
 extern double _MCFCRT_GetHiResMonoClock(void) _MCFCRT_NOEXCEPT;
 
+// The mono cycle clock is the invariant TSC when the CPU has one. Otherwise it falls back to the performance counter (on Windows) or
+// `CLOCK_MONOTONIC` in nanoseconds (elsewhere). Its unit is unspecified, and its frequency is calibrated on the first use.
+// Values should be converted to nanoseconds only after they have been subtracted from each other, or be converted in batches
+// after tracing has finished. `_MCFCRT_GetPreciseMonoClock()` does both in one step and returns integral nanoseconds.
+// This is not an inline function because it would have to read a flag in the DLL, which would require `__dllimport__` for DLL consumers
+// but not for static ones.
+extern _MCFCRT_STD uint64_t _MCFCRT_GetMonoCycleClock(void) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD uint64_t _MCFCRT_GetMonoCycleClockFrequency(void) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD uint64_t _MCFCRT_ConvertMonoCyclesToNanoseconds(_MCFCRT_STD uint64_t __cycles) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD uint64_t _MCFCRT_GetPreciseMonoClock(void) _MCFCRT_NOEXCEPT;
+
 _MCFCRT_EXTERN_C_END
 
 #endif
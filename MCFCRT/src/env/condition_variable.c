@@ -4,15 +4,9 @@
 
 #define __MCFCRT_CONDITION_VARIABLE_INLINE_OR_EXTERN     extern inline
 #include "condition_variable.h"
-#include "_nt_timeout.h"
+#include "_park.h"
 #include "xassert.h"
 #include "expect.h"
-#include <ntdef.h>
-
-__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtWaitForKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtReleaseKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-
-__attribute__((__dllimport__, __stdcall__, __const__)) extern BOOLEAN RtlDllShutdownInProgress(void);
 
 #ifndef __BYTE_ORDER__
 #  error Byte order is unknown.
@@ -26,10 +20,11 @@ __attribute__((__dllimport__, __stdcall__, __const__)) extern BOOLEAN RtlDllShut
 #  define BSFB(v_)              ((uintptr_t)(v_) << ((sizeof(uintptr_t) - 1) * CHAR_BIT))
 #endif
 
-#define MASK_THREADS_RELEASED   ((uintptr_t)( BSFB(0x03)))
-#define MASK_THREADS_SPINNING   ((uintptr_t)( BSFB(0x0C)))
-#define MASK_SPIN_FAILURE_COUNT ((uintptr_t)( BSFB(0xF0)))
-#define MASK_THREADS_TRAPPED    ((uintptr_t)(~BSFB(0xFF)))
+#define MASK_THREADS_RELEASED   ((uintptr_t)(                 BSFB(0x03)))
+#define MASK_THREADS_SPINNING   ((uintptr_t)(                 BSFB(0x0C)))
+#define MASK_SPIN_FAILURE_COUNT ((uintptr_t)(                 BSFB(0xF0)))
+#define MASK_THREADS_DEFERRED   ((uintptr_t)( BSUSR(0xFF)                ))
+#define MASK_THREADS_TRAPPED    ((uintptr_t)(~BSUSR(0xFF) & ~BSFB(0xFF)))
 
 #define THREADS_RELEASED_ONE    ((uintptr_t)(MASK_THREADS_RELEASED & -MASK_THREADS_RELEASED))
 #define THREADS_RELEASED_MAX    ((uintptr_t)(MASK_THREADS_RELEASED / THREADS_RELEASED_ONE))
@@ -40,6 +35,9 @@ __attribute__((__dllimport__, __stdcall__, __const__)) extern BOOLEAN RtlDllShut
 #define SPIN_FAILURE_COUNT_ONE  ((uintptr_t)(MASK_SPIN_FAILURE_COUNT & -MASK_SPIN_FAILURE_COUNT))
 #define SPIN_FAILURE_COUNT_MAX  ((uintptr_t)(MASK_SPIN_FAILURE_COUNT / SPIN_FAILURE_COUNT_ONE))
 
+#define THREADS_DEFERRED_ONE    ((uintptr_t)(MASK_THREADS_DEFERRED & -MASK_THREADS_DEFERRED))
+#define THREADS_DEFERRED_MAX    ((uintptr_t)(MASK_THREADS_DEFERRED / THREADS_DEFERRED_ONE))
+
 #define THREADS_TRAPPED_ONE     ((uintptr_t)(MASK_THREADS_TRAPPED & -MASK_THREADS_TRAPPED))
 #define THREADS_TRAPPED_MAX     ((uintptr_t)(MASK_THREADS_TRAPPED / THREADS_TRAPPED_ONE))
 
@@ -52,6 +50,24 @@ static inline size_t Min(size_t uSelf, size_t uOther){
 	return (uSelf <= uOther) ? uSelf : uOther;
 }
 
+static void SignalDeferredThread(volatile uintptr_t *puControl){
+	{
+		uintptr_t uOld, uNew;
+		uOld = __atomic_load_n(puControl, __ATOMIC_RELAXED);
+		do {
+			const size_t uThreadsDeferred = (uOld & MASK_THREADS_DEFERRED) / THREADS_DEFERRED_ONE;
+			if(_MCFCRT_EXPECT(uThreadsDeferred == 0)){
+				return;
+			}
+			uNew = uOld - THREADS_DEFERRED_ONE;
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+	}
+	// The thread to wake up has been counted out of `MASK_THREADS_TRAPPED` by whoever signaled it, so it must be released here.
+	if(_MCFCRT_EXPECT(!__MCFCRT_IsShutdownInProgress())){
+		__MCFCRT_UnparkThread((void *)puControl);
+	}
+}
+
 __attribute__((__always_inline__)) static inline bool ReallyWaitForConditionVariable(volatile uintptr_t *puControl, _MCFCRT_ConditionVariableUnlockCallback pfnUnlockCallback, _MCFCRT_ConditionVariableRelockCallback pfnRelockCallback, intptr_t nContext, size_t uMaxSpinCountInitial, bool bMayTimeOut, uint64_t u64UntilFastMonoClock, bool bRelockIfTimeOut){
 	size_t uMaxSpinCount, uSpinMultiplier;
 	bool bSignaled, bSpinnable;
@@ -153,11 +169,8 @@ __attribute__((__always_inline__)) static inline bool ReallyWaitForConditionVari
 		nUnlocked = (*pfnUnlockCallback)(nContext);
 	}
 	if(bMayTimeOut){
-		LARGE_INTEGER liTimeout;
-		__MCFCRT_InitializeNtTimeout(&liTimeout, u64UntilFastMonoClock);
-		NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-		while(_MCFCRT_EXPECT(lStatus == STATUS_TIMEOUT)){
+		bool bUnparked = __MCFCRT_ParkThread((void *)puControl, u64UntilFastMonoClock);
+		while(_MCFCRT_EXPECT(!bUnparked)){
 			bool bDecremented;
 			{
 				uintptr_t uOld, uNew;
@@ -177,43 +190,48 @@ __attribute__((__always_inline__)) static inline bool ReallyWaitForConditionVari
 				}
 				return false;
 			}
-			liTimeout.QuadPart = 0;
-			lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+			// We have been signaled, but the release might have been deferred to another thread which is waiting for the mutex.
+			// It might take a while, so don't spin.
+			__MCFCRT_ParkThreadForever((void *)puControl);
+			break;
 		}
 	} else {
-		NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-		_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+		__MCFCRT_ParkThreadForever((void *)puControl);
 	}
 	(*pfnRelockCallback)(nContext, nUnlocked);
+	// Now that we own the mutex, wake up the next thread that has been signaled along with us, if any. It will go to sleep on the mutex
+	// until we release it, rather than spinning on it together with us.
+	SignalDeferredThread(puControl);
 	return true;
 }
 __attribute__((__always_inline__)) static inline size_t ReallySignalConditionVariable(volatile uintptr_t *puControl, size_t uMaxCountToReleaseOrSignal){
 	uintptr_t uCountToRelease; // Number of threads spinning to release
 	uintptr_t uCountToSignal; // Number of threads trapped to signal
+	uintptr_t uCountToDefer; // Number of threads signaled to be woken up by their predecessors
 	{
 		uintptr_t uOld, uNew;
 		uOld = __atomic_load_n(puControl, __ATOMIC_RELAXED);
 		do {
 			const size_t uThreadsReleased = (uOld & MASK_THREADS_RELEASED) / THREADS_RELEASED_ONE;
 			const size_t uThreadsSpinning = (uOld & MASK_THREADS_SPINNING) / THREADS_SPINNING_ONE;
+			const size_t uThreadsDeferred = (uOld & MASK_THREADS_DEFERRED) / THREADS_DEFERRED_ONE;
 			const size_t uThreadsTrapped = (uOld & MASK_THREADS_TRAPPED) / THREADS_TRAPPED_ONE;
 			uCountToRelease = Min(uThreadsSpinning - uThreadsReleased, uMaxCountToReleaseOrSignal);
 			uCountToSignal = Min(uThreadsTrapped, uMaxCountToReleaseOrSignal - uCountToRelease);
-			uNew = uOld + uCountToRelease * THREADS_RELEASED_ONE - uCountToSignal * THREADS_TRAPPED_ONE;
+			// Wake up only one thread. The others will be woken up one by one, each by its predecessor after that one has relocked the mutex.
+			// Should the counter overflow, the remaining threads are woken up by us.
+			uCountToDefer = (uCountToSignal > 1) ? Min(uCountToSignal - 1, THREADS_DEFERRED_MAX - uThreadsDeferred) : 0;
+			uNew = uOld + uCountToRelease * THREADS_RELEASED_ONE + uCountToDefer * THREADS_DEFERRED_ONE - uCountToSignal * THREADS_TRAPPED_ONE;
 			if(uNew == uOld){
 				break;
 			}
 		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
 	}
-	// If `RtlDllShutdownInProgress()` is `true`, other threads will have been terminated.
-	// Calling `NtReleaseKeyedEvent()` when no thread is waiting results in deadlocks. Don't do that.
-	if(_MCFCRT_EXPECT_NOT((uCountToSignal > 0) && !RtlDllShutdownInProgress())){
-		for(size_t uIndex = 0; uIndex < uCountToSignal; ++uIndex){
-			NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
-			_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+	// If `__MCFCRT_IsShutdownInProgress()` is `true`, other threads will have been terminated.
+	// Calling `__MCFCRT_UnparkThread()` when no thread is waiting results in deadlocks. Don't do that.
+	if(_MCFCRT_EXPECT_NOT((uCountToSignal > 0) && !__MCFCRT_IsShutdownInProgress())){
+		for(size_t uIndex = uCountToDefer; uIndex < uCountToSignal; ++uIndex){
+			__MCFCRT_UnparkThread((void *)puControl);
 		}
 	}
 	return uCountToRelease + uCountToSignal;
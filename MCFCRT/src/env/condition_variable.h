@@ -13,6 +13,10 @@
 
 _MCFCRT_EXTERN_C_BEGIN
 
+// When more than one trapped thread is signaled at a time (by a broadcast, for example), only the first one is woken up immediately.
+// Each of them wakes up the next one after it has relocked the mutex, so they are moved onto the wait queue of the mutex one by one
+// instead of contending on it all at once. Hence all threads waiting on the same condition variable shall use the same mutex.
+
 // In the case of static initialization, please initialize it with { 0 }.
 typedef struct __MCFCRT_tagConditionVariable {
 	_MCFCRT_STD uintptr_t __u;
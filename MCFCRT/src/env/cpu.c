@@ -2,6 +2,7 @@
 // 有关具体授权说明，请参阅 MCFLicense.txt。
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
+#define __MCFCRT_CPU_INLINE_OR_EXTERN     extern inline
 #include "cpu.h"
 #include "expect.h"
 #include "once_flag.h"
@@ -9,6 +10,12 @@
 #include "xassert.h"
 #include <cpuid.h>
 
+#ifdef _WIN32
+#  include "mcfwin.h"
+#else
+#  include <unistd.h>
+#endif
+
 #define RND_NEAREST     (0u)            // 四舍六入五凑双。
 #define RND_DOWN        (1u)            // 向负无穷舍入。
 #define RND_UP          (2u)            // 向正无穷舍入。
@@ -39,36 +46,203 @@ void __MCFCRT_CpuResetFloatingPointEnvironment(void){
 }
 
 static _MCFCRT_OnceFlag g_once;
-static unsigned g_cache_sizes[_MCFCRT_kCpuCacheLevelMax + 1];
+static _MCFCRT_CpuCacheInfo g_caches[_MCFCRT_kCpuCacheLevelMax + 1];
+static unsigned g_logical_processor_count;
+static unsigned g_physical_core_count;
+static unsigned g_prefetch_stride;
 
-static void FetchCpuInfoOnce(void){
-	const _MCFCRT_OnceResult result = _MCFCRT_WaitForOnceFlagForever(&g_once);
-	if(result == _MCFCRT_kOnceResultFinished){
-		return;
+static bool IsVendorAmd(void){
+	unsigned eax, ebx, ecx, edx;
+	__cpuid(0, eax, ebx, ecx, edx);
+	// "AuthenticAMD" or "HygonGenuine", the latter of which is a licensed clone.
+	return ((ebx == 0x68747541) && (edx == 0x69746E65) && (ecx == 0x444D4163)) ||
+	       ((ebx == 0x6F677948) && (edx == 0x6E65476E) && (ecx == 0x656E6975));
+}
+static bool HasAmdTopologyExtensions(void){
+	unsigned eax, ebx, ecx, edx;
+	__cpuid(0x80000000, eax, ebx, ecx, edx);
+	if(eax < 0x8000001E){
+		return false;
 	}
-	_MCFCRT_ASSERT(result == _MCFCRT_kOnceResultInitial);
+	__cpuid(0x80000001, eax, ebx, ecx, edx);
+	return (ecx >> 22) & 1;
+}
 
+static void EnumerateCaches(unsigned leaf){
 	// Reference:
 	//   Intel® 64 and IA-32 Architectures Software Developer’s Manual, Volume 2 (2A, 2B & 2C):
-	//     Table 3-17. Information Returned by CPUID Instruction
-	// Iterate from cache level 1, until there are no more levels.
-	unsigned level = 1;
-	do {
+	//     Table 3-8. Information Returned by CPUID Instruction (Leaf 04H)
+	//   AMD64 Architecture Programmer’s Manual, Volume 3:
+	//     E.4.15 Function 8000_001Dh—Cache Topology Information
+	// Both leaves have the same layout. Each subleaf describes one cache, until a subleaf of type zero.
+	for(unsigned index = 0; index < 64; ++index){
 		unsigned eax, ebx, ecx, edx;
-		__cpuid_count(0x04, level, eax, ebx, ecx, edx);
-		if((eax & 0x1F) == 0){
-			// No more cache levels. Stop.
+		__cpuid_count(leaf, index, eax, ebx, ecx, edx);
+		const unsigned type = eax & 0x1F;
+		if(type == 0){
+			// No more caches. Stop.
 			break;
 		}
+		if(type == 2){
+			// This is an instruction cache.
+			continue;
+		}
+		const unsigned level = (eax >> 5) & 0x07;
+		if((level < _MCFCRT_kCpuCacheLevel1) || (level >= _MCFCRT_kCpuCacheLevelMax)){
+			continue;
+		}
 		const unsigned ways = ((ebx >> 22) & 0x3FF) + 1;
 		const unsigned partitions = ((ebx >> 12) & 0x3FF) + 1;
 		const unsigned line_size = (ebx & 0xFFF) + 1;
 		const unsigned sets = ecx + 1;
-		g_cache_sizes[level] = ways * partitions * line_size * sets;
-	} while(++level < _MCFCRT_kCpuCacheLevelMax);
+		_MCFCRT_CpuCacheInfo *const info = g_caches + level;
+		info->__uSize = (size_t)ways * partitions * line_size * sets;
+		info->__uLineSize = line_size;
+		info->__uWays = ((eax >> 9) & 1) ? 0 : ways;
+		info->__uSets = sets;
+		info->__uSharingCount = ((eax >> 14) & 0xFFF) + 1;
+		info->__bInclusive = (edx >> 1) & 1;
+	}
+}
+
+static unsigned GetThreadsPerCore(bool amd){
+	unsigned eax, ebx, ecx, edx;
+	if(amd){
+		if(!HasAmdTopologyExtensions()){
+			return 1;
+		}
+		__cpuid(0x8000001E, eax, ebx, ecx, edx);
+		return ((ebx >> 8) & 0xFF) + 1;
+	}
+	__cpuid(0, eax, ebx, ecx, edx);
+	if(eax < 0x0B){
+		return 1;
+	}
+	// The first subleaf of the extended topology enumeration leaf describes the SMT level, if any.
+	__cpuid_count(0x0B, 0, eax, ebx, ecx, edx);
+	if(((ecx >> 8) & 0xFF) != 1){
+		return 1;
+	}
+	const unsigned count = ebx & 0xFFFF;
+	return (count != 0) ? count : 1;
+}
+static unsigned GetPrefetchStrideFromDescriptors(void){
+	// Reference:
+	//   Intel® 64 and IA-32 Architectures Software Developer’s Manual, Volume 2 (2A, 2B & 2C):
+	//     Table 3-12. Encoding of CPUID Leaf 2 Descriptors
+	unsigned regs[4];
+	__cpuid(0, regs[0], regs[1], regs[2], regs[3]);
+	if(regs[0] < 0x02){
+		return 0;
+	}
+	__cpuid(0x02, regs[0], regs[1], regs[2], regs[3]);
+	// The low byte of EAX is not a descriptor.
+	regs[0] &= 0xFFFFFF00u;
+	for(unsigned i = 0; i < 4; ++i){
+		if(regs[i] >> 31){
+			// This register does not contain valid descriptors.
+			continue;
+		}
+		for(unsigned shift = 0; shift < 32; shift += 8){
+			switch((regs[i] >> shift) & 0xFF){
+			case 0xF0:
+				return 64;
+			case 0xF1:
+				return 128;
+			}
+		}
+	}
+	return 0;
+}
+
+#ifdef _WIN32
+static unsigned CountPhysicalCores(void){
+	// Query the size of the buffer first, as there may be hundreds of entries on large systems.
+	DWORD size = 0;
+	if(GetLogicalProcessorInformation(_MCFCRT_NULLPTR, &size) || (GetLastError() != ERROR_INSUFFICIENT_BUFFER)){
+		return 0;
+	}
+	// Do not allocate memory from the heap here, as this function might be called from `memcpy()` before the heap is initialized.
+	// This happens only once per process.
+	SYSTEM_LOGICAL_PROCESSOR_INFORMATION *const infos = VirtualAlloc(_MCFCRT_NULLPTR, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if(!infos){
+		return 0;
+	}
+	unsigned count = 0;
+	// If processors have been added in the meantime, this fails and the caller falls back to CPUID.
+	if(GetLogicalProcessorInformation(infos, &size)){
+		for(size_t i = 0; i < size / sizeof(*infos); ++i){
+			count += infos[i].Relationship == RelationProcessorCore;
+		}
+	}
+	VirtualFree(infos, 0, MEM_RELEASE);
+	return count;
+}
+#endif
+
+static void FetchCpuInfoOnce(void){
+	const _MCFCRT_OnceResult result = _MCFCRT_WaitForOnceFlagForever(&g_once);
+	if(result == _MCFCRT_kOnceResultFinished){
+		return;
+	}
+	_MCFCRT_ASSERT(result == _MCFCRT_kOnceResultInitial);
+
+#ifdef _WIN32
+	SYSTEM_INFO sys_info;
+	GetSystemInfo(&sys_info);
+	g_logical_processor_count = sys_info.dwNumberOfProcessors;
+#else
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	g_logical_processor_count = (count > 0) ? (unsigned)count : 1;
+#endif
+
+	const bool amd = IsVendorAmd();
+	unsigned eax, ebx, ecx, edx;
+	__cpuid(0, eax, ebx, ecx, edx);
+	if(amd && HasAmdTopologyExtensions()){
+		EnumerateCaches(0x8000001D);
+	} else if(!amd && (eax >= 0x04)){
+		EnumerateCaches(0x04);
+	}
+	// CPUID reports the maximum number of addressable IDs rather than the number of processors that are actually there.
+	unsigned level = _MCFCRT_kCpuCacheLevel1;
+	for(; level < _MCFCRT_kCpuCacheLevelMax; ++level){
+		_MCFCRT_CpuCacheInfo *const info = g_caches + level;
+		if(info->__uSize == 0){
+			break;
+		}
+		if(info->__uSharingCount > g_logical_processor_count){
+			info->__uSharingCount = g_logical_processor_count;
+		}
+	}
 	// Set up boundary values.
-	g_cache_sizes[_MCFCRT_kCpuCacheLevelMin] = g_cache_sizes[_MCFCRT_kCpuCacheLevel1];
-	g_cache_sizes[_MCFCRT_kCpuCacheLevelMax] = g_cache_sizes[level - 1];
+	g_caches[_MCFCRT_kCpuCacheLevelMin] = g_caches[_MCFCRT_kCpuCacheLevel1];
+	g_caches[_MCFCRT_kCpuCacheLevelMax] = g_caches[level - 1];
+
+	unsigned physical_core_count = 0;
+#ifdef _WIN32
+	physical_core_count = CountPhysicalCores();
+#endif
+	if(physical_core_count == 0){
+		// Assume all cores have the same number of hardware threads. This is not true for hybrid processors.
+		physical_core_count = g_logical_processor_count / GetThreadsPerCore(amd);
+	}
+	if(physical_core_count == 0){
+		physical_core_count = 1;
+	} else if(physical_core_count > g_logical_processor_count){
+		physical_core_count = g_logical_processor_count;
+	}
+	g_physical_core_count = physical_core_count;
+
+	size_t line_size = g_caches[_MCFCRT_kCpuCacheLevel1].__uLineSize;
+	if(line_size == 0){
+		line_size = _MCFCRT_CACHE_LINE_SIZE;
+	}
+	unsigned prefetch_stride = GetPrefetchStrideFromDescriptors();
+	if(prefetch_stride < line_size){
+		prefetch_stride = (unsigned)line_size;
+	}
+	g_prefetch_stride = prefetch_stride;
 
 	_MCFCRT_SignalOnceFlagAsFinished(&g_once);
 }
@@ -78,5 +252,129 @@ size_t _MCFCRT_CpuGetCacheSize(_MCFCRT_CpuCacheLevel level){
 		return 0;
 	}
 	FetchCpuInfoOnce();
-	return g_cache_sizes[level];
+	return g_caches[level].__uSize;
+}
+size_t _MCFCRT_CpuGetLogicalProcessorCount(void){
+	FetchCpuInfoOnce();
+	return g_logical_processor_count;
+}
+
+bool _MCFCRT_CpuGetCacheInfo(_MCFCRT_CpuCacheInfo *info, _MCFCRT_CpuCacheLevel level){
+	if(_MCFCRT_EXPECT_NOT((unsigned)level > _MCFCRT_kCpuCacheLevelMax)){
+		*info = (_MCFCRT_CpuCacheInfo){ 0 };
+		return false;
+	}
+	FetchCpuInfoOnce();
+	*info = g_caches[level];
+	return info->__uSize != 0;
+}
+size_t _MCFCRT_CpuGetPhysicalCoreCount(void){
+	FetchCpuInfoOnce();
+	return g_physical_core_count;
+}
+size_t _MCFCRT_CpuGetCacheLineSize(void){
+	FetchCpuInfoOnce();
+	const size_t line_size = g_caches[_MCFCRT_kCpuCacheLevel1].__uLineSize;
+	if(line_size == 0){
+		return _MCFCRT_CACHE_LINE_SIZE;
+	}
+	return line_size;
+}
+size_t _MCFCRT_CpuGetPrefetchStride(void){
+	FetchCpuInfoOnce();
+	return g_prefetch_stride;
+}
+
+// Bit 31 means the features have been probed, so that a zero can be told from an uninitialized value.
+#define FEATURES_VALID  (1u << 31)
+
+static volatile uint32_t g_features;
+
+static uint64_t ReadExtendedControlRegister0(void){
+	uint32_t lo, hi;
+	__asm__ volatile (
+		"xgetbv \n"
+		: "=a"(lo), "=d"(hi)
+		: "c"(0)
+	);
+	return ((uint64_t)hi << 32) | lo;
+}
+
+static uint32_t ProbeFeatures(void){
+	// Reference:
+	//   Intel® 64 and IA-32 Architectures Software Developer’s Manual, Volume 2 (2A, 2B & 2C):
+	//     Table 3-8. Information Returned by CPUID Instruction
+	//   Volume 1:
+	//     13.3 Enabling the XSAVE Feature Set and XSAVE-Enabled Features
+	uint32_t features = FEATURES_VALID;
+	unsigned eax, ebx, ecx, edx;
+	__cpuid(0, eax, ebx, ecx, edx);
+	const unsigned max_leaf = eax;
+	__cpuid(0x80000000, eax, ebx, ecx, edx);
+	const unsigned max_ext_leaf = eax;
+
+#define SET_IF_(feature_, reg_, bit_)	\
+	(features |= (uint32_t)(((reg_) >> (bit_)) & 1) << (feature_))
+
+	bool os_saves_ymm = false;
+	bool os_saves_zmm = false;
+	if(max_leaf >= 1){
+		__cpuid(1, eax, ebx, ecx, edx);
+		SET_IF_(_MCFCRT_kCpuFeatureSse3,   ecx,  0);
+		SET_IF_(_MCFCRT_kCpuFeaturePclmul, ecx,  1);
+		SET_IF_(_MCFCRT_kCpuFeatureSsse3,  ecx,  9);
+		SET_IF_(_MCFCRT_kCpuFeatureSse41,  ecx, 19);
+		SET_IF_(_MCFCRT_kCpuFeatureSse42,  ecx, 20);
+		SET_IF_(_MCFCRT_kCpuFeaturePopcnt, ecx, 23);
+		if((ecx >> 27) & 1){
+			// OSXSAVE is set, so XGETBV can be executed.
+			const uint64_t xcr0 = ReadExtendedControlRegister0();
+			// XMM and YMM states.
+			os_saves_ymm = (xcr0 & 0x06) == 0x06;
+			// XMM, YMM, opmask, upper halves of ZMM0-15 and ZMM16-31 states.
+			os_saves_zmm = (xcr0 & 0xE6) == 0xE6;
+		}
+		if(os_saves_ymm){
+			SET_IF_(_MCFCRT_kCpuFeatureAvx, ecx, 28);
+			SET_IF_(_MCFCRT_kCpuFeatureFma, ecx, 12);
+		}
+	}
+	if(max_leaf >= 7){
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		SET_IF_(_MCFCRT_kCpuFeatureBmi1, ebx,  3);
+		SET_IF_(_MCFCRT_kCpuFeatureBmi2, ebx,  8);
+		SET_IF_(_MCFCRT_kCpuFeatureErms, ebx,  9);
+		SET_IF_(_MCFCRT_kCpuFeatureSha,  ebx, 29);
+		SET_IF_(_MCFCRT_kCpuFeatureFsrm, edx,  4);
+		if(os_saves_ymm){
+			SET_IF_(_MCFCRT_kCpuFeatureAvx2, ebx, 5);
+		}
+		if(os_saves_zmm){
+			SET_IF_(_MCFCRT_kCpuFeatureAvx512f,  ebx, 16);
+			SET_IF_(_MCFCRT_kCpuFeatureAvx512bw, ebx, 30);
+			SET_IF_(_MCFCRT_kCpuFeatureAvx512vl, ebx, 31);
+		}
+	}
+	if(max_ext_leaf >= 0x80000001){
+		__cpuid(0x80000001, eax, ebx, ecx, edx);
+		SET_IF_(_MCFCRT_kCpuFeatureLzcnt, ecx, 5);
+	}
+	if(max_ext_leaf >= 0x80000007){
+		__cpuid(0x80000007, eax, ebx, ecx, edx);
+		SET_IF_(_MCFCRT_kCpuFeatureInvariantTsc, edx, 8);
+	}
+
+#undef SET_IF_
+
+	return features;
+}
+
+uint32_t _MCFCRT_CpuGetFeatures(void){
+	uint32_t features = __atomic_load_n(&g_features, __ATOMIC_RELAXED);
+	if(_MCFCRT_EXPECT_NOT(!(features & FEATURES_VALID))){
+		// Threads racing here compute the same value, so there is no need for a once flag.
+		features = ProbeFeatures();
+		__atomic_store_n(&g_features, features, __ATOMIC_RELAXED);
+	}
+	return features & ~FEATURES_VALID;
 }
@@ -6,6 +6,11 @@
 #define __MCFCRT_ENV_CPU_H_
 
 #include "_crtdef.h"
+#include "pp.h"
+
+#ifndef __MCFCRT_CPU_INLINE_OR_EXTERN
+#  define __MCFCRT_CPU_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
 
 _MCFCRT_EXTERN_C_BEGIN
 
@@ -20,10 +25,86 @@ typedef enum __MCFCRT_tagCpuCacheLevel {
 } _MCFCRT_CpuCacheLevel;
 
 // For `_MCFCRT_kCpuCacheLevelMin`: Returns the size of the first level of cache.
-// For `_MCFCRT_kCpuCacheLevel{1,2,3,4}` : Returns the size of the specified level of cache.
+// For `_MCFCRT_kCpuCacheLevel{1,2,3}` : Returns the size of the specified level of cache.
 // For `_MCFCRT_kCpuCacheLevelMax` : Returns the size of the last level of cache.
 extern _MCFCRT_STD size_t _MCFCRT_CpuGetCacheSize(_MCFCRT_CpuCacheLevel __level) _MCFCRT_NOEXCEPT;
 
+// Returns the number of logical processors in the system, which is at least one.
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetLogicalProcessorCount(void) _MCFCRT_NOEXCEPT;
+
+typedef struct __MCFCRT_tagCpuCacheInfo {
+	_MCFCRT_STD size_t __uSize;
+	_MCFCRT_STD size_t __uLineSize;
+	// This is zero if the cache is fully associative.
+	_MCFCRT_STD size_t __uWays;
+	_MCFCRT_STD size_t __uSets;
+	// The number of logical processors sharing this cache, which is at least one.
+	_MCFCRT_STD size_t __uSharingCount;
+	// Whether this cache includes all lower levels.
+	bool __bInclusive;
+} _MCFCRT_CpuCacheInfo;
+
+// Fills `*__pInfo` with the data or unified cache at the specified level. Instruction caches are not reported.
+// Returns `false` and fills `*__pInfo` with zeroes if there is no such cache or the CPU does not describe it.
+extern bool _MCFCRT_CpuGetCacheInfo(_MCFCRT_CpuCacheInfo *__pInfo, _MCFCRT_CpuCacheLevel __level) _MCFCRT_NOEXCEPT;
+
+// Returns the number of physical cores in the system, which is at least one and at most the number of logical processors.
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetPhysicalCoreCount(void) _MCFCRT_NOEXCEPT;
+
+// Returns the line size of the first level of data cache. If it is unknown, `_MCFCRT_CACHE_LINE_SIZE` is returned.
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetCacheLineSize(void) _MCFCRT_NOEXCEPT;
+// Returns the granularity in which the hardware prefetches memory, which is at least the cache line size.
+// Data that are accessed by different threads should be at least this far apart to avoid false sharing caused by the prefetcher.
+extern _MCFCRT_STD size_t _MCFCRT_CpuGetPrefetchStride(void) _MCFCRT_NOEXCEPT;
+
+typedef enum __MCFCRT_tagCpuFeature {
+	_MCFCRT_kCpuFeatureSse3          =  0,
+	_MCFCRT_kCpuFeatureSsse3         =  1,
+	_MCFCRT_kCpuFeatureSse41         =  2,
+	_MCFCRT_kCpuFeatureSse42         =  3,
+	_MCFCRT_kCpuFeaturePopcnt        =  4,
+	_MCFCRT_kCpuFeaturePclmul        =  5,
+	_MCFCRT_kCpuFeatureAvx           =  6,
+	_MCFCRT_kCpuFeatureAvx2          =  7,
+	_MCFCRT_kCpuFeatureFma           =  8,
+	_MCFCRT_kCpuFeatureBmi1          =  9,
+	_MCFCRT_kCpuFeatureBmi2          = 10,
+	_MCFCRT_kCpuFeatureLzcnt         = 11,
+	_MCFCRT_kCpuFeatureErms          = 12,  // Enhanced REP MOVSB/STOSB.
+	_MCFCRT_kCpuFeatureFsrm          = 13,  // Fast short REP MOVSB.
+	_MCFCRT_kCpuFeatureSha           = 14,
+	_MCFCRT_kCpuFeatureAvx512f       = 15,
+	_MCFCRT_kCpuFeatureAvx512bw      = 16,
+	_MCFCRT_kCpuFeatureAvx512vl      = 17,
+	_MCFCRT_kCpuFeatureInvariantTsc  = 18,
+} _MCFCRT_CpuFeature;
+
+// Returns a bitmask where bit `_MCFCRT_kCpuFeature*` is set if the feature is available.
+// AVX and AVX-512 features are reported only if the OS saves the corresponding registers across context switches.
+// CPUID is executed once. This function takes no locks, so it can be called from anywhere, including from function dispatchers.
+extern _MCFCRT_STD uint32_t _MCFCRT_CpuGetFeatures(void) _MCFCRT_NOEXCEPT;
+
+__attribute__((__artificial__)) __MCFCRT_CPU_INLINE_OR_EXTERN bool _MCFCRT_CpuHasFeature(_MCFCRT_CpuFeature __feature) _MCFCRT_NOEXCEPT {
+	return (_MCFCRT_CpuGetFeatures() >> __feature) & 1;
+}
+
+// Defines `__name_` as a function that forwards its arguments through a function pointer.
+// The pointer initially points to a resolver, which calls `__select_(_MCFCRT_CpuGetFeatures())` to pick an implementation,
+// patches the pointer, then forwards the first call. Every call after that is a single indirect jump, without checking the CPU again.
+// `__select_` must return the same implementation every time, as the pointer may be patched by multiple threads at once.
+// The function must not return `void`.
+#define _MCFCRT_CPU_DISPATCH(__ret_, __name_, __params_, __args_, __select_)	\
+	static __ret_ _MCFCRT_PP_CAT2(__name_, _resolve_) __params_;	\
+	static __ret_ (*_MCFCRT_PP_CAT2(__name_, _target_)) __params_ = &_MCFCRT_PP_CAT2(__name_, _resolve_);	\
+	static __ret_ _MCFCRT_PP_CAT2(__name_, _resolve_) __params_ {	\
+		__ret_ (*const __target) __params_ = (__select_)(_MCFCRT_CpuGetFeatures());	\
+		__atomic_store_n(&_MCFCRT_PP_CAT2(__name_, _target_), __target, __ATOMIC_RELAXED);	\
+		return (*__target) __args_;	\
+	}	\
+	__ret_ __name_ __params_ {	\
+		return (*__atomic_load_n(&_MCFCRT_PP_CAT2(__name_, _target_), __ATOMIC_RELAXED)) __args_;	\
+	}
+
 _MCFCRT_EXTERN_C_END
 
 #endif
@@ -0,0 +1,120 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_FAIR_MUTEX_INLINE_OR_EXTERN     extern inline
+#include "fair_mutex.h"
+#include "clocks.h"
+#include "thread.h"
+#include "_park.h"
+#include "xassert.h"
+#include "expect.h"
+
+#define STATE_WAITING           ((uintptr_t)0)
+#define STATE_PARKED            ((uintptr_t)1)
+#define STATE_GRANTED           ((uintptr_t)2)
+
+#define MAX_POLL_YIELD_COUNT    ((size_t)16)
+
+typedef struct __MCFCRT_tagFairMutexNode {
+	struct __MCFCRT_tagFairMutexNode *volatile pNext;
+	volatile uintptr_t uState;
+} FairMutexNode;
+
+static inline FairMutexNode *GetSentinel(_MCFCRT_FairMutex *pMutex){
+	// This value is only compared with and is never dereferenced.
+	return (FairMutexNode *)(void *)pMutex;
+}
+
+static void WaitForHandoff(FairMutexNode *pNode, size_t uMaxSpinCount){
+	uintptr_t uState;
+	// Spin on our own node, which is not shared with other waiters.
+	for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+		__builtin_ia32_pause();
+		if(_MCFCRT_EXPECT_NOT(__atomic_load_n(&(pNode->uState), __ATOMIC_ACQUIRE) == STATE_GRANTED)){
+			return;
+		}
+	}
+	// Tell our predecessor that we are going to sleep. If it has granted us the mutex in the meantime, don't.
+	uState = STATE_WAITING;
+	if(!__atomic_compare_exchange_n(&(pNode->uState), &uState, STATE_PARKED, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)){
+		_MCFCRT_ASSERT(uState == STATE_GRANTED);
+		return;
+	}
+	__MCFCRT_ParkThreadForever((void *)pNode);
+	uState = __atomic_load_n(&(pNode->uState), __ATOMIC_ACQUIRE);
+	_MCFCRT_ASSERT(uState == STATE_GRANTED);
+}
+static void HandOff(FairMutexNode *pNode){
+	// `pNode` may go out of scope as soon as the mutex is granted, unless its owner has parked itself, in which case it cannot return before being woken up.
+	const uintptr_t uState = __atomic_exchange_n(&(pNode->uState), STATE_GRANTED, __ATOMIC_RELEASE);
+	// If `__MCFCRT_IsShutdownInProgress()` is `true`, other threads will have been terminated.
+	// Calling `__MCFCRT_UnparkThread()` when no thread is waiting results in deadlocks. Don't do that.
+	if((uState == STATE_PARKED) && !__MCFCRT_IsShutdownInProgress()){
+		__MCFCRT_UnparkThread((void *)pNode);
+	}
+}
+
+bool __MCFCRT_ReallyWaitForFairMutex(_MCFCRT_FairMutex *pMutex, uint64_t u64UntilFastMonoClock){
+	// A waiter cannot leave the queue before it is granted the mutex, so we poll instead of joining the queue.
+	for(size_t uPollIndex = 0; ; ++uPollIndex){
+		FairMutexNode *pTail = _MCFCRT_NULLPTR;
+		if(__atomic_compare_exchange_n(&(pMutex->__pTail), &pTail, GetSentinel(pMutex), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+			return true;
+		}
+		const uint64_t u64Now = _MCFCRT_GetFastMonoClock();
+		if(u64Now >= u64UntilFastMonoClock){
+			return false;
+		}
+		if(uPollIndex < MAX_POLL_YIELD_COUNT){
+			_MCFCRT_YieldThread();
+		} else {
+			_MCFCRT_Sleep(u64Now + 1);
+		}
+	}
+}
+void __MCFCRT_ReallyWaitForFairMutexForever(_MCFCRT_FairMutex *pMutex, size_t uMaxSpinCount){
+	FairMutexNode vNode, *pPrev, *pNext, *pTail;
+
+	vNode.pNext = _MCFCRT_NULLPTR;
+	vNode.uState = STATE_WAITING;
+	// Join the queue.
+	pPrev = __atomic_exchange_n(&(pMutex->__pTail), &vNode, __ATOMIC_ACQ_REL);
+	if(pPrev){
+		// Link ourselves after our predecessor, which is either the owner (which is represented by the mutex itself) or another waiter.
+		if(pPrev == GetSentinel(pMutex)){
+			__atomic_store_n(&(pMutex->__pNext), &vNode, __ATOMIC_RELEASE);
+		} else {
+			__atomic_store_n(&(pPrev->pNext), &vNode, __ATOMIC_RELEASE);
+		}
+		WaitForHandoff(&vNode, uMaxSpinCount);
+	}
+	// We are the owner now. Our node is about to go out of scope, so take it out of the queue.
+	// If we are the last one, the mutex itself becomes the tail. Otherwise, wait for our successor to link itself and move the link into the mutex.
+	pTail = &vNode;
+	if(!__atomic_compare_exchange_n(&(pMutex->__pTail), &pTail, GetSentinel(pMutex), false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+		while(_MCFCRT_EXPECT_NOT(!(pNext = __atomic_load_n(&(vNode.pNext), __ATOMIC_ACQUIRE)))){
+			__builtin_ia32_pause();
+		}
+		__atomic_store_n(&(pMutex->__pNext), pNext, __ATOMIC_RELEASE);
+	}
+}
+void __MCFCRT_ReallySignalFairMutex(_MCFCRT_FairMutex *pMutex){
+	FairMutexNode *pNext, *pTail;
+
+	pNext = __atomic_load_n(&(pMutex->__pNext), __ATOMIC_ACQUIRE);
+	if(!pNext){
+		pTail = GetSentinel(pMutex);
+		if(__atomic_compare_exchange_n(&(pMutex->__pTail), &pTail, _MCFCRT_NULLPTR, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)){
+			return;
+		}
+		_MCFCRT_ASSERT_MSG(pTail, L"互斥锁没有被任何线程锁定。");
+		// A waiter has joined the queue but has not linked itself yet.
+		while(_MCFCRT_EXPECT_NOT(!(pNext = __atomic_load_n(&(pMutex->__pNext), __ATOMIC_ACQUIRE)))){
+			__builtin_ia32_pause();
+		}
+	}
+	// The new owner will store its successor here, so this has to be done before the handoff.
+	__atomic_store_n(&(pMutex->__pNext), _MCFCRT_NULLPTR, __ATOMIC_RELAXED);
+	HandOff(pNext);
+}
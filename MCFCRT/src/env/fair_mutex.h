@@ -0,0 +1,71 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_FAIR_MUTEX_H_
+#define __MCFCRT_ENV_FAIR_MUTEX_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_FAIR_MUTEX_INLINE_OR_EXTERN
+#  define __MCFCRT_FAIR_MUTEX_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// A fair mutex is a queue lock in the manner of Mellor-Crummey and Scott. Threads that have to wait are queued in FIFO order, each of which
+// spins on its own queue node, which lives on its stack, then parks itself on the keyed event using the address of that node as the key.
+// When the mutex is unlocked, ownership is handed off to the first waiter directly, so exactly one thread is woken up and no thread can barge in.
+// This is slower than `_MCFCRT_Mutex` when there is little contention or when owners are preempted, but has bounded unfairness under heavy contention.
+// Waiting with a timeout does not join the queue; instead, the mutex is polled until it is acquired or the timeout expires.
+// As with `_MCFCRT_Mutex`, a fair mutex that has been locked by one thread can be unlocked by another.
+
+struct __MCFCRT_tagFairMutexNode;
+
+// In the case of static initialization, please initialize it with { 0 }.
+typedef struct __MCFCRT_tagFairMutex {
+	// This is the first waiter, which is the successor of the current owner.
+	struct __MCFCRT_tagFairMutexNode *__pNext;
+	// This is the last waiter. If the mutex is locked and there are no waiters, this points to the mutex itself. If the mutex is not locked, this is null.
+	struct __MCFCRT_tagFairMutexNode *__pTail;
+} _MCFCRT_FairMutex;
+
+#define _MCFCRT_FAIR_MUTEX_SUGGESTED_SPIN_COUNT   1000u
+
+__MCFCRT_FAIR_MUTEX_INLINE_OR_EXTERN void _MCFCRT_InitializeFairMutex(_MCFCRT_FairMutex *__pMutex) _MCFCRT_NOEXCEPT {
+	__atomic_store_n(&(__pMutex->__pNext), _MCFCRT_NULLPTR, __ATOMIC_RELAXED);
+	__atomic_store_n(&(__pMutex->__pTail), _MCFCRT_NULLPTR, __ATOMIC_RELEASE);
+}
+
+extern bool __MCFCRT_ReallyWaitForFairMutex(_MCFCRT_FairMutex *__pMutex, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForFairMutexForever(_MCFCRT_FairMutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallySignalFairMutex(_MCFCRT_FairMutex *__pMutex) _MCFCRT_NOEXCEPT;
+
+__MCFCRT_FAIR_MUTEX_INLINE_OR_EXTERN bool _MCFCRT_WaitForFairMutex(_MCFCRT_FairMutex *__pMutex, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	struct __MCFCRT_tagFairMutexNode *__pTail = _MCFCRT_NULLPTR;
+	if(__builtin_expect(__atomic_compare_exchange_n(&(__pMutex->__pTail), &__pTail, (struct __MCFCRT_tagFairMutexNode *)(void *)__pMutex, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+		return true;
+	}
+	if(__u64UntilFastMonoClock == 0){
+		return false;
+	}
+	return __MCFCRT_ReallyWaitForFairMutex(__pMutex, __u64UntilFastMonoClock);
+}
+__MCFCRT_FAIR_MUTEX_INLINE_OR_EXTERN void _MCFCRT_WaitForFairMutexForever(_MCFCRT_FairMutex *__pMutex, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
+	struct __MCFCRT_tagFairMutexNode *__pTail = _MCFCRT_NULLPTR;
+	if(__builtin_expect(__atomic_compare_exchange_n(&(__pMutex->__pTail), &__pTail, (struct __MCFCRT_tagFairMutexNode *)(void *)__pMutex, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+		return;
+	}
+	__MCFCRT_ReallyWaitForFairMutexForever(__pMutex, __uMaxSpinCount);
+}
+__MCFCRT_FAIR_MUTEX_INLINE_OR_EXTERN void _MCFCRT_SignalFairMutex(_MCFCRT_FairMutex *__pMutex) _MCFCRT_NOEXCEPT {
+	struct __MCFCRT_tagFairMutexNode *__pTail = (struct __MCFCRT_tagFairMutexNode *)(void *)__pMutex;
+	if(__builtin_expect(__atomic_compare_exchange_n(&(__pMutex->__pTail), &__pTail, _MCFCRT_NULLPTR, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED), true)){
+		return;
+	}
+	__MCFCRT_ReallySignalFairMutex(__pMutex);
+}
+
+_MCFCRT_EXTERN_C_END
+
+#endif
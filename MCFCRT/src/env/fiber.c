@@ -0,0 +1,324 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "fiber.h"
+#include "xsetjmp.h"
+#include "thread.h"
+#include "xassert.h"
+#include "bail.h"
+#include "expect.h"
+
+#ifdef _WIN32
+#  include "mcfwin.h"
+#else
+#  include <errno.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#endif
+
+#ifdef _WIN32
+// These fields are swapped along with the stack, otherwise the system would reject exception frames on fiber stacks.
+typedef struct tagStackInfo {
+	void *pExceptionList;
+	void *pStackBase;
+	void *pStackLimit;
+} StackInfo;
+#endif
+
+typedef struct tagFiber {
+	_MCFCRT_FiberProc pfnFiberProc;
+	intptr_t nParam;
+	void *pMapping;
+	size_t uMappingSize;
+	void *pStackTop;
+
+	bool bStarted;
+	bool bRunning;
+	bool bFinished;
+	// This is the fiber that resumed this fiber, or a null pointer if it was resumed by a thread directly.
+	struct tagFiber *pResumer;
+
+	// `__builtin_setjmp()` saves only the frame pointer, the stack pointer and the resume address. Other callee-saved registers are spilled onto the stack by the compiler.
+	_MCFCRT_jmp_buf vFiberContext;
+	_MCFCRT_jmp_buf vResumerContext;
+#ifdef _WIN32
+	StackInfo vFiberStack;
+	StackInfo vResumerStack;
+#endif
+
+	intptr_t anLocals[_MCFCRT_FIBER_LOCAL_SLOT_COUNT];
+} Fiber;
+
+#ifdef _WIN32
+
+static size_t GetPageSize(void){
+	SYSTEM_INFO vSystemInfo;
+	GetSystemInfo(&vSystemInfo);
+	return vSystemInfo.dwPageSize;
+}
+static void *MapStack(size_t uSize, size_t uGuardSize){
+	void *const pMapping = VirtualAlloc(_MCFCRT_NULLPTR, uSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if(!pMapping){
+		return _MCFCRT_NULLPTR;
+	}
+	DWORD dwOldProtect;
+	if(!VirtualProtect(pMapping, uGuardSize, PAGE_NOACCESS, &dwOldProtect)){
+		const DWORD dwLastError = GetLastError();
+		VirtualFree(pMapping, 0, MEM_RELEASE);
+		SetLastError(dwLastError);
+		return _MCFCRT_NULLPTR;
+	}
+	return pMapping;
+}
+static void UnmapStack(void *pMapping, size_t uSize){
+	(void)uSize;
+	const bool bSucceeded = VirtualFree(pMapping, 0, MEM_RELEASE);
+	_MCFCRT_ASSERT_MSG(bSucceeded, L"VirtualFree() 失败。");
+}
+static void SetInvalidParameterError(void){
+	SetLastError(ERROR_INVALID_PARAMETER);
+}
+
+static volatile DWORD g_dwTlsIndex = TLS_OUT_OF_INDEXES;
+
+static DWORD RequireTlsIndex(void){
+	DWORD dwTlsIndex = __atomic_load_n(&g_dwTlsIndex, __ATOMIC_ACQUIRE);
+	if(_MCFCRT_EXPECT_NOT(dwTlsIndex == TLS_OUT_OF_INDEXES)){
+		const DWORD dwNewTlsIndex = TlsAlloc();
+		if(dwNewTlsIndex == TLS_OUT_OF_INDEXES){
+			_MCFCRT_Bail(L"TlsAlloc() 失败。");
+		}
+		if(__atomic_compare_exchange_n(&g_dwTlsIndex, &dwTlsIndex, dwNewTlsIndex, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+			dwTlsIndex = dwNewTlsIndex;
+		} else {
+			TlsFree(dwNewTlsIndex);
+		}
+	}
+	return dwTlsIndex;
+}
+// `TlsGetValue()` and `TlsSetValue()` overwrite the per-thread error code even if they succeed.
+__attribute__((__noinline__)) static Fiber *GetCurrentFiberPointer(void){
+	const DWORD dwTlsIndex = RequireTlsIndex();
+	const DWORD dwLastError = GetLastError();
+	Fiber *const pFiber = TlsGetValue(dwTlsIndex);
+	SetLastError(dwLastError);
+	return pFiber;
+}
+__attribute__((__noinline__)) static void SetCurrentFiberPointer(Fiber *pFiber){
+	const DWORD dwTlsIndex = RequireTlsIndex();
+	const DWORD dwLastError = GetLastError();
+	const bool bSucceeded = TlsSetValue(dwTlsIndex, pFiber);
+	_MCFCRT_ASSERT_MSG(bSucceeded, L"TlsSetValue() 失败。");
+	SetLastError(dwLastError);
+}
+
+static void SwapStackInfo(StackInfo *restrict pSaveTo, const StackInfo *restrict pLoadFrom){
+	NT_TIB *const pTib = (NT_TIB *)NtCurrentTeb();
+	pSaveTo->pExceptionList = pTib->ExceptionList;
+	pSaveTo->pStackBase = pTib->StackBase;
+	pSaveTo->pStackLimit = pTib->StackLimit;
+	pTib->ExceptionList = pLoadFrom->pExceptionList;
+	pTib->StackBase = pLoadFrom->pStackBase;
+	pTib->StackLimit = pLoadFrom->pStackLimit;
+}
+
+#else
+
+static size_t GetPageSize(void){
+	return (size_t)sysconf(_SC_PAGESIZE);
+}
+static void *MapStack(size_t uSize, size_t uGuardSize){
+	void *const pMapping = mmap(_MCFCRT_NULLPTR, uSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+	if(pMapping == MAP_FAILED){
+		return _MCFCRT_NULLPTR;
+	}
+	if(mprotect(pMapping, uGuardSize, PROT_NONE) != 0){
+		const int nError = errno;
+		munmap(pMapping, uSize);
+		errno = nError;
+		return _MCFCRT_NULLPTR;
+	}
+	return pMapping;
+}
+static void UnmapStack(void *pMapping, size_t uSize){
+	const int nResult = munmap(pMapping, uSize);
+	_MCFCRT_ASSERT_MSG(nResult == 0, L"munmap() 失败。");
+}
+static void SetInvalidParameterError(void){
+	errno = EINVAL;
+}
+
+static _Thread_local Fiber *t_pCurrentFiber;
+
+// A fiber may be resumed by another thread, so the address of the thread-local variable must be recalculated after each switch.
+__attribute__((__noinline__)) static Fiber *GetCurrentFiberPointer(void){
+	return t_pCurrentFiber;
+}
+__attribute__((__noinline__)) static void SetCurrentFiberPointer(Fiber *pFiber){
+	t_pCurrentFiber = pFiber;
+}
+
+#endif
+
+_MCFCRT_FiberHandle _MCFCRT_CreateFiber(_MCFCRT_FiberProc pfnFiberProc, intptr_t nParam, size_t uStackSize){
+	if(uStackSize == 0){
+		uStackSize = _MCFCRT_FIBER_DEFAULT_STACK_SIZE;
+	}
+	const size_t uPageSize = GetPageSize();
+	// The fiber control block is placed at the top of the stack.
+	const size_t uUsableSize = uStackSize + sizeof(Fiber) + 64;
+	if(uUsableSize < uStackSize){
+		SetInvalidParameterError();
+		return _MCFCRT_NULLPTR;
+	}
+	const size_t uMappingSize = uPageSize + ((uUsableSize + uPageSize - 1) & ~(uPageSize - 1));
+	if(uMappingSize < uUsableSize){
+		SetInvalidParameterError();
+		return _MCFCRT_NULLPTR;
+	}
+	unsigned char *const pMapping = MapStack(uMappingSize, uPageSize);
+	if(!pMapping){
+		return _MCFCRT_NULLPTR;
+	}
+	Fiber *const pFiber = (Fiber *)(((uintptr_t)(pMapping + uMappingSize) - sizeof(Fiber)) & ~(uintptr_t)63);
+	pFiber->pfnFiberProc = pfnFiberProc;
+	pFiber->nParam = nParam;
+	pFiber->pMapping = pMapping;
+	pFiber->uMappingSize = uMappingSize;
+	pFiber->pStackTop = pFiber;
+	pFiber->bStarted = false;
+	pFiber->bRunning = false;
+	pFiber->bFinished = false;
+	pFiber->pResumer = _MCFCRT_NULLPTR;
+#ifdef _WIN32
+	pFiber->vFiberStack.pExceptionList = (void *)-1;
+	pFiber->vFiberStack.pStackBase = pFiber->pStackTop;
+	pFiber->vFiberStack.pStackLimit = pMapping + uPageSize;
+#endif
+	for(size_t i = 0; i < _MCFCRT_FIBER_LOCAL_SLOT_COUNT; ++i){
+		pFiber->anLocals[i] = 0;
+	}
+	return (_MCFCRT_FiberHandle)pFiber;
+}
+void _MCFCRT_DestroyFiber(_MCFCRT_FiberHandle hFiber){
+	Fiber *const pFiber = (Fiber *)hFiber;
+	_MCFCRT_ASSERT_MSG(!pFiber->bRunning, L"不能销毁正在运行的纤程。");
+
+	UnmapStack(pFiber->pMapping, pFiber->uMappingSize);
+}
+
+_MCFCRT_FiberHandle _MCFCRT_GetCurrentFiber(void){
+	return (_MCFCRT_FiberHandle)GetCurrentFiberPointer();
+}
+
+// This function is called on the fiber stack. It never returns.
+__attribute__((__noinline__, __noreturn__)) static void SwitchToResumer(Fiber *pFiber){
+	pFiber->bRunning = false;
+	SetCurrentFiberPointer(pFiber->pResumer);
+#ifdef _WIN32
+	SwapStackInfo(&(pFiber->vFiberStack), &(pFiber->vResumerStack));
+#endif
+	_MCFCRT_LONGJMP(pFiber->vResumerContext);
+}
+
+static unsigned long WrappedFiberProc(void *pParam){
+	Fiber *const pFiber = pParam;
+	(*(pFiber->pfnFiberProc))(pFiber->nParam);
+	return 0;
+}
+__attribute__((__force_align_arg_pointer__, __noreturn__, __used__)) static void FiberEntry(Fiber *pFiber){
+	_MCFCRT_WrapThreadProcWithSehTop(&WrappedFiberProc, pFiber);
+	pFiber->bFinished = true;
+	SwitchToResumer(pFiber);
+}
+
+// A null return address is pushed so stack unwinding stops here.
+__attribute__((__noinline__, __noreturn__)) static void SwitchToNewStack(Fiber *pFiber, void *pStackTop){
+#if defined(__x86_64__) && defined(_WIN64)
+	// Reserve the shadow space for the first parameter.
+	__asm__ volatile (
+		"mov rsp, %0 \n"
+		"sub rsp, 32 \n"
+		"push 0 \n"
+		"jmp %1 \n"
+		: : "r"(pStackTop), "r"(&FiberEntry), "c"(pFiber)
+	);
+#elif defined(__x86_64__)
+	__asm__ volatile (
+		"mov rsp, %0 \n"
+		"push 0 \n"
+		"jmp %1 \n"
+		: : "r"(pStackTop), "r"(&FiberEntry), "D"(pFiber)
+	);
+#elif defined(__i386__)
+	__asm__ volatile (
+		"lea esp, dword ptr[%0 - 16] \n"
+		"mov dword ptr[esp], %2 \n"
+		"push 0 \n"
+		"jmp %1 \n"
+		: : "r"(pStackTop), "r"(&FiberEntry), "r"(pFiber)
+	);
+#else
+#  error This architecture is not supported.
+#endif
+	__builtin_unreachable();
+}
+
+bool _MCFCRT_ResumeFiber(_MCFCRT_FiberHandle hFiber){
+	Fiber *const pFiber = (Fiber *)hFiber;
+	_MCFCRT_ASSERT_MSG(!pFiber->bRunning, L"纤程已在运行。");
+	_MCFCRT_ASSERT_MSG(!pFiber->bFinished, L"纤程已经结束。");
+
+	pFiber->bRunning = true;
+	pFiber->pResumer = GetCurrentFiberPointer();
+	SetCurrentFiberPointer(pFiber);
+#ifdef _WIN32
+	SwapStackInfo(&(pFiber->vResumerStack), &(pFiber->vFiberStack));
+#endif
+	if(_MCFCRT_SETJMP(pFiber->vResumerContext) == 0){
+		if(pFiber->bStarted){
+			_MCFCRT_LONGJMP(pFiber->vFiberContext);
+		}
+		pFiber->bStarted = true;
+		SwitchToNewStack(pFiber, pFiber->pStackTop);
+	}
+	return pFiber->bFinished;
+}
+void _MCFCRT_YieldFiber(void){
+	Fiber *const pFiber = GetCurrentFiberPointer();
+	_MCFCRT_ASSERT_MSG(pFiber, L"当前线程没有在运行纤程。");
+
+	if(_MCFCRT_SETJMP(pFiber->vFiberContext) == 0){
+		SwitchToResumer(pFiber);
+	}
+}
+bool _MCFCRT_IsFiberFinished(_MCFCRT_FiberHandle hFiber){
+	const Fiber *const pFiber = (const Fiber *)hFiber;
+	return pFiber->bFinished;
+}
+
+static volatile size_t g_uNextLocalSlot = 0;
+
+bool _MCFCRT_AllocFiberLocalSlot(size_t *puSlot){
+	size_t uSlot = __atomic_load_n(&g_uNextLocalSlot, __ATOMIC_RELAXED);
+	do {
+		if(uSlot >= _MCFCRT_FIBER_LOCAL_SLOT_COUNT){
+			return false;
+		}
+	} while(!__atomic_compare_exchange_n(&g_uNextLocalSlot, &uSlot, uSlot + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	*puSlot = uSlot;
+	return true;
+}
+intptr_t _MCFCRT_GetFiberLocal(_MCFCRT_FiberHandle hFiber, size_t uSlot){
+	const Fiber *const pFiber = (const Fiber *)hFiber;
+	_MCFCRT_ASSERT(uSlot < _MCFCRT_FIBER_LOCAL_SLOT_COUNT);
+
+	return pFiber->anLocals[uSlot];
+}
+void _MCFCRT_SetFiberLocal(_MCFCRT_FiberHandle hFiber, size_t uSlot, intptr_t nValue){
+	Fiber *const pFiber = (Fiber *)hFiber;
+	_MCFCRT_ASSERT(uSlot < _MCFCRT_FIBER_LOCAL_SLOT_COUNT);
+
+	pFiber->anLocals[uSlot] = nValue;
+}
@@ -0,0 +1,45 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_FIBER_H_
+#define __MCFCRT_ENV_FIBER_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// A fiber is a user-mode thread of execution with its own stack. Fibers are scheduled cooperatively:
+// `_MCFCRT_ResumeFiber()` runs a fiber until it calls `_MCFCRT_YieldFiber()` or its fiber procedure returns, at which point control goes back to the resumer.
+// A fiber may be resumed by a different thread each time, but it must not be resumed by two threads at the same time.
+// Fibers must not be switched inside a C++ `catch` block, because the exception state of the C++ runtime is per-thread.
+
+// The lowest page of each fiber stack is inaccessible, so a stack overflow results in an access violation rather than heap corruption.
+#define _MCFCRT_FIBER_DEFAULT_STACK_SIZE     0x10000u
+#define _MCFCRT_FIBER_LOCAL_SLOT_COUNT       64u
+
+typedef void (*_MCFCRT_FiberProc)(_MCFCRT_STD intptr_t __nParam);
+
+typedef struct __MCFCRT_tagFiberHandle { int __n; } *_MCFCRT_FiberHandle;
+
+// If `__uStackSize` is zero, `_MCFCRT_FIBER_DEFAULT_STACK_SIZE` is used.
+extern _MCFCRT_FiberHandle _MCFCRT_CreateFiber(_MCFCRT_FiberProc __pfnFiberProc, _MCFCRT_STD intptr_t __nParam, _MCFCRT_STD size_t __uStackSize) _MCFCRT_NOEXCEPT;
+// A fiber that has yielded may be destroyed, but objects on its stack will not be destructed.
+extern void _MCFCRT_DestroyFiber(_MCFCRT_FiberHandle __hFiber) _MCFCRT_NOEXCEPT;
+
+// _MCFCRT_GetCurrentFiber() returns a null pointer if the current thread is not running a fiber.
+extern _MCFCRT_FiberHandle _MCFCRT_GetCurrentFiber(void) _MCFCRT_NOEXCEPT;
+// _MCFCRT_ResumeFiber() returns true if the fiber procedure has returned and false if the fiber has yielded.
+extern bool _MCFCRT_ResumeFiber(_MCFCRT_FiberHandle __hFiber) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_YieldFiber(void) _MCFCRT_NOEXCEPT;
+extern bool _MCFCRT_IsFiberFinished(_MCFCRT_FiberHandle __hFiber) _MCFCRT_NOEXCEPT;
+
+// Fiber-local slots are shared by all fibers and are never freed. Their values are initialized to zero.
+// _MCFCRT_AllocFiberLocalSlot() returns false if all `_MCFCRT_FIBER_LOCAL_SLOT_COUNT` slots have been allocated.
+extern bool _MCFCRT_AllocFiberLocalSlot(_MCFCRT_STD size_t *__puSlot) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD intptr_t _MCFCRT_GetFiberLocal(_MCFCRT_FiberHandle __hFiber, _MCFCRT_STD size_t __uSlot) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_SetFiberLocal(_MCFCRT_FiberHandle __hFiber, _MCFCRT_STD size_t __uSlot, _MCFCRT_STD intptr_t __nValue) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
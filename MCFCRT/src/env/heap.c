@@ -4,8 +4,8 @@
 
 #include "heap.h"
 #include "mcfwin.h"
-#include "mutex.h"
 #include "heap_debug.h"
+#include "_heap_engine.h"
 #include "inline_mem.h"
 #include "bail.h"
 
@@ -15,13 +15,19 @@
 #endif
 
 static inline void * Underlying_malloc_zf(size_t size, bool zero_fill){
-	return LocalAlloc(zero_fill ? LPTR : LMEM_FIXED, size);
+	return __MCFCRT_HeapEngineAlloc(size, zero_fill);
+}
+static inline void * Underlying_aligned_malloc_zf(size_t size, size_t alignment, bool zero_fill){
+	return __MCFCRT_HeapEngineAllocAligned(size, alignment, zero_fill);
 }
 static inline void * Underlying_realloc_zf(void *ptr, size_t size, bool zero_fill){
-	return LocalReAlloc(ptr, size, zero_fill ? LPTR : LMEM_FIXED);
+	return __MCFCRT_HeapEngineRealloc(ptr, size, zero_fill);
 }
 static inline void Underlying_free(void *ptr){
-	LocalFree(ptr);
+	__MCFCRT_HeapEngineFree(ptr);
+}
+static inline size_t Underlying_usable_size(const void *ptr){
+	return __MCFCRT_HeapEngineGetUsableSize(ptr);
 }
 
 static inline void InvokeHeapCallback(void *pBlockNew, size_t uSizeNew, void *pBlockOld, const void *pRetAddrOuter, const void *pRetAddrInner){
@@ -40,7 +46,7 @@ void * __MCFCRT_HeapAlloc(size_t uSizeNew, bool bFillsWithZero, const void *pRet
 	// Clobber the per-thread error code unconditionally in debug mode.
 	SetLastError(0xDEADBEEF);
 	// Include the size of additional debug information if requested.
-	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew);
+	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew, 0);
 #else
 	uSizeToAlloc = uSizeNew;
 #endif
@@ -51,7 +57,44 @@ void * __MCFCRT_HeapAlloc(size_t uSizeNew, bool bFillsWithZero, const void *pRet
 	}
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Register it and adjust the pointer.
-	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, pStorageNew, pRetAddrOuter, __builtin_return_address(0));
+	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, pStorageNew, 0, pRetAddrOuter, __builtin_return_address(0));
+	if(!bFillsWithZero && (uSizeNew > 0)){
+		// If any bytes have been allocated, poison those that are considered uninitialized.
+		_MCFCRT_inline_mempset_fwd(pBlockNew, 0xCA, uSizeNew);
+	}
+#else
+	pBlockNew = pStorageNew;
+#endif
+
+	// Invoke the heap callback in the end, if any.
+	InvokeHeapCallback(pBlockNew, uSizeNew, _MCFCRT_NULLPTR, pRetAddrOuter, __builtin_return_address(0));
+	return pBlockNew;
+}
+void * __MCFCRT_HeapAllocAligned(size_t uSizeNew, size_t uAlignment, bool bFillsWithZero, const void *pRetAddrOuter){
+	size_t uPadding, uSizeToAlloc;
+	void *pStorageNew, *pBlockNew;
+
+	if((uAlignment == 0) || ((uAlignment & (uAlignment - 1)) != 0) || (uAlignment > _MCFCRT_HEAP_MAX_ALIGNMENT)){
+		return _MCFCRT_NULLPTR;
+	}
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Clobber the per-thread error code unconditionally in debug mode.
+	SetLastError(0xDEADBEEF);
+	// Move the header forward so the payload is aligned, then include the size of additional debug information if requested.
+	uPadding = __MCFCRT_HeapDebugCalculatePadding(uAlignment);
+	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew, uPadding);
+#else
+	(void)uPadding;
+	uSizeToAlloc = uSizeNew;
+#endif
+	// Perform the allocation.
+	pStorageNew = Underlying_aligned_malloc_zf(uSizeToAlloc, uAlignment, bFillsWithZero);
+	if(!pStorageNew){
+		return _MCFCRT_NULLPTR;
+	}
+#ifdef __MCFCRT_HEAP_DEBUG
+	// Register it and adjust the pointer.
+	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, pStorageNew, uPadding, pRetAddrOuter, __builtin_return_address(0));
 	if(!bFillsWithZero && (uSizeNew > 0)){
 		// If any bytes have been allocated, poison those that are considered uninitialized.
 		_MCFCRT_inline_mempset_fwd(pBlockNew, 0xCA, uSizeNew);
@@ -65,24 +108,25 @@ void * __MCFCRT_HeapAlloc(size_t uSizeNew, bool bFillsWithZero, const void *pRet
 	return pBlockNew;
 }
 void * __MCFCRT_HeapRealloc(void *pBlockOld, size_t uSizeNew, bool bFillsWithZero, const void *pRetAddrOuter){
-	size_t uSizeOld, uSizeToAlloc;
+	size_t uSizeOld, uPaddingOld, uSizeToAlloc;
 	void *pStorageOld, *pStorageNew, *pBlockNew;
 
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Clobber the per-thread error code unconditionally in debug mode.
 	SetLastError(0xDEADBEEF);
 	// Make sure the old block is not corrupted.
-	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &pStorageOld, pBlockOld)){
+	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &uPaddingOld, &pStorageOld, pBlockOld)){
 		_MCFCRT_Bail(L"__MCFCRT_HeapRealloc() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
 	}
 	if(uSizeOld > uSizeNew){
 		// If the block is to be shrinked, poison bytes that are to be discarded.
 		_MCFCRT_inline_mempset_fwd((unsigned char *)pBlockOld + uSizeNew, 0xDB, uSizeOld - uSizeNew);
 	}
-	// Include the size of additional debug information if requested.
-	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew);
+	// Include the size of additional debug information if requested. The payload stays at the same offset in the underlying storage.
+	uSizeToAlloc = __MCFCRT_HeapDebugCalculateSizeToAlloc(uSizeNew, uPaddingOld);
 #else
 	(void)uSizeOld;
+	(void)uPaddingOld;
 	pStorageOld = pBlockOld;
 	uSizeToAlloc = uSizeNew;
 #endif
@@ -91,13 +135,13 @@ void * __MCFCRT_HeapRealloc(void *pBlockOld, size_t uSizeNew, bool bFillsWithZer
 	if(!pStorageNew){
 #ifdef __MCFCRT_HEAP_DEBUG
 		// Stuff it back...
-		__MCFCRT_HeapDebugUndoUnregister(pStorageOld);
+		__MCFCRT_HeapDebugUndoUnregister(pBlockOld);
 #endif
 		return _MCFCRT_NULLPTR;
 	}
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Register it and adjust the pointer.
-	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, pStorageNew, pRetAddrOuter, __builtin_return_address(0));
+	__MCFCRT_HeapDebugRegister(&pBlockNew, uSizeNew, pStorageNew, uPaddingOld, pRetAddrOuter, __builtin_return_address(0));
 	if(!bFillsWithZero && (uSizeNew > uSizeOld)){
 		// If the block has been extended, poison bytes that are considered uninitialized.
 		_MCFCRT_inline_mempset_fwd((unsigned char *)pBlockNew + uSizeOld, 0xCC, uSizeNew - uSizeOld);
@@ -110,30 +154,57 @@ void * __MCFCRT_HeapRealloc(void *pBlockOld, size_t uSizeNew, bool bFillsWithZer
 	InvokeHeapCallback(pBlockNew, uSizeNew, pBlockOld, pRetAddrOuter, __builtin_return_address(0));
 	return pBlockNew;
 }
-void __MCFCRT_HeapFree(void *pBlockOld, const void *pRetAddrOuter){
-	size_t uSizeOld;
+__attribute__((__always_inline__)) static inline void ReallyFree(void *pBlockOld, bool bSizeKnown, size_t uSizeKnown, const void *pRetAddrOuter, const void *pRetAddrInner){
+	size_t uSizeOld, uPaddingOld;
 	void *pStorageOld;
 
 #ifdef __MCFCRT_HEAP_DEBUG
 	// Clobber the per-thread error code unconditionally in debug mode.
 	SetLastError(0xDEADBEEF);
 	// Make sure the old block is not corrupted.
-	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &pStorageOld, pBlockOld)){
-		_MCFCRT_Bail(L"__MCFCRT_HeapFree() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
+	if(!__MCFCRT_HeapDebugValidateAndUnregister(&uSizeOld, &uPaddingOld, &pStorageOld, pBlockOld)){
+		_MCFCRT_Bail(bSizeKnown ? L"__MCFCRT_HeapFreeSized() 检测到堆损坏，这通常是错误的内存写入操作导致的。"
+		                        : L"__MCFCRT_HeapFree() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
+	}
+	if(bSizeKnown && (uSizeKnown != uSizeOld)){
+		_MCFCRT_Bail(L"__MCFCRT_HeapFreeSized() 检测到内存块大小不匹配，这通常是释放内存时传入了错误的大小导致的。");
 	}
 	if(uSizeOld > 0){
 		// If any bytes are to be freed, poison those that are to be discarded.
 		_MCFCRT_inline_mempset_fwd(pBlockOld, 0xDD, uSizeOld);
 	}
 #else
+	// The size class of a block is stored in the header of its chunk, which is located by masking the address. There is nothing to gain from the size.
+	(void)bSizeKnown;
+	(void)uSizeKnown;
 	(void)uSizeOld;
+	(void)uPaddingOld;
 	pStorageOld = pBlockOld;
 #endif
 	// Perform the deallocation.
 	Underlying_free(pStorageOld);
 
 	// Invoke the heap callback in the end, if any.
-	InvokeHeapCallback(_MCFCRT_NULLPTR, 0, pBlockOld, pRetAddrOuter, __builtin_return_address(0));
+	InvokeHeapCallback(_MCFCRT_NULLPTR, 0, pBlockOld, pRetAddrOuter, pRetAddrInner);
+}
+
+void __MCFCRT_HeapFree(void *pBlockOld, const void *pRetAddrOuter){
+	ReallyFree(pBlockOld, false, 0, pRetAddrOuter, __builtin_return_address(0));
+}
+void __MCFCRT_HeapFreeSized(void *pBlockOld, size_t uSizeOld, const void *pRetAddrOuter){
+	ReallyFree(pBlockOld, true, uSizeOld, pRetAddrOuter, __builtin_return_address(0));
+}
+
+size_t __MCFCRT_HeapGetUsableSize(const void *pBlock){
+#ifdef __MCFCRT_HEAP_DEBUG
+	size_t uSize;
+	if(!__MCFCRT_HeapDebugValidate(&uSize, pBlock)){
+		_MCFCRT_Bail(L"__MCFCRT_HeapGetUsableSize() 检测到堆损坏，这通常是错误的内存写入操作导致的。");
+	}
+	return uSize;
+#else
+	return Underlying_usable_size(pBlock);
+#endif
 }
 
 static volatile _MCFCRT_HeapCallback g_pfnHeapCallback = _MCFCRT_NULLPTR;
@@ -144,3 +215,10 @@ _MCFCRT_HeapCallback _MCFCRT_GetHeapCallback(void){
 _MCFCRT_HeapCallback _MCFCRT_SetHeapCallback(_MCFCRT_HeapCallback pfnNewCallback){
 	return __atomic_exchange_n(&g_pfnHeapCallback, pfnNewCallback, __ATOMIC_RELEASE);
 }
+
+void _MCFCRT_GetHeapStatistics(_MCFCRT_HeapStatistics *pStatistics){
+	__MCFCRT_HeapEngineGetStatistics(pStatistics);
+}
+size_t _MCFCRT_GetHeapThreadStatistics(_MCFCRT_HeapThreadStatistics *restrict pThreads, size_t uMaxCount){
+	return __MCFCRT_HeapEngineGetThreadStatistics(pThreads, uMaxCount);
+}
@@ -13,11 +13,53 @@ __attribute__((__malloc__)) extern void * __MCFCRT_HeapAlloc(_MCFCRT_STD size_t
 __attribute__((__nonnull__(1))) extern void * __MCFCRT_HeapRealloc(void *__pBlockOld, _MCFCRT_STD size_t __uSizeNew, bool __bFillsWithZero, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
 __attribute__((__nonnull__(1))) extern void __MCFCRT_HeapFree(void *__pBlockOld, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
 
+// Blocks may be aligned to any power of two up to this value. `__MCFCRT_HeapAllocAligned()` returns a null pointer if the alignment is invalid.
+// Over-aligned blocks can be reallocated and freed as usual. Nevertheless, reallocation may not preserve the alignment.
+#define _MCFCRT_HEAP_MAX_ALIGNMENT   0x8000u
+
+__attribute__((__malloc__)) extern void * __MCFCRT_HeapAllocAligned(_MCFCRT_STD size_t __uSizeNew, _MCFCRT_STD size_t __uAlignment, bool __bFillsWithZero, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
+// `__uSizeOld` shall be the size that was requested when the block was allocated or last reallocated. It is checked by the debug heap.
+__attribute__((__nonnull__(1))) extern void __MCFCRT_HeapFreeSized(void *__pBlockOld, _MCFCRT_STD size_t __uSizeOld, const void *__pRetAddrOuter) _MCFCRT_NOEXCEPT;
+// This function returns the number of bytes that can be used in a block, which is never less than the size that was requested.
+// If the debug heap is enabled, it returns the size that was requested exactly, so writes beyond that are still caught.
+__attribute__((__nonnull__(1))) extern _MCFCRT_STD size_t __MCFCRT_HeapGetUsableSize(const void *__pBlock) _MCFCRT_NOEXCEPT;
+
 typedef void (*_MCFCRT_HeapCallback)(void *__pBlockNew, _MCFCRT_STD size_t __uSizeNew, void *__pBlockOld, const void *__pRetAddrOuter, const void *__pRetAddrInner);
 
 extern _MCFCRT_HeapCallback _MCFCRT_GetHeapCallback(void) _MCFCRT_NOEXCEPT;
 extern _MCFCRT_HeapCallback _MCFCRT_SetHeapCallback(_MCFCRT_HeapCallback __pfnNewCallback) _MCFCRT_NOEXCEPT;
 
+// Bytes are counted in usable sizes of blocks, which include the overhead of the debug heap, if any.
+// Bucket #0 counts allocations of no more than 16 bytes. Bucket #n counts those of (2^(n+3), 2^(n+4)] bytes. The last bucket also counts all larger ones.
+// Counters are updated without synchronization, hence the peak may fall short of the actual value by up to 64KiB per thread.
+#define _MCFCRT_HEAP_STATISTICS_BUCKET_COUNT   32u
+
+typedef struct __MCFCRT_tagHeapStatistics {
+	_MCFCRT_STD size_t __uBytesInUse;
+	_MCFCRT_STD size_t __uPeakBytesInUse;
+	_MCFCRT_STD uint64_t __u64BytesAllocated;
+	_MCFCRT_STD uint64_t __u64BytesFreed;
+	_MCFCRT_STD uint64_t __u64AllocationCount;
+	_MCFCRT_STD uint64_t __u64FreeCount;
+	_MCFCRT_STD uint64_t __u64ReallocInPlaceCount;
+	_MCFCRT_STD uint64_t __u64ReallocCopyCount;
+	_MCFCRT_STD uint64_t __au64AllocationCountBySize[_MCFCRT_HEAP_STATISTICS_BUCKET_COUNT];
+	_MCFCRT_STD size_t __uThreadCount;
+} _MCFCRT_HeapStatistics;
+
+typedef struct __MCFCRT_tagHeapThreadStatistics {
+	_MCFCRT_STD uintptr_t __uThreadId;
+	_MCFCRT_STD uint64_t __u64BytesAllocated;
+	_MCFCRT_STD uint64_t __u64BytesFreed;
+	_MCFCRT_STD uint64_t __u64AllocationCount;
+	_MCFCRT_STD uint64_t __u64FreeCount;
+} _MCFCRT_HeapThreadStatistics;
+
+extern void _MCFCRT_GetHeapStatistics(_MCFCRT_HeapStatistics *__pStatistics) _MCFCRT_NOEXCEPT;
+// This function copies statistics of at most `__uMaxCount` threads into `__pThreads` and returns the number of threads that have allocated memory and
+// have not exited. Figures of threads that have exited are only included in the result of `_MCFCRT_GetHeapStatistics()`.
+extern _MCFCRT_STD size_t _MCFCRT_GetHeapThreadStatistics(_MCFCRT_HeapThreadStatistics *_MCFCRT_RESTRICT __pThreads, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+
 __attribute__((__always_inline__, __malloc__)) static inline void * _MCFCRT_malloc(_MCFCRT_STD size_t  __size) _MCFCRT_NOEXCEPT {
 	return __MCFCRT_HeapAlloc(__size, false,
 		__builtin_return_address(0));
@@ -46,6 +88,32 @@ __attribute__((__always_inline__)) static inline void _MCFCRT_free(void *__ptr)
 		__builtin_return_address(0));
 }
 
+__attribute__((__always_inline__, __malloc__)) static inline void * _MCFCRT_aligned_alloc(_MCFCRT_STD size_t __alignment, _MCFCRT_STD size_t __size) _MCFCRT_NOEXCEPT {
+	return __MCFCRT_HeapAllocAligned(__size, __alignment, false,
+		__builtin_return_address(0));
+}
+__attribute__((__always_inline__)) static inline void _MCFCRT_free_sized(void *__ptr, _MCFCRT_STD size_t __size) _MCFCRT_NOEXCEPT {
+	if(!__ptr){
+		return;
+	}
+	__MCFCRT_HeapFreeSized(__ptr, __size,
+		__builtin_return_address(0));
+}
+__attribute__((__always_inline__)) static inline void _MCFCRT_free_aligned_sized(void *__ptr, _MCFCRT_STD size_t __alignment, _MCFCRT_STD size_t __size) _MCFCRT_NOEXCEPT {
+	(void)__alignment;
+	if(!__ptr){
+		return;
+	}
+	__MCFCRT_HeapFreeSized(__ptr, __size,
+		__builtin_return_address(0));
+}
+__attribute__((__always_inline__)) static inline _MCFCRT_STD size_t _MCFCRT_malloc_usable_size(const void *__ptr) _MCFCRT_NOEXCEPT {
+	if(!__ptr){
+		return 0;
+	}
+	return __MCFCRT_HeapGetUsableSize(__ptr);
+}
+
 _MCFCRT_EXTERN_C_END
 
 #endif
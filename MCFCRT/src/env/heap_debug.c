@@ -11,6 +11,7 @@
 #include "clocks.h"
 #include "../ext/wcpcpy.h"
 #include "../ext/itow.h"
+#include <emmintrin.h>
 
 typedef struct tagBlockHeader {
 	_MCFCRT_AvlNodeHeader avlhBlockIndex;
@@ -18,7 +19,7 @@ typedef struct tagBlockHeader {
 	const void *pRetAddrOuter;
 	const void *pRetAddrInner;
 	uintptr_t uCookie;
-	uintptr_t uReserved;
+	size_t uPadding; // The number of bytes between the underlying storage and this header.
 	unsigned char abySentry[16];
 } BlockHeader;
 
@@ -42,37 +43,90 @@ typedef struct tagBlockTrailer {
 
 static_assert(sizeof(BlockTrailer) % alignof(max_align_t) == 0, "??");
 
-static inline unsigned char LcgGetByte(unsigned long *pulSeed){
-	unsigned long ulSeed = *pulSeed;
-	ulSeed = ulSeed * 1664525u + 1013904223u;
-	*pulSeed = ulSeed;
-	return (unsigned char)(ulSeed >> 24);
+// Sentries are generated and checked 16 bytes at a time. Every 16-byte word is derived from the cookie and its index, so the words of a sentry differ
+// from each other and from those of other blocks.
+static inline __m128i MakeSentrySeed(uintptr_t uCookie){
+	const uint32_t u32Cookie = (uint32_t)((uint64_t)uCookie ^ ((uint64_t)uCookie >> 32));
+	return _mm_set_epi32((int)(u32Cookie * 0x85EBCA6Bu), (int)(u32Cookie ^ 0xC2B2AE35u), (int)(u32Cookie * 0x27D4EB2Fu), (int)(u32Cookie + 0x165667B1u));
 }
+static inline __m128i MakeSentryWord(__m128i xmmSeed, size_t uIndex){
+	const __m128i xmmMultiplier = _mm_set1_epi16((short)0x9E37);
+	__m128i xmmWord = _mm_add_epi32(xmmSeed, _mm_set1_epi32((int)((uint32_t)uIndex * 0x61C88647u)));
+	xmmWord = _mm_mullo_epi16(xmmWord, xmmMultiplier);
+	xmmWord = _mm_xor_si128(xmmWord, _mm_srli_epi32(xmmWord, 13));
+	xmmWord = _mm_mullo_epi16(xmmWord, xmmMultiplier);
+	xmmWord = _mm_xor_si128(xmmWord, _mm_shuffle_epi32(xmmWord, 0x4E));
+	return xmmWord;
+}
+
+static_assert(sizeof(((BlockHeader *)0)->abySentry) % 16 == 0, "??");
+static_assert(sizeof(((BlockTrailer *)0)->abySentry) % 16 == 0, "??");
 
 __attribute__((__noinline__, __noclone__)) static void MakeSentry(unsigned char *pbyData, size_t uSize, uintptr_t uCookie){
-	unsigned long ulSeed = (unsigned long)uCookie;
-	for(size_t uIndex = 0; uIndex < uSize; ++uIndex){
-		pbyData[uIndex] = LcgGetByte(&ulSeed);
+	const __m128i xmmSeed = MakeSentrySeed(uCookie);
+	for(size_t uIndex = 0; uIndex < uSize / 16; ++uIndex){
+		_mm_storeu_si128((__m128i *)pbyData + uIndex, MakeSentryWord(xmmSeed, uIndex));
 	}
 }
 __attribute__((__noinline__, __noclone__)) static bool CheckSentry(uintptr_t uCookie, const unsigned char *pbyData, size_t uSize){
-	unsigned long ulSeed = (unsigned long)uCookie;
-	for(size_t uIndex = 0; uIndex < uSize; ++uIndex){
-		if(pbyData[uIndex] != LcgGetByte(&ulSeed)){
-			return false;
-		}
+	const __m128i xmmSeed = MakeSentrySeed(uCookie);
+	__m128i xmmDiff = _mm_setzero_si128();
+	for(size_t uIndex = 0; uIndex < uSize / 16; ++uIndex){
+		xmmDiff = _mm_or_si128(xmmDiff, _mm_xor_si128(_mm_loadu_si128((const __m128i *)pbyData + uIndex), MakeSentryWord(xmmSeed, uIndex)));
 	}
-	return true;
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(xmmDiff, _mm_setzero_si128())) == 0xFFFF;
+}
+
+// Blocks are distributed among shards according to their addresses, each of which has its own mutex, so threads rarely contend for the same one.
+#define SHARD_COUNT   64u
+
+typedef struct tagShard {
+	alignas(_MCFCRT_CACHE_LINE_SIZE) _MCFCRT_Mutex vMutex;
+	_MCFCRT_AvlRoot avlBlocks;
+} Shard;
+
+static Shard g_aShards[SHARD_COUNT];
+
+static inline Shard *GetShard(const BlockHeader *pHeader){
+	const uint32_t u32Hash = (uint32_t)((uintptr_t)pHeader / alignof(max_align_t)) * 0x9E3779B9u;
+	return g_aShards + (u32Hash >> 26);
 }
 
-static _MCFCRT_Mutex   g_vMutex    = { 0 };
-static _MCFCRT_AvlRoot g_avlBlocks = _MCFCRT_NULLPTR;
+static_assert(SHARD_COUNT == 1u << (32 - 26), "Please update `GetShard()`.");
+
+static const BlockHeader *PopLowestBlockUnlocked(const BlockHeader **ppCursors){
+	// Shards are merged so blocks are reported in ascending order of their addresses, as if there were only one shard.
+	const BlockHeader **ppLowest = _MCFCRT_NULLPTR;
+	for(size_t uIndex = 0; uIndex < SHARD_COUNT; ++uIndex){
+		const BlockHeader **const ppCursor = ppCursors + uIndex;
+		if(!*ppCursor){
+			continue;
+		}
+		if(ppLowest && (*ppLowest < *ppCursor)){
+			continue;
+		}
+		ppLowest = ppCursor;
+	}
+	if(!ppLowest){
+		return _MCFCRT_NULLPTR;
+	}
+	const BlockHeader *const pHeader = *ppLowest;
+	*ppLowest = (BlockHeader *)_MCFCRT_AvlNext((_MCFCRT_AvlNodeHeader *)pHeader);
+	return pHeader;
+}
 
 static void CheckForMemoryLeaksUnlocked(void){
 	wchar_t awcLine[1024];
 	uintptr_t uCount = 0;
-	const BlockHeader *pHeader = (BlockHeader *)_MCFCRT_AvlFront(&g_avlBlocks);
-	while(pHeader){
+	const BlockHeader *apCursors[SHARD_COUNT];
+	for(size_t uIndex = 0; uIndex < SHARD_COUNT; ++uIndex){
+		apCursors[uIndex] = (BlockHeader *)_MCFCRT_AvlFront(&(g_aShards[uIndex].avlBlocks));
+	}
+	for(;;){
+		const BlockHeader *const pHeader = PopLowestBlockUnlocked(apCursors);
+		if(!pHeader){
+			break;
+		}
 		++uCount;
 		if(uCount <= 9999){
 			wchar_t *pwcWrite = awcLine;
@@ -89,7 +143,6 @@ static void CheckForMemoryLeaksUnlocked(void){
 			pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" ***");
 			_MCFCRT_WriteStandardErrorText(awcLine, (size_t)(pwcWrite - awcLine), true);
 		}
-		pHeader = (BlockHeader *)_MCFCRT_AvlNext((_MCFCRT_AvlNodeHeader *)pHeader);
 	}
 	if(uCount > 9999){
 		wchar_t *pwcWrite = awcLine;
@@ -112,15 +165,21 @@ void __MCFCRT_HeapDebugUninit(void){
 	CheckForMemoryLeaksUnlocked();
 }
 
-size_t __MCFCRT_HeapDebugCalculateSizeToAlloc(size_t uSize){
+size_t __MCFCRT_HeapDebugCalculatePadding(size_t uAlignment){
+	return (uAlignment - sizeof(BlockHeader) % uAlignment) % uAlignment;
+}
+size_t __MCFCRT_HeapDebugCalculateSizeToAlloc(size_t uSize, size_t uPadding){
 	size_t uSizeToAlloc;
 	if(__builtin_add_overflow(uSize, sizeof(BlockHeader) + sizeof(BlockTrailer), &uSizeToAlloc)){
 		return SIZE_MAX;
 	}
+	if(__builtin_add_overflow(uSizeToAlloc, uPadding, &uSizeToAlloc)){
+		return SIZE_MAX;
+	}
 	return uSizeToAlloc;
 }
-void __MCFCRT_HeapDebugRegister(void **restrict ppBlock, size_t uSize, void *pStorage, const void *pRetAddrOuter, const void *pRetAddrInner){
-	BlockHeader *const pHeader = pStorage;
+void __MCFCRT_HeapDebugRegister(void **restrict ppBlock, size_t uSize, void *pStorage, size_t uPadding, const void *pRetAddrOuter, const void *pRetAddrInner){
+	BlockHeader *const pHeader = (void *)((char *)pStorage + uPadding);
 	void *const pBlock = (char *)pHeader + sizeof(BlockHeader);
 	BlockTrailer *const pTrailer = (void *)((char *)pHeader + sizeof(BlockHeader) + uSize);
 
@@ -129,21 +188,47 @@ void __MCFCRT_HeapDebugRegister(void **restrict ppBlock, size_t uSize, void *pSt
 	pHeader->pRetAddrOuter = pRetAddrOuter;
 	pHeader->pRetAddrInner = pRetAddrInner;
 	pHeader->uCookie = (uintptr_t)_MCFCRT_GetFastMonoClock();
-	pHeader->uReserved = 0;
+	pHeader->uPadding = uPadding;
 	MakeSentry(pHeader->abySentry, sizeof(pHeader->abySentry), pHeader->uCookie);
 	// Initialize the trailer.
 	MakeSentry(pTrailer->abySentry, sizeof(pTrailer->abySentry), pHeader->uCookie);
 
 	// Register it.
-	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	_MCFCRT_AvlAttach(&g_avlBlocks, (_MCFCRT_AvlNodeHeader *)pStorage, &BlockHeaderComparatorNodes);
-	_MCFCRT_SignalMutex(&g_vMutex);
+	Shard *const pShard = GetShard(pHeader);
+	_MCFCRT_WaitForMutexForever(&(pShard->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	_MCFCRT_AvlAttach(&(pShard->avlBlocks), (_MCFCRT_AvlNodeHeader *)pHeader, &BlockHeaderComparatorNodes);
+	_MCFCRT_SignalMutex(&(pShard->vMutex));
 
 	*ppBlock = pBlock;
 }
-bool __MCFCRT_HeapDebugValidateAndUnregister(size_t *restrict puSize, void **restrict ppStorage, void *pBlock){
-	void *const pStorage = (char *)pBlock - sizeof(BlockHeader);
-	BlockHeader *const pHeader = pStorage;
+bool __MCFCRT_HeapDebugValidate(size_t *restrict puSize, const void *pBlock){
+	const BlockHeader *const pHeader = (const void *)((const char *)pBlock - sizeof(BlockHeader));
+	const size_t uSize = pHeader->uSize;
+	const BlockTrailer *const pTrailer = (const void *)((const char *)pHeader + sizeof(BlockHeader) + uSize);
+
+	// Check the header.
+	if(!CheckSentry(pHeader->uCookie, pHeader->abySentry, sizeof(pHeader->abySentry))){
+		return false;
+	}
+	// Check the trailer.
+	if(!CheckSentry(pHeader->uCookie, pTrailer->abySentry, sizeof(pTrailer->abySentry))){
+		return false;
+	}
+
+	// Search for it in all registered blocks.
+	Shard *const pShard = GetShard(pHeader);
+	_MCFCRT_WaitForMutexForever(&(pShard->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	const BlockHeader *const pHeaderFound = (const BlockHeader *)_MCFCRT_AvlFind(&(pShard->avlBlocks), (intptr_t)pHeader, &BlockHeaderComparatorNodeHeader);
+	_MCFCRT_SignalMutex(&(pShard->vMutex));
+	if(pHeaderFound != pHeader){
+		return false;
+	}
+
+	*puSize = uSize;
+	return true;
+}
+bool __MCFCRT_HeapDebugValidateAndUnregister(size_t *restrict puSize, size_t *restrict puPadding, void **restrict ppStorage, void *pBlock){
+	BlockHeader *const pHeader = (void *)((char *)pBlock - sizeof(BlockHeader));
 	const size_t uSize = pHeader->uSize;
 	BlockTrailer *const pTrailer = (void *)((char *)pHeader + sizeof(BlockHeader) + uSize);
 
@@ -157,37 +242,39 @@ bool __MCFCRT_HeapDebugValidateAndUnregister(size_t *restrict puSize, void **res
 	}
 
 	// Search for it in all registered blocks. Detach it if one is found.
-	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	BlockHeader *const pHeaderFound = (BlockHeader *)_MCFCRT_AvlFind(&g_avlBlocks, (intptr_t)pHeader, &BlockHeaderComparatorNodeHeader);
+	Shard *const pShard = GetShard(pHeader);
+	_MCFCRT_WaitForMutexForever(&(pShard->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	BlockHeader *const pHeaderFound = (BlockHeader *)_MCFCRT_AvlFind(&(pShard->avlBlocks), (intptr_t)pHeader, &BlockHeaderComparatorNodeHeader);
 	if(pHeaderFound != pHeader){
-		_MCFCRT_SignalMutex(&g_vMutex);
+		_MCFCRT_SignalMutex(&(pShard->vMutex));
 		return false;
 	}
-	_MCFCRT_AvlDetach((_MCFCRT_AvlNodeHeader *)pStorage);
-	_MCFCRT_SignalMutex(&g_vMutex);
+	_MCFCRT_AvlDetach((_MCFCRT_AvlNodeHeader *)pHeader);
+	_MCFCRT_SignalMutex(&(pShard->vMutex));
 
 	// Leave the header alone in order to enable the unregistration to be reverted.
 	// Zero out the trailer so the storage can be passed to `HeapReAlloc()` with the `HEAP_ZERO_MEMORY` option without causing confusion.
 	_MCFCRT_inline_mempset_fwd(pTrailer, 0, sizeof(*pTrailer));
 
-	*ppStorage = pStorage;
+	*ppStorage = (char *)pHeader - pHeader->uPadding;
+	*puPadding = pHeader->uPadding;
 	*puSize = uSize;
 	return true;
 }
-void __MCFCRT_HeapDebugUndoUnregister(void *pStorage){
-	BlockHeader *const pHeader = pStorage;
+void __MCFCRT_HeapDebugUndoUnregister(void *pBlock){
+	BlockHeader *const pHeader = (void *)((char *)pBlock - sizeof(BlockHeader));
 	const size_t uSize = pHeader->uSize;
 
 	// Generate a new cookie and update the header sentry.
 	pHeader->uCookie = (uintptr_t)_MCFCRT_GetFastMonoClock();
-	pHeader->uReserved = 0;
 	MakeSentry(pHeader->abySentry, sizeof(pHeader->abySentry), pHeader->uCookie);
 	// Reinitialize the trailer.
 	BlockTrailer *const pTrailer = (void *)((char *)pHeader + sizeof(BlockHeader) + uSize);
 	MakeSentry(pTrailer->abySentry, sizeof(pTrailer->abySentry), pHeader->uCookie);
 
 	// Re-register it.
-	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
-	_MCFCRT_AvlAttach(&g_avlBlocks, (_MCFCRT_AvlNodeHeader *)pStorage, &BlockHeaderComparatorNodes);
-	_MCFCRT_SignalMutex(&g_vMutex);
+	Shard *const pShard = GetShard(pHeader);
+	_MCFCRT_WaitForMutexForever(&(pShard->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	_MCFCRT_AvlAttach(&(pShard->avlBlocks), (_MCFCRT_AvlNodeHeader *)pHeader, &BlockHeaderComparatorNodes);
+	_MCFCRT_SignalMutex(&(pShard->vMutex));
 }
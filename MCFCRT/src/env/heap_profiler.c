@@ -0,0 +1,262 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "heap_profiler.h"
+#include "_profiler_common.h"
+#include "heap.h"
+#include "thread.h"
+#include "inline_mem.h"
+#include "expect.h"
+#include "../ext/random.h"
+#include "../ext/wcpcpy.h"
+#include "../ext/itow.h"
+
+#define SITE_COUNT              __MCFCRT_PROFILER_SITE_COUNT
+#define BUCKET_COUNT            ((size_t)2048)
+#define BUCKET_SIZE             ((size_t)(_MCFCRT_CACHE_LINE_SIZE / sizeof(void *)))
+#define COUNTDOWN_BITS          6
+#define COUNTDOWN_COUNT         ((size_t)1 << COUNTDOWN_BITS)
+
+// A slot in a bucket is being filled if it holds this value.
+#define SAMPLE_BUSY             ((void *)1)
+
+typedef struct tagSite {
+	const void *volatile pRetAddr;
+	volatile size_t uLiveBytes;
+	volatile size_t uLiveBlocks;
+	volatile uint64_t u64TotalBytes;
+	volatile uint64_t u64TotalBlocks;
+} Site;
+
+// The last site collects samples that do not fit in the table.
+static Site g_aSites[SITE_COUNT + 1];
+
+// Sampled blocks are looked up in a hash table of buckets, each of which takes up exactly one cache line, so freeing a block that was not sampled costs
+// a single cache miss at most. A sample is dropped if its bucket is full.
+typedef struct tagSampleBucket {
+	alignas(_MCFCRT_CACHE_LINE_SIZE) void *volatile apBlocks[BUCKET_SIZE];
+} SampleBucket;
+
+typedef struct tagSampleInfo {
+	size_t uSiteIndex;
+	size_t uWeightBytes;
+	size_t uWeightBlocks;
+} SampleInfo;
+
+static SampleBucket g_aSampleBuckets[BUCKET_COUNT];
+static SampleInfo g_aaSampleInfos[BUCKET_COUNT][BUCKET_SIZE];
+static volatile size_t g_uSamplesDropped;
+
+// Threads count bytes down on different cache lines, which they choose according to hashes of their thread IDs.
+// A countdown being shared by two threads is harmless, as the result is only a slight deviation in the sampling rate.
+typedef struct tagCountdown {
+	alignas(_MCFCRT_CACHE_LINE_SIZE) volatile intptr_t nBytesRemaining;
+} Countdown;
+
+static Countdown g_aCountdowns[COUNTDOWN_COUNT];
+
+static volatile bool g_bRunning = false;
+static volatile size_t g_uSamplingInterval = _MCFCRT_HEAP_PROFILER_SUGGESTED_SAMPLING_INTERVAL;
+static volatile _MCFCRT_HeapCallback g_pfnPrevious = _MCFCRT_NULLPTR;
+
+static inline intptr_t GenerateCountdown(size_t uInterval){
+	// The mean of intervals between two samples is `uInterval`. The jitter breaks patterns that would otherwise make some call sites never sampled.
+	size_t uCountdown = uInterval / 2 + _MCFCRT_GetRandom_uint32() % uInterval;
+	if(uCountdown > INTPTR_MAX){
+		uCountdown = INTPTR_MAX;
+	}
+	return (intptr_t)uCountdown;
+}
+
+static inline Countdown *GetCountdown(void){
+	// Windows thread IDs are multiples of four, so they are hashed with a Fibonacci multiplication, whose highest bits depend on all bits of the ID.
+	const uint64_t u64Hash = (uint64_t)_MCFCRT_GetCurrentThreadId() * 0x9E3779B97F4A7C15u;
+	return g_aCountdowns + (size_t)(u64Hash >> (64 - COUNTDOWN_BITS));
+}
+
+static inline bool ShouldSample(size_t *restrict puInterval, size_t uSize){
+	if(uSize == 0){
+		return false;
+	}
+	Countdown *const pCountdown = GetCountdown();
+	const intptr_t nBytesRemaining = __atomic_sub_fetch(&(pCountdown->nBytesRemaining), (intptr_t)((uSize > INTPTR_MAX) ? INTPTR_MAX : uSize), __ATOMIC_RELAXED);
+	if(_MCFCRT_EXPECT(nBytesRemaining > 0)){
+		return false;
+	}
+	const size_t uInterval = __atomic_load_n(&g_uSamplingInterval, __ATOMIC_RELAXED);
+	__atomic_store_n(&(pCountdown->nBytesRemaining), GenerateCountdown(uInterval), __ATOMIC_RELAXED);
+	*puInterval = uInterval;
+	return true;
+}
+
+static void RecordSample(void *pBlock, size_t uSize, size_t uInterval, const void *pRetAddr){
+	// A block is sampled with a probability of about `uSize / uInterval`, hence the weights.
+	const size_t uWeightBytes = (uSize >= uInterval) ? uSize : uInterval;
+	const size_t uWeightBlocks = (uWeightBytes + uSize / 2) / uSize;
+
+	SampleBucket *const pBucket = g_aSampleBuckets + __MCFCRT_ProfilerHashPointer(pBlock) % BUCKET_COUNT;
+	for(size_t uSlot = 0; uSlot < BUCKET_SIZE; ++uSlot){
+		void *pCurrent = __atomic_load_n(&(pBucket->apBlocks[uSlot]), __ATOMIC_RELAXED);
+		if(pCurrent){
+			continue;
+		}
+		if(!__atomic_compare_exchange_n(&(pBucket->apBlocks[uSlot]), &pCurrent, SAMPLE_BUSY, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+			continue;
+		}
+		const size_t uSiteIndex = __MCFCRT_ProfilerRequireSite((void *)g_aSites, sizeof(Site), pRetAddr);
+		Site *const pSite = g_aSites + uSiteIndex;
+		__atomic_add_fetch(&(pSite->uLiveBytes), uWeightBytes, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&(pSite->uLiveBlocks), uWeightBlocks, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&(pSite->u64TotalBytes), uWeightBytes, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&(pSite->u64TotalBlocks), uWeightBlocks, __ATOMIC_RELAXED);
+
+		SampleInfo *const pInfo = g_aaSampleInfos[pBucket - g_aSampleBuckets] + uSlot;
+		pInfo->uSiteIndex = uSiteIndex;
+		pInfo->uWeightBytes = uWeightBytes;
+		pInfo->uWeightBlocks = uWeightBlocks;
+		__atomic_store_n(&(pBucket->apBlocks[uSlot]), pBlock, __ATOMIC_RELEASE);
+		return;
+	}
+	__atomic_add_fetch(&g_uSamplesDropped, 1, __ATOMIC_RELAXED);
+}
+static void ForgetSample(void *pBlock){
+	// The callback is invoked after a block has been freed, so its address might have been reused and sampled again when we get here.
+	// In that case, we remove either record. Since every record is removed exactly once, live figures are still correct in the end.
+	SampleBucket *const pBucket = g_aSampleBuckets + __MCFCRT_ProfilerHashPointer(pBlock) % BUCKET_COUNT;
+	for(size_t uSlot = 0; uSlot < BUCKET_SIZE; ++uSlot){
+		void *pCurrent = __atomic_load_n(&(pBucket->apBlocks[uSlot]), __ATOMIC_ACQUIRE);
+		if(_MCFCRT_EXPECT(pCurrent != pBlock)){
+			continue;
+		}
+		const SampleInfo *const pInfo = g_aaSampleInfos[pBucket - g_aSampleBuckets] + uSlot;
+		const size_t uSiteIndex = pInfo->uSiteIndex;
+		const size_t uWeightBytes = pInfo->uWeightBytes;
+		const size_t uWeightBlocks = pInfo->uWeightBlocks;
+		if(!__atomic_compare_exchange_n(&(pBucket->apBlocks[uSlot]), &pCurrent, _MCFCRT_NULLPTR, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+			continue;
+		}
+		Site *const pSite = g_aSites + uSiteIndex;
+		__atomic_sub_fetch(&(pSite->uLiveBytes), uWeightBytes, __ATOMIC_RELAXED);
+		__atomic_sub_fetch(&(pSite->uLiveBlocks), uWeightBlocks, __ATOMIC_RELAXED);
+		return;
+	}
+}
+
+static void ProfilerCallback(void *pBlockNew, size_t uSizeNew, void *pBlockOld, const void *pRetAddrOuter, const void *pRetAddrInner){
+	if(pBlockOld){
+		ForgetSample(pBlockOld);
+	}
+	size_t uInterval;
+	if(pBlockNew && ShouldSample(&uInterval, uSizeNew)){
+		RecordSample(pBlockNew, uSizeNew, uInterval, pRetAddrOuter);
+	}
+
+	const _MCFCRT_HeapCallback pfnPrevious = __atomic_load_n(&g_pfnPrevious, __ATOMIC_ACQUIRE);
+	if(pfnPrevious){
+		(*pfnPrevious)(pBlockNew, uSizeNew, pBlockOld, pRetAddrOuter, pRetAddrInner);
+	}
+}
+
+bool _MCFCRT_StartHeapProfiler(size_t uSamplingInterval){
+	bool bRunning = false;
+	if(!__atomic_compare_exchange_n(&g_bRunning, &bRunning, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+		return false;
+	}
+	const size_t uInterval = (uSamplingInterval != 0) ? uSamplingInterval : 1;
+
+	// Discard records of the previous run.
+	_MCFCRT_inline_mempset_fwd((void *)g_aSites, 0, sizeof(g_aSites));
+	_MCFCRT_inline_mempset_fwd((void *)g_aSampleBuckets, 0, sizeof(g_aSampleBuckets));
+	__atomic_store_n(&g_uSamplesDropped, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&g_uSamplingInterval, uInterval, __ATOMIC_RELAXED);
+	for(size_t uIndex = 0; uIndex < COUNTDOWN_COUNT; ++uIndex){
+		__atomic_store_n(&(g_aCountdowns[uIndex].nBytesRemaining), GenerateCountdown(uInterval), __ATOMIC_RELAXED);
+	}
+
+	// Set `g_pfnPrevious` before installing our callback, so no call to the previous callback is missed.
+	__atomic_store_n(&g_pfnPrevious, _MCFCRT_GetHeapCallback(), __ATOMIC_RELEASE);
+	const _MCFCRT_HeapCallback pfnPrevious = _MCFCRT_SetHeapCallback(&ProfilerCallback);
+	__atomic_store_n(&g_pfnPrevious, pfnPrevious, __ATOMIC_RELEASE);
+	return true;
+}
+void _MCFCRT_StopHeapProfiler(void){
+	bool bRunning = true;
+	if(!__atomic_compare_exchange_n(&g_bRunning, &bRunning, false, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+		return;
+	}
+	_MCFCRT_SetHeapCallback(__atomic_load_n(&g_pfnPrevious, __ATOMIC_ACQUIRE));
+}
+bool _MCFCRT_IsHeapProfilerRunning(void){
+	return __atomic_load_n(&g_bRunning, __ATOMIC_ACQUIRE);
+}
+
+static bool IsSiteEmpty(const Site *pSite){
+	return __atomic_load_n(&(pSite->u64TotalBlocks), __ATOMIC_RELAXED) == 0;
+}
+static void CopySite(_MCFCRT_HeapProfilerSite *restrict pOutput, const Site *pSite){
+	pOutput->__pRetAddr      = __atomic_load_n(&(pSite->pRetAddr), __ATOMIC_RELAXED);
+	pOutput->__uLiveBytes    = __atomic_load_n(&(pSite->uLiveBytes), __ATOMIC_RELAXED);
+	pOutput->__uLiveBlocks   = __atomic_load_n(&(pSite->uLiveBlocks), __ATOMIC_RELAXED);
+	pOutput->__u64TotalBytes  = __atomic_load_n(&(pSite->u64TotalBytes), __ATOMIC_RELAXED);
+	pOutput->__u64TotalBlocks = __atomic_load_n(&(pSite->u64TotalBlocks), __ATOMIC_RELAXED);
+}
+
+size_t _MCFCRT_GetHeapProfilerSnapshot(_MCFCRT_HeapProfilerSite *restrict pSites, size_t uMaxCount){
+	size_t uCount = 0;
+	for(size_t uIndex = 0; uIndex <= SITE_COUNT; ++uIndex){
+		const Site *const pSite = g_aSites + uIndex;
+		if(IsSiteEmpty(pSite)){
+			continue;
+		}
+		if(uCount < uMaxCount){
+			CopySite(pSites + uCount, pSite);
+		}
+		++uCount;
+	}
+	return uCount;
+}
+
+static bool SiteComesBefore(const void *pSite, const void *pOther){
+	const _MCFCRT_HeapProfilerSite *const pHeapSite = pSite;
+	const _MCFCRT_HeapProfilerSite *const pHeapOther = pOther;
+	if(pHeapSite->__uLiveBytes != pHeapOther->__uLiveBytes){
+		return pHeapSite->__uLiveBytes > pHeapOther->__uLiveBytes;
+	}
+	return pHeapSite->__u64TotalBytes > pHeapOther->__u64TotalBytes;
+}
+static size_t GetSnapshot(void *pSites, size_t uMaxCount){
+	return _MCFCRT_GetHeapProfilerSnapshot(pSites, uMaxCount);
+}
+static wchar_t *PrintHeader(wchar_t *pwcWrite, size_t uCount){
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"*** Heap profile: ");
+	pwcWrite = _MCFCRT_itow_u(pwcWrite, uCount);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" call site(s), sampling interval = ");
+	pwcWrite = _MCFCRT_itow_u(pwcWrite, __atomic_load_n(&g_uSamplingInterval, __ATOMIC_RELAXED));
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" bytes, ");
+	pwcWrite = _MCFCRT_itow_u(pwcWrite, __atomic_load_n(&g_uSamplesDropped, __ATOMIC_RELAXED));
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" sample(s) dropped ***");
+	return pwcWrite;
+}
+static wchar_t *PrintSite(wchar_t *pwcWrite, const void *pSite){
+	const _MCFCRT_HeapProfilerSite *const pHeapSite = pSite;
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" : live = ");
+	pwcWrite = _MCFCRT_itow_u(pwcWrite, pHeapSite->__uLiveBytes);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" bytes in ");
+	pwcWrite = _MCFCRT_itow_u(pwcWrite, pHeapSite->__uLiveBlocks);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" block(s), total = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pHeapSite->__u64TotalBytes);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" bytes in ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pHeapSite->__u64TotalBlocks);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" block(s)");
+	return pwcWrite;
+}
+
+static const __MCFCRT_ProfilerReport kReport = { sizeof(_MCFCRT_HeapProfilerSite), &GetSnapshot, &SiteComesBefore, &PrintHeader, &PrintSite };
+
+bool _MCFCRT_DumpHeapProfilerToStandardError(void){
+	return __MCFCRT_ProfilerDumpToStandardError(&kReport);
+}
+bool _MCFCRT_DumpHeapProfilerToFile(const wchar_t *pwszPath){
+	return __MCFCRT_ProfilerDumpToFile(&kReport, pwszPath);
+}
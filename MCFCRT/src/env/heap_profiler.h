@@ -0,0 +1,43 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_HEAP_PROFILER_H_
+#define __MCFCRT_ENV_HEAP_PROFILER_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// The heap profiler samples roughly one allocation out of every `__uSamplingInterval` bytes and attributes it to the return address of its caller.
+// It is built on `_MCFCRT_SetHeapCallback()`. The callback that was installed before the profiler is started gets called by the profiler thereafter.
+// Do not call `_MCFCRT_SetHeapCallback()` while the profiler is running, otherwise the profiler will not be able to restore it when it is stopped.
+// Figures are estimates that have been scaled by the sampling probability. Apart from the dump functions, nothing here takes a lock.
+
+#define _MCFCRT_HEAP_PROFILER_SUGGESTED_SAMPLING_INTERVAL   0x80000u
+
+typedef struct __MCFCRT_tagHeapProfilerSite {
+	const void *__pRetAddr;
+	_MCFCRT_STD size_t __uLiveBytes;
+	_MCFCRT_STD size_t __uLiveBlocks;
+	_MCFCRT_STD uint64_t __u64TotalBytes;
+	_MCFCRT_STD uint64_t __u64TotalBlocks;
+} _MCFCRT_HeapProfilerSite;
+
+// `_MCFCRT_StartHeapProfiler()` returns `false` if the profiler is running already, in which case the sampling interval is unchanged.
+extern bool _MCFCRT_StartHeapProfiler(_MCFCRT_STD size_t __uSamplingInterval) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_StopHeapProfiler(void) _MCFCRT_NOEXCEPT;
+extern bool _MCFCRT_IsHeapProfilerRunning(void) _MCFCRT_NOEXCEPT;
+
+// This function copies at most `__uMaxCount` call sites into `__pSites` and returns the number of call sites that have been recorded in total.
+// Records are kept after the profiler is stopped and are discarded when it is started again.
+extern _MCFCRT_STD size_t _MCFCRT_GetHeapProfilerSnapshot(_MCFCRT_HeapProfilerSite *_MCFCRT_RESTRICT __pSites, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+
+// These functions write a human-readable report of all call sites, sorted by the number of live bytes in descending order.
+// `_MCFCRT_DumpHeapProfilerToFile()` truncates the file if it exists. It returns `false` and sets the per-thread error code in case of failure.
+extern bool _MCFCRT_DumpHeapProfilerToStandardError(void) _MCFCRT_NOEXCEPT;
+extern bool _MCFCRT_DumpHeapProfilerToFile(const wchar_t *__pwszPath) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
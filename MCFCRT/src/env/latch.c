@@ -0,0 +1,37 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_LATCH_INLINE_OR_EXTERN     extern inline
+#include "latch.h"
+#include "wait_on_address.h"
+#include "xassert.h"
+
+__attribute__((__always_inline__)) static inline bool ReallyWaitForLatch(_MCFCRT_Latch *pLatch, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	for(;;){
+		const uintptr_t uCount = __atomic_load_n(&(pLatch->__uCount), __ATOMIC_ACQUIRE);
+		if(uCount == 0){
+			return true;
+		}
+		// Only the last count-down wakes waiters up. If the count has been decremented but is not zero, we are not woken up and will keep sleeping.
+		if(bMayTimeOut){
+			if(!_MCFCRT_WaitOnAddress(&(pLatch->__uCount), &uCount, sizeof(uCount), u64UntilFastMonoClock)){
+				return _MCFCRT_IsLatchReady(pLatch);
+			}
+		} else {
+			_MCFCRT_WaitOnAddressForever(&(pLatch->__uCount), &uCount, sizeof(uCount));
+		}
+	}
+}
+
+bool __MCFCRT_ReallyWaitForLatch(_MCFCRT_Latch *pLatch, uint64_t u64UntilFastMonoClock){
+	const bool bReady = ReallyWaitForLatch(pLatch, true, u64UntilFastMonoClock);
+	return bReady;
+}
+void __MCFCRT_ReallyWaitForLatchForever(_MCFCRT_Latch *pLatch){
+	const bool bReady = ReallyWaitForLatch(pLatch, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bReady);
+}
+void __MCFCRT_ReallyWakeLatchWaiters(_MCFCRT_Latch *pLatch){
+	_MCFCRT_WakeAllByAddress(&(pLatch->__uCount));
+}
@@ -0,0 +1,60 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_LATCH_H_
+#define __MCFCRT_ENV_LATCH_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_LATCH_INLINE_OR_EXTERN
+#  define __MCFCRT_LATCH_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// A latch is a one-shot counter. Threads waiting for it are woken up when it has been counted down to zero. It cannot be reset.
+
+typedef struct __MCFCRT_tagLatch {
+	_MCFCRT_STD uintptr_t __uCount;
+} _MCFCRT_Latch;
+
+__MCFCRT_LATCH_INLINE_OR_EXTERN void _MCFCRT_InitializeLatch(_MCFCRT_Latch *__pLatch, _MCFCRT_STD size_t __uInitCount) _MCFCRT_NOEXCEPT {
+	__atomic_store_n(&(__pLatch->__uCount), __uInitCount, __ATOMIC_RELEASE);
+}
+
+extern bool __MCFCRT_ReallyWaitForLatch(_MCFCRT_Latch *__pLatch, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForLatchForever(_MCFCRT_Latch *__pLatch) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWakeLatchWaiters(_MCFCRT_Latch *__pLatch) _MCFCRT_NOEXCEPT;
+
+__MCFCRT_LATCH_INLINE_OR_EXTERN bool _MCFCRT_IsLatchReady(const _MCFCRT_Latch *__pLatch) _MCFCRT_NOEXCEPT {
+	return __atomic_load_n(&(__pLatch->__uCount), __ATOMIC_ACQUIRE) == 0;
+}
+__MCFCRT_LATCH_INLINE_OR_EXTERN bool _MCFCRT_WaitForLatch(_MCFCRT_Latch *__pLatch, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	if(__builtin_expect(_MCFCRT_IsLatchReady(__pLatch), true)){
+		return true;
+	}
+	if(__u64UntilFastMonoClock == 0){
+		return false;
+	}
+	return __MCFCRT_ReallyWaitForLatch(__pLatch, __u64UntilFastMonoClock);
+}
+__MCFCRT_LATCH_INLINE_OR_EXTERN void _MCFCRT_WaitForLatchForever(_MCFCRT_Latch *__pLatch) _MCFCRT_NOEXCEPT {
+	if(__builtin_expect(_MCFCRT_IsLatchReady(__pLatch), true)){
+		return;
+	}
+	__MCFCRT_ReallyWaitForLatchForever(__pLatch);
+}
+// `__uCount` shall not be greater than the current count. `true` is returned if the latch has been counted down to zero by this call.
+__MCFCRT_LATCH_INLINE_OR_EXTERN bool _MCFCRT_CountDownLatch(_MCFCRT_Latch *__pLatch, _MCFCRT_STD size_t __uCount) _MCFCRT_NOEXCEPT {
+	const _MCFCRT_STD uintptr_t __uOld = __atomic_fetch_sub(&(__pLatch->__uCount), __uCount, __ATOMIC_ACQ_REL);
+	if(__builtin_expect(__uOld != __uCount, true)){
+		return false;
+	}
+	__MCFCRT_ReallyWakeLatchWaiters(__pLatch);
+	return true;
+}
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -4,15 +4,9 @@
 
 #define __MCFCRT_MUTEX_INLINE_OR_EXTERN     extern inline
 #include "mutex.h"
-#include "_nt_timeout.h"
+#include "_park.h"
 #include "xassert.h"
 #include "expect.h"
-#include <ntdef.h>
-
-__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtWaitForKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtReleaseKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-
-__attribute__((__dllimport__, __stdcall__, __const__)) extern BOOLEAN RtlDllShutdownInProgress(void);
 
 #ifndef __BYTE_ORDER__
 #  error Byte order is unknown.
@@ -43,7 +37,7 @@ __attribute__((__dllimport__, __stdcall__, __const__)) extern BOOLEAN RtlDllShut
 #define MIN_SPIN_COUNT          ((uintptr_t)16)
 #define MAX_SPIN_MULTIPLIER     ((uintptr_t)32)
 
-__attribute__((__always_inline__)) static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMaxSpinCountInitial, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+__attribute__((__always_inline__)) static inline bool ReallyWaitForMutex(volatile uintptr_t *puControl, size_t uMaxSpinCountInitial, bool bMayTimeOut, uint64_t u64UntilFastMonoClock, size_t *puKeyedEventWaits){
 	for(;;){
 		size_t uMaxSpinCount, uSpinMultiplier;
 		bool bTaken, bSpinnable;
@@ -140,11 +134,9 @@ __attribute__((__always_inline__)) static inline bool ReallyWaitForMutex(volatil
 			}
 		}
 		if(bMayTimeOut){
-			LARGE_INTEGER liTimeout;
-			__MCFCRT_InitializeNtTimeout(&liTimeout, u64UntilFastMonoClock);
-			NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-			while(_MCFCRT_EXPECT(lStatus == STATUS_TIMEOUT)){
+			++*puKeyedEventWaits;
+			bool bUnparked = __MCFCRT_ParkThread((void *)puControl, u64UntilFastMonoClock);
+			while(_MCFCRT_EXPECT(!bUnparked)){
 				bool bDecremented;
 				{
 					uintptr_t uOld, uNew;
@@ -161,14 +153,11 @@ __attribute__((__always_inline__)) static inline bool ReallyWaitForMutex(volatil
 				if(bDecremented){
 					return false;
 				}
-				liTimeout.QuadPart = 0;
-				lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-				_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+				bUnparked = __MCFCRT_ParkThread((void *)puControl, 0);
 			}
 		} else {
-			NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-			_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+			++*puKeyedEventWaits;
+			__MCFCRT_ParkThreadForever((void *)puControl);
 		}
 	}
 }
@@ -183,21 +172,60 @@ __attribute__((__always_inline__)) static inline void ReallySignalMutex(volatile
 			uNew = (uOld & ~MASK_LOCKED) - bSignalOne * THREADS_TRAPPED_ONE;
 		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
 	}
-	// If `RtlDllShutdownInProgress()` is `true`, other threads will have been terminated.
-	// Calling `NtReleaseKeyedEvent()` when no thread is waiting results in deadlocks. Don't do that.
-	if(_MCFCRT_EXPECT_NOT(bSignalOne && !RtlDllShutdownInProgress())){
-		NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-		_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
-		_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+	// If `__MCFCRT_IsShutdownInProgress()` is `true`, other threads will have been terminated.
+	// Calling `__MCFCRT_UnparkThread()` when no thread is waiting results in deadlocks. Don't do that.
+	if(_MCFCRT_EXPECT_NOT(bSignalOne && !__MCFCRT_IsShutdownInProgress())){
+		__MCFCRT_UnparkThread((void *)puControl);
 	}
 }
 
+#ifdef _WIN32
+
+#include "mutex_profiler.h"
+
+// The profiled path is kept out of line, so the number of keyed event waits is optimized away when the profiler is not running.
+__attribute__((__noinline__)) static bool ProfiledWaitForMutex(_MCFCRT_Mutex *pMutex, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	size_t uKeyedEventWaits = 0;
+	const uint64_t u64Begin = __MCFCRT_MutexProfilerBeginWait();
+	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, bMayTimeOut, u64UntilFastMonoClock, &uKeyedEventWaits);
+	__MCFCRT_MutexProfilerEndWait(pMutex, u64Begin, bLocked, uKeyedEventWaits);
+	return bLocked;
+}
+
+static inline bool IsProfilerRunning(void){
+	return _MCFCRT_IsMutexProfilerRunning();
+}
+
+#else
+
+// The mutex profiler is not available on other platforms.
+static inline bool ProfiledWaitForMutex(_MCFCRT_Mutex *pMutex, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	size_t uKeyedEventWaits = 0;
+	return ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, bMayTimeOut, u64UntilFastMonoClock, &uKeyedEventWaits);
+}
+
+static inline bool IsProfilerRunning(void){
+	return false;
+}
+
+#endif
+
 bool __MCFCRT_ReallyWaitForMutex(_MCFCRT_Mutex *pMutex, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
-	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, true, u64UntilFastMonoClock);
+	if(_MCFCRT_EXPECT_NOT(IsProfilerRunning())){
+		return ProfiledWaitForMutex(pMutex, uMaxSpinCount, true, u64UntilFastMonoClock);
+	}
+	size_t uKeyedEventWaits = 0;
+	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, true, u64UntilFastMonoClock, &uKeyedEventWaits);
 	return bLocked;
 }
 void __MCFCRT_ReallyWaitForMutexForever(_MCFCRT_Mutex *pMutex, size_t uMaxSpinCount){
-	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, false, UINT64_MAX);
+	if(_MCFCRT_EXPECT_NOT(IsProfilerRunning())){
+		const bool bLocked = ProfiledWaitForMutex(pMutex, uMaxSpinCount, false, UINT64_MAX);
+		_MCFCRT_ASSERT(bLocked);
+		return;
+	}
+	size_t uKeyedEventWaits = 0;
+	const bool bLocked = ReallyWaitForMutex(&(pMutex->__u), uMaxSpinCount, false, UINT64_MAX, &uKeyedEventWaits);
 	_MCFCRT_ASSERT(bLocked);
 }
 void __MCFCRT_ReallySignalMutex(_MCFCRT_Mutex *pMutex){
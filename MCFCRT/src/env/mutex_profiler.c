@@ -0,0 +1,172 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "mutex_profiler.h"
+#include "_profiler_common.h"
+#include "mcfwin.h"
+#include "../ext/wcpcpy.h"
+#include "../ext/itow.h"
+
+#define SITE_COUNT              __MCFCRT_PROFILER_SITE_COUNT
+
+typedef struct tagSite {
+	const void *volatile pMutex;
+	volatile uint64_t u64Acquisitions;
+	volatile uint64_t u64SpinAcquisitions;
+	volatile uint64_t u64WaitAcquisitions;
+	volatile uint64_t u64KeyedEventWaits;
+	volatile uint64_t u64Timeouts;
+	volatile uint64_t u64TotalWaitTicks;
+	volatile uint64_t u64MaxWaitTicks;
+} Site;
+
+// The last site collects mutexes that do not fit in the table.
+static Site g_aSites[SITE_COUNT + 1];
+
+static volatile bool g_bRunning = false;
+
+static inline uint64_t GetTicks(void){
+	// Do not use `_MCFCRT_GetHiResMonoClock()`, which initializes itself with a once flag that might be waited for here.
+	LARGE_INTEGER liCounter;
+	QueryPerformanceCounter(&liCounter);
+	return (uint64_t)liCounter.QuadPart;
+}
+static uint64_t TicksToNanoseconds(uint64_t u64Ticks){
+	LARGE_INTEGER liFrequency;
+	QueryPerformanceFrequency(&liFrequency);
+	const uint64_t u64Frequency = (uint64_t)liFrequency.QuadPart;
+	return u64Ticks / u64Frequency * 1000000000 + u64Ticks % u64Frequency * 1000000000 / u64Frequency;
+}
+
+static inline void UpdateMaximum(volatile uint64_t *pu64Maximum, uint64_t u64Value){
+	uint64_t u64Old = __atomic_load_n(pu64Maximum, __ATOMIC_RELAXED);
+	while(u64Old < u64Value){
+		if(__atomic_compare_exchange_n(pu64Maximum, &u64Old, u64Value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+			break;
+		}
+	}
+}
+
+uint64_t __MCFCRT_MutexProfilerBeginWait(void){
+	return GetTicks();
+}
+void __MCFCRT_MutexProfilerEndWait(const void *pMutex, uint64_t u64Begin, bool bLocked, size_t uKeyedEventWaits){
+	const uint64_t u64Ticks = GetTicks() - u64Begin;
+
+	Site *const pSite = g_aSites + __MCFCRT_ProfilerRequireSite((void *)g_aSites, sizeof(Site), pMutex);
+	if(bLocked){
+		__atomic_add_fetch(&(pSite->u64Acquisitions), 1, __ATOMIC_RELAXED);
+		if(uKeyedEventWaits == 0){
+			__atomic_add_fetch(&(pSite->u64SpinAcquisitions), 1, __ATOMIC_RELAXED);
+		} else {
+			__atomic_add_fetch(&(pSite->u64WaitAcquisitions), 1, __ATOMIC_RELAXED);
+		}
+	} else {
+		__atomic_add_fetch(&(pSite->u64Timeouts), 1, __ATOMIC_RELAXED);
+	}
+	__atomic_add_fetch(&(pSite->u64KeyedEventWaits), uKeyedEventWaits, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(pSite->u64TotalWaitTicks), u64Ticks, __ATOMIC_RELAXED);
+	UpdateMaximum(&(pSite->u64MaxWaitTicks), u64Ticks);
+}
+
+bool _MCFCRT_StartMutexProfiler(void){
+	bool bRunning = false;
+	if(!__atomic_compare_exchange_n(&g_bRunning, &bRunning, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+		return false;
+	}
+	// Discard records of the previous run. Threads that are in the slow path right now may still add their figures to the new run.
+	for(size_t uIndex = 0; uIndex <= SITE_COUNT; ++uIndex){
+		Site *const pSite = g_aSites + uIndex;
+		__atomic_store_n(&(pSite->pMutex), _MCFCRT_NULLPTR, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pSite->u64Acquisitions), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pSite->u64SpinAcquisitions), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pSite->u64WaitAcquisitions), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pSite->u64KeyedEventWaits), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pSite->u64Timeouts), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pSite->u64TotalWaitTicks), 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&(pSite->u64MaxWaitTicks), 0, __ATOMIC_RELAXED);
+	}
+	return true;
+}
+void _MCFCRT_StopMutexProfiler(void){
+	__atomic_store_n(&g_bRunning, false, __ATOMIC_RELEASE);
+}
+bool _MCFCRT_IsMutexProfilerRunning(void){
+	return __atomic_load_n(&g_bRunning, __ATOMIC_RELAXED);
+}
+
+static bool IsSiteEmpty(const Site *pSite){
+	return (__atomic_load_n(&(pSite->u64Acquisitions), __ATOMIC_RELAXED) == 0) && (__atomic_load_n(&(pSite->u64Timeouts), __ATOMIC_RELAXED) == 0);
+}
+static void CopySite(_MCFCRT_MutexProfilerSite *restrict pOutput, const Site *pSite){
+	pOutput->__pMutex              = __atomic_load_n(&(pSite->pMutex), __ATOMIC_RELAXED);
+	pOutput->__u64Acquisitions     = __atomic_load_n(&(pSite->u64Acquisitions), __ATOMIC_RELAXED);
+	pOutput->__u64SpinAcquisitions = __atomic_load_n(&(pSite->u64SpinAcquisitions), __ATOMIC_RELAXED);
+	pOutput->__u64WaitAcquisitions = __atomic_load_n(&(pSite->u64WaitAcquisitions), __ATOMIC_RELAXED);
+	pOutput->__u64KeyedEventWaits  = __atomic_load_n(&(pSite->u64KeyedEventWaits), __ATOMIC_RELAXED);
+	pOutput->__u64Timeouts         = __atomic_load_n(&(pSite->u64Timeouts), __ATOMIC_RELAXED);
+	pOutput->__u64TotalWaitTime    = TicksToNanoseconds(__atomic_load_n(&(pSite->u64TotalWaitTicks), __ATOMIC_RELAXED));
+	pOutput->__u64MaxWaitTime      = TicksToNanoseconds(__atomic_load_n(&(pSite->u64MaxWaitTicks), __ATOMIC_RELAXED));
+}
+
+size_t _MCFCRT_GetMutexProfilerSnapshot(_MCFCRT_MutexProfilerSite *restrict pSites, size_t uMaxCount){
+	size_t uCount = 0;
+	for(size_t uIndex = 0; uIndex <= SITE_COUNT; ++uIndex){
+		const Site *const pSite = g_aSites + uIndex;
+		if(IsSiteEmpty(pSite)){
+			continue;
+		}
+		if(uCount < uMaxCount){
+			CopySite(pSites + uCount, pSite);
+		}
+		++uCount;
+	}
+	return uCount;
+}
+
+static bool SiteComesBefore(const void *pSite, const void *pOther){
+	const _MCFCRT_MutexProfilerSite *const pMutexSite = pSite;
+	const _MCFCRT_MutexProfilerSite *const pMutexOther = pOther;
+	if(pMutexSite->__u64TotalWaitTime != pMutexOther->__u64TotalWaitTime){
+		return pMutexSite->__u64TotalWaitTime > pMutexOther->__u64TotalWaitTime;
+	}
+	return pMutexSite->__u64MaxWaitTime > pMutexOther->__u64MaxWaitTime;
+}
+static size_t GetSnapshot(void *pSites, size_t uMaxCount){
+	return _MCFCRT_GetMutexProfilerSnapshot(pSites, uMaxCount);
+}
+static wchar_t *PrintHeader(wchar_t *pwcWrite, size_t uCount){
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"*** Mutex profile: ");
+	pwcWrite = _MCFCRT_itow_u(pwcWrite, uCount);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" contended mutex(es) ***");
+	return pwcWrite;
+}
+static wchar_t *PrintSite(wchar_t *pwcWrite, const void *pSite){
+	const _MCFCRT_MutexProfilerSite *const pMutexSite = pSite;
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" : acquired = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pMutexSite->__u64Acquisitions);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" (spun = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pMutexSite->__u64SpinAcquisitions);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", waited = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pMutexSite->__u64WaitAcquisitions);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L"), keyed event waits = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pMutexSite->__u64KeyedEventWaits);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", timed out = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pMutexSite->__u64Timeouts);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L", wait time total = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pMutexSite->__u64TotalWaitTime / 1000);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" us, max = ");
+	pwcWrite = __MCFCRT_ProfilerPrintUint64(pwcWrite, pMutexSite->__u64MaxWaitTime / 1000);
+	pwcWrite = _MCFCRT_wcpcpy(pwcWrite, L" us");
+	return pwcWrite;
+}
+
+static const __MCFCRT_ProfilerReport kReport = { sizeof(_MCFCRT_MutexProfilerSite), &GetSnapshot, &SiteComesBefore, &PrintHeader, &PrintSite };
+
+bool _MCFCRT_DumpMutexProfilerToStandardError(void){
+	return __MCFCRT_ProfilerDumpToStandardError(&kReport);
+}
+bool _MCFCRT_DumpMutexProfilerToFile(const wchar_t *pwszPath){
+	return __MCFCRT_ProfilerDumpToFile(&kReport, pwszPath);
+}
@@ -0,0 +1,50 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_MUTEX_PROFILER_H_
+#define __MCFCRT_ENV_MUTEX_PROFILER_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// The mutex profiler records contention on `_MCFCRT_Mutex` objects, keyed by their addresses.
+// Only acquisitions that take the slow path are recorded; those that succeed on the inline fast path are not contended and are not counted, so the
+// fast path is left untouched. When the profiler is not running, the slow path costs an additional function call that checks a flag.
+// A mutex is said to be acquired by spinning if it has been acquired without waiting on the keyed event, and by waiting otherwise.
+// Wait time is measured from the beginning of the slow path to the end of it, in nanoseconds. Timed-out attempts count towards wait time as well.
+// If a mutex is destroyed and another one is created at the same address, records of both are merged. Nothing here takes a lock.
+
+typedef struct __MCFCRT_tagMutexProfilerSite {
+	const void *__pMutex;
+	_MCFCRT_STD uint64_t __u64Acquisitions;
+	_MCFCRT_STD uint64_t __u64SpinAcquisitions;
+	_MCFCRT_STD uint64_t __u64WaitAcquisitions;
+	_MCFCRT_STD uint64_t __u64KeyedEventWaits;
+	_MCFCRT_STD uint64_t __u64Timeouts;
+	_MCFCRT_STD uint64_t __u64TotalWaitTime;
+	_MCFCRT_STD uint64_t __u64MaxWaitTime;
+} _MCFCRT_MutexProfilerSite;
+
+// `_MCFCRT_StartMutexProfiler()` returns `false` if the profiler is running already.
+extern bool _MCFCRT_StartMutexProfiler(void) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_StopMutexProfiler(void) _MCFCRT_NOEXCEPT;
+extern bool _MCFCRT_IsMutexProfilerRunning(void) _MCFCRT_NOEXCEPT;
+
+// These functions are called by the slow path of `_MCFCRT_Mutex` and shall not be called otherwise.
+extern _MCFCRT_STD uint64_t __MCFCRT_MutexProfilerBeginWait(void) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_MutexProfilerEndWait(const void *__pMutex, _MCFCRT_STD uint64_t __u64Begin, bool __bLocked, _MCFCRT_STD size_t __uKeyedEventWaits) _MCFCRT_NOEXCEPT;
+
+// This function copies at most `__uMaxCount` mutexes into `__pSites` and returns the number of mutexes that have been recorded in total.
+// Records are kept after the profiler is stopped and are discarded when it is started again.
+extern _MCFCRT_STD size_t _MCFCRT_GetMutexProfilerSnapshot(_MCFCRT_MutexProfilerSite *_MCFCRT_RESTRICT __pSites, _MCFCRT_STD size_t __uMaxCount) _MCFCRT_NOEXCEPT;
+
+// These functions write a human-readable report of all mutexes, sorted by total wait time in descending order.
+// `_MCFCRT_DumpMutexProfilerToFile()` truncates the file if it exists. It returns `false` and sets the per-thread error code in case of failure.
+extern bool _MCFCRT_DumpMutexProfilerToStandardError(void) _MCFCRT_NOEXCEPT;
+extern bool _MCFCRT_DumpMutexProfilerToFile(const wchar_t *__pwszPath) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -4,15 +4,9 @@
 
 #define __MCFCRT_ONCE_FLAG_INLINE_OR_EXTERN     extern inline
 #include "once_flag.h"
-#include "_nt_timeout.h"
+#include "_park.h"
 #include "xassert.h"
 #include "expect.h"
-#include <ntdef.h>
-
-__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtWaitForKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-__attribute__((__dllimport__, __stdcall__)) extern NTSTATUS NtReleaseKeyedEvent(HANDLE hKeyedEvent, void *pKey, BOOLEAN bAlertable, const LARGE_INTEGER *pliTimeout);
-
-__attribute__((__dllimport__, __stdcall__, __const__)) extern BOOLEAN RtlDllShutdownInProgress(void);
 
 #ifndef __BYTE_ORDER__
 #  error Byte order is unknown.
@@ -59,11 +53,8 @@ __attribute__((__always_inline__)) static inline _MCFCRT_OnceResult ReallyWaitFo
 			return _MCFCRT_kOnceResultInitial;
 		}
 		if(bMayTimeOut){
-			LARGE_INTEGER liTimeout;
-			__MCFCRT_InitializeNtTimeout(&liTimeout, u64UntilFastMonoClock);
-			NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-			while(_MCFCRT_EXPECT(lStatus == STATUS_TIMEOUT)){
+			bool bUnparked = __MCFCRT_ParkThread((void *)puControl, u64UntilFastMonoClock);
+			while(_MCFCRT_EXPECT(!bUnparked)){
 				bool bDecremented;
 				{
 					uintptr_t uOld, uNew;
@@ -80,14 +71,10 @@ __attribute__((__always_inline__)) static inline _MCFCRT_OnceResult ReallyWaitFo
 				if(bDecremented){
 					return _MCFCRT_kOnceResultTimedOut;
 				}
-				liTimeout.QuadPart = 0;
-				lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, &liTimeout);
-				_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
+				bUnparked = __MCFCRT_ParkThread((void *)puControl, 0);
 			}
 		} else {
-			NTSTATUS lStatus = NtWaitForKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtWaitForKeyedEvent() 失败。");
-			_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+			__MCFCRT_ParkThreadForever((void *)puControl);
 		}
 	}
 }
@@ -105,13 +92,11 @@ __attribute__((__always_inline__)) static inline void ReallySignalOnceFlag(volat
 			uNew = (uOld & ~(MASK_LOCKED | MASK_FINISHED)) + bFinished * MASK_FINISHED - uCountToSignal * THREADS_TRAPPED_ONE;
 		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(puControl, &uOld, uNew, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
 	}
-	// If `RtlDllShutdownInProgress()` is `true`, other threads will have been terminated.
-	// Calling `NtReleaseKeyedEvent()` when no thread is waiting results in deadlocks. Don't do that.
-	if(_MCFCRT_EXPECT_NOT((uCountToSignal > 0) && !RtlDllShutdownInProgress())){
+	// If `__MCFCRT_IsShutdownInProgress()` is `true`, other threads will have been terminated.
+	// Calling `__MCFCRT_UnparkThread()` when no thread is waiting results in deadlocks. Don't do that.
+	if(_MCFCRT_EXPECT_NOT((uCountToSignal > 0) && !__MCFCRT_IsShutdownInProgress())){
 		for(size_t uIndex = 0; uIndex < uCountToSignal; ++uIndex){
-			NTSTATUS lStatus = NtReleaseKeyedEvent(_MCFCRT_NULLPTR, (void *)puControl, false, _MCFCRT_NULLPTR);
-			_MCFCRT_ASSERT_MSG(NT_SUCCESS(lStatus), L"NtReleaseKeyedEvent() 失败。");
-			_MCFCRT_ASSERT(lStatus != STATUS_TIMEOUT);
+			__MCFCRT_UnparkThread((void *)puControl);
 		}
 	}
 }
@@ -0,0 +1,272 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_RWLOCK_INLINE_OR_EXTERN     extern inline
+#include "rwlock.h"
+#include "_park.h"
+#include "xassert.h"
+#include "expect.h"
+
+#define MASK_WRITER_ACTIVE      __MCFCRT_RWLOCK_MASK_WRITER_ACTIVE
+#define MASK_UPGRADE_PENDING    __MCFCRT_RWLOCK_MASK_UPGRADE_PENDING
+#define MASK_UPGRADER_PARKED    __MCFCRT_RWLOCK_MASK_UPGRADER_PARKED
+#define MASK_READERS_ACTIVE     __MCFCRT_RWLOCK_MASK_READERS_ACTIVE
+#define MASK_READERS_WAITING    __MCFCRT_RWLOCK_MASK_READERS_WAITING
+#define MASK_WRITERS_WAITING    __MCFCRT_RWLOCK_MASK_WRITERS_WAITING
+
+#define READERS_ACTIVE_ONE      ((uint64_t)(MASK_READERS_ACTIVE & -MASK_READERS_ACTIVE))
+#define READERS_ACTIVE_MAX      ((uint64_t)(MASK_READERS_ACTIVE / READERS_ACTIVE_ONE))
+
+#define READERS_WAITING_ONE     ((uint64_t)(MASK_READERS_WAITING & -MASK_READERS_WAITING))
+#define READERS_WAITING_MAX     ((uint64_t)(MASK_READERS_WAITING / READERS_WAITING_ONE))
+
+#define WRITERS_WAITING_ONE     ((uint64_t)(MASK_WRITERS_WAITING & -MASK_WRITERS_WAITING))
+#define WRITERS_WAITING_MAX     ((uint64_t)(MASK_WRITERS_WAITING / WRITERS_WAITING_ONE))
+
+// Readers are blocked if any of these bits are set.
+#define MASK_BLOCKING_READERS   ((uint64_t)(MASK_WRITER_ACTIVE | MASK_UPGRADE_PENDING | MASK_WRITERS_WAITING))
+// Writers are blocked if any of these bits are set. If an upgrade is pending, there is at least one reader.
+#define MASK_BLOCKING_WRITERS   ((uint64_t)(MASK_WRITER_ACTIVE | MASK_READERS_ACTIVE))
+
+// Readers, writers and the upgrader wait on different keys. None of these can be the address of another synchronization object.
+static inline void *GetReaderKey(_MCFCRT_RwLock *pLock){
+	return (unsigned char *)&(pLock->__u64);
+}
+static inline void *GetWriterKey(_MCFCRT_RwLock *pLock){
+	return (unsigned char *)&(pLock->__u64) + 2;
+}
+static inline void *GetUpgraderKey(_MCFCRT_RwLock *pLock){
+	return (unsigned char *)&(pLock->__u64) + 4;
+}
+
+static inline size_t GetReadersActive(uint64_t u64Control){
+	return (size_t)((u64Control & MASK_READERS_ACTIVE) / READERS_ACTIVE_ONE);
+}
+
+// If no writer is active or waiting and no upgrade is pending, all waiting readers are granted the lock.
+// Every state transition that might unblock readers goes through this function, so readers never remain parked on an unlocked lock.
+static inline uint64_t GrantReaders(size_t *restrict puReadersToWake, uint64_t u64Control){
+	const size_t uReadersWaiting = (size_t)((u64Control & MASK_READERS_WAITING) / READERS_WAITING_ONE);
+	if((uReadersWaiting == 0) || (u64Control & MASK_BLOCKING_READERS)){
+		*puReadersToWake = 0;
+		return u64Control;
+	}
+	_MCFCRT_ASSERT_MSG(GetReadersActive(u64Control) + uReadersWaiting <= READERS_ACTIVE_MAX, L"读者数目超出上限。");
+	*puReadersToWake = uReadersWaiting;
+	return u64Control - uReadersWaiting * READERS_WAITING_ONE + uReadersWaiting * READERS_ACTIVE_ONE;
+}
+
+static void ReleaseWaiters(void *pKey, size_t uCount){
+	// If `__MCFCRT_IsShutdownInProgress()` is `true`, other threads will have been terminated.
+	// Calling `__MCFCRT_UnparkThread()` when no thread is waiting results in deadlocks. Don't do that.
+	if(_MCFCRT_EXPECT_NOT((uCount != 0) && __MCFCRT_IsShutdownInProgress())){
+		return;
+	}
+	for(size_t uIndex = 0; uIndex < uCount; ++uIndex){
+		__MCFCRT_UnparkThread(pKey);
+	}
+}
+
+// Waiters are counted in the control word. Whoever decrements a counter releases one waiter on the corresponding key, which means the lock
+// has been handed off to it. So if we time out but the counter has been decremented by someone else, we must wait for the release.
+// This function returns `true` if the lock has been handed off to us and `false` if we have timed out and have been removed from the counter.
+static bool Park(_MCFCRT_RwLock *pLock, bool bWriter, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	void *const pKey = bWriter ? GetWriterKey(pLock) : GetReaderKey(pLock);
+	if(bMayTimeOut){
+		bool bUnparked = __MCFCRT_ParkThread(pKey, u64UntilFastMonoClock);
+		while(_MCFCRT_EXPECT(!bUnparked)){
+			bool bDecremented;
+			size_t uReadersToWake = 0;
+			{
+				uint64_t u64Old, u64New;
+				u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+				do {
+					if(bWriter){
+						bDecremented = (u64Old & MASK_WRITERS_WAITING) != 0;
+						if(!bDecremented){
+							break;
+						}
+						// If we were the last waiting writer, readers that have been blocked by us can go on.
+						u64New = GrantReaders(&uReadersToWake, u64Old - WRITERS_WAITING_ONE);
+					} else {
+						bDecremented = (u64Old & MASK_READERS_WAITING) != 0;
+						if(!bDecremented){
+							break;
+						}
+						u64New = u64Old - READERS_WAITING_ONE;
+					}
+				} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64New, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)));
+			}
+			if(bDecremented){
+				ReleaseWaiters(GetReaderKey(pLock), uReadersToWake);
+				return false;
+			}
+			bUnparked = __MCFCRT_ParkThread(pKey, 0);
+		}
+	} else {
+		__MCFCRT_ParkThreadForever(pKey);
+	}
+	return true;
+}
+
+__attribute__((__always_inline__)) static inline bool ReallyWaitForRwLock(_MCFCRT_RwLock *pLock, bool bWriter, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	const uint64_t u64MaskBlocking = bWriter ? MASK_BLOCKING_WRITERS : MASK_BLOCKING_READERS;
+	const uint64_t u64ActiveOne = bWriter ? MASK_WRITER_ACTIVE : READERS_ACTIVE_ONE;
+	const uint64_t u64MaskWaiting = bWriter ? MASK_WRITERS_WAITING : MASK_READERS_WAITING;
+	const uint64_t u64WaitingOne = u64MaskWaiting & -u64MaskWaiting;
+	bool bTaken;
+	// Spin for a while, hoping that the lock will be released soon.
+	for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+		uint64_t u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+		if(!(u64Old & u64MaskBlocking) && __atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64Old + u64ActiveOne, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+			return true;
+		}
+		__builtin_ia32_pause();
+	}
+	// Get the lock or count ourselves as a waiter atomically.
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+		do {
+			bTaken = !(u64Old & u64MaskBlocking);
+			if(bTaken){
+				u64New = u64Old + u64ActiveOne;
+			} else {
+				_MCFCRT_ASSERT_MSG((u64Old & u64MaskWaiting) != u64MaskWaiting, L"等待线程数目超出上限。");
+				u64New = u64Old + u64WaitingOne;
+			}
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64New, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)));
+	}
+	if(_MCFCRT_EXPECT(bTaken)){
+		return true;
+	}
+	return Park(pLock, bWriter, bMayTimeOut, u64UntilFastMonoClock);
+}
+
+bool __MCFCRT_ReallyWaitForRwLockShared(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
+	const bool bLocked = ReallyWaitForRwLock(pLock, false, uMaxSpinCount, true, u64UntilFastMonoClock);
+	return bLocked;
+}
+void __MCFCRT_ReallyWaitForRwLockSharedForever(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount){
+	const bool bLocked = ReallyWaitForRwLock(pLock, false, uMaxSpinCount, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bLocked);
+}
+void __MCFCRT_ReallySignalRwLockShared(_MCFCRT_RwLock *pLock){
+	bool bWakeWriter, bWakeUpgrader;
+	size_t uReadersToWake;
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+		do {
+			_MCFCRT_ASSERT_MSG(!(u64Old & MASK_WRITER_ACTIVE) && (GetReadersActive(u64Old) != 0), L"读写锁没有被任何读者锁定。");
+			u64New = u64Old - READERS_ACTIVE_ONE;
+			bWakeWriter = false;
+			bWakeUpgrader = false;
+			if(u64New & MASK_UPGRADE_PENDING){
+				// The upgrader is a reader, too. If it is the only one left, it becomes the writer.
+				if(GetReadersActive(u64New) == 1){
+					bWakeUpgrader = u64New & MASK_UPGRADER_PARKED;
+					u64New = (u64New & ~(MASK_UPGRADE_PENDING | MASK_UPGRADER_PARKED)) - READERS_ACTIVE_ONE + MASK_WRITER_ACTIVE;
+				}
+			} else if((GetReadersActive(u64New) == 0) && (u64New & MASK_WRITERS_WAITING)){
+				// Hand the lock off to the next writer.
+				bWakeWriter = true;
+				u64New = u64New - WRITERS_WAITING_ONE + MASK_WRITER_ACTIVE;
+			}
+			u64New = GrantReaders(&uReadersToWake, u64New);
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64New, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)));
+	}
+	ReleaseWaiters(GetUpgraderKey(pLock), bWakeUpgrader);
+	ReleaseWaiters(GetWriterKey(pLock), bWakeWriter);
+	ReleaseWaiters(GetReaderKey(pLock), uReadersToWake);
+}
+
+bool __MCFCRT_ReallyWaitForRwLockExclusive(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
+	const bool bLocked = ReallyWaitForRwLock(pLock, true, uMaxSpinCount, true, u64UntilFastMonoClock);
+	return bLocked;
+}
+void __MCFCRT_ReallyWaitForRwLockExclusiveForever(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount){
+	const bool bLocked = ReallyWaitForRwLock(pLock, true, uMaxSpinCount, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bLocked);
+}
+void __MCFCRT_ReallySignalRwLockExclusive(_MCFCRT_RwLock *pLock){
+	bool bWakeWriter;
+	size_t uReadersToWake;
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+		do {
+			_MCFCRT_ASSERT_MSG(u64Old & MASK_WRITER_ACTIVE, L"读写锁没有被任何写者锁定。");
+			bWakeWriter = (u64Old & MASK_WRITERS_WAITING) != 0;
+			if(bWakeWriter){
+				// Writers are preferred. Hand the lock off to the next writer.
+				uReadersToWake = 0;
+				u64New = u64Old - WRITERS_WAITING_ONE;
+			} else {
+				u64New = GrantReaders(&uReadersToWake, u64Old - MASK_WRITER_ACTIVE);
+			}
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64New, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)));
+	}
+	ReleaseWaiters(GetWriterKey(pLock), bWakeWriter);
+	ReleaseWaiters(GetReaderKey(pLock), uReadersToWake);
+}
+
+bool _MCFCRT_UpgradeRwLock(_MCFCRT_RwLock *pLock, size_t uMaxSpinCount){
+	bool bTaken;
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+		do {
+			_MCFCRT_ASSERT_MSG(!(u64Old & MASK_WRITER_ACTIVE) && (GetReadersActive(u64Old) != 0), L"读写锁没有被任何读者锁定。");
+			if(u64Old & MASK_UPGRADE_PENDING){
+				return false;
+			}
+			bTaken = GetReadersActive(u64Old) == 1;
+			if(bTaken){
+				u64New = u64Old - READERS_ACTIVE_ONE + MASK_WRITER_ACTIVE;
+			} else {
+				u64New = u64Old + MASK_UPGRADE_PENDING;
+			}
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64New, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)));
+	}
+	if(_MCFCRT_EXPECT(bTaken)){
+		return true;
+	}
+	// The last one of the other readers will make us the writer. See `__MCFCRT_ReallySignalRwLockShared()`.
+	for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+		if(!(__atomic_load_n(&(pLock->__u64), __ATOMIC_ACQUIRE) & MASK_UPGRADE_PENDING)){
+			return true;
+		}
+		__builtin_ia32_pause();
+	}
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+		do {
+			bTaken = !(u64Old & MASK_UPGRADE_PENDING);
+			if(bTaken){
+				break;
+			}
+			u64New = u64Old | MASK_UPGRADER_PARKED;
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64New, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)));
+	}
+	if(_MCFCRT_EXPECT(bTaken)){
+		return true;
+	}
+	__MCFCRT_ParkThreadForever(GetUpgraderKey(pLock));
+	return true;
+}
+void _MCFCRT_DowngradeRwLock(_MCFCRT_RwLock *pLock){
+	size_t uReadersToWake;
+	{
+		uint64_t u64Old, u64New;
+		u64Old = __atomic_load_n(&(pLock->__u64), __ATOMIC_RELAXED);
+		do {
+			_MCFCRT_ASSERT_MSG(u64Old & MASK_WRITER_ACTIVE, L"读写锁没有被任何写者锁定。");
+			// Waiting readers can join us unless a writer is waiting.
+			u64New = GrantReaders(&uReadersToWake, u64Old - MASK_WRITER_ACTIVE + READERS_ACTIVE_ONE);
+		} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pLock->__u64), &u64Old, u64New, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
+	}
+	ReleaseWaiters(GetReaderKey(pLock), uReadersToWake);
+}
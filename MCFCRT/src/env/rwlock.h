@@ -0,0 +1,108 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_RWLOCK_H_
+#define __MCFCRT_ENV_RWLOCK_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_RWLOCK_INLINE_OR_EXTERN
+#  define __MCFCRT_RWLOCK_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// A reader-writer lock can be held by either one writer or any number of readers. It is not recursive in either mode.
+// Writers are preferred: Once a writer starts waiting, new readers are blocked until no writer is waiting. When a writer releases the lock,
+// it is handed off to the next waiting writer if any, and to all waiting readers otherwise.
+// A reader can upgrade itself to a writer, in which case new readers are blocked and it gets the lock as soon as all other readers have left,
+// before any waiting writers. Only one upgrade can be pending at a time. A writer can downgrade itself to a reader without releasing the lock.
+// As with `_MCFCRT_Mutex`, a lock that has been locked by one thread can be unlocked by another.
+
+// In the case of static initialization, please initialize it with { 0 }.
+typedef struct __MCFCRT_tagRwLock {
+	_MCFCRT_STD uint64_t __u64;
+} _MCFCRT_RwLock;
+
+#define _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT   100u
+
+// These are for internal use only.
+#define __MCFCRT_RWLOCK_MASK_WRITER_ACTIVE     ((_MCFCRT_STD uint64_t)0x0000000000000001u)
+#define __MCFCRT_RWLOCK_MASK_UPGRADE_PENDING   ((_MCFCRT_STD uint64_t)0x0000000000000002u)
+#define __MCFCRT_RWLOCK_MASK_UPGRADER_PARKED   ((_MCFCRT_STD uint64_t)0x0000000000000004u)
+#define __MCFCRT_RWLOCK_MASK_READERS_ACTIVE    ((_MCFCRT_STD uint64_t)0x0000000000FFFFF0u)
+#define __MCFCRT_RWLOCK_MASK_READERS_WAITING   ((_MCFCRT_STD uint64_t)0x00000FFFFF000000u)
+#define __MCFCRT_RWLOCK_MASK_WRITERS_WAITING   ((_MCFCRT_STD uint64_t)0xFFFFF00000000000u)
+
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_InitializeRwLock(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT {
+	__atomic_store_n(&(__pLock->__u64), 0, __ATOMIC_RELEASE);
+}
+
+extern bool __MCFCRT_ReallyWaitForRwLockShared(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForRwLockSharedForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallySignalRwLockShared(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT;
+extern bool __MCFCRT_ReallyWaitForRwLockExclusive(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForRwLockExclusiveForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallySignalRwLockExclusive(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT;
+
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN bool _MCFCRT_WaitForRwLockShared(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __u64Old = __atomic_load_n(&(__pLock->__u64), __ATOMIC_RELAXED);
+	if(__builtin_expect(((__u64Old & (__MCFCRT_RWLOCK_MASK_WRITER_ACTIVE | __MCFCRT_RWLOCK_MASK_UPGRADE_PENDING | __MCFCRT_RWLOCK_MASK_WRITERS_WAITING)) == 0) &&
+		__atomic_compare_exchange_n(&(__pLock->__u64), &__u64Old, __u64Old + (__MCFCRT_RWLOCK_MASK_READERS_ACTIVE & -__MCFCRT_RWLOCK_MASK_READERS_ACTIVE), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true))
+	{
+		return true;
+	}
+	return __MCFCRT_ReallyWaitForRwLockShared(__pLock, __uMaxSpinCount, __u64UntilFastMonoClock);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_WaitForRwLockSharedForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __u64Old = __atomic_load_n(&(__pLock->__u64), __ATOMIC_RELAXED);
+	if(__builtin_expect(((__u64Old & (__MCFCRT_RWLOCK_MASK_WRITER_ACTIVE | __MCFCRT_RWLOCK_MASK_UPGRADE_PENDING | __MCFCRT_RWLOCK_MASK_WRITERS_WAITING)) == 0) &&
+		__atomic_compare_exchange_n(&(__pLock->__u64), &__u64Old, __u64Old + (__MCFCRT_RWLOCK_MASK_READERS_ACTIVE & -__MCFCRT_RWLOCK_MASK_READERS_ACTIVE), false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true))
+	{
+		return;
+	}
+	__MCFCRT_ReallyWaitForRwLockSharedForever(__pLock, __uMaxSpinCount);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_SignalRwLockShared(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __u64Old = __atomic_load_n(&(__pLock->__u64), __ATOMIC_RELAXED);
+	if(__builtin_expect(((__u64Old & ~__MCFCRT_RWLOCK_MASK_READERS_ACTIVE) == 0) && ((__u64Old & __MCFCRT_RWLOCK_MASK_READERS_ACTIVE) != 0) &&
+		__atomic_compare_exchange_n(&(__pLock->__u64), &__u64Old, __u64Old - (__MCFCRT_RWLOCK_MASK_READERS_ACTIVE & -__MCFCRT_RWLOCK_MASK_READERS_ACTIVE), false, __ATOMIC_RELEASE, __ATOMIC_RELAXED), true))
+	{
+		return;
+	}
+	__MCFCRT_ReallySignalRwLockShared(__pLock);
+}
+
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN bool _MCFCRT_WaitForRwLockExclusive(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __u64Old = 0;
+	if(__builtin_expect(__atomic_compare_exchange_n(&(__pLock->__u64), &__u64Old, __MCFCRT_RWLOCK_MASK_WRITER_ACTIVE, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+		return true;
+	}
+	return __MCFCRT_ReallyWaitForRwLockExclusive(__pLock, __uMaxSpinCount, __u64UntilFastMonoClock);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_WaitForRwLockExclusiveForever(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __u64Old = 0;
+	if(__builtin_expect(__atomic_compare_exchange_n(&(__pLock->__u64), &__u64Old, __MCFCRT_RWLOCK_MASK_WRITER_ACTIVE, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), true)){
+		return;
+	}
+	__MCFCRT_ReallyWaitForRwLockExclusiveForever(__pLock, __uMaxSpinCount);
+}
+__MCFCRT_RWLOCK_INLINE_OR_EXTERN void _MCFCRT_SignalRwLockExclusive(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __u64Old = __MCFCRT_RWLOCK_MASK_WRITER_ACTIVE;
+	if(__builtin_expect(__atomic_compare_exchange_n(&(__pLock->__u64), &__u64Old, 0, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED), true)){
+		return;
+	}
+	__MCFCRT_ReallySignalRwLockExclusive(__pLock);
+}
+
+// The calling thread shall hold the lock as a reader. If it is upgraded to a writer, `true` is returned.
+// If another upgrade is pending, `false` is returned and the lock is still held as a reader. In this case, the caller should release it and
+// lock it again as a writer to avoid deadlocks, and should be aware that the data being protected might have been modified when it gets the lock.
+extern bool _MCFCRT_UpgradeRwLock(_MCFCRT_RwLock *__pLock, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+// The calling thread shall hold the lock as a writer. It will hold the lock as a reader after this function returns.
+extern void _MCFCRT_DowngradeRwLock(_MCFCRT_RwLock *__pLock) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -0,0 +1,63 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#define __MCFCRT_SEMAPHORE_INLINE_OR_EXTERN     extern inline
+#include "semaphore.h"
+#include "wait_on_address.h"
+#include "xassert.h"
+#include "expect.h"
+
+__attribute__((__always_inline__)) static inline bool ReallyWaitForSemaphore(_MCFCRT_Semaphore *pSemaphore, size_t uMaxSpinCount, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	for(size_t uSpinIndex = 0; _MCFCRT_EXPECT(uSpinIndex < uMaxSpinCount); ++uSpinIndex){
+		__builtin_ia32_pause();
+		if(_MCFCRT_EXPECT_NOT(__MCFCRT_TryDecrementSemaphore(pSemaphore))){
+			return true;
+		}
+	}
+	// This pairs with the load of `__uWaiting` in `_MCFCRT_PostSemaphore()`. At least one of them will see the other.
+	__atomic_fetch_add(&(pSemaphore->__uWaiting), 1, __ATOMIC_SEQ_CST);
+	bool bDecremented;
+	for(;;){
+		uintptr_t uOld = __atomic_load_n(&(pSemaphore->__uCount), __ATOMIC_SEQ_CST);
+		while(uOld != 0){
+			if(__atomic_compare_exchange_n(&(pSemaphore->__uCount), &uOld, uOld - 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+				bDecremented = true;
+				goto jDone;
+			}
+		}
+		// If the count is no longer zero, this function returns immediately.
+		if(bMayTimeOut){
+			if(!_MCFCRT_WaitOnAddress(&(pSemaphore->__uCount), &uOld, sizeof(uOld), u64UntilFastMonoClock)){
+				bDecremented = __MCFCRT_TryDecrementSemaphore(pSemaphore);
+				goto jDone;
+			}
+		} else {
+			_MCFCRT_WaitOnAddressForever(&(pSemaphore->__uCount), &uOld, sizeof(uOld));
+		}
+	}
+jDone:
+	__atomic_fetch_sub(&(pSemaphore->__uWaiting), 1, __ATOMIC_RELAXED);
+	return bDecremented;
+}
+
+bool __MCFCRT_ReallyWaitForSemaphore(_MCFCRT_Semaphore *pSemaphore, size_t uMaxSpinCount, uint64_t u64UntilFastMonoClock){
+	const bool bDecremented = ReallyWaitForSemaphore(pSemaphore, uMaxSpinCount, true, u64UntilFastMonoClock);
+	return bDecremented;
+}
+void __MCFCRT_ReallyWaitForSemaphoreForever(_MCFCRT_Semaphore *pSemaphore, size_t uMaxSpinCount){
+	const bool bDecremented = ReallyWaitForSemaphore(pSemaphore, uMaxSpinCount, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bDecremented);
+}
+void __MCFCRT_ReallyWakeSemaphoreWaiters(_MCFCRT_Semaphore *pSemaphore, size_t uPostCount){
+	// Wake up no more threads than the number of units posted, so they do not fight over them.
+	if(uPostCount >= __atomic_load_n(&(pSemaphore->__uWaiting), __ATOMIC_RELAXED)){
+		_MCFCRT_WakeAllByAddress(&(pSemaphore->__uCount));
+		return;
+	}
+	for(size_t uIndex = 0; uIndex < uPostCount; ++uIndex){
+		if(_MCFCRT_WakeOneByAddress(&(pSemaphore->__uCount)) == 0){
+			break;
+		}
+	}
+}
@@ -0,0 +1,87 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_SEMAPHORE_H_
+#define __MCFCRT_ENV_SEMAPHORE_H_
+
+#include "_crtdef.h"
+
+#ifndef __MCFCRT_SEMAPHORE_INLINE_OR_EXTERN
+#  define __MCFCRT_SEMAPHORE_INLINE_OR_EXTERN     __attribute__((__gnu_inline__)) extern inline
+#endif
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// Posting to and waiting for a semaphore are lock-free as long as no thread has to sleep.
+
+typedef struct __MCFCRT_tagSemaphore {
+	_MCFCRT_STD uintptr_t __uCount;
+	_MCFCRT_STD uintptr_t __uWaiting;
+} _MCFCRT_Semaphore;
+
+#define _MCFCRT_SEMAPHORE_SUGGESTED_SPIN_COUNT   100u
+
+__MCFCRT_SEMAPHORE_INLINE_OR_EXTERN void _MCFCRT_InitializeSemaphore(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t __uInitCount) _MCFCRT_NOEXCEPT {
+	__atomic_store_n(&(__pSemaphore->__uWaiting), 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&(__pSemaphore->__uCount), __uInitCount, __ATOMIC_RELEASE);
+}
+
+extern bool __MCFCRT_ReallyWaitForSemaphore(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWaitForSemaphoreForever(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT;
+extern void __MCFCRT_ReallyWakeSemaphoreWaiters(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t __uPostCount) _MCFCRT_NOEXCEPT;
+
+__MCFCRT_SEMAPHORE_INLINE_OR_EXTERN bool __MCFCRT_TryDecrementSemaphore(_MCFCRT_Semaphore *__pSemaphore) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uintptr_t __uOld = __atomic_load_n(&(__pSemaphore->__uCount), __ATOMIC_RELAXED);
+	do {
+		if(__uOld == 0){
+			return false;
+		}
+	} while(__builtin_expect(!__atomic_compare_exchange_n(&(__pSemaphore->__uCount), &__uOld, __uOld - 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED), false));
+	return true;
+}
+
+__MCFCRT_SEMAPHORE_INLINE_OR_EXTERN bool _MCFCRT_WaitForSemaphore(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t __uMaxSpinCount, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT {
+	if(__builtin_expect(__MCFCRT_TryDecrementSemaphore(__pSemaphore), true)){
+		return true;
+	}
+	if(__u64UntilFastMonoClock == 0){
+		return false;
+	}
+	return __MCFCRT_ReallyWaitForSemaphore(__pSemaphore, __uMaxSpinCount, __u64UntilFastMonoClock);
+}
+__MCFCRT_SEMAPHORE_INLINE_OR_EXTERN void _MCFCRT_WaitForSemaphoreForever(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t __uMaxSpinCount) _MCFCRT_NOEXCEPT {
+	if(__builtin_expect(__MCFCRT_TryDecrementSemaphore(__pSemaphore), true)){
+		return;
+	}
+	__MCFCRT_ReallyWaitForSemaphoreForever(__pSemaphore, __uMaxSpinCount);
+}
+// The count before the post is returned.
+__MCFCRT_SEMAPHORE_INLINE_OR_EXTERN _MCFCRT_STD size_t _MCFCRT_PostSemaphore(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t __uPostCount) _MCFCRT_NOEXCEPT {
+	const _MCFCRT_STD uintptr_t __uOld = __atomic_fetch_add(&(__pSemaphore->__uCount), __uPostCount, __ATOMIC_SEQ_CST);
+	// This pairs with the increment of `__uWaiting` in `__MCFCRT_ReallyWaitForSemaphore()`. At least one of them will see the other.
+	if(__builtin_expect(__atomic_load_n(&(__pSemaphore->__uWaiting), __ATOMIC_SEQ_CST) != 0, false)){
+		__MCFCRT_ReallyWakeSemaphoreWaiters(__pSemaphore, __uPostCount);
+	}
+	return __uOld;
+}
+// The count before the post is stored into `*__puOldCount`. If the count would overflow, it is left intact and `false` is returned.
+__MCFCRT_SEMAPHORE_INLINE_OR_EXTERN bool _MCFCRT_TryPostSemaphore(_MCFCRT_Semaphore *__pSemaphore, _MCFCRT_STD size_t *__puOldCount, _MCFCRT_STD size_t __uPostCount) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uintptr_t __uOld = __atomic_load_n(&(__pSemaphore->__uCount), __ATOMIC_RELAXED);
+	do {
+		if(__builtin_expect(__uPostCount > UINTPTR_MAX - __uOld, false)){
+			*__puOldCount = __uOld;
+			return false;
+		}
+	} while(__builtin_expect(!__atomic_compare_exchange_n(&(__pSemaphore->__uCount), &__uOld, __uOld + __uPostCount, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED), false));
+	// See `_MCFCRT_PostSemaphore()`.
+	if(__builtin_expect(__atomic_load_n(&(__pSemaphore->__uWaiting), __ATOMIC_SEQ_CST) != 0, false)){
+		__MCFCRT_ReallyWakeSemaphoreWaiters(__pSemaphore, __uPostCount);
+	}
+	*__puOldCount = __uOld;
+	return true;
+}
+
+_MCFCRT_EXTERN_C_END
+
+#endif
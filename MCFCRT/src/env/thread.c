@@ -3,9 +3,12 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "thread.h"
+#include "xassert.h"
+
+#ifdef _WIN32
+
 #include "_nt_timeout.h"
 #include "_seh_top.h"
-#include "xassert.h"
 #include "mcfwin.h"
 #include <ntdef.h>
 
@@ -119,3 +122,146 @@ void _MCFCRT_WaitForThreadForever(_MCFCRT_ThreadHandle hThread){
 uintptr_t _MCFCRT_GetCurrentThreadId(void){
 	return GetCurrentThreadId();
 }
+
+#else
+
+#include "clocks.h"
+#include "latch.h"
+#include "expect.h"
+#include "bail.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// A thread handle points to this control block, which is shared by the handle and the thread itself and is freed by whichever releases it last.
+typedef struct tagThreadControl {
+	uintptr_t uRefCount;
+	_MCFCRT_NativeThreadProc pfnThreadProc;
+	void *pParam;
+	pid_t nThreadId;
+	// This is counted down after `nThreadId` has been set.
+	_MCFCRT_Latch vIdReady;
+	// This is counted down when the thread is resumed. Threads can only be suspended upon creation.
+	_MCFCRT_Latch vResumed;
+	// This is counted down after the thread procedure returns.
+	_MCFCRT_Latch vExited;
+} ThreadControl;
+
+static void DropThreadControl(ThreadControl *pControl){
+	if(__atomic_sub_fetch(&(pControl->uRefCount), 1, __ATOMIC_ACQ_REL) != 0){
+		return;
+	}
+	free(pControl);
+}
+
+static void *NativeThreadProc(void *pParam){
+	ThreadControl *const pControl = pParam;
+	pControl->nThreadId = (pid_t)syscall(SYS_gettid);
+	_MCFCRT_CountDownLatch(&(pControl->vIdReady), 1);
+	_MCFCRT_WaitForLatchForever(&(pControl->vResumed));
+	(*(pControl->pfnThreadProc))(pControl->pParam);
+	_MCFCRT_CountDownLatch(&(pControl->vExited), 1);
+	DropThreadControl(pControl);
+	return _MCFCRT_NULLPTR;
+}
+
+_MCFCRT_ThreadHandle _MCFCRT_CreateNativeThread(_MCFCRT_NativeThreadProc pfnThreadProc, void *pParam, bool bSuspended, uintptr_t *restrict puThreadId){
+	ThreadControl *const pControl = malloc(sizeof(ThreadControl));
+	if(!pControl){
+		errno = ENOMEM;
+		return _MCFCRT_NULLPTR;
+	}
+	pControl->uRefCount = 2;
+	pControl->pfnThreadProc = pfnThreadProc;
+	pControl->pParam = pParam;
+	pControl->nThreadId = 0;
+	_MCFCRT_InitializeLatch(&(pControl->vIdReady), 1);
+	_MCFCRT_InitializeLatch(&(pControl->vResumed), bSuspended);
+	_MCFCRT_InitializeLatch(&(pControl->vExited), 1);
+
+	pthread_t vThread;
+	const int nError = pthread_create(&vThread, _MCFCRT_NULLPTR, &NativeThreadProc, pControl);
+	if(nError != 0){
+		free(pControl);
+		errno = nError;
+		return _MCFCRT_NULLPTR;
+	}
+	pthread_detach(vThread);
+	if(puThreadId){
+		_MCFCRT_WaitForLatchForever(&(pControl->vIdReady));
+		*puThreadId = (uintptr_t)pControl->nThreadId;
+	}
+	return (_MCFCRT_ThreadHandle)pControl;
+}
+void _MCFCRT_CloseThread(_MCFCRT_ThreadHandle hThread){
+	DropThreadControl((ThreadControl *)hThread);
+}
+
+unsigned long _MCFCRT_WrapThreadProcWithSehTop(_MCFCRT_WrappedThreadProc pfnThreadProc, void *pParam){
+	return (*pfnThreadProc)(pParam);
+}
+
+void _MCFCRT_Sleep(uint64_t u64UntilFastMonoClock){
+	for(;;){
+		const uint64_t u64Now = _MCFCRT_GetFastMonoClock();
+		if(u64Now >= u64UntilFastMonoClock){
+			break;
+		}
+		const uint64_t u64DeltaMs = u64UntilFastMonoClock - u64Now;
+		struct timespec vTimeout;
+		vTimeout.tv_sec = (time_t)(u64DeltaMs / 1000);
+		vTimeout.tv_nsec = (long)(u64DeltaMs % 1000) * 1000000;
+		nanosleep(&vTimeout, _MCFCRT_NULLPTR);
+	}
+}
+// There are no APCs, so alertable sleeps always time out.
+bool _MCFCRT_AlertableSleep(uint64_t u64UntilFastMonoClock){
+	_MCFCRT_Sleep(u64UntilFastMonoClock);
+	return false;
+}
+__attribute__((__noreturn__)) void _MCFCRT_AlertableSleepForever(void){
+	for(;;){
+		pause();
+	}
+}
+void _MCFCRT_YieldThread(void){
+	sched_yield();
+}
+
+__attribute__((__noreturn__)) long _MCFCRT_SuspendThread(_MCFCRT_ThreadHandle hThread){
+	(void)hThread;
+	_MCFCRT_Bail(L"_MCFCRT_SuspendThread() 在此平台上不受支持。");
+}
+long _MCFCRT_ResumeThread(_MCFCRT_ThreadHandle hThread){
+	ThreadControl *const pControl = (ThreadControl *)hThread;
+	// Threads may resume the same thread concurrently, so the latch is counted down with a CAS that does not go below zero.
+	uintptr_t uOld = __atomic_load_n(&(pControl->vResumed.__uCount), __ATOMIC_RELAXED);
+	do {
+		if(uOld == 0){
+			return 0;
+		}
+	} while(_MCFCRT_EXPECT_NOT(!__atomic_compare_exchange_n(&(pControl->vResumed.__uCount), &uOld, uOld - 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)));
+	if(uOld == 1){
+		__MCFCRT_ReallyWakeLatchWaiters(&(pControl->vResumed));
+	}
+	return (long)uOld;
+}
+
+bool _MCFCRT_WaitForThread(_MCFCRT_ThreadHandle hThread, uint64_t u64UntilFastMonoClock){
+	ThreadControl *const pControl = (ThreadControl *)hThread;
+	return _MCFCRT_WaitForLatch(&(pControl->vExited), u64UntilFastMonoClock);
+}
+void _MCFCRT_WaitForThreadForever(_MCFCRT_ThreadHandle hThread){
+	ThreadControl *const pControl = (ThreadControl *)hThread;
+	_MCFCRT_WaitForLatchForever(&(pControl->vExited));
+}
+
+uintptr_t _MCFCRT_GetCurrentThreadId(void){
+	return (uintptr_t)syscall(SYS_gettid);
+}
+
+#endif
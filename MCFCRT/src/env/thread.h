@@ -9,7 +9,11 @@
 
 _MCFCRT_EXTERN_C_BEGIN
 
+#ifdef _WIN32
 typedef unsigned long (__attribute__((__stdcall__)) *_MCFCRT_NativeThreadProc)(void *__pParam);
+#else
+typedef unsigned long (*_MCFCRT_NativeThreadProc)(void *__pParam);
+#endif
 
 typedef struct __MCFCRT_tagThreadHandle { int __n; } *_MCFCRT_ThreadHandle;
 
@@ -0,0 +1,160 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "wait_on_address.h"
+#include "mutex.h"
+#include "_park.h"
+#include "xassert.h"
+#include "expect.h"
+
+#define BUCKET_COUNT_LOG2       8u
+#define BUCKET_COUNT            ((size_t)1 << BUCKET_COUNT_LOG2)
+
+typedef struct tagWaiter {
+	struct tagWaiter *pPrev;
+	struct tagWaiter *pNext;
+	volatile void *pAddress;
+	bool bWoken;
+} Waiter;
+
+// Each bucket is put in its own cache line, so threads waiting for unrelated objects do not interfere with each other.
+typedef struct __attribute__((__aligned__(64))) tagBucket {
+	_MCFCRT_Mutex vMutex;
+	Waiter *pFirst;
+	Waiter *pLast;
+} Bucket;
+
+static Bucket g_aBuckets[BUCKET_COUNT];
+
+static inline Bucket *GetBucket(volatile void *pAddress){
+	// This is Fibonacci hashing. The lowest bits are discarded, as most objects are aligned.
+	const uintptr_t uHash = ((uintptr_t)pAddress >> 2) * (uintptr_t)0x9E3779B97F4A7C15u;
+	return g_aBuckets + (uHash >> (sizeof(uintptr_t) * CHAR_BIT - BUCKET_COUNT_LOG2));
+}
+
+static inline bool IsValueExpected(volatile void *pAddress, const void *pExpected, size_t uSize){
+	switch(uSize){
+	case 1:
+		return __atomic_load_n((volatile uint8_t *)pAddress, __ATOMIC_ACQUIRE) == *(const uint8_t *)pExpected;
+	case 2:
+		return __atomic_load_n((volatile uint16_t *)pAddress, __ATOMIC_ACQUIRE) == *(const uint16_t *)pExpected;
+	case 4:
+		return __atomic_load_n((volatile uint32_t *)pAddress, __ATOMIC_ACQUIRE) == *(const uint32_t *)pExpected;
+	case 8:
+		return __atomic_load_n((volatile uint64_t *)pAddress, __ATOMIC_ACQUIRE) == *(const uint64_t *)pExpected;
+	default:
+		_MCFCRT_ASSERT_MSG(false, L"被等待的对象大小无效。");
+		__builtin_unreachable();
+	}
+}
+
+static void Unlink(Bucket *pBucket, Waiter *pWaiter){
+	if(pWaiter->pPrev){
+		pWaiter->pPrev->pNext = pWaiter->pNext;
+	} else {
+		pBucket->pFirst = pWaiter->pNext;
+	}
+	if(pWaiter->pNext){
+		pWaiter->pNext->pPrev = pWaiter->pPrev;
+	} else {
+		pBucket->pLast = pWaiter->pPrev;
+	}
+}
+
+static bool ReallyWaitOnAddress(volatile void *pAddress, const void *pExpected, size_t uSize, bool bMayTimeOut, uint64_t u64UntilFastMonoClock){
+	_MCFCRT_ASSERT_MSG(((uintptr_t)pAddress & (uSize - 1)) == 0, L"被等待的对象没有按照其大小对齐。");
+
+	Bucket *const pBucket = GetBucket(pAddress);
+	Waiter vWaiter;
+	_MCFCRT_WaitForMutexForever(&(pBucket->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		// Since the wake functions lock the same mutex, no wakeup can happen between the comparison and the enqueue operation.
+		if(!IsValueExpected(pAddress, pExpected, uSize)){
+			_MCFCRT_SignalMutex(&(pBucket->vMutex));
+			return true;
+		}
+		vWaiter.pPrev = pBucket->pLast;
+		vWaiter.pNext = _MCFCRT_NULLPTR;
+		vWaiter.pAddress = pAddress;
+		vWaiter.bWoken = false;
+		if(pBucket->pLast){
+			pBucket->pLast->pNext = &vWaiter;
+		} else {
+			pBucket->pFirst = &vWaiter;
+		}
+		pBucket->pLast = &vWaiter;
+	}
+	_MCFCRT_SignalMutex(&(pBucket->vMutex));
+
+	if(bMayTimeOut){
+		const bool bUnparked = __MCFCRT_ParkThread((void *)&vWaiter, u64UntilFastMonoClock);
+		if(_MCFCRT_EXPECT(!bUnparked)){
+			bool bWoken;
+			_MCFCRT_WaitForMutexForever(&(pBucket->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+			{
+				bWoken = vWaiter.bWoken;
+				if(!bWoken){
+					Unlink(pBucket, &vWaiter);
+				}
+			}
+			_MCFCRT_SignalMutex(&(pBucket->vMutex));
+			if(!bWoken){
+				return false;
+			}
+			// We have been taken off the queue, so the waker is going to release us. Wait for it, otherwise it would wait for us forever.
+			__MCFCRT_ParkThreadForever((void *)&vWaiter);
+		}
+	} else {
+		__MCFCRT_ParkThreadForever((void *)&vWaiter);
+	}
+	return true;
+}
+static size_t ReallyWakeByAddress(volatile void *pAddress, size_t uMaxCountToWake){
+	Bucket *const pBucket = GetBucket(pAddress);
+	// Waiters to release are moved into this list, which is singly linked through `pPrev`.
+	Waiter *pWoken = _MCFCRT_NULLPTR;
+	size_t uCountWoken = 0;
+	_MCFCRT_WaitForMutexForever(&(pBucket->vMutex), _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	{
+		Waiter *pWaiter = pBucket->pFirst;
+		while(pWaiter && (uCountWoken < uMaxCountToWake)){
+			Waiter *const pNext = pWaiter->pNext;
+			if(pWaiter->pAddress == pAddress){
+				Unlink(pBucket, pWaiter);
+				pWaiter->bWoken = true;
+				pWaiter->pPrev = pWoken;
+				pWoken = pWaiter;
+				++uCountWoken;
+			}
+			pWaiter = pNext;
+		}
+	}
+	_MCFCRT_SignalMutex(&(pBucket->vMutex));
+
+	// If `__MCFCRT_IsShutdownInProgress()` is `true`, other threads will have been terminated.
+	// Calling `__MCFCRT_UnparkThread()` when no thread is waiting results in deadlocks. Don't do that.
+	if(_MCFCRT_EXPECT_NOT((uCountWoken > 0) && !__MCFCRT_IsShutdownInProgress())){
+		while(pWoken){
+			// `pWoken` goes out of scope as soon as its owner is released, so get the next one beforehand.
+			Waiter *const pNext = pWoken->pPrev;
+			__MCFCRT_UnparkThread((void *)pWoken);
+			pWoken = pNext;
+		}
+	}
+	return uCountWoken;
+}
+
+bool _MCFCRT_WaitOnAddress(volatile void *pAddress, const void *pExpected, size_t uSize, uint64_t u64UntilFastMonoClock){
+	return ReallyWaitOnAddress(pAddress, pExpected, uSize, true, u64UntilFastMonoClock);
+}
+void _MCFCRT_WaitOnAddressForever(volatile void *pAddress, const void *pExpected, size_t uSize){
+	const bool bWoken = ReallyWaitOnAddress(pAddress, pExpected, uSize, false, UINT64_MAX);
+	_MCFCRT_ASSERT(bWoken);
+}
+size_t _MCFCRT_WakeOneByAddress(volatile void *pAddress){
+	return ReallyWakeByAddress(pAddress, 1);
+}
+size_t _MCFCRT_WakeAllByAddress(volatile void *pAddress){
+	return ReallyWakeByAddress(pAddress, SIZE_MAX);
+}
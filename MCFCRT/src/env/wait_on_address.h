@@ -0,0 +1,31 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_ENV_WAIT_ON_ADDRESS_H_
+#define __MCFCRT_ENV_WAIT_ON_ADDRESS_H_
+
+#include "_crtdef.h"
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// These functions make it possible to wait for any naturally aligned object of 1, 2, 4 or 8 bytes to change, without a kernel object per object.
+// Waiting threads are kept in a global table of wait queues that is indexed by the address being waited for.
+
+// If the object designated by `__pAddress` compares equal to the object designated by `__pExpected`, the calling thread goes to sleep until it is
+// woken up by `_MCFCRT_WakeOneByAddress()` or `_MCFCRT_WakeAllByAddress()` with the same address, or until the time point specified by
+// `__u64UntilFastMonoClock` has been reached. Otherwise, it returns immediately.
+// The comparison and the enqueue operation are atomic with respect to the wake functions. Hence if the object is modified before
+// one of the wake functions is called, no wakeup will be lost.
+// `false` is returned if the wait has timed out. `true` is returned otherwise. Spurious wakeups are impossible, but the caller should check the object
+// again anyway, as it might have been modified once more before the caller gets a chance to read it.
+extern bool _MCFCRT_WaitOnAddress(volatile void *__pAddress, const void *__pExpected, _MCFCRT_STD size_t __uSize, _MCFCRT_STD uint64_t __u64UntilFastMonoClock) _MCFCRT_NOEXCEPT;
+extern void _MCFCRT_WaitOnAddressForever(volatile void *__pAddress, const void *__pExpected, _MCFCRT_STD size_t __uSize) _MCFCRT_NOEXCEPT;
+
+// These functions return the number of threads that have been woken up.
+extern _MCFCRT_STD size_t _MCFCRT_WakeOneByAddress(volatile void *__pAddress) _MCFCRT_NOEXCEPT;
+extern _MCFCRT_STD size_t _MCFCRT_WakeAllByAddress(volatile void *__pAddress) _MCFCRT_NOEXCEPT;
+
+_MCFCRT_EXTERN_C_END
+
+#endif
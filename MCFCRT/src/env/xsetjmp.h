@@ -11,13 +11,14 @@ _MCFCRT_EXTERN_C_BEGIN
 
 // `__builtin_setjmp()` makes use of the first 5 elements.
 // The additional 3 are reserved for future use.
-typedef _MCFCRT_STD uintptr_t _MCFCRT_jmp_buf[5 + 3];
+// The elements are pointers, so passing the buffer to these built-ins does not violate strict aliasing.
+typedef void *_MCFCRT_jmp_buf[5 + 3];
 
 // See <https://gcc.gnu.org/bugzilla/show_bug.cgi?id=59039> for the purpose of this wrapper.
 __attribute__((__noreturn__)) extern void __MCFCRT_longjmp_wrapper(void **__env) _MCFCRT_NOEXCEPT;
 
-#define _MCFCRT_SETJMP(__env_)    (__builtin_setjmp((void **)(__env_)))
-#define _MCFCRT_LONGJMP(__env_)   (__MCFCRT_longjmp_wrapper((void **)(__env_)))
+#define _MCFCRT_SETJMP(__env_)    (__builtin_setjmp(__env_))
+#define _MCFCRT_LONGJMP(__env_)   (__MCFCRT_longjmp_wrapper(__env_))
 
 _MCFCRT_EXTERN_C_END
 
@@ -4,9 +4,12 @@
 
 #include "rawmemchr.h"
 #include "../env/expect.h"
+#include "../env/cpu.h"
 #include "../stdc/string/_sse2.h"
+#include "../stdc/string/_avx2.h"
+#include "../stdc/string/_avx512bw.h"
 
-void * _MCFCRT_rawmemchr(const void *s, int c){
+static void * rawmemchr_sse2(const void *s, int c){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -36,4 +39,86 @@ void * _MCFCRT_rawmemchr(const void *s, int c){
 end:
 	arp = arp - 32 + (unsigned)__builtin_ctzl(mask);
 	return (char *)arp;
+#undef BEGIN
+#undef END
 }
+
+__attribute__((__target__("avx2")))
+static void * rawmemchr_avx2(const void *s, int c){
+	// 同 SSE2 版本，只是每次处理 64 字节。
+	const char *arp = (const char *)((uintptr_t)s & (uintptr_t)-64);
+	__m256i yc[1];
+	__MCFCRT_ymmsetb(yc, (uint8_t)c);
+
+	__m256i yw[2];
+	uint64_t mask;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp = __MCFCRT_ymmload_2(yw, arp, _mm256_load_si256);	\
+	mask = __MCFCRT_ymmcmp_21b(yw, yc);
+#define END	\
+	if(_MCFCRT_EXPECT_NOT(mask != 0)){	\
+		goto end;	\
+	}
+//=============================================================================
+	BEGIN
+	dist = (const char *)s - (arp - 64);
+	mask &= (uint64_t)-1 << dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end:
+	arp = arp - 64 + (unsigned)__builtin_ctzll(mask);
+	return (char *)arp;
+#undef BEGIN
+#undef END
+}
+
+__attribute__((__target__("avx512f,avx512bw")))
+static void * rawmemchr_avx512bw(const void *s, int c){
+	// 同 SSE2 版本，只是每次处理 64 字节。
+	const char *arp = (const char *)((uintptr_t)s & (uintptr_t)-64);
+	__m512i zc[1];
+	__MCFCRT_zmmsetb(zc, (uint8_t)c);
+
+	__m512i zw[1];
+	uint64_t mask;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp = __MCFCRT_zmmload_1(zw, arp);	\
+	mask = __MCFCRT_zmmcmp_11b(zw, zc);
+#define END	\
+	if(_MCFCRT_EXPECT_NOT(mask != 0)){	\
+		goto end;	\
+	}
+//=============================================================================
+	BEGIN
+	dist = (const char *)s - (arp - 64);
+	mask &= (uint64_t)-1 << dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end:
+	arp = arp - 64 + (unsigned)__builtin_ctzll(mask);
+	return (char *)arp;
+#undef BEGIN
+#undef END
+}
+
+typedef void *Rawmemchr(const void *, int);
+
+static Rawmemchr *SelectRawmemchr(uint32_t features){
+	if((features >> _MCFCRT_kCpuFeatureAvx512bw) & 1){
+		return &rawmemchr_avx512bw;
+	}
+	if((features >> _MCFCRT_kCpuFeatureAvx2) & 1){
+		return &rawmemchr_avx2;
+	}
+	return &rawmemchr_sse2;
+}
+
+_MCFCRT_CPU_DISPATCH(void *, _MCFCRT_rawmemchr, (const void *s, int c), (s, c), SelectRawmemchr)
@@ -37,17 +37,17 @@ __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_DecodeUtf8(const char **__ppchRea
 	if(__pchRead == __pchReadEnd){
 		return _MCFCRT_UTF_NO_DATA;
 	}
-	const _MCFCRT_STD uint_fast32_t __u32Unit = (_MCFCRT_STD uint8_t)*(__pchRead++);
+	const _MCFCRT_STD uint32_t __u32Unit = (_MCFCRT_STD uint8_t)*(__pchRead++);
 #define __MCFCRT_UTF_DECODE_ONE_(__reg_, __bits_)	\
 	{	\
-		const _MCFCRT_STD uint_fast32_t __u32NextUnit_ = (_MCFCRT_STD uint8_t)*(__pchRead++);	\
-		_MCFCRT_STD uint_fast32_t __u32Test_;	\
+		const _MCFCRT_STD uint32_t __u32NextUnit_ = (_MCFCRT_STD uint8_t)*(__pchRead++);	\
+		_MCFCRT_STD uint32_t __u32Test_;	\
 		if((__u32Test_ = __u32NextUnit_ - 0x80) >= 0x40){	\
 			__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, (__reg_), __jDone)	\
 		}	\
 		(__reg_) += __u32Test_ << (__bits_);	\
 	}
-	_MCFCRT_STD uint_fast32_t __u32CodePoint, __u32Test;
+	_MCFCRT_STD uint32_t __u32CodePoint, __u32Test;
 	if(__u32Unit < 0x80){
 		__u32CodePoint = __u32Unit;
 	} else if((__u32Test = __u32Unit - 0x80) < 0x40){
@@ -102,14 +102,14 @@ __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_DecodeUtf16(const char16_t **__pp
 	if(__pc16Read == __pc16ReadEnd){
 		return _MCFCRT_UTF_NO_DATA;
 	}
-	const _MCFCRT_STD uint_fast32_t __u32Unit = (_MCFCRT_STD uint16_t)*(__pc16Read++);
-	_MCFCRT_STD uint_fast32_t __u32CodePoint, __u32Test;
+	const _MCFCRT_STD uint32_t __u32Unit = (_MCFCRT_STD uint16_t)*(__pc16Read++);
+	_MCFCRT_STD uint32_t __u32CodePoint, __u32Test;
 	if((__u32Test = __u32Unit - 0xD800) < 0x400){
 		if(__pc16ReadEnd - __pc16Read < 1){
 			return _MCFCRT_UTF_PARTIAL_DATA;
 		}
 		__u32CodePoint = __u32Test << 10;
-		_MCFCRT_STD uint_fast32_t __u32NextUnit = (_MCFCRT_STD uint16_t)*(__pc16Read++);
+		_MCFCRT_STD uint32_t __u32NextUnit = (_MCFCRT_STD uint16_t)*(__pc16Read++);
 		if((__u32Test = __u32NextUnit - 0xDC00) >= 0x400){
 			__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, __u32CodePoint, __jDone)
 		}
@@ -130,8 +130,8 @@ __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_DecodeUtf32(const char32_t **__pp
 	if(__pc32Read == __pc32ReadEnd){
 		return _MCFCRT_UTF_NO_DATA;
 	}
-	const _MCFCRT_STD uint_fast32_t __u32Unit = (_MCFCRT_STD uint32_t)*(__pc32Read++);
-	_MCFCRT_STD uint_fast32_t __u32CodePoint;
+	const _MCFCRT_STD uint32_t __u32Unit = (_MCFCRT_STD uint32_t)*(__pc32Read++);
+	_MCFCRT_STD uint32_t __u32CodePoint;
 	if(__u32Unit - 0xD800 < 0x800){
 		__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, __u32CodePoint, __jDone)
 	} else if(__u32Unit < 0x110000){
@@ -149,17 +149,17 @@ __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_DecodeCesu8(const char **__ppchRe
 	if(__pchRead == __pchReadEnd){
 		return _MCFCRT_UTF_NO_DATA;
 	}
-	const _MCFCRT_STD uint_fast32_t __u32Unit = (_MCFCRT_STD uint8_t)*(__pchRead++);
+	const _MCFCRT_STD uint32_t __u32Unit = (_MCFCRT_STD uint8_t)*(__pchRead++);
 #define __MCFCRT_UTF_DECODE_ONE_(__reg_, __bits_)	\
 	{	\
-		const _MCFCRT_STD uint_fast32_t __u32NextUnit_ = (_MCFCRT_STD uint8_t)*(__pchRead++);	\
-		_MCFCRT_STD uint_fast32_t __u32Test_;	\
+		const _MCFCRT_STD uint32_t __u32NextUnit_ = (_MCFCRT_STD uint8_t)*(__pchRead++);	\
+		_MCFCRT_STD uint32_t __u32Test_;	\
 		if((__u32Test_ = __u32NextUnit_ - 0x80) >= 0x40){	\
 			__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, (__reg_), __jDone)	\
 		}	\
 		(__reg_) += __u32Test_ << (__bits_);	\
 	}
-	_MCFCRT_STD uint_fast32_t __u32CodePoint, __u32Test;
+	_MCFCRT_STD uint32_t __u32CodePoint, __u32Test;
 	if(__u32Unit < 0x80){
 		__u32CodePoint = __u32Unit;
 	} else if((__u32Test = __u32Unit - 0x80) < 0x40){
@@ -191,7 +191,7 @@ __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_DecodeCesu8(const char **__ppchRe
 				return _MCFCRT_UTF_PARTIAL_DATA;
 			}
 			__u32CodePoint = __u32Test << 10;
-			_MCFCRT_STD uint_fast32_t __u32NextUnit = (_MCFCRT_STD uint8_t)*(__pchRead++);
+			_MCFCRT_STD uint32_t __u32NextUnit = (_MCFCRT_STD uint8_t)*(__pchRead++);
 			if((__u32Test = __u32NextUnit - 0xE0) >= 0x10){
 				__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, __u32CodePoint, __jDone)
 			}
@@ -216,7 +216,7 @@ __jDone:
 
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_EncodeUtf8(char **__ppchWrite, char *__pchWriteEnd, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char *__pchWrite = *__ppchWrite;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x80){
 		if(__pchWriteEnd - __pchWrite < 1){
 			return _MCFCRT_UTF_BUFFER_TOO_SMALL;
@@ -256,7 +256,7 @@ __jReplace:
 }
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_EncodeUtf16(char16_t **__ppc16Write, char16_t *__pc16WriteEnd, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char16_t *__pc16Write = *__ppc16Write;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x10000){
 		if(__u32CodePoint - 0xD800 < 0x800){
 			__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, __u32CodePoint, __jReplace)
@@ -270,8 +270,8 @@ __jReplace:
 		if(__pc16WriteEnd - __pc16Write < 2){
 			return _MCFCRT_UTF_BUFFER_TOO_SMALL;
 		}
-		const _MCFCRT_STD uint_fast32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
-		const _MCFCRT_STD uint_fast32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
+		const _MCFCRT_STD uint32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
+		const _MCFCRT_STD uint32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
 		*(__pc16Write++) = (char16_t)__u32LeadingSurrogate;
 		*(__pc16Write++) = (char16_t)__u32TrailingSurrogate;
 	} else {
@@ -283,7 +283,7 @@ __jReplace:
 }
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_EncodeUtf32(char32_t **__ppc32Write, char32_t *__pc32WriteEnd, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char32_t *__pc32Write = *__ppc32Write;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x110000){
 		if(__u32CodePoint - 0xD800 < 0x800){
 			__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, __u32CodePoint, __jReplace)
@@ -302,7 +302,7 @@ __jReplace:
 }
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_EncodeCesu8(char **__ppchWrite, char *__pchWriteEnd, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char *__pchWrite = *__ppchWrite;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x80){
 		if(__pchWriteEnd - __pchWrite < 1){
 			return _MCFCRT_UTF_BUFFER_TOO_SMALL;
@@ -329,8 +329,8 @@ __jReplace:
 		if(__pchWriteEnd - __pchWrite < 6){
 			return _MCFCRT_UTF_BUFFER_TOO_SMALL;
 		}
-		const _MCFCRT_STD uint_fast32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
-		const _MCFCRT_STD uint_fast32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
+		const _MCFCRT_STD uint32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
+		const _MCFCRT_STD uint32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
 		*(__pchWrite++) = (char)(((__u32LeadingSurrogate       ) >> 12) + 0xE0);
 		*(__pchWrite++) = (char)(((__u32LeadingSurrogate  << 20) >> 26) + 0x80);
 		*(__pchWrite++) = (char)(((__u32LeadingSurrogate  << 26) >> 26) + 0x80);
@@ -347,7 +347,7 @@ __jReplace:
 
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_UncheckedEncodeUtf8(char **__ppchWrite, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char *__pchWrite = *__ppchWrite;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x80){
 		*(__pchWrite++) = (char)__u32CodePoint;
 	} else if(__u32CodePoint < 0x800){
@@ -375,7 +375,7 @@ __jReplace:
 }
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_UncheckedEncodeUtf16(char16_t **__ppc16Write, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char16_t *__pc16Write = *__ppc16Write;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x10000){
 		if(__u32CodePoint - 0xD800 < 0x800){
 			__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, __u32CodePoint, __jReplace)
@@ -383,8 +383,8 @@ __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_UncheckedEncodeUtf16(char16_t **_
 __jReplace:
 		*(__pc16Write++) = (char16_t)__u32CodePoint;
 	} else if(__u32CodePoint < 0x110000){
-		const _MCFCRT_STD uint_fast32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
-		const _MCFCRT_STD uint_fast32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
+		const _MCFCRT_STD uint32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
+		const _MCFCRT_STD uint32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
 		*(__pc16Write++) = (char16_t)__u32LeadingSurrogate;
 		*(__pc16Write++) = (char16_t)__u32TrailingSurrogate;
 	} else {
@@ -396,7 +396,7 @@ __jReplace:
 }
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_UncheckedEncodeUtf32(char32_t **__ppc32Write, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char32_t *__pc32Write = *__ppc32Write;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x110000){
 		if(__u32CodePoint - 0xD800 < 0x800){
 			__MCFCRT_UTF_HANDLE_INVALID_INPUT_(__bPermissive, __u32CodePoint, __jReplace)
@@ -412,7 +412,7 @@ __jReplace:
 }
 __MCFCRT_UTF_INLINE_OR_EXTERN char32_t _MCFCRT_UncheckedEncodeCesu8(char **__ppchWrite, char32_t __c32Char, bool __bPermissive) _MCFCRT_NOEXCEPT {
 	char *__pchWrite = *__ppchWrite;
-	_MCFCRT_STD uint_fast32_t __u32CodePoint = __c32Char;
+	_MCFCRT_STD uint32_t __u32CodePoint = __c32Char;
 	if(__u32CodePoint < 0x80){
 		*(__pchWrite++) = (char)__u32CodePoint;
 	} else if(__u32CodePoint < 0x800){
@@ -427,8 +427,8 @@ __jReplace:
 		*(__pchWrite++) = (char)(((__u32CodePoint << 20) >> 26) + 0x80);
 		*(__pchWrite++) = (char)(((__u32CodePoint << 26) >> 26) + 0x80);
 	} else if(__u32CodePoint < 0x110000){
-		const _MCFCRT_STD uint_fast32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
-		const _MCFCRT_STD uint_fast32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
+		const _MCFCRT_STD uint32_t __u32LeadingSurrogate  = (((__u32CodePoint - 0x10000)      ) >> 10) + 0xD800;
+		const _MCFCRT_STD uint32_t __u32TrailingSurrogate = (((__u32CodePoint          ) << 22) >> 22) + 0xDC00;
 		*(__pchWrite++) = (char)(((__u32LeadingSurrogate       ) >> 12) + 0xE0);
 		*(__pchWrite++) = (char)(((__u32LeadingSurrogate  << 20) >> 26) + 0x80);
 		*(__pchWrite++) = (char)(((__u32LeadingSurrogate  << 26) >> 26) + 0x80);
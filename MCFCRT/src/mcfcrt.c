@@ -6,6 +6,7 @@
 #include "env/xassert.h"
 #include "env/standard_streams.h"
 #include "env/heap_debug.h"
+#include "env/_heap_engine.h"
 #include "env/_mopthread.h"
 #include "env/crt_module.h"
 
@@ -14,16 +15,22 @@ static ptrdiff_t g_nCounter = 0;
 bool __MCFCRT_InitRecursive(void){
 	ptrdiff_t nCounter = g_nCounter;
 	if(nCounter == 0){
+		if(!__MCFCRT_HeapEngineInit()){
+			return false;
+		}
 		if(!__MCFCRT_StandardStreamsInit()){
+			__MCFCRT_HeapEngineUninit();
 			return false;
 		}
 		if(!__MCFCRT_HeapDebugInit()){
 			__MCFCRT_StandardStreamsUninit();
+			__MCFCRT_HeapEngineUninit();
 			return false;
 		}
 		if(!__MCFCRT_MopthreadInit()){
 			__MCFCRT_HeapDebugUninit();
 			__MCFCRT_StandardStreamsUninit();
+			__MCFCRT_HeapEngineUninit();
 			return false;
 		}
 		// Add more initialization...
@@ -43,5 +50,6 @@ void __MCFCRT_UninitRecursive(void){
 		__MCFCRT_DiscardCrtModuleQuickExitCallbacks();
 		__MCFCRT_HeapDebugUninit();
 		__MCFCRT_StandardStreamsUninit();
+		__MCFCRT_HeapEngineUninit();
 	}
 }
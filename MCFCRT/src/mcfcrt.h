@@ -9,23 +9,33 @@
 
 #ifndef __MCFCRT_NO_GENERAL_INCLUDES
 // ------------------------------ env ------------------------------
+#  include "env/arena.h"
 #  include "env/avl_tree.h"
 #  include "env/bail.h"
+#  include "env/barrier.h"
 #  include "env/clocks.h"
 #  include "env/condition_variable.h"
 #  include "env/xassert.h"
 #  include "env/crt_module.h"
 #  include "env/expect.h"
+#  include "env/fair_mutex.h"
+#  include "env/fiber.h"
 #  include "env/heap.h"
 #  include "env/heap_debug.h"
+#  include "env/heap_profiler.h"
 #  include "env/inline_mem.h"
 #  include "env/last_error.h"
+#  include "env/latch.h"
 #  include "env/mutex.h"
+#  include "env/mutex_profiler.h"
 #  include "env/offset_of.h"
 #  include "env/once_flag.h"
 #  include "env/pp.h"
+#  include "env/rwlock.h"
+#  include "env/semaphore.h"
 #  include "env/standard_streams.h"
 #  include "env/thread.h"
+#  include "env/wait_on_address.h"
 // ------------------------------ ext ------------------------------
 #  include "ext/alloca.h"
 #  include "ext/atoi.h"
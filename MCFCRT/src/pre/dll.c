@@ -12,6 +12,7 @@
 #include "../env/crt_module.h"
 #include "../env/bail.h"
 #include "../env/thread.h"
+#include "../env/_heap_engine.h"
 #include "../env/mcfwin.h"
 
 __attribute__((__weak__)) extern bool _MCFCRT_OnDllProcessAttach(void *pInstance, bool bDynamic);
@@ -69,6 +70,7 @@ static unsigned long WrappedDllStartup(void *pOpaque){
 		if(_MCFCRT_OnDllThreadDetach){
 			_MCFCRT_OnDllThreadDetach(pParams->hInstance);
 		}
+		__MCFCRT_HeapEngineThreadCleanup();
 		return true;
 
 	default:
@@ -12,6 +12,7 @@
 #include "../env/crt_module.h"
 #include "../env/bail.h"
 #include "../env/thread.h"
+#include "../env/_heap_engine.h"
 #include "../env/mcfwin.h"
 
 extern unsigned _MCFCRT_Main(void);
@@ -70,6 +71,7 @@ static unsigned long WrappedTlsCallback(void *pOpaque){
 
 	case DLL_THREAD_DETACH:
 		__MCFCRT_TlsCleanup();
+		__MCFCRT_HeapEngineThreadCleanup();
 		return true;
 
 	default:
@@ -0,0 +1,12 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#include "../../env/_crtdef.h"
+#include "../../env/heap.h"
+
+#undef free_sized
+
+__attribute__((__noinline__)) void free_sized(void *p, size_t size){
+	_MCFCRT_free_sized(p, size);
+}
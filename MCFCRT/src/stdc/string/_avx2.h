@@ -0,0 +1,77 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_STDC_STRING_AVX2_H_
+#define __MCFCRT_STDC_STRING_AVX2_H_
+
+#include "../../env/_crtdef.h"
+#include <immintrin.h>
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// 这些函数只能在具有 `__target__("avx2")` 属性的函数中使用，并且调用者必须确保 CPU 支持 AVX2。
+
+__attribute__((__always_inline__, __target__("avx2"))) static inline void __MCFCRT_ymmsetz(__m256i *__word) _MCFCRT_NOEXCEPT {
+	*__word = _mm256_setzero_si256();
+}
+__attribute__((__always_inline__, __target__("avx2"))) static inline void __MCFCRT_ymmsetb(__m256i *__word, _MCFCRT_STD uint8_t __val) _MCFCRT_NOEXCEPT {
+	*__word = _mm256_set1_epi8((char)__val);
+}
+
+__attribute__((__always_inline__, __target__("avx2"))) static inline const void * __MCFCRT_ymmload_2(__m256i *_MCFCRT_RESTRICT __words, const void *_MCFCRT_RESTRICT __src, __m256i (*__loader)(const __m256i *)) _MCFCRT_NOEXCEPT {
+	__m256i *__wp = __words;
+	const __m256i *__rp = (const __m256i *)__src;
+	for(unsigned __i = 0; __i < 2; ++__i){
+		*(__wp++) = __loader(__rp++);
+	}
+	return __rp;
+}
+
+__attribute__((__always_inline__, __target__("avx2"))) static inline void * __MCFCRT_ymmstore_2(void *_MCFCRT_RESTRICT __dst, const __m256i *_MCFCRT_RESTRICT __words, void (*__storer)(__m256i *, __m256i)) _MCFCRT_NOEXCEPT {
+	__m256i *__wp = (__m256i *)__dst;
+	const __m256i *__rp = __words;
+	for(unsigned __i = 0; __i < 2; ++__i){
+		__storer(__wp++, *(__rp++));
+	}
+	return __wp;
+}
+
+__attribute__((__always_inline__, __target__("avx2"))) static inline _MCFCRT_STD uint64_t __MCFCRT_ymmcmp_21b(const __m256i *__lhs, const __m256i *__rhs) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __mask = 0;
+	for(unsigned __i = 0; __i < 2; ++__i){
+		const __m256i __t = _mm256_cmpeq_epi8(__lhs[__i], __rhs[0]);
+		__mask += (_MCFCRT_STD uint64_t)(_MCFCRT_STD uint32_t)_mm256_movemask_epi8(__t) << __i * 32;
+	}
+	return __mask;
+}
+__attribute__((__always_inline__, __target__("avx2"))) static inline _MCFCRT_STD uint64_t __MCFCRT_ymmcmp_22b(const __m256i *__lhs, const __m256i *__rhs) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __mask = 0;
+	for(unsigned __i = 0; __i < 2; ++__i){
+		const __m256i __t = _mm256_cmpeq_epi8(__lhs[__i], __rhs[__i]);
+		__mask += (_MCFCRT_STD uint64_t)(_MCFCRT_STD uint32_t)_mm256_movemask_epi8(__t) << __i * 32;
+	}
+	return __mask;
+}
+
+__attribute__((__always_inline__, __target__("avx2"))) static inline _MCFCRT_STD uint64_t __MCFCRT_ymmcmpor_211b(const __m256i *__lhs, const __m256i *__rhs, const __m256i *__third) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __mask = 0;
+	for(unsigned __i = 0; __i < 2; ++__i){
+		const __m256i __t = _mm256_or_si256(_mm256_cmpeq_epi8(__lhs[__i], __third[0]), _mm256_cmpeq_epi8(__lhs[__i], __rhs[0]));
+		__mask += (_MCFCRT_STD uint64_t)(_MCFCRT_STD uint32_t)_mm256_movemask_epi8(__t) << __i * 32;
+	}
+	return __mask;
+}
+
+__attribute__((__always_inline__, __target__("avx2"))) static inline _MCFCRT_STD uint64_t __MCFCRT_ymmcmpandn_221b(const __m256i *__lhs, const __m256i *__rhs, const __m256i *__third) _MCFCRT_NOEXCEPT {
+	_MCFCRT_STD uint64_t __mask = 0;
+	for(unsigned __i = 0; __i < 2; ++__i){
+		const __m256i __t = _mm256_andnot_si256(_mm256_cmpeq_epi8(__lhs[__i], __third[0]), _mm256_cmpeq_epi8(__lhs[__i], __rhs[__i]));
+		__mask += (_MCFCRT_STD uint64_t)(_MCFCRT_STD uint32_t)_mm256_movemask_epi8(__t) << __i * 32;
+	}
+	return __mask;
+}
+
+_MCFCRT_EXTERN_C_END
+
+#endif
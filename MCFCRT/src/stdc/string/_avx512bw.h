@@ -0,0 +1,50 @@
+// 这个文件是 MCF 的一部分。
+// 有关具体授权说明，请参阅 MCFLicense.txt。
+// Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
+
+#ifndef __MCFCRT_STDC_STRING_AVX512BW_H_
+#define __MCFCRT_STDC_STRING_AVX512BW_H_
+
+#include "../../env/_crtdef.h"
+#include <immintrin.h>
+
+_MCFCRT_EXTERN_C_BEGIN
+
+// 这些函数只能在具有 `__target__("avx512f,avx512bw")` 属性的函数中使用，并且调用者必须确保 CPU 支持 AVX-512BW。
+// 一个 ZMM 寄存器恰好是 64 字节，比较结果就是一个 64 位的掩码，因此不需要像 SSE2 和 AVX2 版本那样拼接掩码。
+
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline void __MCFCRT_zmmsetz(__m512i *__word) _MCFCRT_NOEXCEPT {
+	*__word = _mm512_setzero_si512();
+}
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline void __MCFCRT_zmmsetb(__m512i *__word, _MCFCRT_STD uint8_t __val) _MCFCRT_NOEXCEPT {
+	*__word = _mm512_set1_epi8((char)__val);
+}
+
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline const void * __MCFCRT_zmmload_1(__m512i *_MCFCRT_RESTRICT __words, const void *_MCFCRT_RESTRICT __src) _MCFCRT_NOEXCEPT {
+	const __m512i *__rp = (const __m512i *)__src;
+	__words[0] = _mm512_load_si512(__rp++);
+	return __rp;
+}
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline const void * __MCFCRT_zmmloadu_1(__m512i *_MCFCRT_RESTRICT __words, const void *_MCFCRT_RESTRICT __src) _MCFCRT_NOEXCEPT {
+	const __m512i *__rp = (const __m512i *)__src;
+	__words[0] = _mm512_loadu_si512(__rp++);
+	return __rp;
+}
+// 掩码以外的字节被视为零，也不会被读取，因此不会引发页错误。
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline void __MCFCRT_zmmloadm_1(__m512i *_MCFCRT_RESTRICT __words, const void *_MCFCRT_RESTRICT __src, _MCFCRT_STD uint64_t __mask) _MCFCRT_NOEXCEPT {
+	__words[0] = _mm512_maskz_loadu_epi8((__mmask64)__mask, __src);
+}
+
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline _MCFCRT_STD uint64_t __MCFCRT_zmmcmp_11b(const __m512i *__lhs, const __m512i *__rhs) _MCFCRT_NOEXCEPT {
+	return (_MCFCRT_STD uint64_t)_mm512_cmpeq_epi8_mask(__lhs[0], __rhs[0]);
+}
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline _MCFCRT_STD uint64_t __MCFCRT_zmmcmpor_111b(const __m512i *__lhs, const __m512i *__rhs, const __m512i *__third) _MCFCRT_NOEXCEPT {
+	return (_MCFCRT_STD uint64_t)(_mm512_cmpeq_epi8_mask(__lhs[0], __third[0]) | _mm512_cmpeq_epi8_mask(__lhs[0], __rhs[0]));
+}
+__attribute__((__always_inline__, __target__("avx512f,avx512bw"))) static inline _MCFCRT_STD uint64_t __MCFCRT_zmmcmpandn_111b(const __m512i *__lhs, const __m512i *__rhs, const __m512i *__third) _MCFCRT_NOEXCEPT {
+	return (_MCFCRT_STD uint64_t)(_mm512_cmpeq_epi8_mask(__lhs[0], __rhs[0]) & ~_mm512_cmpeq_epi8_mask(__lhs[0], __third[0]));
+}
+
+_MCFCRT_EXTERN_C_END
+
+#endif
@@ -4,11 +4,14 @@
 
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
+#include "../../env/cpu.h"
 #include "_sse2.h"
+#include "_avx2.h"
+#include "_avx512bw.h"
 
 #undef memchr
 
-void * memchr(const void *s, int c, size_t n){
+static void * memchr_sse2(const void *s, int c, size_t n){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -52,4 +55,114 @@ end:
 	}
 end_null:
 	return _MCFCRT_NULLPTR;
+#undef BEGIN
+#undef END
 }
+
+__attribute__((__target__("avx2")))
+static void * memchr_avx2(const void *s, int c, size_t n){
+	// 同 SSE2 版本，只是每次处理 64 字节。
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-64);
+	__m256i yc[1];
+	__MCFCRT_ymmsetb(yc, (uint8_t)c);
+
+	__m256i yw[2];
+	uint64_t mask;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp = __MCFCRT_ymmload_2(yw, arp, _mm256_load_si256);	\
+	mask = __MCFCRT_ymmcmp_21b(yw, yc);
+#define END	\
+	dist = arp - ((const unsigned char *)s + n);	\
+	if(_MCFCRT_EXPECT_NOT(dist >= 0)){	\
+		goto end_trunc;	\
+	}	\
+	dist = 0;	\
+	if(_MCFCRT_EXPECT_NOT(mask != 0)){	\
+		goto end;	\
+	}
+//=============================================================================
+	if(_MCFCRT_EXPECT_NOT(n == 0)){
+		goto end_null;
+	}
+	BEGIN
+	dist = (const unsigned char *)s - (arp - 64);
+	mask &= (uint64_t)-1 << dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end_trunc:
+	mask |= ~((uint64_t)-1 >> dist);
+end:
+	if((mask << dist) != 0){
+		arp = arp - 64 + (unsigned)__builtin_ctzll(mask);
+		return (unsigned char *)arp;
+	}
+end_null:
+	return _MCFCRT_NULLPTR;
+#undef BEGIN
+#undef END
+}
+
+__attribute__((__target__("avx512f,avx512bw")))
+static void * memchr_avx512bw(const void *s, int c, size_t n){
+	// 同 SSE2 版本，只是每次处理 64 字节。
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-64);
+	__m512i zc[1];
+	__MCFCRT_zmmsetb(zc, (uint8_t)c);
+
+	__m512i zw[1];
+	uint64_t mask;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp = __MCFCRT_zmmload_1(zw, arp);	\
+	mask = __MCFCRT_zmmcmp_11b(zw, zc);
+#define END	\
+	dist = arp - ((const unsigned char *)s + n);	\
+	if(_MCFCRT_EXPECT_NOT(dist >= 0)){	\
+		goto end_trunc;	\
+	}	\
+	dist = 0;	\
+	if(_MCFCRT_EXPECT_NOT(mask != 0)){	\
+		goto end;	\
+	}
+//=============================================================================
+	if(_MCFCRT_EXPECT_NOT(n == 0)){
+		goto end_null;
+	}
+	BEGIN
+	dist = (const unsigned char *)s - (arp - 64);
+	mask &= (uint64_t)-1 << dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end_trunc:
+	mask |= ~((uint64_t)-1 >> dist);
+end:
+	if((mask << dist) != 0){
+		arp = arp - 64 + (unsigned)__builtin_ctzll(mask);
+		return (unsigned char *)arp;
+	}
+end_null:
+	return _MCFCRT_NULLPTR;
+#undef BEGIN
+#undef END
+}
+
+typedef void *Memchr(const void *, int, size_t);
+
+static Memchr *SelectMemchr(uint32_t features){
+	if((features >> _MCFCRT_kCpuFeatureAvx512bw) & 1){
+		return &memchr_avx512bw;
+	}
+	if((features >> _MCFCRT_kCpuFeatureAvx2) & 1){
+		return &memchr_avx2;
+	}
+	return &memchr_sse2;
+}
+
+_MCFCRT_CPU_DISPATCH(void *, memchr, (const void *s, int c, size_t n), (s, c, n), SelectMemchr)
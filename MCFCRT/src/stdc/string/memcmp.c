@@ -4,6 +4,9 @@
 
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
+#include "../../env/cpu.h"
+#include "_avx2.h"
+#include "_avx512bw.h"
 
 #if __GNUC__ >= 7
 #  pragma GCC diagnostic ignored "-Wswitch-unreachable"
@@ -14,7 +17,7 @@
 
 #undef memcmp
 
-int memcmp(const void *s1, const void *s2, size_t n){
+static int memcmp_generic(const void *s1, const void *s2, size_t n){
 	const unsigned char *rp1 = s1;
 	const unsigned char *rp2 = s2;
 	const unsigned char *const erp2 = rp2 + n;
@@ -22,7 +25,7 @@ int memcmp(const void *s1, const void *s2, size_t n){
 		do {
 #define COMPARE_STEP_(k_)	\
 		if(_MCFCRT_EXPECT_NOT(*(const uintptr_t *)rp1 != *(const uintptr_t *)rp2)){	\
-			break;	\
+			goto end_word;	\
 		}	\
 		rp1 += UINTPTR_BYTES;	\
 		rp2 += UINTPTR_BYTES;	\
@@ -51,4 +54,105 @@ int memcmp(const void *s1, const void *s2, size_t n){
 #undef COMPARE_STEP_
 	}
 	return 0;
+end_word:
+	// 这个字中一定有不相等的字节。
+	while(*rp1 == *rp2){
+		++rp1;
+		++rp2;
+	}
+	return (*rp1 < *rp2) ? -1 : 1;
+}
+
+__attribute__((__target__("avx2")))
+static int memcmp_avx2(const void *s1, const void *s2, size_t n){
+	// 长度是已知的，因此可以不对齐地读取 [s1, s1 + n) 和 [s2, s2 + n) 中的任何字节。
+	if(_MCFCRT_EXPECT_NOT(n < 32)){
+		return memcmp_generic(s1, s2, n);
+	}
+	const unsigned char *rp1 = s1;
+	const unsigned char *rp2 = s2;
+	const unsigned char *const erp1 = rp1 + n;
+	__m256i yw[2], yc[2];
+	uint64_t mask;
+	while(_MCFCRT_EXPECT((size_t)(erp1 - rp1) >= 64)){
+		for(unsigned i = 0; i < 2; ++i){
+			yw[i] = _mm256_loadu_si256((const __m256i *)rp1 + i);
+			yc[i] = _mm256_loadu_si256((const __m256i *)rp2 + i);
+		}
+		mask = ~__MCFCRT_ymmcmp_22b(yw, yc);
+		if(_MCFCRT_EXPECT_NOT(mask != 0)){
+			goto end;
+		}
+		rp1 += 64;
+		rp2 += 64;
+	}
+	// 剩余不到 64 字节。先比较开头的 32 字节，再比较最后的 32 字节，后者可能与已经比较过的字节重叠。
+	if((size_t)(erp1 - rp1) > 32){
+		yw[0] = _mm256_loadu_si256((const __m256i *)rp1);
+		yc[0] = _mm256_loadu_si256((const __m256i *)rp2);
+		mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(yw[0], yc[0]));
+		if(_MCFCRT_EXPECT_NOT(mask != 0)){
+			goto end;
+		}
+	}
+	rp2 += (erp1 - 32) - rp1;
+	rp1 = erp1 - 32;
+	yw[0] = _mm256_loadu_si256((const __m256i *)rp1);
+	yc[0] = _mm256_loadu_si256((const __m256i *)rp2);
+	mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(yw[0], yc[0]));
+	if(_MCFCRT_EXPECT(mask == 0)){
+		return 0;
+	}
+end:
+	rp1 += (unsigned)__builtin_ctzll(mask);
+	rp2 += (unsigned)__builtin_ctzll(mask);
+	return (*rp1 < *rp2) ? -1 : 1;
+}
+
+__attribute__((__target__("avx512f,avx512bw")))
+static int memcmp_avx512bw(const void *s1, const void *s2, size_t n){
+	// 末尾不足 64 字节的部分使用掩码读取，掩码以外的字节不会被访问。
+	const unsigned char *rp1 = s1;
+	const unsigned char *rp2 = s2;
+	const unsigned char *const erp1 = rp1 + n;
+	__m512i zw[1], zc[1];
+	uint64_t mask;
+	while(_MCFCRT_EXPECT((size_t)(erp1 - rp1) >= 64)){
+		__MCFCRT_zmmloadu_1(zw, rp1);
+		__MCFCRT_zmmloadu_1(zc, rp2);
+		mask = ~__MCFCRT_zmmcmp_11b(zw, zc);
+		if(_MCFCRT_EXPECT_NOT(mask != 0)){
+			goto end;
+		}
+		rp1 += 64;
+		rp2 += 64;
+	}
+	if(rp1 == erp1){
+		return 0;
+	}
+	const uint64_t valid = ((uint64_t)1 << (erp1 - rp1)) - 1;
+	__MCFCRT_zmmloadm_1(zw, rp1, valid);
+	__MCFCRT_zmmloadm_1(zc, rp2, valid);
+	mask = ~__MCFCRT_zmmcmp_11b(zw, zc) & valid;
+	if(_MCFCRT_EXPECT(mask == 0)){
+		return 0;
+	}
+end:
+	rp1 += (unsigned)__builtin_ctzll(mask);
+	rp2 += (unsigned)__builtin_ctzll(mask);
+	return (*rp1 < *rp2) ? -1 : 1;
 }
+
+typedef int Memcmp(const void *, const void *, size_t);
+
+static Memcmp *SelectMemcmp(uint32_t features){
+	if((features >> _MCFCRT_kCpuFeatureAvx512bw) & 1){
+		return &memcmp_avx512bw;
+	}
+	if((features >> _MCFCRT_kCpuFeatureAvx2) & 1){
+		return &memcmp_avx2;
+	}
+	return &memcmp_generic;
+}
+
+_MCFCRT_CPU_DISPATCH(int, memcmp, (const void *s1, const void *s2, size_t n), (s1, s2, n), SelectMemcmp)
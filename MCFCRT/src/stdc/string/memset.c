@@ -3,6 +3,8 @@
 // Copyleft 2013 - 2018, LH_Mouse. All wrongs reserved.
 
 #include "_memset_impl.h"
+#include "_avx2.h"
+#include "_avx512bw.h"
 
 #undef memset
 
@@ -12,9 +14,69 @@ void * __MCFCRT_memset32(void *s, uint32_t c32, size_t n){
 	return s;
 }
 
-void * memset(void *s, int c, size_t n){
+static void * memset_sse2(void *s, int c, size_t n){
 	uint32_t c32 = (uint8_t)c;
 	c32 += c32 <<  8;
 	c32 += c32 << 16;
 	return __MCFCRT_memset32(s, c32, n);
 }
+
+__attribute__((__target__("avx2")))
+static void * memset_avx2(void *s, int c, size_t n){
+	// 小块仍然使用 SSE2 版本中的跳转表。大于末级缓存四分之一的块需要使用非临时存储，也交给 SSE2 版本。
+	if(_MCFCRT_EXPECT_NOT((n <= 64) || (n > _MCFCRT_CpuGetCacheSize(_MCFCRT_kCpuCacheLevelMax) / 4))){
+		return memset_sse2(s, c, n);
+	}
+	unsigned char *wp = s;
+	unsigned char *const ewp = wp + n;
+	__m256i yw[2];
+	__MCFCRT_ymmsetb(yw, (uint8_t)c);
+	yw[1] = yw[0];
+	// 首尾的 64 字节可能是不对齐的，单独写入。
+	_mm256_storeu_si256((__m256i *)wp, yw[0]);
+	_mm256_storeu_si256((__m256i *)ewp - 2, yw[0]);
+	_mm256_storeu_si256((__m256i *)ewp - 1, yw[0]);
+	// 其余部分按 32 字节对齐写入，每次 64 字节。末尾不足 64 字节的部分已经写过了。
+	wp = (unsigned char *)(((uintptr_t)wp + 32) & (uintptr_t)-32);
+	while(_MCFCRT_EXPECT((size_t)(ewp - wp) > 64)){
+		wp = __MCFCRT_ymmstore_2(wp, yw, _mm256_store_si256);
+	}
+	return s;
+}
+
+__attribute__((__target__("avx512f,avx512bw")))
+static void * memset_avx512bw(void *s, int c, size_t n){
+	// 同 AVX2 版本，只是每次写入 64 字节。
+	if(_MCFCRT_EXPECT_NOT((n <= 128) || (n > _MCFCRT_CpuGetCacheSize(_MCFCRT_kCpuCacheLevelMax) / 4))){
+		return memset_avx2(s, c, n);
+	}
+	unsigned char *wp = s;
+	unsigned char *const ewp = wp + n;
+	__m512i zw[1];
+	__MCFCRT_zmmsetb(zw, (uint8_t)c);
+	_mm512_storeu_si512(wp, zw[0]);
+	_mm512_storeu_si512((__m512i *)ewp - 2, zw[0]);
+	_mm512_storeu_si512((__m512i *)ewp - 1, zw[0]);
+	wp = (unsigned char *)(((uintptr_t)wp + 64) & (uintptr_t)-64);
+	while(_MCFCRT_EXPECT((size_t)(ewp - wp) > 128)){
+		_mm512_store_si512(wp, zw[0]);
+		wp += 64;
+		_mm512_store_si512(wp, zw[0]);
+		wp += 64;
+	}
+	return s;
+}
+
+typedef void *Memset(void *, int, size_t);
+
+static Memset *SelectMemset(uint32_t features){
+	if((features >> _MCFCRT_kCpuFeatureAvx512bw) & 1){
+		return &memset_avx512bw;
+	}
+	if((features >> _MCFCRT_kCpuFeatureAvx2) & 1){
+		return &memset_avx2;
+	}
+	return &memset_sse2;
+}
+
+_MCFCRT_CPU_DISPATCH(void *, memset, (void *s, int c, size_t n), (s, c, n), SelectMemset)
@@ -4,11 +4,14 @@
 
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
+#include "../../env/cpu.h"
 #include "_sse2.h"
+#include "_avx2.h"
+#include "_avx512bw.h"
 
 #undef strchr
 
-char * strchr(const char *s, int c){
+static char * strchr_sse2(const char *s, int c){
 	// 如果 arp 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -43,4 +46,96 @@ end:
 		return (char *)arp;
 	}
 	return _MCFCRT_NULLPTR;
+#undef BEGIN
+#undef END
 }
+
+__attribute__((__target__("avx2")))
+static char * strchr_avx2(const char *s, int c){
+	// 同 SSE2 版本，只是每次处理 64 字节。
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-64);
+	__m256i yc[1];
+	__MCFCRT_ymmsetb(yc, (uint8_t)c);
+	__m256i yz[1];
+	__MCFCRT_ymmsetz(yz);
+
+	__m256i yw[2];
+	uint64_t mask;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp = __MCFCRT_ymmload_2(yw, arp, _mm256_load_si256);	\
+	mask = __MCFCRT_ymmcmpor_211b(yw, yc, yz);
+#define END	\
+	if(_MCFCRT_EXPECT_NOT(mask != 0)){	\
+		goto end;	\
+	}
+//=============================================================================
+	BEGIN
+	dist = (const unsigned char *)s - (arp - 64);
+	mask &= (uint64_t)-1 << dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end:
+	arp = arp - 64 + (unsigned)__builtin_ctzll(mask);
+	if(*arp == (unsigned char)c){
+		return (char *)arp;
+	}
+	return _MCFCRT_NULLPTR;
+#undef BEGIN
+#undef END
+}
+
+__attribute__((__target__("avx512f,avx512bw")))
+static char * strchr_avx512bw(const char *s, int c){
+	// 同 SSE2 版本，只是每次处理 64 字节。
+	const unsigned char *arp = (const unsigned char *)((uintptr_t)s & (uintptr_t)-64);
+	__m512i zc[1];
+	__MCFCRT_zmmsetb(zc, (uint8_t)c);
+	__m512i zz[1];
+	__MCFCRT_zmmsetz(zz);
+
+	__m512i zw[1];
+	uint64_t mask;
+	ptrdiff_t dist;
+//=============================================================================
+#define BEGIN	\
+	arp = __MCFCRT_zmmload_1(zw, arp);	\
+	mask = __MCFCRT_zmmcmpor_111b(zw, zc, zz);
+#define END	\
+	if(_MCFCRT_EXPECT_NOT(mask != 0)){	\
+		goto end;	\
+	}
+//=============================================================================
+	BEGIN
+	dist = (const unsigned char *)s - (arp - 64);
+	mask &= (uint64_t)-1 << dist;
+	for(;;){
+		END
+		BEGIN
+	}
+end:
+	arp = arp - 64 + (unsigned)__builtin_ctzll(mask);
+	if(*arp == (unsigned char)c){
+		return (char *)arp;
+	}
+	return _MCFCRT_NULLPTR;
+#undef BEGIN
+#undef END
+}
+
+typedef char *Strchr(const char *, int);
+
+static Strchr *SelectStrchr(uint32_t features){
+	if((features >> _MCFCRT_kCpuFeatureAvx512bw) & 1){
+		return &strchr_avx512bw;
+	}
+	if((features >> _MCFCRT_kCpuFeatureAvx2) & 1){
+		return &strchr_avx2;
+	}
+	return &strchr_sse2;
+}
+
+_MCFCRT_CPU_DISPATCH(char *, strchr, (const char *s, int c), (s, c), SelectStrchr)
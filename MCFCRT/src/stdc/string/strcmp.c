@@ -4,12 +4,15 @@
 
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
+#include "../../env/cpu.h"
 #include "_sse2.h"
 #include "_ssse3.h"
+#include "_avx2.h"
+#include "_avx512bw.h"
 
 #undef strcmp
 
-int strcmp(const char *s1, const char *s2){
+static int strcmp_sse2(const char *s1, const char *s2){
 	// 如果 arp1 和 arp2 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -64,4 +67,111 @@ end:
 	return (*arp1 < *arp2) ? -1 : 1;
 end_equal:
 	return 0;
+#undef BEGIN
+#undef END
 }
+
+__attribute__((__target__("avx2")))
+static int strcmp_avx2(const char *s1, const char *s2){
+	// arp1 是对齐到 64 字节的，因此同 SSE2 版本一样不会越界。
+	// 对于 arp2，如果它开始的 64 字节跨越了页边界，就逐字节比较这 64 字节，否则就直接读取它们。
+	// 这样每次只能读取属于同一页的字节，而每一页中至少有一个字节属于 s2，因此 arp2 也不会越界。
+	const unsigned char *arp1 = (const unsigned char *)((uintptr_t)s1 & (uintptr_t)-64);
+	const unsigned char *arp2 = (const unsigned char *)((uintptr_t)s2 - ((uintptr_t)s1 - (uintptr_t)arp1));
+	__m256i yz[1];
+	__MCFCRT_ymmsetz(yz);
+
+	__m256i yw[2], yc[2];
+	uint64_t mask;
+	unsigned dist = (unsigned)((const unsigned char *)s1 - arp1);
+	for(;;){
+		if(_MCFCRT_EXPECT_NOT(((uintptr_t)arp2 & (_MCFCRT_PAGE_SIZE_MINIMUM - 1)) > _MCFCRT_PAGE_SIZE_MINIMUM - 64)){
+			for(unsigned i = dist; i < 64; ++i){
+				if((arp1[i] != arp2[i]) || (arp1[i] == 0)){
+					arp1 += i;
+					arp2 += i;
+					goto end;
+				}
+			}
+		} else {
+			__MCFCRT_ymmload_2(yw, arp1, _mm256_load_si256);
+			yc[0] = _mm256_loadu_si256((const __m256i *)arp2);
+			yc[1] = _mm256_loadu_si256((const __m256i *)arp2 + 1);
+			mask = ~__MCFCRT_ymmcmpandn_221b(yw, yc, yz);
+			mask &= (uint64_t)-1 << dist;
+			if(_MCFCRT_EXPECT_NOT(mask != 0)){
+				const unsigned i = (unsigned)__builtin_ctzll(mask);
+				arp1 += i;
+				arp2 += i;
+				goto end;
+			}
+		}
+		arp1 += 64;
+		arp2 += 64;
+		dist = 0;
+	}
+end:
+	if(*arp1 == *arp2){
+		return 0;
+	}
+	return (*arp1 < *arp2) ? -1 : 1;
+}
+
+__attribute__((__target__("avx512f,avx512bw")))
+static int strcmp_avx512bw(const char *s1, const char *s2){
+	// arp1 是对齐到 64 字节的，因此同 SSE2 版本一样不会越界。
+	// 对于 arp2，如果它开始的 64 字节跨越了页边界，就逐字节比较这 64 字节，否则就直接读取它们。
+	// 这样每次只能读取属于同一页的字节，而每一页中至少有一个字节属于 s2，因此 arp2 也不会越界。
+	const unsigned char *arp1 = (const unsigned char *)((uintptr_t)s1 & (uintptr_t)-64);
+	const unsigned char *arp2 = (const unsigned char *)((uintptr_t)s2 - ((uintptr_t)s1 - (uintptr_t)arp1));
+	__m512i zz[1];
+	__MCFCRT_zmmsetz(zz);
+
+	__m512i zw[1], zc[1];
+	uint64_t mask;
+	unsigned dist = (unsigned)((const unsigned char *)s1 - arp1);
+	for(;;){
+		if(_MCFCRT_EXPECT_NOT(((uintptr_t)arp2 & (_MCFCRT_PAGE_SIZE_MINIMUM - 1)) > _MCFCRT_PAGE_SIZE_MINIMUM - 64)){
+			for(unsigned i = dist; i < 64; ++i){
+				if((arp1[i] != arp2[i]) || (arp1[i] == 0)){
+					arp1 += i;
+					arp2 += i;
+					goto end;
+				}
+			}
+		} else {
+			__MCFCRT_zmmload_1(zw, arp1);
+			__MCFCRT_zmmloadu_1(zc, arp2);
+			mask = ~__MCFCRT_zmmcmpandn_111b(zw, zc, zz);
+			mask &= (uint64_t)-1 << dist;
+			if(_MCFCRT_EXPECT_NOT(mask != 0)){
+				const unsigned i = (unsigned)__builtin_ctzll(mask);
+				arp1 += i;
+				arp2 += i;
+				goto end;
+			}
+		}
+		arp1 += 64;
+		arp2 += 64;
+		dist = 0;
+	}
+end:
+	if(*arp1 == *arp2){
+		return 0;
+	}
+	return (*arp1 < *arp2) ? -1 : 1;
+}
+
+typedef int Strcmp(const char *, const char *);
+
+static Strcmp *SelectStrcmp(uint32_t features){
+	if((features >> _MCFCRT_kCpuFeatureAvx512bw) & 1){
+		return &strcmp_avx512bw;
+	}
+	if((features >> _MCFCRT_kCpuFeatureAvx2) & 1){
+		return &strcmp_avx2;
+	}
+	return &strcmp_sse2;
+}
+
+_MCFCRT_CPU_DISPATCH(int, strcmp, (const char *s1, const char *s2), (s1, s2), SelectStrcmp)
@@ -4,12 +4,15 @@
 
 #include "../../env/_crtdef.h"
 #include "../../env/expect.h"
+#include "../../env/cpu.h"
 #include "_sse2.h"
 #include "_ssse3.h"
+#include "_avx2.h"
+#include "_avx512bw.h"
 
 #undef strncmp
 
-int strncmp(const char *s1, const char *s2, size_t n){
+static int strncmp_sse2(const char *s1, const char *s2, size_t n){
 	// 如果 arp1 和 arp2 是对齐到字的，就不用考虑越界的问题。
 	// 因为内存按页分配的，也自然对齐到页，并且也对齐到字。
 	// 每个字内的字节的权限必然一致。
@@ -38,8 +41,8 @@ int strncmp(const char *s1, const char *s2, size_t n){
 	__MCFCRT_xmmalign_2(xc, s2v, align);	\
 	mask = ~__MCFCRT_xmmcmpandn_221b(xw, xc, xz);
 #define END	\
-	dist = arp1 - ((const unsigned char *)s1 + n);	\
-	if(_MCFCRT_EXPECT_NOT(dist >= 0)){	\
+	if(_MCFCRT_EXPECT_NOT(arp1 >= (const unsigned char *)s1 + n)){	\
+		dist = arp1 - ((const unsigned char *)s1 + n);	\
 		goto end_trunc;	\
 	}	\
 	dist = 0;	\
@@ -50,6 +53,11 @@ int strncmp(const char *s1, const char *s2, size_t n){
 	if(_MCFCRT_EXPECT_NOT(n == 0)){
 		goto end_equal;
 	}
+	// 如果 n 太大，s1 + n 或者 s2 + n 会回绕。字符串一定在地址空间结束之前结束，因此可以截断 n。
+	const uintptr_t top = ((uintptr_t)s1 > (uintptr_t)s2) ? (uintptr_t)s1 : (uintptr_t)s2;
+	if(n > UINTPTR_MAX - top){
+		n = UINTPTR_MAX - top;
+	}
 	__MCFCRT_xmmsetz_2(s2v + 2);
 	arp2 = __MCFCRT_xmmload_2(s2v + 4, arp2, _mm_load_si128);
 	mask = __MCFCRT_xmmcmp_21b(s2v + 4, xz);
@@ -76,4 +84,139 @@ end:
 	}
 end_equal:
 	return 0;
+#undef BEGIN
+#undef END
+}
+
+__attribute__((__target__("avx2")))
+static int strncmp_avx2(const char *s1, const char *s2, size_t n){
+	// 参考 strcmp() 的注释。
+	const unsigned char *arp1 = (const unsigned char *)((uintptr_t)s1 & (uintptr_t)-64);
+	const unsigned char *arp2 = (const unsigned char *)((uintptr_t)s2 - ((uintptr_t)s1 - (uintptr_t)arp1));
+	__m256i yz[1];
+	__MCFCRT_ymmsetz(yz);
+
+	__m256i yw[2], yc[2];
+	uint64_t mask;
+	unsigned dist = (unsigned)((const unsigned char *)s1 - arp1);
+	if(_MCFCRT_EXPECT_NOT(n == 0)){
+		return 0;
+	}
+	// 从 arp1 开始还需要比较多少字节。如果 n 太大，就把它当作无穷大。
+	size_t rem = n + dist;
+	if(rem < n){
+		rem = SIZE_MAX;
+	}
+	for(;;){
+		const unsigned lim = (rem < 64) ? (unsigned)rem : 64;
+		if(_MCFCRT_EXPECT_NOT(((uintptr_t)arp2 & (_MCFCRT_PAGE_SIZE_MINIMUM - 1)) > _MCFCRT_PAGE_SIZE_MINIMUM - 64)){
+			for(unsigned i = dist; i < lim; ++i){
+				if((arp1[i] != arp2[i]) || (arp1[i] == 0)){
+					arp1 += i;
+					arp2 += i;
+					goto end;
+				}
+			}
+		} else {
+			__MCFCRT_ymmload_2(yw, arp1, _mm256_load_si256);
+			yc[0] = _mm256_loadu_si256((const __m256i *)arp2);
+			yc[1] = _mm256_loadu_si256((const __m256i *)arp2 + 1);
+			mask = ~__MCFCRT_ymmcmpandn_221b(yw, yc, yz);
+			mask &= (uint64_t)-1 << dist;
+			if(lim < 64){
+				mask &= ~((uint64_t)-1 << lim);
+			}
+			if(_MCFCRT_EXPECT_NOT(mask != 0)){
+				const unsigned i = (unsigned)__builtin_ctzll(mask);
+				arp1 += i;
+				arp2 += i;
+				goto end;
+			}
+		}
+		if(rem <= 64){
+			return 0;
+		}
+		rem -= 64;
+		arp1 += 64;
+		arp2 += 64;
+		dist = 0;
+	}
+end:
+	if(*arp1 == *arp2){
+		return 0;
+	}
+	return (*arp1 < *arp2) ? -1 : 1;
 }
+
+__attribute__((__target__("avx512f,avx512bw")))
+static int strncmp_avx512bw(const char *s1, const char *s2, size_t n){
+	// 参考 strcmp() 的注释。
+	const unsigned char *arp1 = (const unsigned char *)((uintptr_t)s1 & (uintptr_t)-64);
+	const unsigned char *arp2 = (const unsigned char *)((uintptr_t)s2 - ((uintptr_t)s1 - (uintptr_t)arp1));
+	__m512i zz[1];
+	__MCFCRT_zmmsetz(zz);
+
+	__m512i zw[1], zc[1];
+	uint64_t mask;
+	unsigned dist = (unsigned)((const unsigned char *)s1 - arp1);
+	if(_MCFCRT_EXPECT_NOT(n == 0)){
+		return 0;
+	}
+	// 从 arp1 开始还需要比较多少字节。如果 n 太大，就把它当作无穷大。
+	size_t rem = n + dist;
+	if(rem < n){
+		rem = SIZE_MAX;
+	}
+	for(;;){
+		const unsigned lim = (rem < 64) ? (unsigned)rem : 64;
+		if(_MCFCRT_EXPECT_NOT(((uintptr_t)arp2 & (_MCFCRT_PAGE_SIZE_MINIMUM - 1)) > _MCFCRT_PAGE_SIZE_MINIMUM - 64)){
+			for(unsigned i = dist; i < lim; ++i){
+				if((arp1[i] != arp2[i]) || (arp1[i] == 0)){
+					arp1 += i;
+					arp2 += i;
+					goto end;
+				}
+			}
+		} else {
+			__MCFCRT_zmmload_1(zw, arp1);
+			__MCFCRT_zmmloadu_1(zc, arp2);
+			mask = ~__MCFCRT_zmmcmpandn_111b(zw, zc, zz);
+			mask &= (uint64_t)-1 << dist;
+			if(lim < 64){
+				mask &= ~((uint64_t)-1 << lim);
+			}
+			if(_MCFCRT_EXPECT_NOT(mask != 0)){
+				const unsigned i = (unsigned)__builtin_ctzll(mask);
+				arp1 += i;
+				arp2 += i;
+				goto end;
+			}
+		}
+		if(rem <= 64){
+			return 0;
+		}
+		rem -= 64;
+		arp1 += 64;
+		arp2 += 64;
+		dist = 0;
+	}
+end:
+	if(*arp1 == *arp2){
+		return 0;
+	}
+	return (*arp1 < *arp2) ? -1 : 1;
+}
+
+typedef int Strncmp(const char *, const char *, size_t);
+
+static Strncmp *SelectStrncmp(uint32_t features){
+	if((features >> _MCFCRT_kCpuFeatureAvx512bw) & 1){
+		return &strncmp_avx512bw;
+	}
+	if((features >> _MCFCRT_kCpuFeatureAvx2) & 1){
+		return &strncmp_avx2;
+	}
+	return &strncmp_sse2;
+}
+
+_MCFCRT_CPU_DISPATCH(int, strncmp, (const char *s1, const char *s2, size_t n), (s1, s2, n), SelectStrncmp)
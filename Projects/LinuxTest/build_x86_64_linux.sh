@@ -0,0 +1,35 @@
+#!/bin/bash
+
+set -e
+
+CPPFLAGS=" -Og -g -Wall -Wextra -pedantic -pedantic-errors -Werror -Wno-error=unused-parameter	\
+	-Wwrite-strings -Wconversion -Wsign-conversion -Wdouble-promotion -Wsuggest-attribute=noreturn -Wundef -Wshadow -Wstrict-aliasing=2	\
+	-pipe -march=core2 -mtune=intel -masm=intel -fshort-wchar -pthread ${EXTRA_FLAGS}"
+CFLAGS=" -std=c11 -Wstrict-prototypes"
+LDFLAGS=" -pthread ${EXTRA_FLAGS}"
+
+MCFCRT_SOURCES="	\
+	env/_park.c env/cpu.c env/clocks.c env/thread.c env/once_flag.c env/mutex.c env/fair_mutex.c	\
+	env/wait_on_address.c env/semaphore.c env/latch.c env/barrier.c env/condition_variable.c env/rwlock.c	\
+	env/fiber.c env/xsetjmp.c env/bail.c env/xassert.c	\
+	stdc/string/_memset_impl.c	\
+	ext/wcpcpy.c ext/wcppcpy.c ext/itow.c ext/utf.c"
+
+# 测试代码使用 <MCFCRT/...> 包含头文件，与安装后的布局相同。
+mkdir -p _include _obj
+ln -sfn ../../../MCFCRT/src _include/MCFCRT
+
+OBJECTS=""
+for SOURCE in ${MCFCRT_SOURCES}; do
+	OBJECT="_obj/mcfcrt_$(echo ${SOURCE} | tr '/' '_').o"
+	gcc ${CPPFLAGS} ${CFLAGS} -D__MCFCRT_NO_GENERAL_INCLUDES -I../../MCFCRT/src -include env/_crtdef.h -c ../../MCFCRT/src/${SOURCE} -o ${OBJECT}
+	OBJECTS="${OBJECTS} ${OBJECT}"
+done
+for SOURCE in *.c; do
+	OBJECT="_obj/${SOURCE%.c}.o"
+	gcc ${CPPFLAGS} ${CFLAGS} -I_include -c ${SOURCE} -o ${OBJECT}
+	OBJECTS="${OBJECTS} ${OBJECT}"
+done
+
+gcc ${OBJECTS} ${LDFLAGS} -o linux_test
+./linux_test
@@ -0,0 +1,4 @@
+#!/bin/bash
+
+# ThreadSanitizer 不理解 futex，但能发现普通的数据竞争。
+EXTRA_FLAGS=" -fsanitize=thread -Wno-tsan" exec ./build_x86_64_linux.sh
@@ -0,0 +1,137 @@
+#include <MCFCRT/env/condition_variable.h>
+#include <MCFCRT/env/mutex.h>
+#include <MCFCRT/env/clocks.h>
+#include <MCFCRT/env/thread.h>
+#include "tests.h"
+
+#define CONSUMER_COUNT      16u
+#define ITEMS_PER_CONSUMER  2000u
+// 这个数量超过了能够延迟唤醒的线程数，多出来的线程会被直接唤醒。
+#define BROADCAST_WAITER_COUNT  300u
+
+static _MCFCRT_ConditionVariable g_vCond;
+static _MCFCRT_Mutex g_vMutex;
+static size_t g_uAvailable;
+static size_t g_uConsumed;
+static size_t g_uWaiting;
+static bool g_bGo;
+
+static intptr_t UnlockMutex(intptr_t nContext){
+	_MCFCRT_SignalMutex((_MCFCRT_Mutex *)nContext);
+	return 1;
+}
+static void RelockMutex(intptr_t nContext, intptr_t nUnlocked){
+	(void)nUnlocked;
+	_MCFCRT_WaitForMutexForever((_MCFCRT_Mutex *)nContext, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+}
+
+static unsigned long ConsumerThreadProc(void *pParam){
+	uint32_t u32Seed = (uint32_t)(uintptr_t)pParam;
+	for(unsigned i = 0; i < ITEMS_PER_CONSUMER; ){
+		const uint32_t u32Random = NextRandom(&u32Seed);
+		const size_t uSpinCount = (u32Random & 1) ? _MCFCRT_CONDITION_VARIABLE_SUGGESTED_SPIN_COUNT : 0;
+		_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		bool bTimedOut = false;
+		while(!bTimedOut && (g_uAvailable == 0)){
+			if((u32Random >> 1) % 4 == 0){
+				bTimedOut = !_MCFCRT_WaitForConditionVariable(&g_vCond, &UnlockMutex, &RelockMutex, (intptr_t)&g_vMutex, uSpinCount, _MCFCRT_GetFastMonoClock() + 1);
+			} else {
+				_MCFCRT_WaitForConditionVariableForever(&g_vCond, &UnlockMutex, &RelockMutex, (intptr_t)&g_vMutex, uSpinCount);
+			}
+		}
+		if(!bTimedOut){
+			--g_uAvailable;
+			++g_uConsumed;
+			++i;
+		}
+		_MCFCRT_SignalMutex(&g_vMutex);
+	}
+	return 0;
+}
+static unsigned long ProducerThreadProc(void *pParam){
+	(void)pParam;
+
+	const size_t uTotal = CONSUMER_COUNT * ITEMS_PER_CONSUMER;
+	size_t uProduced = 0;
+	while(uProduced < uTotal){
+		size_t uCount = 1 + uProduced % 37;
+		if(uCount > uTotal - uProduced){
+			uCount = uTotal - uProduced;
+		}
+		_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		g_uAvailable += uCount;
+		uProduced += uCount;
+		if(uProduced % 3 != 0){
+			_MCFCRT_BroadcastConditionVariable(&g_vCond);
+		} else {
+			_MCFCRT_SignalConditionVariable(&g_vCond, uCount);
+		}
+		_MCFCRT_SignalMutex(&g_vMutex);
+		if(uProduced % 5 == 0){
+			_MCFCRT_YieldThread();
+		}
+	}
+	return 0;
+}
+static unsigned long ProducerConsumerThreadProc(void *pParam){
+	const size_t uIndex = (size_t)pParam;
+	if(uIndex == CONSUMER_COUNT){
+		return ProducerThreadProc(pParam);
+	}
+	return ConsumerThreadProc(pParam);
+}
+
+static unsigned long BroadcastWaiterThreadProc(void *pParam){
+	(void)pParam;
+
+	_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+	++g_uWaiting;
+	while(!g_bGo){
+		_MCFCRT_WaitForConditionVariableForever(&g_vCond, &UnlockMutex, &RelockMutex, (intptr_t)&g_vMutex, 0);
+	}
+	++g_uConsumed;
+	_MCFCRT_SignalMutex(&g_vMutex);
+	return 0;
+}
+static unsigned long BroadcastThreadProc(void *pParam){
+	const size_t uIndex = (size_t)pParam;
+	if(uIndex != BROADCAST_WAITER_COUNT){
+		return BroadcastWaiterThreadProc(pParam);
+	}
+	for(;;){
+		_MCFCRT_WaitForMutexForever(&g_vMutex, _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT);
+		const bool bAllWaiting = g_uWaiting == BROADCAST_WAITER_COUNT;
+		if(bAllWaiting){
+			g_bGo = true;
+			_MCFCRT_BroadcastConditionVariable(&g_vCond);
+		}
+		_MCFCRT_SignalMutex(&g_vMutex);
+		if(bAllWaiting){
+			break;
+		}
+		_MCFCRT_YieldThread();
+	}
+	return 0;
+}
+
+bool TestConditionVariable(void){
+	bool bPassed = true;
+
+	_MCFCRT_InitializeConditionVariable(&g_vCond);
+	_MCFCRT_InitializeMutex(&g_vMutex);
+	g_uAvailable = 0;
+	g_uConsumed = 0;
+	RunTestThreads(&ProducerConsumerThreadProc, CONSUMER_COUNT + 1);
+	bPassed &= (g_uConsumed == CONSUMER_COUNT * ITEMS_PER_CONSUMER) && (g_uAvailable == 0);
+
+	g_uConsumed = 0;
+	g_uWaiting = 0;
+	g_bGo = false;
+	RunTestThreads(&BroadcastThreadProc, BROADCAST_WAITER_COUNT + 1);
+	bPassed &= g_uConsumed == BROADCAST_WAITER_COUNT;
+
+	// 没有线程在等待时，条件变量应当只剩下自旋失败计数。
+	bPassed &= (g_vCond.__u & ~(uintptr_t)0xFF) == 0;
+	bPassed &= _MCFCRT_BroadcastConditionVariable(&g_vCond) == 0;
+	return bPassed;
+}
@@ -0,0 +1,249 @@
+#include <MCFCRT/env/fiber.h>
+#include <MCFCRT/env/thread.h>
+#include "tests.h"
+
+#define PING_PONG_COUNT   1000u
+#define RECURSION_DEPTH   40u
+#define FRAME_SIZE        1024u
+#define MIGRATION_COUNT   8u
+
+static _MCFCRT_FiberHandle g_hOuter, g_hInner;
+static volatile unsigned g_uStep;
+static volatile bool g_bFiberPassed;
+static size_t g_uLocalSlot;
+
+// 纤程栈在控制块下面，而栈底还有一个保护页。
+static bool IsOnFiberStack(_MCFCRT_FiberHandle hFiber, const volatile void *pObject){
+	const uintptr_t uTop = (uintptr_t)hFiber;
+	return ((uintptr_t)pObject < uTop) && ((uintptr_t)pObject > uTop - _MCFCRT_FIBER_DEFAULT_STACK_SIZE - 4096);
+}
+
+static void PingPongFiberProc(intptr_t nParam){
+	(void)nParam;
+
+	bool bPassed = _MCFCRT_GetCurrentFiber() == g_hOuter;
+	// 这些值跨越纤程切换保存在寄存器或纤程栈上，切换回来之后必须保持不变。
+	uint32_t u32Seed = 12345;
+	uint64_t u64Sum = 0;
+	uintptr_t uXor = 0;
+	for(unsigned i = 0; i < PING_PONG_COUNT; ++i){
+		bPassed &= g_uStep == i * 2;
+		g_uStep = i * 2 + 1;
+		const uint32_t u32Random = NextRandom(&u32Seed);
+		u64Sum += u32Random;
+		uXor ^= (uintptr_t)u32Random << (i % 8);
+		_MCFCRT_YieldFiber();
+		bPassed &= _MCFCRT_GetCurrentFiber() == g_hOuter;
+	}
+	uint32_t u32Check = 12345;
+	uint64_t u64CheckSum = 0;
+	uintptr_t uCheckXor = 0;
+	for(unsigned i = 0; i < PING_PONG_COUNT; ++i){
+		const uint32_t u32Random = NextRandom(&u32Check);
+		u64CheckSum += u32Random;
+		uCheckXor ^= (uintptr_t)u32Random << (i % 8);
+	}
+	bPassed &= u32Seed == u32Check;
+	bPassed &= u64Sum == u64CheckSum;
+	bPassed &= uXor == uCheckXor;
+	g_bFiberPassed = bPassed;
+}
+
+static bool TestPingPong(void){
+	bool bPassed = true;
+
+	g_uStep = 0;
+	g_bFiberPassed = false;
+	g_hOuter = _MCFCRT_CreateFiber(&PingPongFiberProc, 0, 0);
+	if(!g_hOuter){
+		return false;
+	}
+	bPassed &= _MCFCRT_GetCurrentFiber() == _MCFCRT_NULLPTR;
+	// 恢复者的局部变量也必须保持不变。
+	volatile char chMarker = 'm';
+	unsigned uResumed = 0;
+	while(!_MCFCRT_ResumeFiber(g_hOuter)){
+		bPassed &= _MCFCRT_GetCurrentFiber() == _MCFCRT_NULLPTR;
+		bPassed &= !_MCFCRT_IsFiberFinished(g_hOuter);
+		bPassed &= g_uStep == uResumed * 2 + 1;
+		++uResumed;
+		g_uStep = uResumed * 2;
+	}
+	bPassed &= chMarker == 'm';
+	bPassed &= uResumed == PING_PONG_COUNT;
+	bPassed &= _MCFCRT_IsFiberFinished(g_hOuter);
+	bPassed &= _MCFCRT_GetCurrentFiber() == _MCFCRT_NULLPTR;
+	bPassed &= g_bFiberPassed;
+	_MCFCRT_DestroyFiber(g_hOuter);
+	return bPassed;
+}
+
+__attribute__((__noinline__)) static unsigned Recurse(unsigned uDepth){
+	volatile unsigned char abyFrame[FRAME_SIZE];
+	for(size_t i = 0; i < sizeof(abyFrame); ++i){
+		abyFrame[i] = (unsigned char)(uDepth + i);
+	}
+	if(!IsOnFiberStack(_MCFCRT_GetCurrentFiber(), abyFrame)){
+		return 0;
+	}
+	unsigned uResult = 1;
+	if(uDepth != 0){
+		// 在最深处让出，之后各栈帧的内容必须保持不变。
+		uResult = Recurse(uDepth - 1);
+	} else {
+		_MCFCRT_YieldFiber();
+	}
+	for(size_t i = 0; i < sizeof(abyFrame); ++i){
+		if(abyFrame[i] != (unsigned char)(uDepth + i)){
+			return 0;
+		}
+	}
+	return uResult;
+}
+static void DeepFiberProc(intptr_t nParam){
+	(void)nParam;
+
+	g_bFiberPassed = Recurse(RECURSION_DEPTH) == 1;
+}
+
+static bool TestDeepStack(void){
+	bool bPassed = true;
+
+	g_bFiberPassed = false;
+	g_hOuter = _MCFCRT_CreateFiber(&DeepFiberProc, 0, 0);
+	if(!g_hOuter){
+		return false;
+	}
+	bPassed &= !_MCFCRT_ResumeFiber(g_hOuter);
+	// 在纤程让出期间使用调用者的栈，不能破坏纤程栈。
+	volatile unsigned char abyScratch[FRAME_SIZE * 4];
+	for(size_t i = 0; i < sizeof(abyScratch); ++i){
+		abyScratch[i] = 0xCC;
+	}
+	bPassed &= !IsOnFiberStack(g_hOuter, abyScratch);
+	bPassed &= _MCFCRT_ResumeFiber(g_hOuter);
+	bPassed &= g_bFiberPassed;
+	_MCFCRT_DestroyFiber(g_hOuter);
+	return bPassed;
+}
+
+static void InnerFiberProc(intptr_t nParam){
+	bool bPassed = _MCFCRT_GetCurrentFiber() == g_hInner;
+	bPassed &= _MCFCRT_GetFiberLocal(g_hInner, g_uLocalSlot) == 0;
+	_MCFCRT_SetFiberLocal(g_hInner, g_uLocalSlot, nParam);
+	_MCFCRT_YieldFiber();
+	bPassed &= _MCFCRT_GetCurrentFiber() == g_hInner;
+	bPassed &= _MCFCRT_GetFiberLocal(_MCFCRT_GetCurrentFiber(), g_uLocalSlot) == nParam;
+	g_bFiberPassed = bPassed;
+}
+static void OuterFiberProc(intptr_t nParam){
+	bool bPassed = _MCFCRT_GetCurrentFiber() == g_hOuter;
+	_MCFCRT_SetFiberLocal(g_hOuter, g_uLocalSlot, nParam);
+	// 内层纤程让出之后，控制权回到外层纤程而不是线程。
+	bPassed &= !_MCFCRT_ResumeFiber(g_hInner);
+	bPassed &= _MCFCRT_GetCurrentFiber() == g_hOuter;
+	bPassed &= _MCFCRT_GetFiberLocal(g_hInner, g_uLocalSlot) == nParam + 1;
+	_MCFCRT_YieldFiber();
+	bPassed &= _MCFCRT_GetCurrentFiber() == g_hOuter;
+	bPassed &= _MCFCRT_GetFiberLocal(_MCFCRT_GetCurrentFiber(), g_uLocalSlot) == nParam;
+	g_bFiberPassed = false;
+	bPassed &= _MCFCRT_ResumeFiber(g_hInner);
+	bPassed &= g_bFiberPassed;
+	bPassed &= _MCFCRT_GetCurrentFiber() == g_hOuter;
+	g_bFiberPassed = bPassed;
+}
+
+static bool TestNestedFibersAndLocals(void){
+	bool bPassed = true;
+
+	if(!_MCFCRT_AllocFiberLocalSlot(&g_uLocalSlot)){
+		return false;
+	}
+	g_bFiberPassed = false;
+	g_hOuter = _MCFCRT_CreateFiber(&OuterFiberProc, 100, 0);
+	if(!g_hOuter){
+		return false;
+	}
+	g_hInner = _MCFCRT_CreateFiber(&InnerFiberProc, 101, 0);
+	if(!g_hInner){
+		_MCFCRT_DestroyFiber(g_hOuter);
+		return false;
+	}
+	bPassed &= _MCFCRT_GetFiberLocal(g_hOuter, g_uLocalSlot) == 0;
+	bPassed &= !_MCFCRT_ResumeFiber(g_hOuter);
+	bPassed &= _MCFCRT_GetCurrentFiber() == _MCFCRT_NULLPTR;
+	bPassed &= _MCFCRT_GetFiberLocal(g_hOuter, g_uLocalSlot) == 100;
+	bPassed &= _MCFCRT_GetFiberLocal(g_hInner, g_uLocalSlot) == 101;
+	bPassed &= _MCFCRT_ResumeFiber(g_hOuter);
+	bPassed &= _MCFCRT_IsFiberFinished(g_hInner);
+	bPassed &= g_bFiberPassed;
+	_MCFCRT_DestroyFiber(g_hInner);
+	_MCFCRT_DestroyFiber(g_hOuter);
+
+	// 槽位用尽之后分配失败。
+	size_t uSlot;
+	size_t uAllocated = 1;
+	while(_MCFCRT_AllocFiberLocalSlot(&uSlot)){
+		bPassed &= uSlot < _MCFCRT_FIBER_LOCAL_SLOT_COUNT;
+		++uAllocated;
+	}
+	bPassed &= uAllocated <= _MCFCRT_FIBER_LOCAL_SLOT_COUNT;
+	return bPassed;
+}
+
+static volatile size_t g_uResumerFailures;
+
+static void MigratingFiberProc(intptr_t nParam){
+	(void)nParam;
+
+	bool bPassed = true;
+	for(unsigned i = 0; i < MIGRATION_COUNT; ++i){
+		// 每次恢复都在另一个线程上，线程局部的当前纤程指针必须重新计算。
+		bPassed &= _MCFCRT_GetCurrentFiber() == g_hOuter;
+		_MCFCRT_YieldFiber();
+	}
+	bPassed &= _MCFCRT_GetCurrentFiber() == g_hOuter;
+	g_bFiberPassed = bPassed;
+}
+static unsigned long ResumerThreadProc(void *pParam){
+	(void)pParam;
+
+	if(_MCFCRT_GetCurrentFiber() != _MCFCRT_NULLPTR){
+		__atomic_add_fetch(&g_uResumerFailures, 1, __ATOMIC_RELAXED);
+	}
+	if(_MCFCRT_ResumeFiber(g_hOuter)){
+		__atomic_add_fetch(&g_uResumerFailures, 1, __ATOMIC_RELAXED);
+	}
+	if(_MCFCRT_GetCurrentFiber() != _MCFCRT_NULLPTR){
+		__atomic_add_fetch(&g_uResumerFailures, 1, __ATOMIC_RELAXED);
+	}
+	return 0;
+}
+
+static bool TestMigration(void){
+	bool bPassed = true;
+
+	g_uResumerFailures = 0;
+	g_bFiberPassed = false;
+	g_hOuter = _MCFCRT_CreateFiber(&MigratingFiberProc, 0, 0);
+	if(!g_hOuter){
+		return false;
+	}
+	for(unsigned i = 0; i < MIGRATION_COUNT; ++i){
+		RunTestThreads(&ResumerThreadProc, 1);
+	}
+	bPassed &= _MCFCRT_ResumeFiber(g_hOuter);
+	bPassed &= g_bFiberPassed;
+	bPassed &= __atomic_load_n(&g_uResumerFailures, __ATOMIC_RELAXED) == 0;
+	_MCFCRT_DestroyFiber(g_hOuter);
+	return bPassed;
+}
+
+bool TestFiber(void){
+	bool bPassed = true;
+	bPassed &= TestPingPong();
+	bPassed &= TestDeepStack();
+	bPassed &= TestNestedFibersAndLocals();
+	bPassed &= TestMigration();
+	return bPassed;
+}
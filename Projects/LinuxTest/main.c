@@ -0,0 +1,51 @@
+#include <MCFCRT/env/thread.h>
+#include <MCFCRT/env/bail.h>
+#include <stdio.h>
+#include "tests.h"
+
+void RunTestThreads(TestThreadProc pfnProc, size_t uCount){
+	_MCFCRT_ThreadHandle ahThreads[1024];
+	if(uCount > sizeof(ahThreads) / sizeof(ahThreads[0])){
+		_MCFCRT_Bail(L"线程太多。");
+	}
+	for(size_t i = 0; i < uCount; ++i){
+		ahThreads[i] = _MCFCRT_CreateNativeThread(pfnProc, (void *)i, false, _MCFCRT_NULLPTR);
+		if(!ahThreads[i]){
+			_MCFCRT_Bail(L"_MCFCRT_CreateNativeThread() 失败。");
+		}
+	}
+	for(size_t i = 0; i < uCount; ++i){
+		_MCFCRT_WaitForThreadForever(ahThreads[i]);
+		_MCFCRT_CloseThread(ahThreads[i]);
+	}
+}
+uint32_t NextRandom(uint32_t *pu32Seed){
+	*pu32Seed = *pu32Seed * 1664525u + 1013904223u;
+	return *pu32Seed >> 8;
+}
+
+static const struct {
+	const char *pszName;
+	bool (*pfnTest)(void);
+} kTests[] = {
+	{ "thread",             &TestThread             },
+	{ "mutex",              &TestMutex              },
+	{ "fair_mutex",         &TestFairMutex          },
+	{ "condition_variable", &TestConditionVariable  },
+	{ "rwlock",             &TestRwLock             },
+	{ "wait_on_address",    &TestWaitOnAddress      },
+	{ "semaphore",          &TestSemaphore          },
+	{ "fiber",              &TestFiber              },
+	{ "string",             &TestString             },
+};
+
+int main(void){
+	unsigned uFailures = 0;
+	for(size_t i = 0; i < sizeof(kTests) / sizeof(kTests[0]); ++i){
+		const bool bPassed = (*(kTests[i].pfnTest))();
+		printf("%-20s %s\n", kTests[i].pszName, bPassed ? "passed" : "FAILED");
+		fflush(stdout);
+		uFailures += !bPassed;
+	}
+	return uFailures != 0;
+}
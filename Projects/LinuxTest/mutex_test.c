@@ -0,0 +1,92 @@
+#include <MCFCRT/env/mutex.h>
+#include <MCFCRT/env/fair_mutex.h>
+#include <MCFCRT/env/clocks.h>
+#include <MCFCRT/env/thread.h>
+#include "tests.h"
+
+#define THREAD_COUNT    8u
+#define LOOP_COUNT      20000u
+
+static _MCFCRT_Mutex g_vMutex;
+static _MCFCRT_FairMutex g_vFairMutex;
+static volatile size_t g_uInside;
+static volatile size_t g_uViolations;
+static size_t g_uCounter;
+
+static void EnterCriticalSection(uint32_t u32Random){
+	if(__atomic_add_fetch(&g_uInside, 1, __ATOMIC_RELAXED) != 1){
+		__atomic_add_fetch(&g_uViolations, 1, __ATOMIC_RELAXED);
+	}
+	++g_uCounter;
+	if(u32Random % 64 == 0){
+		_MCFCRT_YieldThread();
+	}
+	__atomic_sub_fetch(&g_uInside, 1, __ATOMIC_RELAXED);
+}
+
+static unsigned long MutexThreadProc(void *pParam){
+	uint32_t u32Seed = (uint32_t)(uintptr_t)pParam;
+	for(unsigned i = 0; i < LOOP_COUNT; ++i){
+		const uint32_t u32Random = NextRandom(&u32Seed);
+		const size_t uSpinCount = (u32Random & 1) ? _MCFCRT_MUTEX_SUGGESTED_SPIN_COUNT : 0;
+		switch((u32Random >> 1) % 8){
+		case 0:
+			// 尝试加锁，失败则重试。
+			if(!_MCFCRT_WaitForMutex(&g_vMutex, 0, 0)){
+				--i;
+				continue;
+			}
+			break;
+		case 1:
+			// 带超时的等待。
+			if(!_MCFCRT_WaitForMutex(&g_vMutex, uSpinCount, _MCFCRT_GetFastMonoClock() + 1)){
+				--i;
+				continue;
+			}
+			break;
+		default:
+			_MCFCRT_WaitForMutexForever(&g_vMutex, uSpinCount);
+			break;
+		}
+		EnterCriticalSection(u32Random);
+		_MCFCRT_SignalMutex(&g_vMutex);
+	}
+	return 0;
+}
+static unsigned long FairMutexThreadProc(void *pParam){
+	uint32_t u32Seed = (uint32_t)(uintptr_t)pParam;
+	for(unsigned i = 0; i < LOOP_COUNT; ++i){
+		const uint32_t u32Random = NextRandom(&u32Seed);
+		if(u32Random % 16 == 0){
+			if(!_MCFCRT_WaitForFairMutex(&g_vFairMutex, _MCFCRT_GetFastMonoClock() + 1)){
+				--i;
+				continue;
+			}
+		} else {
+			_MCFCRT_WaitForFairMutexForever(&g_vFairMutex, (u32Random & 1) ? _MCFCRT_FAIR_MUTEX_SUGGESTED_SPIN_COUNT : 0);
+		}
+		EnterCriticalSection(u32Random);
+		_MCFCRT_SignalFairMutex(&g_vFairMutex);
+	}
+	return 0;
+}
+
+bool TestMutex(void){
+	_MCFCRT_InitializeMutex(&g_vMutex);
+	g_uViolations = 0;
+	g_uCounter = 0;
+	RunTestThreads(&MutexThreadProc, THREAD_COUNT);
+	// 所有线程都退出之后，互斥锁应当回到初始状态。
+	return (g_uViolations == 0) && (g_uCounter == THREAD_COUNT * LOOP_COUNT) && (g_vMutex.__u == 0);
+}
+bool TestFairMutex(void){
+	_MCFCRT_InitializeFairMutex(&g_vFairMutex);
+	g_uViolations = 0;
+	g_uCounter = 0;
+	RunTestThreads(&FairMutexThreadProc, THREAD_COUNT);
+	bool bPassed = (g_uViolations == 0) && (g_uCounter == THREAD_COUNT * LOOP_COUNT);
+	bPassed &= _MCFCRT_WaitForFairMutex(&g_vFairMutex, 0);
+	bPassed &= !_MCFCRT_WaitForFairMutex(&g_vFairMutex, 0);
+	_MCFCRT_SignalFairMutex(&g_vFairMutex);
+	return bPassed;
+}
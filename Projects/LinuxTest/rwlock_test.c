@@ -0,0 +1,93 @@
+#include <MCFCRT/env/rwlock.h>
+#include <MCFCRT/env/clocks.h>
+#include <MCFCRT/env/thread.h>
+#include "tests.h"
+
+#define THREAD_COUNT    12u
+#define LOOP_COUNT      10000u
+
+static _MCFCRT_RwLock g_vLock;
+static volatile size_t g_uReaders;
+static volatile size_t g_uWriters;
+static volatile size_t g_uViolations;
+static size_t g_uData;
+
+static void CheckShared(void){
+	if(__atomic_load_n(&g_uWriters, __ATOMIC_RELAXED) != 0){
+		__atomic_add_fetch(&g_uViolations, 1, __ATOMIC_RELAXED);
+	}
+}
+static void CheckExclusive(void){
+	if((__atomic_load_n(&g_uReaders, __ATOMIC_RELAXED) != 0) || (__atomic_load_n(&g_uWriters, __ATOMIC_RELAXED) != 1)){
+		__atomic_add_fetch(&g_uViolations, 1, __ATOMIC_RELAXED);
+	}
+}
+
+static void ReadThenUnlock(void){
+	__atomic_add_fetch(&g_uReaders, 1, __ATOMIC_RELAXED);
+	CheckShared();
+	__atomic_sub_fetch(&g_uReaders, 1, __ATOMIC_RELAXED);
+	_MCFCRT_SignalRwLockShared(&g_vLock);
+}
+static void WriteThenUnlock(uint32_t u32Random){
+	__atomic_add_fetch(&g_uWriters, 1, __ATOMIC_RELAXED);
+	CheckExclusive();
+	++g_uData;
+	if(u32Random % 3 == 0){
+		_MCFCRT_YieldThread();
+	}
+	CheckExclusive();
+	__atomic_sub_fetch(&g_uWriters, 1, __ATOMIC_RELAXED);
+	if(u32Random % 7 == 0){
+		_MCFCRT_DowngradeRwLock(&g_vLock);
+		ReadThenUnlock();
+	} else {
+		_MCFCRT_SignalRwLockExclusive(&g_vLock);
+	}
+}
+
+static unsigned long RwLockThreadProc(void *pParam){
+	uint32_t u32Seed = (uint32_t)(uintptr_t)pParam;
+	for(unsigned i = 0; i < LOOP_COUNT; ++i){
+		const uint32_t u32Random = NextRandom(&u32Seed);
+		const size_t uSpinCount = (u32Random & 1) ? _MCFCRT_RWLOCK_SUGGESTED_SPIN_COUNT : 0;
+		const unsigned uAction = (u32Random >> 1) % 100;
+		if(uAction < 60){
+			if(uAction < 5){
+				if(!_MCFCRT_WaitForRwLockShared(&g_vLock, uSpinCount, _MCFCRT_GetFastMonoClock() + 1)){
+					continue;
+				}
+			} else {
+				_MCFCRT_WaitForRwLockSharedForever(&g_vLock, uSpinCount);
+			}
+			if(uAction % 10 == 1){
+				// 尝试升级为写锁。只能有一个升级在进行中，失败时仍然持有读锁。
+				if(_MCFCRT_UpgradeRwLock(&g_vLock, uSpinCount)){
+					WriteThenUnlock(u32Random);
+				} else {
+					ReadThenUnlock();
+				}
+			} else {
+				ReadThenUnlock();
+			}
+		} else {
+			if(uAction < 65){
+				if(!_MCFCRT_WaitForRwLockExclusive(&g_vLock, uSpinCount, _MCFCRT_GetFastMonoClock() + 1)){
+					continue;
+				}
+			} else {
+				_MCFCRT_WaitForRwLockExclusiveForever(&g_vLock, uSpinCount);
+			}
+			WriteThenUnlock(u32Random);
+		}
+	}
+	return 0;
+}
+
+bool TestRwLock(void){
+	_MCFCRT_InitializeRwLock(&g_vLock);
+	g_uViolations = 0;
+	g_uData = 0;
+	RunTestThreads(&RwLockThreadProc, THREAD_COUNT);
+	return (g_uViolations == 0) && (g_uData != 0) && (g_vLock.__u64 == 0);
+}
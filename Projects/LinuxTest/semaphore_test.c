@@ -0,0 +1,99 @@
+#include <MCFCRT/env/semaphore.h>
+#include <MCFCRT/env/latch.h>
+#include <MCFCRT/env/barrier.h>
+#include <MCFCRT/env/clocks.h>
+#include <MCFCRT/env/thread.h>
+#include "tests.h"
+
+#define CONSUMER_COUNT  12u
+#define PHASE_COUNT     2000u
+#define ITEM_COUNT      5000u
+
+static _MCFCRT_Semaphore g_vSemaphore;
+static _MCFCRT_Latch g_vLatch;
+static _MCFCRT_Barrier g_vBarrier;
+static volatile size_t g_uItemsTaken;
+static volatile size_t g_uSerialThreads;
+static volatile size_t g_uViolations;
+static volatile unsigned g_auPhases[CONSUMER_COUNT];
+
+static unsigned long ConsumerThreadProc(void *pParam){
+	const size_t uIndex = (size_t)pParam;
+	uint32_t u32Seed = (uint32_t)uIndex;
+	_MCFCRT_CountDownLatch(&g_vLatch, 1);
+	// 所有线程都到达屏障之前，没有线程可以越过它。
+	for(unsigned uPhase = 0; uPhase < PHASE_COUNT; ++uPhase){
+		__atomic_store_n(&g_auPhases[uIndex], uPhase, __ATOMIC_RELAXED);
+		const size_t uSpinCount = (NextRandom(&u32Seed) & 1) ? _MCFCRT_BARRIER_SUGGESTED_SPIN_COUNT : 0;
+		if(_MCFCRT_ArriveAtBarrierAndWait(&g_vBarrier, uSpinCount)){
+			__atomic_add_fetch(&g_uSerialThreads, 1, __ATOMIC_RELAXED);
+		}
+		for(size_t i = 0; i < CONSUMER_COUNT; ++i){
+			if(__atomic_load_n(&g_auPhases[i], __ATOMIC_RELAXED) < uPhase){
+				__atomic_add_fetch(&g_uViolations, 1, __ATOMIC_RELAXED);
+			}
+		}
+	}
+	for(unsigned uTaken = 0; uTaken < ITEM_COUNT; ){
+		const uint32_t u32Random = NextRandom(&u32Seed);
+		const size_t uSpinCount = (u32Random & 1) ? _MCFCRT_SEMAPHORE_SUGGESTED_SPIN_COUNT : 0;
+		if((u32Random >> 1) % 4 == 0){
+			if(!_MCFCRT_WaitForSemaphore(&g_vSemaphore, uSpinCount, _MCFCRT_GetFastMonoClock() + 1)){
+				continue;
+			}
+		} else {
+			_MCFCRT_WaitForSemaphoreForever(&g_vSemaphore, uSpinCount);
+		}
+		__atomic_add_fetch(&g_uItemsTaken, 1, __ATOMIC_RELAXED);
+		++uTaken;
+	}
+	return 0;
+}
+static unsigned long ProducerThreadProc(void *pParam){
+	(void)pParam;
+
+	_MCFCRT_WaitForLatchForever(&g_vLatch);
+	size_t uPosted = 0;
+	while(uPosted < CONSUMER_COUNT * ITEM_COUNT){
+		size_t uCount = 1 + uPosted % 7;
+		if(uCount > CONSUMER_COUNT * ITEM_COUNT - uPosted){
+			uCount = CONSUMER_COUNT * ITEM_COUNT - uPosted;
+		}
+		_MCFCRT_PostSemaphore(&g_vSemaphore, uCount);
+		uPosted += uCount;
+		if(uPosted % 13 == 0){
+			_MCFCRT_YieldThread();
+		}
+	}
+	return 0;
+}
+static unsigned long SemaphoreThreadProc(void *pParam){
+	const size_t uIndex = (size_t)pParam;
+	if(uIndex == CONSUMER_COUNT){
+		return ProducerThreadProc(pParam);
+	}
+	return ConsumerThreadProc(pParam);
+}
+
+bool TestSemaphore(void){
+	bool bPassed = true;
+
+	_MCFCRT_InitializeSemaphore(&g_vSemaphore, 0);
+	_MCFCRT_InitializeLatch(&g_vLatch, CONSUMER_COUNT);
+	_MCFCRT_InitializeBarrier(&g_vBarrier, CONSUMER_COUNT);
+	RunTestThreads(&SemaphoreThreadProc, CONSUMER_COUNT + 1);
+	bPassed &= g_uItemsTaken == CONSUMER_COUNT * ITEM_COUNT;
+	// 每个阶段恰好有一个线程得到 true。
+	bPassed &= g_uSerialThreads == PHASE_COUNT;
+	bPassed &= g_uViolations == 0;
+	bPassed &= (g_vSemaphore.__uCount == 0) && (g_vSemaphore.__uWaiting == 0);
+	bPassed &= !_MCFCRT_WaitForSemaphore(&g_vSemaphore, 0, _MCFCRT_GetFastMonoClock() + 5);
+
+	// 会导致计数溢出的 post 不修改计数。
+	size_t uOldCount;
+	_MCFCRT_InitializeSemaphore(&g_vSemaphore, SIZE_MAX - 2);
+	bPassed &= !_MCFCRT_TryPostSemaphore(&g_vSemaphore, &uOldCount, 3) && (uOldCount == SIZE_MAX - 2);
+	bPassed &= _MCFCRT_TryPostSemaphore(&g_vSemaphore, &uOldCount, 2) && (uOldCount == SIZE_MAX - 2);
+	bPassed &= !_MCFCRT_TryPostSemaphore(&g_vSemaphore, &uOldCount, 1) && (g_vSemaphore.__uCount == SIZE_MAX);
+	return bPassed;
+}
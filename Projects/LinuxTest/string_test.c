@@ -0,0 +1,317 @@
+#include <MCFCRT/env/cpu.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "tests.h"
+
+// 直接包含字符串函数的源文件，以便按指定的 CPU 特性选择实现并调用。
+// 分发函数本身与 C 库中的同名函数冲突，因此不生成。
+#undef _MCFCRT_CPU_DISPATCH
+#define _MCFCRT_CPU_DISPATCH(__ret_, __name_, __params_, __args_, __select_)
+
+// ELF 不支持 `__selectany__`。所有源文件都在这一个翻译单元中，因此不需要它。
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wattributes"
+#include <MCFCRT/stdc/string/memchr.c>
+#include <MCFCRT/stdc/string/memcmp.c>
+#include <MCFCRT/stdc/string/memset.c>
+#include <MCFCRT/stdc/string/strchr.c>
+#include <MCFCRT/stdc/string/strcmp.c>
+#include <MCFCRT/stdc/string/strncmp.c>
+#include <MCFCRT/ext/rawmemchr.c>
+#pragma GCC diagnostic pop
+
+#define ITERATION_COUNT  50000u
+#define REPORT_LIMIT     10u
+
+static const struct {
+	const char *pszName;
+	uint32_t u32Features;
+} kLevels[] = {
+	{ "sse2",     0 },
+	{ "avx2",     1u << _MCFCRT_kCpuFeatureAvx2 },
+	{ "avx512bw", (1u << _MCFCRT_kCpuFeatureAvx2) | (1u << _MCFCRT_kCpuFeatureAvx512f) | (1u << _MCFCRT_kCpuFeatureAvx512bw) },
+};
+
+typedef struct tagKernels {
+	Memchr *pfnMemchr;
+	Rawmemchr *pfnRawmemchr;
+	Strchr *pfnStrchr;
+	Memcmp *pfnMemcmp;
+	Strcmp *pfnStrcmp;
+	Strncmp *pfnStrncmp;
+	Memset *pfnMemset;
+} Kernels;
+
+static void SelectKernels(Kernels *pKernels, uint32_t u32Features){
+	pKernels->pfnMemchr    = SelectMemchr(u32Features);
+	pKernels->pfnRawmemchr = SelectRawmemchr(u32Features);
+	pKernels->pfnStrchr    = SelectStrchr(u32Features);
+	pKernels->pfnMemcmp    = SelectMemcmp(u32Features);
+	pKernels->pfnStrcmp    = SelectStrcmp(u32Features);
+	pKernels->pfnStrncmp   = SelectStrncmp(u32Features);
+	pKernels->pfnMemset    = SelectMemset(u32Features);
+}
+
+// 朴素的参考实现。这里不能调用 C 库，编译器也可能把循环替换成库函数调用，因此使用 volatile。
+static const unsigned char *NaiveMemchr(const unsigned char *s, int c, size_t n){
+	for(size_t i = 0; i < n; ++i){
+		if(((const volatile unsigned char *)s)[i] == (unsigned char)c){
+			return s + i;
+		}
+	}
+	return _MCFCRT_NULLPTR;
+}
+static int NaiveMemcmp(const unsigned char *s1, const unsigned char *s2, size_t n){
+	for(size_t i = 0; i < n; ++i){
+		const int d = ((const volatile unsigned char *)s1)[i] - ((const volatile unsigned char *)s2)[i];
+		if(d != 0){
+			return d;
+		}
+	}
+	return 0;
+}
+static int NaiveStrncmp(const unsigned char *s1, const unsigned char *s2, size_t n){
+	for(size_t i = 0; i < n; ++i){
+		const int d = ((const volatile unsigned char *)s1)[i] - ((const volatile unsigned char *)s2)[i];
+		if((d != 0) || (s1[i] == 0)){
+			return d;
+		}
+	}
+	return 0;
+}
+static size_t NaiveStrlen(const unsigned char *s){
+	size_t n = 0;
+	while(((const volatile unsigned char *)s)[n] != 0){
+		++n;
+	}
+	return n;
+}
+static void NaiveFill(unsigned char *s, unsigned char c, size_t n){
+	for(size_t i = 0; i < n; ++i){
+		((volatile unsigned char *)s)[i] = c;
+	}
+}
+static void NaiveCopy(unsigned char *d, const unsigned char *s, size_t n){
+	for(size_t i = 0; i < n; ++i){
+		((volatile unsigned char *)d)[i] = s[i];
+	}
+}
+static int Sign(int n){
+	return (n > 0) - (n < 0);
+}
+
+// 每块数据的前后都是不可访问的保护页，读写越界会立即导致段错误。
+typedef struct tagRegion {
+	unsigned char *pbyBegin;
+	size_t uSize;
+} Region;
+
+static bool CreateRegion(Region *pRegion, size_t uPageSize, size_t uPageCount){
+	unsigned char *const pbyBase = mmap(_MCFCRT_NULLPTR, uPageSize * (uPageCount + 2), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(pbyBase == MAP_FAILED){
+		return false;
+	}
+	if((mprotect(pbyBase, uPageSize, PROT_NONE) != 0) || (mprotect(pbyBase + uPageSize * (uPageCount + 1), uPageSize, PROT_NONE) != 0)){
+		munmap(pbyBase, uPageSize * (uPageCount + 2));
+		return false;
+	}
+	pRegion->pbyBegin = pbyBase + uPageSize;
+	pRegion->uSize = uPageSize * uPageCount;
+	return true;
+}
+static void DestroyRegion(const Region *pRegion, size_t uPageSize){
+	munmap(pRegion->pbyBegin - uPageSize, pRegion->uSize + uPageSize * 2);
+}
+
+// 多数长度很短，因为短串的首尾处理最容易出错；偶尔会有跨越多页的长串。
+static size_t RandomLength(uint32_t *pu32Seed, size_t uMax){
+	const uint32_t u32Kind = NextRandom(pu32Seed) % 16;
+	size_t uLength;
+	if(u32Kind < 10){
+		uLength = NextRandom(pu32Seed) % 130;
+	} else if(u32Kind < 15){
+		uLength = NextRandom(pu32Seed) % 600;
+	} else {
+		uLength = NextRandom(pu32Seed) % (uMax + 1);
+	}
+	return (uLength < uMax) ? uLength : uMax;
+}
+// 字符集中的字符很少，以便制造较长的公共前缀和多次匹配。
+static unsigned char RandomChar(uint32_t *pu32Seed){
+	const uint32_t u32Kind = NextRandom(pu32Seed) % 8;
+	if(u32Kind < 6){
+		return (unsigned char)"abcx"[u32Kind % 4];
+	}
+	return (unsigned char)(NextRandom(pu32Seed) % 255 + 1);
+}
+// 把长度为 uLength 的块放在区域的开头附近、紧贴区域的末尾，或者区域中的任意位置，以覆盖各种对齐方式。
+static unsigned char *PlaceBlock(uint32_t *pu32Seed, const Region *pRegion, size_t uLength){
+	const size_t uRoom = pRegion->uSize - uLength + 1;
+	switch(NextRandom(pu32Seed) % 3){
+	case 0:
+		return pRegion->pbyBegin + NextRandom(pu32Seed) % ((uRoom < 128) ? uRoom : 128);
+	case 1:
+		return pRegion->pbyBegin + pRegion->uSize - uLength;
+	default:
+		return pRegion->pbyBegin + NextRandom(pu32Seed) % uRoom;
+	}
+}
+
+static unsigned g_uMismatches;
+
+static bool Check(bool bMatched, const char *pszLevel, const char *pszFunction, uint32_t u32Iteration){
+	if(!bMatched){
+		if(g_uMismatches < REPORT_LIMIT){
+			printf("  %s: %s mismatch at iteration %u\n", pszLevel, pszFunction, (unsigned)u32Iteration);
+		}
+		++g_uMismatches;
+	}
+	return bMatched;
+}
+
+static void TestLevel(const char *pszLevel, const Kernels *pTest, const Kernels *pBase, const Region *pRegions, uint32_t u32Seed){
+	const Region *const pRegion1 = pRegions + 0;
+	const Region *const pRegion2 = pRegions + 1;
+	const Region *const pRegion3 = pRegions + 2;
+
+	for(uint32_t u32Iteration = 0; u32Iteration < ITERATION_COUNT; ++u32Iteration){
+		// 第一个字符串。
+		const size_t uLength1 = RandomLength(&u32Seed, pRegion1->uSize - 1);
+		unsigned char *const s1 = PlaceBlock(&u32Seed, pRegion1, uLength1 + 1);
+		for(size_t i = 0; i < uLength1; ++i){
+			s1[i] = RandomChar(&u32Seed);
+		}
+		s1[uLength1] = 0;
+		const int c = (NextRandom(&u32Seed) % 4 == 0) ? 0 : RandomChar(&u32Seed);
+
+		// memchr() 分别查找到字符串末尾，以及一直查找到区域末尾。
+		const size_t auMemchrLengths[] = { uLength1, (size_t)(pRegion1->pbyBegin + pRegion1->uSize - s1) };
+		for(size_t k = 0; k < sizeof(auMemchrLengths) / sizeof(auMemchrLengths[0]); ++k){
+			const void *const pExpected = NaiveMemchr(s1, c, auMemchrLengths[k]);
+			Check((*(pTest->pfnMemchr))(s1, c, auMemchrLengths[k]) == pExpected, pszLevel, "memchr", u32Iteration);
+			Check((*(pBase->pfnMemchr))(s1, c, auMemchrLengths[k]) == pExpected, pszLevel, "memchr (sse2)", u32Iteration);
+		}
+		// rawmemchr() 和 strchr() 的结果必须在字符串之内，否则就越界了。
+		const void *const pTerminator = (*(pTest->pfnRawmemchr))(s1, 0);
+		Check(pTerminator == s1 + uLength1, pszLevel, "rawmemchr", u32Iteration);
+		const unsigned char *const pFound = NaiveMemchr(s1, c, uLength1 + 1);
+		if(pFound){
+			Check((*(pTest->pfnRawmemchr))(s1, c) == pFound, pszLevel, "rawmemchr", u32Iteration);
+			Check((*(pBase->pfnRawmemchr))(s1, c) == pFound, pszLevel, "rawmemchr (sse2)", u32Iteration);
+		}
+		Check((*(pTest->pfnStrchr))((const char *)s1, c) == (const char *)pFound, pszLevel, "strchr", u32Iteration);
+		Check((*(pBase->pfnStrchr))((const char *)s1, c) == (const char *)pFound, pszLevel, "strchr (sse2)", u32Iteration);
+
+		// 第二个字符串是第一个的副本，可能被截短、加长，或者修改了一个字节。
+		const uint32_t u32Mode = NextRandom(&u32Seed) % 5;
+		size_t uLength2 = uLength1;
+		if((u32Mode == 1) && (uLength2 != 0)){
+			uLength2 = NextRandom(&u32Seed) % uLength2;
+		} else if(u32Mode == 2){
+			uLength2 += NextRandom(&u32Seed) % 20;
+		}
+		if(uLength2 > pRegion2->uSize - 1){
+			uLength2 = pRegion2->uSize - 1;
+		}
+		unsigned char *const s2 = PlaceBlock(&u32Seed, pRegion2, uLength2 + 1);
+		NaiveCopy(s2, s1, (uLength2 < uLength1) ? uLength2 : uLength1);
+		for(size_t i = uLength1; i < uLength2; ++i){
+			s2[i] = RandomChar(&u32Seed);
+		}
+		s2[uLength2] = 0;
+		if((u32Mode == 3) && (uLength2 != 0)){
+			s2[NextRandom(&u32Seed) % uLength2] = RandomChar(&u32Seed);
+		} else if((u32Mode == 4) && (uLength2 != 0)){
+			// 翻转最高位，检查比较是否按无符号字节进行。
+			const size_t uPos = NextRandom(&u32Seed) % uLength2;
+			s2[uPos] ^= 0x80;
+			if(s2[uPos] == 0){
+				s2[uPos] = 1;
+			}
+		}
+		const size_t uLength2Actual = NaiveStrlen(s2);
+
+		// strcmp() 两个方向都要比较。
+		for(unsigned uSwap = 0; uSwap < 2; ++uSwap){
+			const unsigned char *const a = uSwap ? s2 : s1;
+			const unsigned char *const b = uSwap ? s1 : s2;
+			const size_t uLengthA = uSwap ? uLength2Actual : uLength1;
+			const int nExpected = Sign(NaiveStrncmp(a, b, uLengthA + 1));
+			Check(Sign((*(pTest->pfnStrcmp))((const char *)a, (const char *)b)) == nExpected, pszLevel, "strcmp", u32Iteration);
+			Check(Sign((*(pBase->pfnStrcmp))((const char *)a, (const char *)b)) == nExpected, pszLevel, "strcmp (sse2)", u32Iteration);
+		}
+		// strncmp() 的长度可能小于、等于或大于字符串长度，也可能是 SIZE_MAX。
+		size_t uLimit;
+		switch(NextRandom(&u32Seed) % 4){
+		case 0:
+			uLimit = SIZE_MAX;
+			break;
+		case 1:
+			uLimit = uLength1;
+			break;
+		default:
+			uLimit = NextRandom(&u32Seed) % (uLength1 + 40);
+			break;
+		}
+		{
+			const int nExpected = Sign(NaiveStrncmp(s1, s2, (uLimit < uLength1 + 1) ? uLimit : uLength1 + 1));
+			Check(Sign((*(pTest->pfnStrncmp))((const char *)s1, (const char *)s2, uLimit)) == nExpected, pszLevel, "strncmp", u32Iteration);
+			Check(Sign((*(pBase->pfnStrncmp))((const char *)s1, (const char *)s2, uLimit)) == nExpected, pszLevel, "strncmp (sse2)", u32Iteration);
+		}
+		// memcmp() 只比较两个块都有的部分，包括结束符。
+		{
+			const size_t uCount = ((uLength1 < uLength2) ? uLength1 : uLength2) + 1;
+			const int nExpected = Sign(NaiveMemcmp(s1, s2, uCount));
+			Check(Sign((*(pTest->pfnMemcmp))(s1, s2, uCount)) == nExpected, pszLevel, "memcmp", u32Iteration);
+			Check(Sign((*(pBase->pfnMemcmp))(s1, s2, uCount)) == nExpected, pszLevel, "memcmp (sse2)", u32Iteration);
+		}
+
+		// memset() 不能写到块的外面。区域的其余部分保持为一个已知的字节。
+		{
+			const size_t uCount = RandomLength(&u32Seed, pRegion3->uSize);
+			unsigned char *const d = PlaceBlock(&u32Seed, pRegion3, uCount);
+			const unsigned char byFill = (unsigned char)NextRandom(&u32Seed);
+			for(unsigned uBase = 0; uBase < 2; ++uBase){
+				const Kernels *const pKernels = uBase ? pBase : pTest;
+				NaiveFill(pRegion3->pbyBegin, 0xEE, pRegion3->uSize);
+				bool bMatched = (*(pKernels->pfnMemset))(d, byFill, uCount) == d;
+				for(size_t i = 0; bMatched && (i < pRegion3->uSize); ++i){
+					const unsigned char *const p = pRegion3->pbyBegin + i;
+					bMatched = *p == (((p >= d) && (p < d + uCount)) ? byFill : 0xEE);
+				}
+				Check(bMatched, pszLevel, uBase ? "memset (sse2)" : "memset", u32Iteration);
+			}
+		}
+	}
+}
+
+bool TestString(void){
+	const size_t uPageSize = (size_t)sysconf(_SC_PAGESIZE);
+	Region aRegions[3];
+	for(size_t i = 0; i < sizeof(aRegions) / sizeof(aRegions[0]); ++i){
+		if(!CreateRegion(aRegions + i, uPageSize, 4)){
+			return false;
+		}
+	}
+
+	Kernels vBase;
+	SelectKernels(&vBase, 0);
+	const uint32_t u32Available = _MCFCRT_CpuGetFeatures();
+	g_uMismatches = 0;
+	for(size_t i = 0; i < sizeof(kLevels) / sizeof(kLevels[0]); ++i){
+		// 跳过这个 CPU 不支持的实现。
+		if((u32Available & kLevels[i].u32Features) != kLevels[i].u32Features){
+			printf("  %s: not supported, skipped\n", kLevels[i].pszName);
+			continue;
+		}
+		Kernels vTest;
+		SelectKernels(&vTest, kLevels[i].u32Features);
+		TestLevel(kLevels[i].pszName, &vTest, &vBase, aRegions, (uint32_t)i + 1);
+	}
+
+	for(size_t i = 0; i < sizeof(aRegions) / sizeof(aRegions[0]); ++i){
+		DestroyRegion(aRegions + i, uPageSize);
+	}
+	return g_uMismatches == 0;
+}
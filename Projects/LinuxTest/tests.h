@@ -0,0 +1,27 @@
+#ifndef MCF_LINUX_TEST_TESTS_H_
+#define MCF_LINUX_TEST_TESTS_H_
+
+#include <MCFCRT/env/_crtdef.h>
+
+// 这些测试在 Linux 上使用 futex 后端构建并运行 MCFCRT 的同步原语，以便使用 ThreadSanitizer 等工具检查。
+// 字符串函数的各个实现也在这里与朴素的实现逐一比较。
+// 每个测试都在单独的文件中，由 main.c 依次调用。测试通过时返回 true。
+
+typedef unsigned long (*TestThreadProc)(void *pParam);
+
+// 创建 uCount 个线程并等待它们全部结束。每个线程的参数是它的序号。
+extern void RunTestThreads(TestThreadProc pfnProc, size_t uCount);
+// 线性同余随机数发生器，各线程使用自己的种子。
+extern uint32_t NextRandom(uint32_t *pu32Seed);
+
+extern bool TestThread(void);
+extern bool TestMutex(void);
+extern bool TestFairMutex(void);
+extern bool TestConditionVariable(void);
+extern bool TestRwLock(void);
+extern bool TestWaitOnAddress(void);
+extern bool TestSemaphore(void);
+extern bool TestFiber(void);
+extern bool TestString(void);
+
+#endif
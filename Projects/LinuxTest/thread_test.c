@@ -0,0 +1,70 @@
+#include <MCFCRT/env/thread.h>
+#include <MCFCRT/env/clocks.h>
+#include "tests.h"
+
+static volatile bool g_bRan;
+static volatile uintptr_t g_uThreadId;
+static _MCFCRT_ThreadHandle g_hSuspended;
+static volatile size_t g_uResumeCount;
+
+#define RESUMER_COUNT  8u
+
+static unsigned long ThreadProc(void *pParam){
+	__atomic_store_n(&g_uThreadId, _MCFCRT_GetCurrentThreadId(), __ATOMIC_RELAXED);
+	_MCFCRT_Sleep(_MCFCRT_GetFastMonoClock() + (uintptr_t)pParam);
+	__atomic_store_n(&g_bRan, true, __ATOMIC_RELEASE);
+	return 0;
+}
+
+static unsigned long NopThreadProc(void *pParam){
+	(void)pParam;
+	return 0;
+}
+static unsigned long ResumerThreadProc(void *pParam){
+	(void)pParam;
+	__atomic_add_fetch(&g_uResumeCount, (size_t)_MCFCRT_ResumeThread(g_hSuspended), __ATOMIC_RELAXED);
+	return 0;
+}
+
+bool TestThread(void){
+	bool bPassed = true;
+
+	uintptr_t uThreadId;
+	const _MCFCRT_ThreadHandle hThread = _MCFCRT_CreateNativeThread(&ThreadProc, (void *)100, true, &uThreadId);
+	if(!hThread){
+		return false;
+	}
+	// 挂起的线程不会运行。
+	_MCFCRT_Sleep(_MCFCRT_GetFastMonoClock() + 20);
+	bPassed &= !__atomic_load_n(&g_bRan, __ATOMIC_ACQUIRE);
+	bPassed &= _MCFCRT_ResumeThread(hThread) == 1;
+	bPassed &= _MCFCRT_ResumeThread(hThread) == 0;
+	bPassed &= !_MCFCRT_WaitForThread(hThread, _MCFCRT_GetFastMonoClock() + 10);
+	_MCFCRT_WaitForThreadForever(hThread);
+	bPassed &= __atomic_load_n(&g_bRan, __ATOMIC_ACQUIRE);
+	bPassed &= __atomic_load_n(&g_uThreadId, __ATOMIC_RELAXED) == uThreadId;
+	bPassed &= uThreadId != _MCFCRT_GetCurrentThreadId();
+	bPassed &= _MCFCRT_WaitForThread(hThread, 0);
+	_MCFCRT_CloseThread(hThread);
+
+	// 在线程结束之前关闭句柄也是可以的。
+	_MCFCRT_CloseThread(_MCFCRT_CreateNativeThread(&ThreadProc, (void *)0, false, _MCFCRT_NULLPTR));
+
+	// 多个线程同时恢复同一个线程，只有一个能成功。
+	for(unsigned uRound = 0; uRound < 100; ++uRound){
+		g_hSuspended = _MCFCRT_CreateNativeThread(&NopThreadProc, _MCFCRT_NULLPTR, true, _MCFCRT_NULLPTR);
+		if(!g_hSuspended){
+			return false;
+		}
+		g_uResumeCount = 0;
+		RunTestThreads(&ResumerThreadProc, RESUMER_COUNT);
+		bPassed &= g_uResumeCount == 1;
+		_MCFCRT_WaitForThreadForever(g_hSuspended);
+		bPassed &= _MCFCRT_ResumeThread(g_hSuspended) == 0;
+		_MCFCRT_CloseThread(g_hSuspended);
+	}
+
+	const uint64_t u64Utc = 12345678;
+	bPassed &= _MCFCRT_GetUtcClockFromLocal(_MCFCRT_GetLocalClockFromUtc(u64Utc)) == u64Utc;
+	return bPassed;
+}
@@ -0,0 +1,77 @@
+#include <MCFCRT/env/wait_on_address.h>
+#include <MCFCRT/env/clocks.h>
+#include <MCFCRT/env/thread.h>
+#include "tests.h"
+
+#define WAITER_COUNT    16u
+#define ROUND_COUNT     5000u
+
+static volatile uint32_t g_u32Sequence;
+static volatile uint8_t g_au8Done[WAITER_COUNT];
+
+static unsigned long WaiterThreadProc(void *pParam){
+	const size_t uIndex = (size_t)pParam;
+	uint32_t u32Seed = (uint32_t)uIndex;
+	uint32_t u32Last = 0;
+	while(u32Last < ROUND_COUNT){
+		const uint32_t u32Random = NextRandom(&u32Seed);
+		const uint32_t u32Current = __atomic_load_n(&g_u32Sequence, __ATOMIC_ACQUIRE);
+		if(u32Current == u32Last){
+			if(u32Random % 3 == 0){
+				_MCFCRT_WaitOnAddress(&g_u32Sequence, &u32Last, sizeof(u32Last), _MCFCRT_GetFastMonoClock() + 1);
+			} else {
+				_MCFCRT_WaitOnAddressForever(&g_u32Sequence, &u32Last, sizeof(u32Last));
+			}
+			continue;
+		}
+		u32Last = u32Current;
+	}
+	__atomic_store_n(&g_au8Done[uIndex], 1, __ATOMIC_RELEASE);
+	_MCFCRT_WakeAllByAddress(&g_au8Done[uIndex]);
+	return 0;
+}
+static unsigned long WakerThreadProc(void *pParam){
+	(void)pParam;
+
+	for(uint32_t u32Sequence = 1; u32Sequence <= ROUND_COUNT; ++u32Sequence){
+		__atomic_store_n(&g_u32Sequence, u32Sequence, __ATOMIC_RELEASE);
+		if(u32Sequence % 2 != 0){
+			_MCFCRT_WakeAllByAddress(&g_u32Sequence);
+		} else {
+			while(_MCFCRT_WakeOneByAddress(&g_u32Sequence) != 0){
+				// 逐个唤醒所有线程。
+			}
+		}
+		if(u32Sequence % 64 == 0){
+			_MCFCRT_YieldThread();
+		}
+	}
+	// 等待所有线程看到最后的值。
+	for(size_t i = 0; i < WAITER_COUNT; ++i){
+		const uint8_t u8Expected = 0;
+		_MCFCRT_WaitOnAddressForever(&g_au8Done[i], &u8Expected, sizeof(u8Expected));
+	}
+	return 0;
+}
+static unsigned long WaitOnAddressThreadProc(void *pParam){
+	const size_t uIndex = (size_t)pParam;
+	if(uIndex == WAITER_COUNT){
+		return WakerThreadProc(pParam);
+	}
+	return WaiterThreadProc(pParam);
+}
+
+bool TestWaitOnAddress(void){
+	bool bPassed = true;
+
+	RunTestThreads(&WaitOnAddressThreadProc, WAITER_COUNT + 1);
+	for(size_t i = 0; i < WAITER_COUNT; ++i){
+		bPassed &= g_au8Done[i] != 0;
+	}
+	// 值不同时立即返回，超时则返回 false。
+	const uint32_t u32Other = 0;
+	bPassed &= _MCFCRT_WaitOnAddress(&g_u32Sequence, &u32Other, sizeof(u32Other), _MCFCRT_GetFastMonoClock() + 1000);
+	const uint32_t u32Same = ROUND_COUNT;
+	bPassed &= !_MCFCRT_WaitOnAddress(&g_u32Sequence, &u32Same, sizeof(u32Same), _MCFCRT_GetFastMonoClock() + 5);
+	return bPassed;
+}
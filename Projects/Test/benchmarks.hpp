@@ -0,0 +1,16 @@
+#ifndef MCF_TEST_BENCHMARKS_HPP_
+#define MCF_TEST_BENCHMARKS_HPP_
+
+// 每个基准测试和测试都在单独的文件中，由 main.cpp 依次调用。
+// 测试通过时返回 true。它们不使用 MCF_ASSERT()，因为发布构建定义了 NDEBUG，那时断言不会被检查。
+
+extern bool TestTimerWheel();
+extern bool TestCoroutines();
+
+extern void BenchFiber();
+extern void BenchHeap();
+extern void BenchMutex();
+extern void BenchThreadPool();
+extern void BenchTls();
+
+#endif
@@ -0,0 +1,261 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Containers/Vector.hpp>
+#include <MCF/Thread/Thread.hpp>
+#include <MCF/Coroutines/Task.hpp>
+#include <MCF/Coroutines/RunLoop.hpp>
+#include <MCF/Coroutines/AsyncMutex.hpp>
+#include <MCF/Coroutines/AsyncConditionVariable.hpp>
+#include <MCF/Coroutines/AsyncSemaphore.hpp>
+#include <stdexcept>
+#include "benchmarks.hpp"
+
+using namespace MCF;
+
+namespace {
+
+constexpr unsigned kChainDepth = 10000;
+constexpr std::size_t kTimerCount = 8;
+constexpr unsigned kWaiterCount = 4;
+
+MCF_BEGIN_COROUTINE_DEFINITIONS
+
+// 每一层结束时通过对称转移直接恢复上一层。只有在 GCC 把对称转移编译为尾调用时，栈才不会随调用链的深度增长。
+Task<unsigned> Descend(unsigned uDepth, std::uintptr_t &uDeepestFrame){
+	if(uDepth == 0){
+		uDeepestFrame = reinterpret_cast<std::uintptr_t>(__builtin_frame_address(0));
+		co_return 0u;
+	}
+	co_return co_await Descend(uDepth - 1, uDeepestFrame) + 1;
+}
+Task<bool> CheckSymmetricTransfer(){
+	const auto uTopFrame = reinterpret_cast<std::uintptr_t>(__builtin_frame_address(0));
+	std::uintptr_t uDeepestFrame = 0;
+	const auto uDepth = co_await Descend(kChainDepth, uDeepestFrame);
+	bool bPassed = uDepth == kChainDepth;
+#ifdef NDEBUG
+	// 调试构建使用 -Og，不启用 -foptimize-sibling-calls，每一层都会占用几十字节的栈。
+	const auto uDistance = (uTopFrame > uDeepestFrame) ? (uTopFrame - uDeepestFrame) : (uDeepestFrame - uTopFrame);
+	bPassed &= uDistance < 0x10000;
+#else
+	static_cast<void>(uTopFrame);
+#endif
+	co_return bPassed;
+}
+
+Task<void> SleepAndRecord(RunLoop &vLoop, std::uint64_t u64DueTime, Vector<std::uint64_t> &vecWokenDueTimes, bool &bPassed){
+	co_await vLoop.SleepUntil(u64DueTime);
+	bPassed &= GetFastMonoClock() >= u64DueTime;
+	vecWokenDueTimes.Push(u64DueTime);
+}
+
+Task<void> StopAndContinue(RunLoop &vLoop, unsigned &uStage){
+	uStage = 1;
+	vLoop.Stop();
+	co_await vLoop.Reschedule();
+	uStage = 2;
+}
+
+Task<void> LockAndRecord(AsyncMutex &vMutex, unsigned uIndex, Vector<unsigned> &vecOrder){
+	co_await vMutex.Lock();
+	vecOrder.Push(uIndex);
+	vMutex.Unlock();
+}
+// Unlock() 把所有权按等待的顺序直接交给等待者。
+Task<bool> CheckMutexHandoff(RunLoop &vLoop){
+	bool bPassed = true;
+	AsyncMutex vMutex;
+	Vector<unsigned> vecOrder;
+	co_await vMutex.Lock();
+	for(unsigned i = 0; i < kWaiterCount; ++i){
+		vLoop.Spawn(LockAndRecord(vMutex, i, vecOrder));
+	}
+	// 分离的协程在下一批中开始运行，之后它们都在等待互斥体。
+	co_await vLoop.Reschedule();
+	bPassed &= vecOrder.IsEmpty();
+	bPassed &= !vMutex.TryLock();
+	vMutex.Unlock();
+	// 互斥体被交给了第一个等待者，因此仍然是锁定的。
+	bPassed &= vMutex.IsLocked();
+	// 这个协程排在所有等待者之后。
+	co_await vMutex.Lock();
+	bPassed &= vecOrder.GetSize() == kWaiterCount;
+	for(unsigned i = 0; i < vecOrder.GetSize(); ++i){
+		bPassed &= vecOrder[i] == i;
+	}
+	vMutex.Unlock();
+	bPassed &= !vMutex.IsLocked();
+	co_return bPassed;
+}
+
+Task<void> WaitForSignal(AsyncMutex &vMutex, AsyncConditionVariable &vCond, unsigned &uWaiting, unsigned &uWoken, bool &bPassed){
+	co_await vMutex.Lock();
+	++uWaiting;
+	co_await vCond.Wait(vMutex);
+	// 被唤醒的协程重新锁定了互斥体。
+	bPassed &= vMutex.IsLocked();
+	++uWoken;
+	vMutex.Unlock();
+}
+Task<bool> CheckConditionVariable(RunLoop &vLoop){
+	bool bPassed = true;
+	AsyncMutex vMutex;
+	AsyncConditionVariable vCond;
+	unsigned uWaiting = 0, uWoken = 0;
+	bPassed &= vCond.Signal() == 0;
+	for(unsigned i = 0; i < kWaiterCount; ++i){
+		vLoop.Spawn(WaitForSignal(vMutex, vCond, uWaiting, uWoken, bPassed));
+	}
+	while(uWaiting < kWaiterCount){
+		co_await vLoop.Reschedule();
+	}
+	co_await vMutex.Lock();
+	bPassed &= vCond.Signal() == 1;
+	vMutex.Unlock();
+	while(uWoken < 1){
+		co_await vLoop.Reschedule();
+	}
+	co_await vMutex.Lock();
+	bPassed &= uWoken == 1;
+	bPassed &= vCond.Broadcast() == kWaiterCount - 1;
+	bPassed &= vCond.Signal() == 0;
+	vMutex.Unlock();
+	while(uWoken < kWaiterCount){
+		co_await vLoop.Reschedule();
+	}
+	co_return bPassed;
+}
+
+Task<void> WaitAndRecord(AsyncSemaphore &vSemaphore, unsigned uIndex, Vector<unsigned> &vecOrder){
+	co_await vSemaphore.Wait();
+	vecOrder.Push(uIndex);
+}
+// 投递的计数先交给等待者，剩下的才加到计数上。
+Task<bool> CheckSemaphore(RunLoop &vLoop){
+	bool bPassed = true;
+	AsyncSemaphore vSemaphore(0);
+	Vector<unsigned> vecOrder;
+	for(unsigned i = 0; i < kWaiterCount; ++i){
+		vLoop.Spawn(WaitAndRecord(vSemaphore, i, vecOrder));
+	}
+	co_await vLoop.Reschedule();
+	bPassed &= vecOrder.IsEmpty();
+	bPassed &= vSemaphore.Post(kWaiterCount + 1) == 0;
+	bPassed &= vSemaphore.GetCount() == 1;
+	co_await vLoop.Reschedule();
+	bPassed &= vecOrder.GetSize() == kWaiterCount;
+	for(unsigned i = 0; i < vecOrder.GetSize(); ++i){
+		bPassed &= vecOrder[i] == i;
+	}
+	bPassed &= vSemaphore.TryWait();
+	bPassed &= !vSemaphore.TryWait();
+	co_return bPassed;
+}
+
+// 被其他线程唤醒的协程回到它挂起时所在的 RunLoop 中恢复。
+Task<bool> WaitForOtherThread(RunLoop &vLoop, AsyncSemaphore &vSemaphore){
+	const auto uThreadId = ::_MCFCRT_GetCurrentThreadId();
+	co_await vSemaphore.Wait();
+	co_return (RunLoop::GetCurrent() == &vLoop) && (::_MCFCRT_GetCurrentThreadId() == uThreadId);
+}
+
+Task<int> ReturnOrThrow(bool bThrow){
+	if(bThrow){
+		throw std::runtime_error("ReturnOrThrow");
+	}
+	co_return 42;
+}
+Task<void> ThrowFromVoid(){
+	co_await ReturnOrThrow(true);
+}
+// 协程抛出的异常在 co_await 它的地方被重新抛出。
+Task<bool> CheckExceptionsInCoroutine(){
+	bool bPassed = co_await ReturnOrThrow(false) == 42;
+	bool bCaught = false;
+	try {
+		co_await ReturnOrThrow(true);
+	} catch(std::runtime_error &){
+		bCaught = true;
+	}
+	bPassed &= bCaught;
+	bCaught = false;
+	try {
+		co_await ThrowFromVoid();
+	} catch(std::runtime_error &){
+		bCaught = true;
+	}
+	bPassed &= bCaught;
+	co_return bPassed;
+}
+
+MCF_END_COROUTINE_DEFINITIONS
+
+bool TestTimerOrder(RunLoop &vLoop){
+	bool bPassed = true;
+	Vector<std::uint64_t> vecWokenDueTimes;
+	const auto u64Base = GetFastMonoClock();
+	// 以打乱的顺序添加定时器，它们必须按照到期时刻的顺序被唤醒。
+	for(std::size_t i = 0; i < kTimerCount; ++i){
+		const auto u64DueTime = u64Base + 20 + (i * 5 % kTimerCount) * 10;
+		vLoop.Spawn(SleepAndRecord(vLoop, u64DueTime, vecWokenDueTimes, bPassed));
+	}
+	vLoop.Run();
+	bPassed &= vecWokenDueTimes.GetSize() == kTimerCount;
+	for(std::size_t i = 1; i < vecWokenDueTimes.GetSize(); ++i){
+		bPassed &= vecWokenDueTimes[i - 1] < vecWokenDueTimes[i];
+	}
+	return bPassed;
+}
+
+bool TestStop(RunLoop &vLoop){
+	bool bPassed = true;
+	unsigned uStage = 0;
+	// Run() 开始之前的 Stop() 没有效果。
+	vLoop.Stop();
+	vLoop.Spawn(StopAndContinue(vLoop, uStage));
+	vLoop.Run();
+	bPassed &= uStage == 1;
+	vLoop.Run();
+	bPassed &= uStage == 2;
+	return bPassed;
+}
+
+bool TestWakeFromOtherThread(RunLoop &vLoop){
+	AsyncSemaphore vSemaphore(0);
+	const auto pThread = MakeThread([&]{
+		MCF::Sleep(GetFastMonoClock() + 20);
+		vSemaphore.Post();
+	});
+	const bool bPassed = vLoop.RunUntilComplete(WaitForOtherThread(vLoop, vSemaphore));
+	pThread->Wait();
+	return bPassed;
+}
+
+bool TestExceptions(RunLoop &vLoop){
+	bool bPassed = vLoop.RunUntilComplete(CheckExceptionsInCoroutine());
+	bool bCaught = false;
+	try {
+		vLoop.RunUntilComplete(ReturnOrThrow(true));
+	} catch(std::runtime_error &){
+		bCaught = true;
+	}
+	bPassed &= bCaught;
+	return bPassed;
+}
+
+}
+
+bool TestCoroutines(){
+	bool bPassed = true;
+	RunLoop vLoop;
+	bPassed &= vLoop.RunUntilComplete(CheckSymmetricTransfer());
+	bPassed &= TestTimerOrder(vLoop);
+	bPassed &= TestStop(vLoop);
+	bPassed &= vLoop.RunUntilComplete(CheckMutexHandoff(vLoop));
+	bPassed &= vLoop.RunUntilComplete(CheckConditionVariable(vLoop));
+	bPassed &= vLoop.RunUntilComplete(CheckSemaphore(vLoop));
+	bPassed &= TestWakeFromOtherThread(vLoop);
+	bPassed &= TestExceptions(vLoop);
+	std::printf("coroutines  : %s\n", bPassed ? "passed" : "FAILED");
+	return bPassed;
+}
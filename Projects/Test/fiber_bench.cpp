@@ -0,0 +1,38 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCFCRT/env/fiber.h>
+#include <MCFCRT/env/bail.h>
+#include "benchmarks.hpp"
+
+using namespace MCF;
+
+namespace {
+
+constexpr std::size_t kRoundTrips = 10000000;
+
+// 纤程只是不停地让出，测得的时间全部是一次恢复加一次让出的开销。
+void YieldForever(std::intptr_t nParam) noexcept {
+	static_cast<void>(nParam);
+
+	for(;;){
+		::_MCFCRT_YieldFiber();
+	}
+}
+
+}
+
+void BenchFiber(){
+	const auto hFiber = ::_MCFCRT_CreateFiber(&YieldForever, 0, 0);
+	if(!hFiber){
+		::_MCFCRT_Bail(L"_MCFCRT_CreateFiber() 失败。");
+	}
+	// 第一次恢复要切换到新的栈上，不计入结果。
+	::_MCFCRT_ResumeFiber(hFiber);
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < kRoundTrips; ++i){
+		::_MCFCRT_ResumeFiber(hFiber);
+	}
+	const auto t2 = GetHiResMonoClock();
+	::_MCFCRT_DestroyFiber(hFiber);
+	std::printf("fiber     round trips = %zu : t = %10.3f ms, ns/round trip = %10.1f\n", kRoundTrips, t2 - t1, (t2 - t1) * 1000000 / static_cast<double>(kRoundTrips));
+}
@@ -0,0 +1,88 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/Array.hpp>
+#include <MCF/Thread/Thread.hpp>
+#include "benchmarks.hpp"
+
+using namespace MCF;
+
+namespace {
+
+constexpr std::size_t kLoops = 1000000;
+constexpr std::size_t kSlots = 256;
+constexpr std::size_t kMediumLoops = 100000;
+constexpr std::size_t kMediumSlots = 8;
+
+void BenchSmallBlocks(std::size_t uThreadCount){
+	Array<IntrusivePtr<Thread>, 64> aThreads;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		aThreads[i] = MakeThread([i]{
+			void *apSlots[kSlots] = { };
+			std::uint32_t u32Seed = static_cast<std::uint32_t>(i) * 0x9E3779B9u + 1;
+			for(std::size_t j = 0; j < kLoops; ++j){
+				u32Seed = u32Seed * 1664525u + 1013904223u;
+				auto &pSlot = apSlots[(u32Seed >> 8) % kSlots];
+				if(pSlot){
+					std::free(pSlot);
+					pSlot = nullptr;
+				} else {
+					pSlot = std::malloc((u32Seed >> 20) % 512 + 1);
+				}
+			}
+			for(auto &pSlot : apSlots){
+				if(pSlot){
+					std::free(pSlot);
+				}
+			}
+		});
+	}
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		aThreads[i]->Wait();
+	}
+	const auto t2 = GetHiResMonoClock();
+	std::printf("heap      threads = %2zu : t = %10.3f ms, ops/ms = %10.1f\n", uThreadCount, t2 - t1, static_cast<double>(uThreadCount * kLoops) / (t2 - t1));
+}
+
+// 旧的堆是在 LocalAlloc() 之上实现的，因此拿它作为中等大小的块的基准。
+template<typename AllocT, typename FreeT>
+double BenchMediumBlocksWith(std::size_t uSize, AllocT &&vAlloc, FreeT &&vFree){
+	void *apSlots[kMediumSlots] = { };
+	std::uint32_t u32Seed = 1;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t j = 0; j < kMediumLoops; ++j){
+		u32Seed = u32Seed * 1664525u + 1013904223u;
+		auto &pSlot = apSlots[(u32Seed >> 8) % kMediumSlots];
+		if(pSlot){
+			vFree(pSlot);
+			pSlot = nullptr;
+		} else {
+			// 在 uSize 和 uSize * 1.125 之间随机选取大小。
+			pSlot = vAlloc(uSize + (u32Seed >> 16) % (uSize / 8 + 1));
+			static_cast<volatile char *>(pSlot)[0] = 1;
+		}
+	}
+	for(auto &pSlot : apSlots){
+		if(pSlot){
+			vFree(pSlot);
+		}
+	}
+	const auto t2 = GetHiResMonoClock();
+	return (t2 - t1) * 1000000 / kMediumLoops;
+}
+void BenchMediumBlocks(std::size_t uSize){
+	const auto dMalloc = BenchMediumBlocksWith(uSize, [](std::size_t uBytes){ return std::malloc(uBytes); }, [](void *pBlock){ std::free(pBlock); });
+	const auto dLocal = BenchMediumBlocksWith(uSize, [](std::size_t uBytes){ return static_cast<void *>(::LocalAlloc(LMEM_FIXED, uBytes)); }, [](void *pBlock){ ::LocalFree(pBlock); });
+	std::printf("heap      size = %6zu : malloc = %8.1f ns/op, LocalAlloc = %8.1f ns/op\n", uSize, dMalloc, dLocal);
+}
+
+}
+
+void BenchHeap(){
+	for(std::size_t uThreadCount = 1; uThreadCount <= 16; uThreadCount *= 2){
+		BenchSmallBlocks(uThreadCount);
+	}
+	for(std::size_t uSize = 8192; uSize <= 262144; uSize *= 2){
+		BenchMediumBlocks(uSize);
+	}
+}
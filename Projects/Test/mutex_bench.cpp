@@ -0,0 +1,67 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/Array.hpp>
+#include <MCF/Containers/Vector.hpp>
+#include <MCF/Thread/Thread.hpp>
+#include <MCF/Thread/Mutex.hpp>
+#include <MCF/Thread/FairMutex.hpp>
+#include <algorithm>
+#include "benchmarks.hpp"
+
+using namespace MCF;
+
+namespace {
+
+constexpr std::size_t kLoops = 20000;
+constexpr std::size_t kMaxThreads = 64;
+
+template<typename MutexT>
+void BenchOne(const char *pszName, std::size_t uThreadCount){
+	MutexT vMutex;
+	volatile std::size_t uCounter = 0;
+	Array<Vector<double>, kMaxThreads> avecLatencies;
+	Array<IntrusivePtr<Thread>, kMaxThreads> aThreads;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		auto &vecLatencies = avecLatencies[i];
+		vecLatencies.Append(kLoops);
+		aThreads[i] = MakeThread([&, i]{
+			std::uint32_t u32Seed = static_cast<std::uint32_t>(i) * 0x9E3779B9u + 1;
+			for(std::size_t j = 0; j < kLoops; ++j){
+				const auto t3 = GetHiResMonoClock();
+				vMutex.Lock();
+				const auto t4 = GetHiResMonoClock();
+				uCounter = uCounter + 1;
+				vMutex.Unlock();
+				vecLatencies[j] = t4 - t3;
+				// Do something outside the critical section, so threads do not always find the mutex locked.
+				for(std::size_t k = (u32Seed >> 24) % 64; k != 0; --k){
+					u32Seed = u32Seed * 1664525u + 1013904223u;
+				}
+			}
+		});
+	}
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		aThreads[i]->Wait();
+	}
+	const auto t2 = GetHiResMonoClock();
+	MCF_ASSERT(uCounter == uThreadCount * kLoops);
+
+	Vector<double> vecAll;
+	for(std::size_t i = 0; i < uThreadCount; ++i){
+		vecAll.Append(avecLatencies[i].GetBegin(), avecLatencies[i].GetEnd());
+	}
+	const auto pP99 = vecAll.GetBegin() + static_cast<std::ptrdiff_t>(vecAll.GetSize() * 99 / 100);
+	std::nth_element(vecAll.GetBegin(), pP99, vecAll.GetEnd());
+	std::printf("%-9s threads = %2zu : t = %10.3f ms, ops/ms = %10.1f, p99 acquire = %10.3f us\n",
+		pszName, uThreadCount, t2 - t1, static_cast<double>(uThreadCount * kLoops) / (t2 - t1), *pP99 * 1000);
+}
+
+}
+
+void BenchMutex(){
+	for(std::size_t uThreadCount = 2; uThreadCount <= kMaxThreads; uThreadCount *= 2){
+		BenchOne<Mutex>("Mutex", uThreadCount);
+		BenchOne<FairMutex>("FairMutex", uThreadCount);
+	}
+}
@@ -0,0 +1,68 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Thread/ThreadPool.hpp>
+#include <MCFCRT/env/cpu.h>
+#include "benchmarks.hpp"
+
+using namespace MCF;
+
+namespace {
+
+constexpr unsigned kFibonacciN = 30;
+constexpr std::size_t kFlatTaskCount = 1000000;
+
+// 每个任务只做一次加法，调度开销占了绝大部分。
+unsigned long Fibonacci(ThreadPool &vPool, unsigned uN){
+	if(uN < 2){
+		return uN;
+	}
+	unsigned long ulFirst;
+	const auto pTask = vPool.Submit([&]{ ulFirst = Fibonacci(vPool, uN - 1); });
+	const auto ulSecond = Fibonacci(vPool, uN - 2);
+	pTask->Wait();
+	return ulFirst + ulSecond;
+}
+
+double BenchRecursive(std::size_t uWorkerCount){
+	ThreadPool vPool(uWorkerCount);
+	unsigned long ulResult = 0;
+	const auto t1 = GetHiResMonoClock();
+	vPool.Submit([&]{ ulResult = Fibonacci(vPool, kFibonacciN); })->Wait();
+	const auto t2 = GetHiResMonoClock();
+	MCF_ASSERT(ulResult == 832040);
+	return t2 - t1;
+}
+double BenchFlat(std::size_t uWorkerCount){
+	Atomic<std::size_t> uCounter(0);
+	const auto t1 = GetHiResMonoClock();
+	{
+		ThreadPool vPool(uWorkerCount);
+		for(std::size_t i = 0; i < kFlatTaskCount; ++i){
+			vPool.Submit([&]{ uCounter.Increment(kAtomicRelaxed); });
+		}
+		// 析构函数等待所有任务完成。
+	}
+	const auto t2 = GetHiResMonoClock();
+	MCF_ASSERT(uCounter.Load(kAtomicRelaxed) == kFlatTaskCount);
+	return t2 - t1;
+}
+
+}
+
+void BenchThreadPool(){
+	const auto uMaxWorkerCount = ::_MCFCRT_CpuGetLogicalProcessorCount();
+	// fib(30) 会创建 1346268 个任务。
+	const double dRecursiveTaskCount = 1346268;
+	double dRecursiveBase = 0, dFlatBase = 0;
+	for(std::size_t uWorkerCount = 1; uWorkerCount <= uMaxWorkerCount; ++uWorkerCount){
+		const auto dRecursive = BenchRecursive(uWorkerCount);
+		const auto dFlat = BenchFlat(uWorkerCount);
+		if(uWorkerCount == 1){
+			dRecursiveBase = dRecursive;
+			dFlatBase = dFlat;
+		}
+		std::printf("workers = %2zu : recursive t = %9.3f ms, tasks/ms = %9.1f, speedup = %5.2f | flat t = %9.3f ms, tasks/ms = %9.1f, speedup = %5.2f\n",
+			uWorkerCount, dRecursive, dRecursiveTaskCount / dRecursive, dRecursiveBase / dRecursive,
+			dFlat, static_cast<double>(kFlatTaskCount) / dFlat, dFlatBase / dFlat);
+	}
+}
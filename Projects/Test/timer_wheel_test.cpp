@@ -0,0 +1,158 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Containers/Vector.hpp>
+#include <MCF/Thread/TimerWheel.hpp>
+#include <algorithm>
+#include "benchmarks.hpp"
+
+using namespace MCF;
+
+namespace {
+
+// 覆盖每一层以及时间轮范围之外的到期时刻，这些计时器在触发之前要在层与层之间移动。
+constexpr std::uint64_t kCascadeOffsets[] = {
+	1, 2, 255, 256, 257, 511, 65535, 65536, 65537, 65792, 16777215, 16777216, 16777217, 4294967295, 4294967296, 4294967297, 10000000000,
+};
+
+bool TestCascade(std::uint64_t u64TickInterval){
+	bool bPassed = true;
+	TimerWheel vWheel(u64TickInterval);
+	const auto u64Base = GetFastMonoClock();
+	std::uint64_t u64Now = u64Base, u64Previous = u64Base;
+
+	Vector<IntrusivePtr<WheelTimer>> vecTimers;
+	Vector<std::uint64_t> vecFiredAt;
+	for(std::size_t i = 0; i < sizeof(kCascadeOffsets) / sizeof(kCascadeOffsets[0]); ++i){
+		const auto u64DueTime = u64Base + kCascadeOffsets[i];
+		vecFiredAt.Push(0);
+		vecTimers.Push(vWheel.Schedule(u64DueTime, [&, i, u64DueTime]{
+			bPassed &= vecFiredAt[i] == 0;
+			// 不能早于到期时刻触发，也不能晚于到期之后的第一次 Advance()。
+			bPassed &= u64Now >= u64DueTime;
+			bPassed &= u64Previous < u64DueTime + u64TickInterval;
+			vecFiredAt[i] = u64Now;
+		}));
+	}
+	while(vWheel.GetPendingCount() != 0){
+		const auto u64WakeTime = vWheel.GetNextWakeTime();
+		if(u64WakeTime == UINT64_MAX){
+			bPassed = false;
+			break;
+		}
+		u64Previous = u64Now;
+		u64Now = std::max(u64Now, u64WakeTime);
+		vWheel.Advance(u64Now);
+	}
+	bPassed &= vWheel.GetNextWakeTime() == UINT64_MAX;
+	for(std::size_t i = 0; i < vecTimers.GetSize(); ++i){
+		bPassed &= vecFiredAt[i] != 0;
+		// 已经触发的计时器不再属于时间轮。
+		bPassed &= !vecTimers[i]->GetWheel();
+		bPassed &= !vecTimers[i]->IsPending();
+		bPassed &= !vecTimers[i]->Cancel();
+	}
+	return bPassed;
+}
+
+bool TestRescheduleDuringDispatch(){
+	bool bPassed = true;
+	TimerWheel vWheel(1);
+	const auto u64Base = GetFastMonoClock();
+
+	// 周期性的计时器在自己的回调中重新调度自己。
+	unsigned uPeriodicCount = 0;
+	IntrusivePtr<WheelTimer> pPeriodic;
+	pPeriodic = vWheel.Schedule(u64Base + 10, [&]{
+		bPassed &= !pPeriodic->GetWheel();
+		if(++uPeriodicCount < 100){
+			vWheel.Schedule(pPeriodic, u64Base + 10 + uPeriodicCount * 300);
+			bPassed &= pPeriodic->IsPending();
+		}
+	});
+
+	// 这两个计时器在同一批中被取出，先被分发的那个取消另一个，因此恰好有一个被触发。
+	unsigned uRivalCount = 0;
+	IntrusivePtr<WheelTimer> pFirst, pSecond;
+	pFirst = vWheel.Schedule(u64Base + 50, [&]{
+		++uRivalCount;
+		bPassed &= pSecond->Cancel();
+		bPassed &= !pSecond->Cancel();
+	});
+	pSecond = vWheel.Schedule(u64Base + 50, [&]{
+		++uRivalCount;
+		bPassed &= pFirst->Cancel();
+		bPassed &= !pFirst->Cancel();
+	});
+
+	// 这两个计时器也在同一批中被取出，先被分发的那个把另一个推迟，被推迟的那个要在之后的一批中触发。
+	unsigned uDelayedCount = 0;
+	IntrusivePtr<WheelTimer> pEarly, pLate;
+	pEarly = vWheel.Schedule(u64Base + 70, [&]{
+		++uDelayedCount;
+		if(uDelayedCount == 1){
+			vWheel.Schedule(pLate, u64Base + 1000);
+		}
+	});
+	pLate = vWheel.Schedule(u64Base + 70, [&]{
+		++uDelayedCount;
+		if(uDelayedCount == 1){
+			vWheel.Schedule(pEarly, u64Base + 1000);
+		}
+	});
+
+	vWheel.Advance(u64Base + 999);
+	bPassed &= uRivalCount == 1;
+	bPassed &= uDelayedCount == 1;
+	bPassed &= !pFirst->GetWheel() && !pSecond->GetWheel();
+	vWheel.Advance(u64Base + 1000);
+	bPassed &= uDelayedCount == 2;
+	// 在分发期间被调度到已经过去的时刻的计时器在下一批中触发。
+	while(vWheel.GetPendingCount() != 0){
+		if(vWheel.GetNextWakeTime() != 0){
+			bPassed = false;
+			break;
+		}
+		vWheel.Advance(u64Base + 100000);
+	}
+	bPassed &= uPeriodicCount == 100;
+	return bPassed;
+}
+
+bool TestTimersOutliveWheel(){
+	bool bPassed = true;
+	IntrusivePtr<WheelTimer> pFired, pCancelled, pPending;
+	unsigned uFiredCount = 0;
+	{
+		TimerWheel vWheel(1);
+		const auto u64Base = GetFastMonoClock();
+		pFired = vWheel.Schedule(u64Base + 1, [&]{ ++uFiredCount; });
+		pCancelled = vWheel.Schedule(u64Base + 1, [&]{ ++uFiredCount; });
+		pPending = vWheel.Schedule(u64Base + 1000000, [&]{ ++uFiredCount; });
+		bPassed &= pCancelled->Cancel();
+		vWheel.Advance(u64Base + 2);
+		bPassed &= uFiredCount == 1;
+		bPassed &= pPending->GetWheel() == &vWheel;
+		bPassed &= pPending->GetDueTime() == u64Base + 1000000;
+	}
+	// 时间轮析构之后，无论计时器是已触发、已取消还是仍在等待，都不能再访问时间轮。
+	for(const auto &pTimer : { pFired, pCancelled, pPending }){
+		bPassed &= !pTimer->GetWheel();
+		bPassed &= !pTimer->IsPending();
+		bPassed &= pTimer->GetDueTime() == 0;
+		bPassed &= !pTimer->Cancel();
+	}
+	bPassed &= uFiredCount == 1;
+	return bPassed;
+}
+
+}
+
+bool TestTimerWheel(){
+	bool bPassed = true;
+	bPassed &= TestCascade(1);
+	bPassed &= TestCascade(7);
+	bPassed &= TestRescheduleDuringDispatch();
+	bPassed &= TestTimersOutliveWheel();
+	std::printf("timer wheel : %s\n", bPassed ? "passed" : "FAILED");
+	return bPassed;
+}
@@ -0,0 +1,97 @@
+#include <MCF/StdMCF.hpp>
+#include <MCF/Core/Clocks.hpp>
+#include <MCF/Core/Array.hpp>
+#include <MCFCRT/pre/tls.h>
+#include <MCFCRT/env/thread.h>
+#include <MCFCRT/env/bail.h>
+#include "benchmarks.hpp"
+
+using namespace MCF;
+
+namespace {
+
+constexpr std::size_t kMaxKeys = 256;
+constexpr std::size_t kGetLoops = 20000000;
+constexpr std::size_t kMapKeys = 40;
+constexpr std::size_t kMapThreads = 2000;
+
+// 循环依次访问 uKeyCount 个键，因此结果包含循环本身的开销，但可以看出访问的代价是否随键的数量增长。
+void BenchGet(std::size_t uKeyCount){
+	Array<::_MCFCRT_TlsKeyHandle, kMaxKeys> ahKeys;
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		ahKeys[i] = ::_MCFCRT_TlsAllocKey(sizeof(std::uintptr_t), nullptr, nullptr, 0);
+		void *pStorage;
+		if(!ahKeys[i] || !::_MCFCRT_TlsRequire(ahKeys[i], &pStorage)){
+			::_MCFCRT_Bail(L"_MCFCRT_TlsRequire() 失败。");
+		}
+		*static_cast<std::uintptr_t *>(pStorage) = i;
+	}
+	std::uintptr_t uSum = 0;
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t j = 0; j < kGetLoops; ++j){
+		void *pStorage;
+		::_MCFCRT_TlsGet(ahKeys[j % uKeyCount], &pStorage);
+		uSum += *static_cast<const std::uintptr_t *>(pStorage);
+	}
+	const auto t2 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		::_MCFCRT_TlsFreeKey(ahKeys[i]);
+	}
+	std::printf("tls get   keys = %3zu : t = %10.3f ms, ns/get = %7.2f, sum = %zu\n", uKeyCount, t2 - t1, (t2 - t1) * 1000000 / static_cast<double>(kGetLoops), static_cast<std::size_t>(uSum));
+}
+
+struct MapParams {
+	const ::_MCFCRT_TlsKeyHandle *phKeys;
+	std::size_t uKeyCount;
+};
+
+__MCFCRT_C_STDCALL
+unsigned long RequireAllKeys(void *pParam){
+	const auto pParams = static_cast<const MapParams *>(pParam);
+	for(std::size_t i = 0; i < pParams->uKeyCount; ++i){
+		void *pStorage;
+		if(!::_MCFCRT_TlsRequire(pParams->phKeys[i], &pStorage)){
+			::_MCFCRT_Bail(L"_MCFCRT_TlsRequire() 失败。");
+		}
+	}
+	return 0;
+}
+
+// 每个线程依次要求所有的键，在退出时销毁它的线程映射表。没有键的结果是创建和等待线程本身的开销，两者之差是线程映射表的代价。
+// 大小和对齐各不相同，其中有几个对象大于半个 slab 或者对齐超过缓存行，它们需要单独的 slab。
+void BenchThreadMap(std::size_t uKeyCount){
+	Array<::_MCFCRT_TlsKeyHandle, kMapKeys> ahKeys;
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		const std::size_t uSize = (i % 10 == 9) ? 3000 : static_cast<std::size_t>(8) << (i % 8);
+		const std::size_t uAlignment = (i % 7 == 6) ? 256 : static_cast<std::size_t>(8) << (i % 3);
+		ahKeys[i] = ::_MCFCRT_TlsAllocKeyAligned(uSize, uAlignment, nullptr, nullptr, 0);
+		if(!ahKeys[i]){
+			::_MCFCRT_Bail(L"_MCFCRT_TlsAllocKeyAligned() 失败。");
+		}
+	}
+	MapParams vParams = { ahKeys.GetData(), uKeyCount };
+	const auto t1 = GetHiResMonoClock();
+	for(std::size_t j = 0; j < kMapThreads; ++j){
+		const auto hThread = ::_MCFCRT_CreateNativeThread(&RequireAllKeys, &vParams, false, nullptr);
+		if(!hThread){
+			::_MCFCRT_Bail(L"_MCFCRT_CreateNativeThread() 失败。");
+		}
+		::_MCFCRT_WaitForThreadForever(hThread);
+		::_MCFCRT_CloseThread(hThread);
+	}
+	const auto t2 = GetHiResMonoClock();
+	for(std::size_t i = 0; i < uKeyCount; ++i){
+		::_MCFCRT_TlsFreeKey(ahKeys[i]);
+	}
+	std::printf("tls map   keys = %3zu : t = %10.3f ms, us/thread = %7.2f\n", uKeyCount, t2 - t1, (t2 - t1) * 1000 / static_cast<double>(kMapThreads));
+}
+
+}
+
+void BenchTls(){
+	for(std::size_t uKeyCount = 1; uKeyCount <= kMaxKeys; uKeyCount *= 4){
+		BenchGet(uKeyCount);
+	}
+	BenchThreadMap(0);
+	BenchThreadMap(kMapKeys);
+}